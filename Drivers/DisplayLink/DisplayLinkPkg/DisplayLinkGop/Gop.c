@@ -11,6 +11,8 @@
 #include "UsbDisplayLink.h"
 #include "Edid.h"
 
+// The pixel format of the DisplayLink device: 24 bits per pixel, red in the first byte
+STATIC CONST EFI_PIXEL_BITMASK mDlRgb888PixelMasks = { 0x000000ff, 0x0000ff00, 0x00ff0000, 0x00000000 };
 
 /**
  *
@@ -69,6 +71,27 @@ CheckBounds (
   return EFI_SUCCESS;
 }
 
+/**
+ * Update the store of the area of the screen that is "dirty" - that we need to send in the next screen update.
+ * @param UsbDisplayLinkDev
+ * @param Y               First line written to
+ * @param Height          Number of lines written to
+ */
+STATIC VOID
+AddDamage (
+  IN  USB_DISPLAYLINK_DEV                     *UsbDisplayLinkDev,
+  IN  UINTN                                   Y,
+  IN  UINTN                                   Height
+)
+{
+  if (Y < UsbDisplayLinkDev->LastY1) {
+    UsbDisplayLinkDev->LastY1 = Y;
+  }
+  if ((Y + Height) > UsbDisplayLinkDev->LastY2) {
+    UsbDisplayLinkDev->LastY2 = Y + Height;
+  }
+}
+
 /**
  * Update the local copy of the Frame Buffer. This local copy is periodically transmitted to the
  * DisplayLink device (via DlGopSendScreenUpdate)
@@ -121,13 +144,7 @@ BuildBackBuffer (
 
   case EfiBltBufferToVideo:
   {
-    // Update the store of the area of the screen that is "dirty" - that we need to send in the next screen update.
-    if (DestinationY < UsbDisplayLinkDev->LastY1) {
-      UsbDisplayLinkDev->LastY1 = DestinationY;
-    }
-    if ((DestinationY + Height) > UsbDisplayLinkDev->LastY2) {
-      UsbDisplayLinkDev->LastY2 = DestinationY + Height;
-    }
+    AddDamage (UsbDisplayLinkDev, DestinationY, Height);
 
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* Blt;
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
@@ -146,6 +163,8 @@ BuildBackBuffer (
 
   case EfiBltVideoToVideo:
   {
+    AddDamage (UsbDisplayLinkDev, DestinationY, Height);
+
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* SrcB;
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
     SrcB = UsbDisplayLinkDev->Screen + SourceY * PixelsPerScanLine + SourceX;
@@ -163,6 +182,8 @@ BuildBackBuffer (
 
   case EfiBltVideoFill:
   {
+    AddDamage (UsbDisplayLinkDev, DestinationY, Height);
+
     EFI_GRAPHICS_OUTPUT_BLT_PIXEL* DstB;
     DstB = UsbDisplayLinkDev->Screen + DestinationY * PixelsPerScanLine + DestinationX;
     for (H = 0; H < Height; H++) {
@@ -251,8 +272,82 @@ DlGopSendTestPattern (
 }
 
 
+/**
+ * Find the line after the last line of the screen that differs from the frame last sent to the DisplayLink device.
+ * Only the lines BLTted to since the last screen update are compared.
+ * @param UsbDisplayLinkDev
+ * @return The line after the last changed line, or LastY1 if no line has changed
+ */
+STATIC UINTN
+FindEndOfDamage (
+    IN USB_DISPLAYLINK_DEV* UsbDisplayLinkDev
+    )
+{
+  UINTN Width;
+  UINTN Line;
+
+  Width = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution;
+  Line = MIN (UsbDisplayLinkDev->LastY2, UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution);
+
+  while (Line > UsbDisplayLinkDev->LastY1) {
+    if (CompareMem (
+          UsbDisplayLinkDev->Screen + (Line - 1) * Width,
+          UsbDisplayLinkDev->ScreenSent + (Line - 1) * Width,
+          Width * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL)) != 0) {
+      break;
+    }
+    Line--;
+  }
+  return Line;
+}
+
+/**
+ * Convert lines of the back buffer to the 24 bits per pixel format of the DisplayLink device, into the transfer buffer.
+ * The lines converted are copied to the copy of the frame last sent to the device.
+ * @param UsbDisplayLinkDev
+ * @param Line            First line to convert
+ * @param Lines           Number of lines to convert, at most DISPLAYLINK_TRANSFER_BUFFER_LINES
+ */
+STATIC VOID
+ConvertLines (
+    IN USB_DISPLAYLINK_DEV* UsbDisplayLinkDev,
+    IN UINTN Line,
+    IN UINTN Lines
+    )
+{
+  UINTN Width;
+  UINTN Pixels;
+
+  Width = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution;
+  Pixels = Width * Lines;
+
+  // Need to swap round the RGB values
+  PixelConvertFromBlt (
+    &UsbDisplayLinkDev->PixelConvertFormat,
+    UsbDisplayLinkDev->TransferBuffer,
+    UsbDisplayLinkDev->Screen + Line * Width,
+    Pixels);
+
+  if (UsbDisplayLinkDev->ScreenSent != NULL) {
+    CopyMem (
+      UsbDisplayLinkDev->ScreenSent + Line * Width,
+      UsbDisplayLinkDev->Screen + Line * Width,
+      Pixels * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+  }
+}
+
 /**
  * Transfer the latest copy of the Blt buffer over USB to the DisplayLink device
+ *
+ * The DisplayLink device is sent the lines of a frame in order, from the top of the screen, and keeps the lines
+ * below the end of a short frame (as it does when a transfer fails part way through a frame). So a partial screen
+ * update stops after the last line that differs from the frame last sent, and is not sent at all if no line differs.
+ *
+ * The lines are converted DISPLAYLINK_TRANSFER_BUFFER_LINES at a time at TPL_NOTIFY, so no BLT changes them while they
+ * are converted, and then transferred at the TPL of the caller. The caller is the TPL_CALLBACK periodic timer, and UsbIo
+ * raises to TPL_NOTIFY for each bulk transfer, so only TPL_NOTIFY event notifications run during a frame, and only
+ * between line transfers; code at TPL_APPLICATION still waits for the whole frame to be sent.
+ * A BLT during the transfers is sent in the next screen update.
  * @param UsbDisplayLinkDev
  * @return
  */
@@ -263,83 +358,112 @@ DlGopSendScreenUpdate (
 {
   EFI_STATUS Status;
   UINT32 USBStatus;
+  BOOLEAN FullScreen;
+  EFI_TPL OriginalTPL;
+  UINTN DataLen;
+  UINTN Height;
+  UINTN EndOfFrame;
+  UINTN FirstBlttedLine;
+  UINTN Line;
+  UINTN Lines;
+  UINTN Index;
+  UINT8* DstPtr;
+
   Status = EFI_SUCCESS;
 
-  // If it has been a while since we sent an update, send a full screen.
+  if (UsbDisplayLinkDev->TransferBuffer == NULL) {
+    return EFI_NOT_READY;
+  }
+
+  OriginalTPL = gBS->RaiseTPL (TPL_NOTIFY);
+
+  // If it has been a while since we sent a full screen, send one.
   // This allows us to update a hot-plugged monitor quickly.
-  if (UsbDisplayLinkDev->TimeSinceLastScreenUpdate > DISPLAYLINK_FULL_SCREEN_UPDATE_PERIOD) {
+  UsbDisplayLinkDev->TimeSinceLastScreenUpdate += (DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 1000);  // Convert us to ms
+  FullScreen = (UsbDisplayLinkDev->TimeSinceLastScreenUpdate > DISPLAYLINK_FULL_SCREEN_UPDATE_PERIOD);
+  if (FullScreen) {
     UsbDisplayLinkDev->LastY1 = 0;
-    UsbDisplayLinkDev->LastY2 = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution - 1;
+    UsbDisplayLinkDev->LastY2 = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution;
   }
 
   // If there has been no BLT since the last update/poll, drop out quietly.
-  if (UsbDisplayLinkDev->LastY2 < UsbDisplayLinkDev->LastY1) {
-    UsbDisplayLinkDev->TimeSinceLastScreenUpdate += (DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 1000);  // Convert us to ms
+  if (UsbDisplayLinkDev->LastY2 <= UsbDisplayLinkDev->LastY1) {
+    gBS->RestoreTPL (OriginalTPL);
     return EFI_SUCCESS;
   }
 
-  UsbDisplayLinkDev->TimeSinceLastScreenUpdate = 0;
+  DataLen = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution * 3; // Send 1 line @ 24 bits per pixel
+  Height = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution;
 
-  EFI_TPL OriginalTPL = gBS->RaiseTPL (TPL_NOTIFY);
+  EndOfFrame = Height;
+  if (!FullScreen && !UsbDisplayLinkDev->FullFrameUpdates && (UsbDisplayLinkDev->ScreenSent != NULL)) {
+    EndOfFrame = FindEndOfDamage (UsbDisplayLinkDev);
+  }
 
-  UINTN DataLen;
-  UINTN Width;
-  UINTN Height;
-  EFI_GRAPHICS_OUTPUT_BLT_PIXEL* SrcPtr;
-  UINT8* DstPtr;
-  UINT8 DstBuffer[1920 * 3]; // Get rid of the magic numbers at some point
-                             // Could also use a buffer allocated at runtime to store the line, stored in the USB_DISPLAYLINK_DEV structure.
-  UINTN H;
+  // Reset the values that store which area of the screen has been BLTted to. The BLTs from now on are sent in the
+  // next screen update.
+  FirstBlttedLine = UsbDisplayLinkDev->LastY1;
+  UsbDisplayLinkDev->LastY2 = 0;
+  UsbDisplayLinkDev->LastY1 = (UINTN)-1;
 
-  DataLen = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution * 3; // Send 1 line @ 24 bits per pixel
-  Width = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->HorizontalResolution;
-  Height = UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info->VerticalResolution;
-  SrcPtr = UsbDisplayLinkDev->Screen;
-  DstPtr = DstBuffer;
-
-  for (H = 0; H < Height; H++) {
-    DstPtr = DstBuffer;
-
-    UINTN W;
-    for (W = 0; W < Width; W++) {
-      // Need to swap round the RGB values
-      DstPtr[0] = ((UINT8 *)SrcPtr)[2];
-      DstPtr[1] = ((UINT8 *)SrcPtr)[1];
-      DstPtr[2] = ((UINT8 *)SrcPtr)[0];
-      SrcPtr++;
-      DstPtr += 3;
-    }
+  // The BLTs since the last update have left the screen as it was, so there is nothing to send.
+  if (EndOfFrame <= FirstBlttedLine) {
+    UsbDisplayLinkDev->DataSaved += DataLen * Height;
+    gBS->RestoreTPL (OriginalTPL);
+    return EFI_SUCCESS;
+  }
 
-    Status = DlUsbBulkWrite (UsbDisplayLinkDev, DstBuffer, DataLen, &USBStatus);
+  if (FullScreen) {
+    UsbDisplayLinkDev->TimeSinceLastScreenUpdate = 0;
+  }
 
-    // USBStatus values defined in usbio.h, e.g. EFI_USB_ERR_TIMEOUT 0x40
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "Screen update - USB bulk transfer of pixel data failed. Line %d len %d, failure code %r USB status x%x\n", H, DataLen, Status, USBStatus));
-      break;
-    }
-    // Need an extra DlUsbBulkWrite if the data length is divisible by USB MaxPacketSize. This spare data will just get written into the (invisible) stride area.
-    // Note that the API doesn't let us do a bulk write of 0.
-    if ((DataLen & (UsbDisplayLinkDev->BulkOutEndpointDescriptor.MaxPacketSize - 1)) == 0) {
-      Status = DlUsbBulkWrite (UsbDisplayLinkDev, DstBuffer, 2, &USBStatus);
+  gBS->RestoreTPL (OriginalTPL);
+
+  for (Line = 0; Line < EndOfFrame; Line += Lines) {
+    Lines = MIN (DISPLAYLINK_TRANSFER_BUFFER_LINES, EndOfFrame - Line);
+
+    OriginalTPL = gBS->RaiseTPL (TPL_NOTIFY);
+    ConvertLines (UsbDisplayLinkDev, Line, Lines);
+    gBS->RestoreTPL (OriginalTPL);
+
+    DstPtr = UsbDisplayLinkDev->TransferBuffer;
+    for (Index = 0; Index < Lines; Index++) {
+      Status = DlUsbBulkWrite (UsbDisplayLinkDev, DstPtr, DataLen, &USBStatus);
+
+      // USBStatus values defined in usbio.h, e.g. EFI_USB_ERR_TIMEOUT 0x40
       if (EFI_ERROR (Status)) {
-        DEBUG ((DEBUG_ERROR, "Screen update - USB bulk transfer of pixel data failed. Line %d len %d, failure code %r USB status x%x\n", H, DataLen, Status, USBStatus));
+        DEBUG ((DEBUG_ERROR, "Screen update - USB bulk transfer of pixel data failed. Line %d len %d, failure code %r USB status x%x\n", Line + Index, DataLen, Status, USBStatus));
         break;
       }
+      UsbDisplayLinkDev->DataSent += DataLen;
+      // Need an extra DlUsbBulkWrite if the data length is divisible by USB MaxPacketSize. This spare data will just get written into the (invisible) stride area.
+      // Note that the API doesn't let us do a bulk write of 0.
+      if ((DataLen & (UsbDisplayLinkDev->BulkOutEndpointDescriptor.MaxPacketSize - 1)) == 0) {
+        Status = DlUsbBulkWrite (UsbDisplayLinkDev, DstPtr, 2, &USBStatus);
+        if (EFI_ERROR (Status)) {
+          DEBUG ((DEBUG_ERROR, "Screen update - USB bulk transfer of pixel data failed. Line %d len %d, failure code %r USB status x%x\n", Line + Index, DataLen, Status, USBStatus));
+          break;
+        }
+      }
+      DstPtr += DataLen;
+    }
+
+    if (EFI_ERROR (Status)) {
+      break;
     }
   }
 
   if (!EFI_ERROR (Status)) {
-    // If we've successfully transmitted the frame, reset the values that store which area of the screen has been BLTted to.
-    // If we haven't succeeded, this will mean we'll try to resend it after the next poll period.
-    UsbDisplayLinkDev->LastY2 = 0;
-    UsbDisplayLinkDev->LastY1 = (UINTN)-1;
+    UsbDisplayLinkDev->DataSaved += DataLen * (Height - EndOfFrame);
+  } else {
+    // If we haven't succeeded, the device may not have the lines that have been converted, so send a full screen
+    // after the next poll period.
+    UsbDisplayLinkDev->TimeSinceLastScreenUpdate = DISPLAYLINK_FULL_SCREEN_UPDATE_PERIOD;
   }
 
   // Payload with length of 1 to terminate the frame
   // We need to do this even if we had an error, to indicate to the DL device that it should now expect a new frame.
-  DlUsbBulkWrite (UsbDisplayLinkDev, DstBuffer, 1, &USBStatus);
-
-  gBS->RestoreTPL (OriginalTPL);
+  DlUsbBulkWrite (UsbDisplayLinkDev, UsbDisplayLinkDev->TransferBuffer, 1, &USBStatus);
 
   return Status;
 }
@@ -485,6 +609,39 @@ DisplayLinkSetMode (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  //
+  // Allocate the copy of the frame last sent to the device. Without it, every screen update sends the whole frame.
+  //
+  if (UsbDisplayLinkDev->ScreenSent != NULL) {
+    FreePool (UsbDisplayLinkDev->ScreenSent);
+    UsbDisplayLinkDev->ScreenSent = NULL;
+  }
+
+  if (!UsbDisplayLinkDev->FullFrameUpdates) {
+    UsbDisplayLinkDev->ScreenSent = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL*)AllocatePool (
+      Gop->Mode->Info->HorizontalResolution *
+      Gop->Mode->Info->VerticalResolution *
+      sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+  }
+
+  //
+  // Allocate the buffer the lines are converted into for the USB transfers
+  //
+  if (UsbDisplayLinkDev->TransferBuffer != NULL) {
+    FreePool (UsbDisplayLinkDev->TransferBuffer);
+  }
+
+  UsbDisplayLinkDev->TransferBuffer = (UINT8*)AllocatePool (
+    Gop->Mode->Info->HorizontalResolution * 3 *
+    MIN (Gop->Mode->Info->VerticalResolution, DISPLAYLINK_TRANSFER_BUFFER_LINES));
+
+  if (UsbDisplayLinkDev->TransferBuffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = PixelConvertConfigure (&UsbDisplayLinkDev->PixelConvertFormat, PixelBitMask, &mDlRgb888PixelMasks);
+  ASSERT_EFI_ERROR (Status);
+
   DEBUG ((DEBUG_INFO, "Video mode %d selected by BIOS - %d x %d.\n", ModeNumber, VideoMode->HActive, VideoMode->VActive));
   // Wait until we are sure that we can set the video mode before we tell the firmware
   Status = DlUsbSendControlWriteMessage (UsbDisplayLinkDev, SET_VIDEO_MODE, 0, VideoMode, sizeof (struct VideoMode));
@@ -506,6 +663,8 @@ DisplayLinkSetMode (
       Gop->Mode->Info->VerticalResolution,
       Gop->Mode->Info->HorizontalResolution * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL),
       Gop->Mode->Info->HorizontalResolution);
+    // The device has no copy of this frame yet, so the next screen update must send all of it.
+    UsbDisplayLinkDev->TimeSinceLastScreenUpdate = DISPLAYLINK_FULL_SCREEN_UPDATE_PERIOD;
     // unlock the DisplayLinkPeriodicTimer
     Gop->Mode->Mode = ModeNumber;
   }
@@ -532,8 +532,11 @@ DisplayLinkPeriodicTimer (
     STATIC UINTN Count = 0;
 
     if (Count++ % 50 == 0) {
-      DlGopPrintTextToScreen (&UsbDisplayLinkDev->GraphicsOutputProtocol, 32, 48, (CONST CHAR16*)L"  Bandwidth: %d MB/s    ", UsbDisplayLinkDev->DataSent * 10000000 / DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 50 / 1024 / 1024);
+      DlGopPrintTextToScreen (&UsbDisplayLinkDev->GraphicsOutputProtocol, 32, 48, (CONST CHAR16*)L"  Bandwidth: %d MB/s  Saved: %d MB/s    ",
+        UsbDisplayLinkDev->DataSent * 10000000 / DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 50 / 1024 / 1024,
+        UsbDisplayLinkDev->DataSaved * 10000000 / DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD / 50 / 1024 / 1024);
       UsbDisplayLinkDev->DataSent = 0;
+      UsbDisplayLinkDev->DataSaved = 0;
     }
   }
 
@@ -671,6 +674,7 @@ UsbDisplayLinkDriverBindingStart (
 
   UsbDisplayLinkDev->ShowBandwidth = ReadEnvironmentBool (L"DisplayLinkShowBandwidth", FALSE);
   UsbDisplayLinkDev->ShowTestPattern = ReadEnvironmentBool (L"DisplayLinkShowTestPatterns", FALSE);
+  UsbDisplayLinkDev->FullFrameUpdates = ReadEnvironmentBool (L"DisplayLinkFullFrameUpdates", FALSE);
 
   //
   // Open USB I/O Protocol
@@ -1065,6 +1069,16 @@ UsbDisplayLinkDriverBindingStop (
     UsbDisplayLinkDev->Screen = NULL;
   }
 
+  if (UsbDisplayLinkDev->ScreenSent != NULL) {
+    FreePool (UsbDisplayLinkDev->ScreenSent);
+    UsbDisplayLinkDev->ScreenSent = NULL;
+  }
+
+  if (UsbDisplayLinkDev->TransferBuffer != NULL) {
+    FreePool (UsbDisplayLinkDev->TransferBuffer);
+    UsbDisplayLinkDev->TransferBuffer = NULL;
+  }
+
   if (UsbDisplayLinkDev->GraphicsOutputProtocol.Mode) {
     if (UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info) {
       FreePool (UsbDisplayLinkDev->GraphicsOutputProtocol.Mode->Info);
@@ -23,6 +23,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PixelConvertLib.h>
 #include <Library/ReportStatusCodeLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
@@ -40,7 +41,9 @@
 #define DISPLAYLINK_USB_BULK_TIMEOUT  (1)
 
 #define DISPLAYLINK_SCREEN_UPDATE_TIMER_PERIOD  ((UINTN)1000000) // 0.1s in us
-#define DISPLAYLINK_FULL_SCREEN_UPDATE_PERIOD   ((UINTN)30000) // 3s in ticks
+#define DISPLAYLINK_FULL_SCREEN_UPDATE_PERIOD   ((UINTN)30000) // 3s in ticks, partial screen updates are sent in between
+
+#define DISPLAYLINK_TRANSFER_BUFFER_LINES       ((UINTN)32) // Lines converted at a time for a screen update
 
 #define DISPLAYLINK_FIXED_VERTICAL_REFRESH_RATE ((UINT16)60)
 
@@ -80,13 +83,18 @@ typedef struct {
   EFI_EDID_ACTIVE_PROTOCOL      EdidActive;
   EFI_UNICODE_STRING_TABLE      *ControllerNameTable;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL *Screen;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL *ScreenSent;                   /** Copy of the frame last sent to the device, used to find the lines that changed */
+  UINT8                         *TransferBuffer;               /** Lines converted to the pixel format of the device, for the USB transfers */
+  PIXEL_CONVERT_FORMAT          PixelConvertFormat;            /** Conversion of the lines to the 24-bit RGB pixel format of the device */
   UINTN                         DataSent;                       /** Debug - used to track the bandwidth */
+  UINTN                         DataSaved;                     /** Debug - used to track the bandwidth saved by partial screen updates */
   EFI_EVENT                     TimerEvent;
   EFI_EVENT                     DriverExitBootServicesEvent;
   BOOLEAN                       ShowBandwidth;                 /** Debugging - show the bandwidth on the screen */
   BOOLEAN                       ShowTestPattern;               /** Show a colourbar pattern instead of the BLTd contents of the framebuffer */
-  UINTN                         LastY1;                        /** Used to track if we can do a partial screen update */
-  UINTN                         LastY2;
+  BOOLEAN                       FullFrameUpdates;              /** Always send the whole frame instead of a partial screen update */
+  UINTN                         LastY1;                        /** First line BLTted to since the last screen update */
+  UINTN                         LastY2;                        /** Line after the last line BLTted to since the last screen update */
   UINTN                         LastWidth;
   UINTN                         TimeSinceLastScreenUpdate;     /** Do a full screen update every (x) seconds */
 } USB_DISPLAYLINK_DEV;
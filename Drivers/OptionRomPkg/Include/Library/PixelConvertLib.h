@@ -0,0 +1,110 @@
+/** @file
+  Library to convert pixels between EFI_GRAPHICS_OUTPUT_BLT_PIXEL and the
+  pixel formats of frame buffers and display devices.
+
+  The conversions use the SIMD instructions of the CPU where there are
+  kernels for them (SSE2 and SSSE3 on X64, NEON on AArch64), and convert one
+  pixel at a time otherwise.
+
+  Copyright (c) 2023, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __PIXEL_CONVERT_LIB__
+#define __PIXEL_CONVERT_LIB__
+
+#include <Protocol/GraphicsOutput.h>
+
+///
+/// A pixel format, set up by PixelConvertConfigure (). The fields are private
+/// to the library, and the assembly kernels depend on their layout.
+///
+typedef struct {
+  EFI_PIXEL_BITMASK    PixelBitMask;
+  UINT32               PixelShl[4];    // R-G-B-Rsvd
+  UINT32               PixelShr[4];    // R-G-B-Rsvd
+  UINT32               BytesPerPixel;
+  UINT32               FromBltKernel;
+  UINT32               ToBltKernel;
+} PIXEL_CONVERT_FORMAT;
+
+/**
+  Set up the conversion of pixels between EFI_GRAPHICS_OUTPUT_BLT_PIXEL and
+  a pixel format.
+
+  @param[out] Format            The conversion to set up.
+  @param[in]  PixelFormat       The pixel format.
+  @param[in]  PixelInformation  The bit masks of the pixel format, used only
+                                when PixelFormat is PixelBitMask.
+
+  @retval  EFI_INVALID_PARAMETER - Invalid pixel format or bit masks
+  @retval  EFI_UNSUPPORTED - PixelFormat is PixelBltOnly
+  @retval  EFI_SUCCESS - The conversion is set up
+
+**/
+EFI_STATUS
+EFIAPI
+PixelConvertConfigure (
+  OUT PIXEL_CONVERT_FORMAT                 *Format,
+  IN  EFI_GRAPHICS_PIXEL_FORMAT            PixelFormat,
+  IN  CONST EFI_PIXEL_BITMASK              *PixelInformation OPTIONAL
+  );
+
+/**
+  Return the size of a pixel of a pixel format.
+
+  @param[in]  Format  The conversion set up by PixelConvertConfigure ().
+
+  @return The number of bytes per pixel.
+
+**/
+UINTN
+EFIAPI
+PixelConvertBytesPerPixel (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format
+  );
+
+/**
+  Convert pixels from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to a pixel format.
+
+  The bits of a pixel outside the red, green and blue masks are cleared,
+  except for PixelBlueGreenRedReserved8BitPerColor, which is copied as is.
+
+  @param[in]  Format       The conversion set up by PixelConvertConfigure ().
+  @param[out] Destination  The converted pixels, BytesPerPixel bytes each.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+**/
+VOID
+EFIAPI
+PixelConvertFromBlt (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format,
+  OUT VOID                                 *Destination,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN  UINTN                                Pixels
+  );
+
+/**
+  Convert pixels from a pixel format to EFI_GRAPHICS_OUTPUT_BLT_PIXEL.
+
+  The Reserved byte of the converted pixels is cleared, except for
+  PixelBlueGreenRedReserved8BitPerColor, which is copied as is.
+
+  @param[in]  Format       The conversion set up by PixelConvertConfigure ().
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert, BytesPerPixel bytes each.
+  @param[in]  Pixels       The number of pixels.
+
+**/
+VOID
+EFIAPI
+PixelConvertToBlt (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *Destination,
+  IN  CONST VOID                           *Source,
+  IN  UINTN                                Pixels
+  );
+
+#endif
@@ -0,0 +1,184 @@
+/** @file
+  Internal definitions of the pixel conversion kernels.
+
+  Copyright (c) 2023, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __PIXEL_CONVERT_INTERNAL__
+#define __PIXEL_CONVERT_INTERNAL__
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/PixelConvertLib.h>
+
+//
+// The kernels of PIXEL_CONVERT_FORMAT.FromBltKernel and ToBltKernel
+//
+#define PIXEL_CONVERT_KERNEL_BIT_MASK             0   // Any bit mask format, a pixel at a time
+#define PIXEL_CONVERT_KERNEL_COPY                 1   // BGRX, copied as is
+#define PIXEL_CONVERT_KERNEL_RGB888               2   // Packed 24-bit RGB, from BLT only
+#define PIXEL_CONVERT_KERNEL_BIT_MASK32_SIMD      3   // 32-bit bit mask formats
+#define PIXEL_CONVERT_KERNEL_SWAP_RED_BLUE_SIMD   4   // RGBX
+#define PIXEL_CONVERT_KERNEL_RGB888_SIMD          5   // Packed 24-bit RGB, from BLT only
+
+//
+// The SIMD kernels InternalPixelConvertSimdSupport () reports for this CPU
+//
+#define PIXEL_CONVERT_SIMD_BIT_MASK32             BIT0
+#define PIXEL_CONVERT_SIMD_SWAP_RED_BLUE          BIT1
+#define PIXEL_CONVERT_SIMD_RGB888                 BIT2
+
+/**
+  Convert pixels from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to a bit mask format,
+  a pixel at a time.
+
+  @param[in]  Format       The conversion.
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+**/
+VOID
+InternalPixelBltToBitMask (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format,
+  OUT VOID                                 *Destination,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN  UINTN                                Pixels
+  );
+
+/**
+  Convert pixels from a bit mask format to EFI_GRAPHICS_OUTPUT_BLT_PIXEL,
+  a pixel at a time.
+
+  @param[in]  Format       The conversion.
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+**/
+VOID
+InternalPixelBitMaskToBlt (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *Destination,
+  IN  CONST VOID                           *Source,
+  IN  UINTN                                Pixels
+  );
+
+/**
+  Convert pixels from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to packed 24-bit RGB,
+  a pixel at a time.
+
+  @param[out] Destination  The converted pixels, 3 bytes each.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+**/
+VOID
+InternalPixelBltToRgb888 (
+  OUT UINT8                                *Destination,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN  UINTN                                Pixels
+  );
+
+/**
+  Report the SIMD kernels this CPU can run.
+
+  @return PIXEL_CONVERT_SIMD_* bits of the kernels.
+
+**/
+UINT32
+InternalPixelConvertSimdSupport (
+  VOID
+  );
+
+//
+// The SIMD kernels convert the pixels that fill their vectors, and return
+// the number of pixels converted. The caller converts the rest.
+//
+
+/**
+  Convert pixels from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to a 32-bit bit mask
+  format. Must only be called if PIXEL_CONVERT_SIMD_BIT_MASK32 is supported.
+
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+  @param[in]  Format       The conversion.
+
+  @return The number of pixels converted.
+
+**/
+UINTN
+EFIAPI
+InternalPixelBltToBitMask32Simd (
+  OUT UINT32                               *Destination,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN  UINTN                                Pixels,
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format
+  );
+
+/**
+  Convert pixels from a 32-bit bit mask format to EFI_GRAPHICS_OUTPUT_BLT_PIXEL.
+  Must only be called if PIXEL_CONVERT_SIMD_BIT_MASK32 is supported.
+
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+  @param[in]  Format       The conversion.
+
+  @return The number of pixels converted.
+
+**/
+UINTN
+EFIAPI
+InternalPixelBitMask32ToBltSimd (
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *Destination,
+  IN  CONST UINT32                         *Source,
+  IN  UINTN                                Pixels,
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format
+  );
+
+/**
+  Swap the red and blue bytes of 32-bit pixels and clear the fourth byte,
+  which converts between BGRX and RGBX either way. Must only be called if
+  PIXEL_CONVERT_SIMD_SWAP_RED_BLUE is supported.
+
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+  @return The number of pixels converted.
+
+**/
+UINTN
+EFIAPI
+InternalPixelSwapRedBlueSimd (
+  OUT UINT32                               *Destination,
+  IN  CONST UINT32                         *Source,
+  IN  UINTN                                Pixels
+  );
+
+/**
+  Convert pixels from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to packed 24-bit RGB.
+  Must only be called if PIXEL_CONVERT_SIMD_RGB888 is supported.
+
+  @param[out] Destination  The converted pixels, 3 bytes each.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+  @return The number of pixels converted.
+
+**/
+UINTN
+EFIAPI
+InternalPixelBltToRgb888Simd (
+  OUT UINT8                                *Destination,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN  UINTN                                Pixels
+  );
+
+#endif
@@ -0,0 +1,413 @@
+/** @file
+  PixelConvertLib - Library to convert pixels between EFI_GRAPHICS_OUTPUT_BLT_PIXEL
+  and the pixel formats of frame buffers and display devices.
+
+  A conversion picks its kernels when it is set up: a SIMD kernel for the
+  common formats when the CPU has one, and the generic shift and mask of a
+  pixel at a time otherwise. The SIMD kernels leave the pixels that do not
+  fill a vector to the generic kernels.
+
+  Copyright (c) 2023, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "PixelConvertInternal.h"
+
+//
+// The assembly kernels read the masks and the shifts at these offsets.
+//
+STATIC_ASSERT (OFFSET_OF (PIXEL_CONVERT_FORMAT, PixelBitMask) == 0, "PixelBitMask offset");
+STATIC_ASSERT (OFFSET_OF (PIXEL_CONVERT_FORMAT, PixelShl) == 16, "PixelShl offset");
+STATIC_ASSERT (OFFSET_OF (PIXEL_CONVERT_FORMAT, PixelShr) == 32, "PixelShr offset");
+
+/**
+  Convert a pixel from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to a bit mask format.
+
+  @param[in]  Format  The conversion.
+  @param[in]  Pixel   The pixel.
+
+  @return The converted pixel.
+
+**/
+STATIC
+UINT32
+BltToBitMaskPixel (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format,
+  IN  UINT32                               Pixel
+  )
+{
+  return (((Pixel << Format->PixelShl[0]) >> Format->PixelShr[0]) & Format->PixelBitMask.RedMask) |
+         (((Pixel << Format->PixelShl[1]) >> Format->PixelShr[1]) & Format->PixelBitMask.GreenMask) |
+         (((Pixel << Format->PixelShl[2]) >> Format->PixelShr[2]) & Format->PixelBitMask.BlueMask);
+}
+
+/**
+  Convert a pixel from a bit mask format to EFI_GRAPHICS_OUTPUT_BLT_PIXEL.
+
+  @param[in]  Format  The conversion.
+  @param[in]  Pixel   The pixel.
+
+  @return The converted pixel.
+
+**/
+STATIC
+UINT32
+BitMaskToBltPixel (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format,
+  IN  UINT32                               Pixel
+  )
+{
+  return (((Pixel & Format->PixelBitMask.RedMask)   >> Format->PixelShl[0]) << Format->PixelShr[0]) |
+         (((Pixel & Format->PixelBitMask.GreenMask) >> Format->PixelShl[1]) << Format->PixelShr[1]) |
+         (((Pixel & Format->PixelBitMask.BlueMask)  >> Format->PixelShl[2]) << Format->PixelShr[2]);
+}
+
+/**
+  Convert pixels from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to a bit mask format,
+  a pixel at a time.
+
+  @param[in]  Format       The conversion.
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+**/
+VOID
+InternalPixelBltToBitMask (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format,
+  OUT VOID                                 *Destination,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN  UINTN                                Pixels
+  )
+{
+  CONST UINT32  *Src;
+  UINT8         *Dst;
+  UINT32        Pixel;
+  UINTN         Index;
+
+  Src = (CONST UINT32 *) Source;
+  Dst = (UINT8 *) Destination;
+
+  switch (Format->BytesPerPixel) {
+  case 4:
+    for (Index = 0; Index < Pixels; Index++) {
+      ((UINT32 *) Dst)[Index] = BltToBitMaskPixel (Format, Src[Index]);
+    }
+    break;
+  case 3:
+    for (Index = 0; Index < Pixels; Index++) {
+      Pixel  = BltToBitMaskPixel (Format, Src[Index]);
+      Dst[0] = (UINT8) Pixel;
+      Dst[1] = (UINT8) (Pixel >> 8);
+      Dst[2] = (UINT8) (Pixel >> 16);
+      Dst   += 3;
+    }
+    break;
+  case 2:
+    for (Index = 0; Index < Pixels; Index++) {
+      ((UINT16 *) Dst)[Index] = (UINT16) BltToBitMaskPixel (Format, Src[Index]);
+    }
+    break;
+  default:
+    for (Index = 0; Index < Pixels; Index++) {
+      Pixel = BltToBitMaskPixel (Format, Src[Index]);
+      CopyMem (Dst, &Pixel, Format->BytesPerPixel);
+      Dst += Format->BytesPerPixel;
+    }
+    break;
+  }
+}
+
+/**
+  Convert pixels from a bit mask format to EFI_GRAPHICS_OUTPUT_BLT_PIXEL,
+  a pixel at a time.
+
+  @param[in]  Format       The conversion.
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+**/
+VOID
+InternalPixelBitMaskToBlt (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *Destination,
+  IN  CONST VOID                           *Source,
+  IN  UINTN                                Pixels
+  )
+{
+  CONST UINT8   *Src;
+  UINT32        *Dst;
+  UINT32        Pixel;
+  UINTN         Index;
+
+  Src = (CONST UINT8 *) Source;
+  Dst = (UINT32 *) Destination;
+
+  switch (Format->BytesPerPixel) {
+  case 4:
+    for (Index = 0; Index < Pixels; Index++) {
+      Dst[Index] = BitMaskToBltPixel (Format, ((CONST UINT32 *) Src)[Index]);
+    }
+    break;
+  case 3:
+    for (Index = 0; Index < Pixels; Index++) {
+      Pixel      = (UINT32) (Src[0] | (Src[1] << 8) | (Src[2] << 16));
+      Dst[Index] = BitMaskToBltPixel (Format, Pixel);
+      Src       += 3;
+    }
+    break;
+  case 2:
+    for (Index = 0; Index < Pixels; Index++) {
+      Dst[Index] = BitMaskToBltPixel (Format, ((CONST UINT16 *) Src)[Index]);
+    }
+    break;
+  default:
+    for (Index = 0; Index < Pixels; Index++) {
+      Pixel = 0;
+      CopyMem (&Pixel, Src, Format->BytesPerPixel);
+      Dst[Index] = BitMaskToBltPixel (Format, Pixel);
+      Src += Format->BytesPerPixel;
+    }
+    break;
+  }
+}
+
+/**
+  Convert pixels from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to packed 24-bit RGB,
+  a pixel at a time.
+
+  @param[out] Destination  The converted pixels, 3 bytes each.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+**/
+VOID
+InternalPixelBltToRgb888 (
+  OUT UINT8                                *Destination,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN  UINTN                                Pixels
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Pixels; Index++) {
+    Destination[0] = Source[Index].Red;
+    Destination[1] = Source[Index].Green;
+    Destination[2] = Source[Index].Blue;
+    Destination += 3;
+  }
+}
+
+/**
+  Set up the conversion of pixels between EFI_GRAPHICS_OUTPUT_BLT_PIXEL and
+  a pixel format.
+
+  @param[out] Format            The conversion to set up.
+  @param[in]  PixelFormat       The pixel format.
+  @param[in]  PixelInformation  The bit masks of the pixel format, used only
+                                when PixelFormat is PixelBitMask.
+
+  @retval  EFI_INVALID_PARAMETER - Invalid pixel format or bit masks
+  @retval  EFI_UNSUPPORTED - PixelFormat is PixelBltOnly
+  @retval  EFI_SUCCESS - The conversion is set up
+
+**/
+EFI_STATUS
+EFIAPI
+PixelConvertConfigure (
+  OUT PIXEL_CONVERT_FORMAT                 *Format,
+  IN  EFI_GRAPHICS_PIXEL_FORMAT            PixelFormat,
+  IN  CONST EFI_PIXEL_BITMASK              *PixelInformation OPTIONAL
+  )
+{
+  STATIC CONST EFI_PIXEL_BITMASK  RgbPixelMasks =
+    { 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 };
+  STATIC CONST EFI_PIXEL_BITMASK  BgrPixelMasks =
+    { 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 };
+  CONST EFI_PIXEL_BITMASK  *BitMask;
+  CONST UINT32             *Masks;
+  UINT32                   MergedMasks;
+  INTN                     Shift;
+  UINTN                    Loop;
+  UINT32                   Simd;
+  BOOLEAN                  RgbMasks;
+
+  switch (PixelFormat) {
+  case PixelRedGreenBlueReserved8BitPerColor:
+    BitMask = &RgbPixelMasks;
+    break;
+  case PixelBlueGreenRedReserved8BitPerColor:
+    BitMask = &BgrPixelMasks;
+    break;
+  case PixelBitMask:
+    if (PixelInformation == NULL) {
+      return EFI_INVALID_PARAMETER;
+    }
+    BitMask = PixelInformation;
+    break;
+  case PixelBltOnly:
+    return EFI_UNSUPPORTED;
+  default:
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (Format, sizeof (*Format));
+
+  MergedMasks = 0;
+  Masks = (CONST UINT32 *) BitMask;
+  for (Loop = 0; Loop < 3; Loop++) {
+    if ((Masks[Loop] == 0) || ((MergedMasks & Masks[Loop]) != 0)) {
+      return EFI_INVALID_PARAMETER;
+    }
+    Shift = HighBitSet32 (Masks[Loop]) - 23 + (INTN) (Loop * 8);
+    if (Shift < 0) {
+      Format->PixelShr[Loop] = (UINT32) -Shift;
+    } else {
+      Format->PixelShl[Loop] = (UINT32) Shift;
+    }
+    MergedMasks = (UINT32) (MergedMasks | Masks[Loop]);
+    DEBUG ((DEBUG_INFO, "%d: shl:%d shr:%d mask:%x\n", Loop, Format->PixelShl[Loop], Format->PixelShr[Loop], Masks[Loop]));
+  }
+  MergedMasks = (UINT32) (MergedMasks | Masks[3]);
+
+  Format->BytesPerPixel = (UINT32) ((HighBitSet32 (MergedMasks) + 7) / 8);
+  CopyMem (&Format->PixelBitMask, BitMask, sizeof (*BitMask));
+
+  DEBUG ((DEBUG_INFO, "Bytes per pixel: %d\n", Format->BytesPerPixel));
+
+  //
+  // Pick the kernels. The generic kernels of PIXEL_CONVERT_KERNEL_BIT_MASK
+  // are left by ZeroMem ().
+  //
+  Simd = InternalPixelConvertSimdSupport ();
+  RgbMasks = (BOOLEAN) ((BitMask->RedMask == RgbPixelMasks.RedMask) &&
+                        (BitMask->GreenMask == RgbPixelMasks.GreenMask) &&
+                        (BitMask->BlueMask == RgbPixelMasks.BlueMask));
+
+  if (PixelFormat == PixelBlueGreenRedReserved8BitPerColor) {
+    Format->FromBltKernel = PIXEL_CONVERT_KERNEL_COPY;
+    Format->ToBltKernel   = PIXEL_CONVERT_KERNEL_COPY;
+  } else if ((Format->BytesPerPixel == 4) && RgbMasks && ((Simd & PIXEL_CONVERT_SIMD_SWAP_RED_BLUE) != 0)) {
+    Format->FromBltKernel = PIXEL_CONVERT_KERNEL_SWAP_RED_BLUE_SIMD;
+    Format->ToBltKernel   = PIXEL_CONVERT_KERNEL_SWAP_RED_BLUE_SIMD;
+  } else if ((Format->BytesPerPixel == 4) && ((Simd & PIXEL_CONVERT_SIMD_BIT_MASK32) != 0)) {
+    Format->FromBltKernel = PIXEL_CONVERT_KERNEL_BIT_MASK32_SIMD;
+    Format->ToBltKernel   = PIXEL_CONVERT_KERNEL_BIT_MASK32_SIMD;
+  } else if ((Format->BytesPerPixel == 3) && RgbMasks) {
+    if ((Simd & PIXEL_CONVERT_SIMD_RGB888) != 0) {
+      Format->FromBltKernel = PIXEL_CONVERT_KERNEL_RGB888_SIMD;
+    } else {
+      Format->FromBltKernel = PIXEL_CONVERT_KERNEL_RGB888;
+    }
+  }
+
+  DEBUG ((DEBUG_INFO, "Kernels: from blt:%d to blt:%d\n", Format->FromBltKernel, Format->ToBltKernel));
+  return EFI_SUCCESS;
+}
+
+/**
+  Return the size of a pixel of a pixel format.
+
+  @param[in]  Format  The conversion set up by PixelConvertConfigure ().
+
+  @return The number of bytes per pixel.
+
+**/
+UINTN
+EFIAPI
+PixelConvertBytesPerPixel (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format
+  )
+{
+  return Format->BytesPerPixel;
+}
+
+/**
+  Convert pixels from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to a pixel format.
+
+  The bits of a pixel outside the red, green and blue masks are cleared,
+  except for PixelBlueGreenRedReserved8BitPerColor, which is copied as is.
+
+  @param[in]  Format       The conversion set up by PixelConvertConfigure ().
+  @param[out] Destination  The converted pixels, BytesPerPixel bytes each.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+**/
+VOID
+EFIAPI
+PixelConvertFromBlt (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format,
+  OUT VOID                                 *Destination,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN  UINTN                                Pixels
+  )
+{
+  UINTN  Converted;
+
+  Converted = 0;
+  switch (Format->FromBltKernel) {
+  case PIXEL_CONVERT_KERNEL_COPY:
+    CopyMem (Destination, Source, Pixels * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    return;
+  case PIXEL_CONVERT_KERNEL_BIT_MASK32_SIMD:
+    Converted = InternalPixelBltToBitMask32Simd (Destination, Source, Pixels, Format);
+    break;
+  case PIXEL_CONVERT_KERNEL_SWAP_RED_BLUE_SIMD:
+    Converted = InternalPixelSwapRedBlueSimd (Destination, (CONST UINT32 *) Source, Pixels);
+    break;
+  case PIXEL_CONVERT_KERNEL_RGB888_SIMD:
+    Converted = InternalPixelBltToRgb888Simd (Destination, Source, Pixels);
+    break;
+  }
+
+  Destination = (UINT8 *) Destination + Converted * Format->BytesPerPixel;
+  if ((Format->FromBltKernel == PIXEL_CONVERT_KERNEL_RGB888) ||
+      (Format->FromBltKernel == PIXEL_CONVERT_KERNEL_RGB888_SIMD)) {
+    InternalPixelBltToRgb888 (Destination, Source + Converted, Pixels - Converted);
+  } else {
+    InternalPixelBltToBitMask (Format, Destination, Source + Converted, Pixels - Converted);
+  }
+}
+
+/**
+  Convert pixels from a pixel format to EFI_GRAPHICS_OUTPUT_BLT_PIXEL.
+
+  The Reserved byte of the converted pixels is cleared, except for
+  PixelBlueGreenRedReserved8BitPerColor, which is copied as is.
+
+  @param[in]  Format       The conversion set up by PixelConvertConfigure ().
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert, BytesPerPixel bytes each.
+  @param[in]  Pixels       The number of pixels.
+
+**/
+VOID
+EFIAPI
+PixelConvertToBlt (
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format,
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *Destination,
+  IN  CONST VOID                           *Source,
+  IN  UINTN                                Pixels
+  )
+{
+  UINTN  Converted;
+
+  Converted = 0;
+  switch (Format->ToBltKernel) {
+  case PIXEL_CONVERT_KERNEL_COPY:
+    CopyMem (Destination, Source, Pixels * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+    return;
+  case PIXEL_CONVERT_KERNEL_BIT_MASK32_SIMD:
+    Converted = InternalPixelBitMask32ToBltSimd (Destination, Source, Pixels, Format);
+    break;
+  case PIXEL_CONVERT_KERNEL_SWAP_RED_BLUE_SIMD:
+    Converted = InternalPixelSwapRedBlueSimd ((UINT32 *) Destination, Source, Pixels);
+    break;
+  }
+
+  Source = (CONST UINT8 *) Source + Converted * Format->BytesPerPixel;
+  InternalPixelBitMaskToBlt (Format, Destination + Converted, Source, Pixels - Converted);
+}
@@ -0,0 +1,119 @@
+/** @file
+  Pixel conversion for architectures without SIMD kernels
+
+  Copyright (c) 2023, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "PixelConvertInternal.h"
+
+/**
+  Report the SIMD kernels this CPU can run.
+
+  @return PIXEL_CONVERT_SIMD_* bits of the kernels.
+
+**/
+UINT32
+InternalPixelConvertSimdSupport (
+  VOID
+  )
+{
+  return 0;
+}
+
+/**
+  Convert pixels from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to a 32-bit bit mask
+  format. This architecture has no SIMD kernels, so it's never used.
+
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+  @param[in]  Format       The conversion.
+
+  @return The number of pixels converted.
+
+**/
+UINTN
+EFIAPI
+InternalPixelBltToBitMask32Simd (
+  OUT UINT32                               *Destination,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN  UINTN                                Pixels,
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format
+  )
+{
+  ASSERT (FALSE);
+  return 0;
+}
+
+/**
+  Convert pixels from a 32-bit bit mask format to EFI_GRAPHICS_OUTPUT_BLT_PIXEL.
+  This architecture has no SIMD kernels, so it's never used.
+
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+  @param[in]  Format       The conversion.
+
+  @return The number of pixels converted.
+
+**/
+UINTN
+EFIAPI
+InternalPixelBitMask32ToBltSimd (
+  OUT EFI_GRAPHICS_OUTPUT_BLT_PIXEL        *Destination,
+  IN  CONST UINT32                         *Source,
+  IN  UINTN                                Pixels,
+  IN  CONST PIXEL_CONVERT_FORMAT           *Format
+  )
+{
+  ASSERT (FALSE);
+  return 0;
+}
+
+/**
+  Swap the red and blue bytes of 32-bit pixels and clear the fourth byte.
+  This architecture has no SIMD kernels, so it's never used.
+
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+  @return The number of pixels converted.
+
+**/
+UINTN
+EFIAPI
+InternalPixelSwapRedBlueSimd (
+  OUT UINT32                               *Destination,
+  IN  CONST UINT32                         *Source,
+  IN  UINTN                                Pixels
+  )
+{
+  ASSERT (FALSE);
+  return 0;
+}
+
+/**
+  Convert pixels from EFI_GRAPHICS_OUTPUT_BLT_PIXEL to packed 24-bit RGB.
+  This architecture has no SIMD kernels, so it's never used.
+
+  @param[out] Destination  The converted pixels, 3 bytes each.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+
+  @return The number of pixels converted.
+
+**/
+UINTN
+EFIAPI
+InternalPixelBltToRgb888Simd (
+  OUT UINT8                                *Destination,
+  IN  CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL  *Source,
+  IN  UINTN                                Pixels
+  )
+{
+  ASSERT (FALSE);
+  return 0;
+}
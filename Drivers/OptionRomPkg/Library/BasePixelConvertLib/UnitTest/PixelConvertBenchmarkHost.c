@@ -0,0 +1,320 @@
+/** @file
+  Throughput benchmark of the pixel conversion kernels of BasePixelConvertLib,
+  run from a host environment.
+
+  Every conversion is measured with the generic kernel, which converts a
+  pixel at a time, and with the other kernels the library can pick for the
+  pixel format on this CPU. Every output is compared with the output of the
+  generic kernel, for a line of pixels and for the short lines that end in
+  the pixels the SIMD kernels leave to the generic kernel.
+
+  Copyright (c) 2023, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <time.h>
+
+#include "../PixelConvertInternal.h"
+#include <Library/MemoryAllocationLib.h>
+
+//
+// Each measurement converts the line until this much time has elapsed.
+//
+#define BENCHMARK_MIN_SECONDS  0.5
+
+//
+// A 1080p line, and the short lines that are checked
+//
+#define BENCHMARK_LINE_PIXELS  1920
+#define CHECK_MAX_PIXELS       40
+
+typedef struct {
+  CONST CHAR8                  *Name;
+  EFI_GRAPHICS_PIXEL_FORMAT    PixelFormat;
+  EFI_PIXEL_BITMASK            PixelInformation;
+} BENCHMARK_PIXEL_FORMAT;
+
+typedef struct {
+  CONST CHAR8    *Name;
+  UINT32         Kernel;
+  UINT32         Simd;      // PIXEL_CONVERT_SIMD_* bit the kernel needs, 0 if none
+  BOOLEAN        ToBlt;     // The kernel converts to EFI_GRAPHICS_OUTPUT_BLT_PIXEL too
+} BENCHMARK_KERNEL;
+
+STATIC CONST BENCHMARK_PIXEL_FORMAT  mPixelFormats[] = {
+  { "RGBX",        PixelRedGreenBlueReserved8BitPerColor, { 0 } },
+  { "A2R10G10B10", PixelBitMask, { 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000 } },
+  { "RGB888",      PixelBitMask, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0x00000000 } },
+  { "R5G6B5",      PixelBitMask, { 0x0000f800, 0x000007e0, 0x0000001f, 0x00000000 } }
+};
+
+STATIC CONST BENCHMARK_KERNEL  mKernels[] = {
+  { "generic",       PIXEL_CONVERT_KERNEL_BIT_MASK,           0,                                TRUE  },
+  { "rgb888",        PIXEL_CONVERT_KERNEL_RGB888,             0,                                FALSE },
+  { "simd bitmask",  PIXEL_CONVERT_KERNEL_BIT_MASK32_SIMD,    PIXEL_CONVERT_SIMD_BIT_MASK32,    TRUE  },
+  { "simd swap",     PIXEL_CONVERT_KERNEL_SWAP_RED_BLUE_SIMD, PIXEL_CONVERT_SIMD_SWAP_RED_BLUE, TRUE  },
+  { "simd rgb888",   PIXEL_CONVERT_KERNEL_RGB888_SIMD,        PIXEL_CONVERT_SIMD_RGB888,        FALSE }
+};
+
+/**
+  Checks whether a kernel can convert a pixel format on this CPU.
+
+  @param[in]  Format   The conversion of the pixel format.
+  @param[in]  Kernel   The kernel.
+  @param[in]  Simd     PIXEL_CONVERT_SIMD_* bits of this CPU.
+
+  @retval     TRUE     The kernel can convert the pixel format.
+  @retval     FALSE    The kernel cannot convert the pixel format.
+**/
+BOOLEAN
+KernelApplies (
+  IN  CONST PIXEL_CONVERT_FORMAT  *Format,
+  IN  CONST BENCHMARK_KERNEL      *Kernel,
+  IN  UINT32                      Simd
+  )
+{
+  BOOLEAN  RgbMasks;
+
+  if ((Kernel->Simd & Simd) != Kernel->Simd) {
+    return FALSE;
+  }
+
+  RgbMasks = (BOOLEAN)((Format->PixelBitMask.RedMask == 0x000000ff) &&
+                       (Format->PixelBitMask.GreenMask == 0x0000ff00) &&
+                       (Format->PixelBitMask.BlueMask == 0x00ff0000));
+
+  switch (Kernel->Kernel) {
+    case PIXEL_CONVERT_KERNEL_BIT_MASK32_SIMD:
+      return (BOOLEAN)(Format->BytesPerPixel == 4);
+    case PIXEL_CONVERT_KERNEL_SWAP_RED_BLUE_SIMD:
+      return (BOOLEAN)((Format->BytesPerPixel == 4) && RgbMasks);
+    case PIXEL_CONVERT_KERNEL_RGB888:
+    case PIXEL_CONVERT_KERNEL_RGB888_SIMD:
+      return (BOOLEAN)((Format->BytesPerPixel == 3) && RgbMasks);
+    default:
+      return TRUE;
+  }
+}
+
+/**
+  Converts pixels with a kernel.
+
+  @param[in]  Format       The conversion, of the generic kernel.
+  @param[in]  Kernel       The kernel.
+  @param[in]  ToBlt        TRUE to convert to EFI_GRAPHICS_OUTPUT_BLT_PIXEL.
+  @param[out] Destination  The converted pixels.
+  @param[in]  Source       The pixels to convert.
+  @param[in]  Pixels       The number of pixels.
+**/
+VOID
+Convert (
+  IN  CONST PIXEL_CONVERT_FORMAT  *Format,
+  IN  UINT32                      Kernel,
+  IN  BOOLEAN                     ToBlt,
+  OUT VOID                        *Destination,
+  IN  CONST VOID                  *Source,
+  IN  UINTN                       Pixels
+  )
+{
+  PIXEL_CONVERT_FORMAT  KernelFormat;
+
+  KernelFormat               = *Format;
+  KernelFormat.FromBltKernel = Kernel;
+  KernelFormat.ToBltKernel   = Kernel;
+  if (ToBlt) {
+    PixelConvertToBlt (&KernelFormat, Destination, Source, Pixels);
+  } else {
+    PixelConvertFromBlt (&KernelFormat, Destination, Source, Pixels);
+  }
+}
+
+/**
+  Checks that a kernel converts alike the generic kernel.
+
+  @param[in]  Format     The conversion, of the generic kernel.
+  @param[in]  Kernel     The kernel.
+  @param[in]  ToBlt      TRUE to convert to EFI_GRAPHICS_OUTPUT_BLT_PIXEL.
+  @param[in]  Source     BENCHMARK_LINE_PIXELS pixels to convert.
+  @param[in]  Expected   Buffer for the output of the generic kernel.
+  @param[in]  Actual     Buffer for the output of the kernel.
+
+  @retval     TRUE       The outputs are alike.
+  @retval     FALSE      The outputs differ.
+**/
+BOOLEAN
+VerifyKernel (
+  IN  CONST PIXEL_CONVERT_FORMAT  *Format,
+  IN  UINT32                      Kernel,
+  IN  BOOLEAN                     ToBlt,
+  IN  CONST UINT8                 *Source,
+  IN  UINT8                       *Expected,
+  IN  UINT8                       *Actual
+  )
+{
+  UINTN  Pixels;
+  UINTN  Size;
+
+  for (Pixels = 0; Pixels <= CHECK_MAX_PIXELS; Pixels++) {
+    Size = Pixels * (ToBlt ? sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL) : Format->BytesPerPixel);
+
+    //
+    // The byte after the pixels must be left as is.
+    //
+    SetMem (Expected, Size + 1, 0x5A);
+    SetMem (Actual, Size + 1, 0x5A);
+    Convert (Format, PIXEL_CONVERT_KERNEL_BIT_MASK, ToBlt, Expected, Source + 4 * Pixels, Pixels);
+    Convert (Format, Kernel, ToBlt, Actual, Source + 4 * Pixels, Pixels);
+    if (CompareMem (Expected, Actual, Size + 1) != 0) {
+      return FALSE;
+    }
+  }
+
+  Size = BENCHMARK_LINE_PIXELS * (ToBlt ? sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL) : Format->BytesPerPixel);
+  Convert (Format, PIXEL_CONVERT_KERNEL_BIT_MASK, ToBlt, Expected, Source, BENCHMARK_LINE_PIXELS);
+  Convert (Format, Kernel, ToBlt, Actual, Source, BENCHMARK_LINE_PIXELS);
+  return (BOOLEAN)(CompareMem (Expected, Actual, Size) == 0);
+}
+
+/**
+  Measures a kernel and prints its throughput.
+
+  @param[in]  Format        The conversion, of the generic kernel.
+  @param[in]  Kernel        The kernel.
+  @param[in]  ToBlt         TRUE to convert to EFI_GRAPHICS_OUTPUT_BLT_PIXEL.
+  @param[in]  Source        BENCHMARK_LINE_PIXELS pixels to convert.
+  @param[in]  Destination   Buffer for the converted pixels.
+  @param[in]  GenericSpeed  Throughput of the generic kernel in MB/s, or 0 for
+                            the generic kernel.
+  @param[out] Speed         Pointer to receive the throughput in MB/s.
+**/
+VOID
+RunTest (
+  IN  CONST PIXEL_CONVERT_FORMAT  *Format,
+  IN  CONST BENCHMARK_KERNEL      *Kernel,
+  IN  BOOLEAN                     ToBlt,
+  IN  CONST UINT8                 *Source,
+  IN  UINT8                       *Destination,
+  IN  double                      GenericSpeed,
+  OUT double                      *Speed
+  )
+{
+  UINTN    Iterations;
+  clock_t  Start;
+  double   Seconds;
+
+  Iterations = 0;
+  Start      = clock ();
+  do {
+    Convert (Format, Kernel->Kernel, ToBlt, Destination, Source, BENCHMARK_LINE_PIXELS);
+    Iterations++;
+    Seconds = (double)(clock () - Start) / CLOCKS_PER_SEC;
+  } while (Seconds < BENCHMARK_MIN_SECONDS);
+
+  //
+  // The throughput is of EFI_GRAPHICS_OUTPUT_BLT_PIXEL, either way.
+  //
+  *Speed = (double)BENCHMARK_LINE_PIXELS * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL) * Iterations / Seconds / 1000000;
+  printf (
+    "  %-8s %-14s %10.2f %8.2fx\n",
+    ToBlt ? "to blt" : "from blt",
+    Kernel->Name,
+    *Speed,
+    (GenericSpeed != 0) ? *Speed / GenericSpeed : 1.0
+    );
+}
+
+/**
+  Runs the benchmark.
+
+  Usage: PixelConvertBenchmarkHost
+
+  @param[in]  Argc  Number of arguments.
+  @param[in]  Argv  Arguments.
+
+  @retval     0     All the kernels converted alike the generic kernel.
+  @retval     1     A kernel converted differently, or out of memory.
+**/
+int
+main (
+  int   Argc,
+  char  *Argv[]
+  )
+{
+  PIXEL_CONVERT_FORMAT  Format;
+  UINT8                 *Source;
+  UINT8                 *Expected;
+  UINT8                 *Actual;
+  UINTN                 BufferSize;
+  UINTN                 FormatIndex;
+  UINTN                 KernelIndex;
+  UINTN                 Index;
+  UINTN                 Direction;
+  BOOLEAN               ToBlt;
+  UINT32                Simd;
+  UINT32                Seed;
+  double                GenericSpeed;
+  double                Speed;
+  int                   Result;
+
+  BufferSize = (BENCHMARK_LINE_PIXELS + CHECK_MAX_PIXELS) * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL) * 2;
+  Source     = AllocatePool (BufferSize);
+  Expected   = AllocatePool (BufferSize);
+  Actual     = AllocatePool (BufferSize);
+  if ((Source == NULL) || (Expected == NULL) || (Actual == NULL)) {
+    printf ("Out of memory\n");
+    return 1;
+  }
+
+  Seed = 0x12345678;
+  for (Index = 0; Index < BufferSize; Index++) {
+    Seed          = Seed * 1103515245 + 12345;
+    Source[Index] = (UINT8)(Seed >> 16);
+  }
+
+  Simd = InternalPixelConvertSimdSupport ();
+  printf ("SIMD kernels: bitmask %s, swap %s, rgb888 %s\n",
+    ((Simd & PIXEL_CONVERT_SIMD_BIT_MASK32) != 0) ? "yes" : "no",
+    ((Simd & PIXEL_CONVERT_SIMD_SWAP_RED_BLUE) != 0) ? "yes" : "no",
+    ((Simd & PIXEL_CONVERT_SIMD_RGB888) != 0) ? "yes" : "no"
+    );
+
+  Result = 0;
+  for (FormatIndex = 0; FormatIndex < ARRAY_SIZE (mPixelFormats); FormatIndex++) {
+    if (EFI_ERROR (PixelConvertConfigure (&Format, mPixelFormats[FormatIndex].PixelFormat, &mPixelFormats[FormatIndex].PixelInformation))) {
+      printf ("Cannot configure %s\n", mPixelFormats[FormatIndex].Name);
+      Result = 1;
+      continue;
+    }
+
+    printf ("%s, %u bytes per pixel\n", mPixelFormats[FormatIndex].Name, (unsigned)Format.BytesPerPixel);
+    printf ("  %-8s %-14s %10s %9s\n", "", "Kernel", "MB/s", "Speedup");
+    for (Direction = 0; Direction < 2; Direction++) {
+      ToBlt        = (BOOLEAN)(Direction != 0);
+      GenericSpeed = 0;
+      for (KernelIndex = 0; KernelIndex < ARRAY_SIZE (mKernels); KernelIndex++) {
+        if ((ToBlt && !mKernels[KernelIndex].ToBlt) ||
+            !KernelApplies (&Format, &mKernels[KernelIndex], Simd))
+        {
+          continue;
+        }
+
+        if (!VerifyKernel (&Format, mKernels[KernelIndex].Kernel, ToBlt, Source, Expected, Actual)) {
+          printf ("  %s %s converts differently\n", ToBlt ? "to blt" : "from blt", mKernels[KernelIndex].Name);
+          Result = 1;
+        }
+
+        RunTest (&Format, &mKernels[KernelIndex], ToBlt, Source, Actual, GenericSpeed, &Speed);
+        if (mKernels[KernelIndex].Kernel == PIXEL_CONVERT_KERNEL_BIT_MASK) {
+          GenericSpeed = Speed;
+        }
+      }
+    }
+  }
+
+  FreePool (Source);
+  FreePool (Expected);
+  FreePool (Actual);
+  return Result;
+}
@@ -0,0 +1,35 @@
+/** @file
+  SIMD pixel conversion kernel detection for X64
+
+  Copyright (c) 2023, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include "../PixelConvertInternal.h"
+
+// CPUID.01h:ECX.SSSE3[bit 9]
+#define PIXEL_CONVERT_CPUID_SSSE3  BIT9
+
+/**
+  Report the SIMD kernels this CPU can run. Every X64 CPU has SSE2, the
+  byte shuffles need SSSE3.
+
+  @return PIXEL_CONVERT_SIMD_* bits of the kernels.
+
+**/
+UINT32
+InternalPixelConvertSimdSupport (
+  VOID
+  )
+{
+  UINT32  Ecx;
+
+  AsmCpuid (1, NULL, NULL, &Ecx, NULL);
+
+  if ((Ecx & PIXEL_CONVERT_CPUID_SSSE3) == 0) {
+    return PIXEL_CONVERT_SIMD_BIT_MASK32;
+  }
+
+  return PIXEL_CONVERT_SIMD_BIT_MASK32 | PIXEL_CONVERT_SIMD_SWAP_RED_BLUE | PIXEL_CONVERT_SIMD_RGB888;
+}
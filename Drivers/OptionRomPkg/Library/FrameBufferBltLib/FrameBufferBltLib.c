@@ -11,6 +11,7 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/BltLib.h>
 #include <Library/DebugLib.h>
+#include <Library/PixelConvertLib.h>
 
 #if 0
 #define VDEBUG DEBUG
@@ -28,44 +29,7 @@ UINTN                           mBltLibHeight;
 UINT8                           mBltLibLineBuffer[MAX_LINE_BUFFER_SIZE];
 UINT8                           *mBltLibFrameBuffer;
 EFI_GRAPHICS_PIXEL_FORMAT       mPixelFormat;
-EFI_PIXEL_BITMASK               mPixelBitMasks;
-INTN                            mPixelShl[4]; // R-G-B-Rsvd
-INTN                            mPixelShr[4]; // R-G-B-Rsvd
-
-
-VOID
-ConfigurePixelBitMaskFormat (
-  IN EFI_PIXEL_BITMASK          *BitMask
-  )
-{
-  UINTN   Loop;
-  UINT32  *Masks;
-  UINT32  MergedMasks;
-
-  MergedMasks = 0;
-  Masks = (UINT32*) BitMask;
-  for (Loop = 0; Loop < 3; Loop++) {
-    ASSERT ((Loop == 3) || (Masks[Loop] != 0));
-    ASSERT ((MergedMasks & Masks[Loop]) == 0);
-    mPixelShl[Loop] = HighBitSet32 (Masks[Loop]) - 23 + (Loop * 8);
-    if (mPixelShl[Loop] < 0) {
-      mPixelShr[Loop] = -mPixelShl[Loop];
-      mPixelShl[Loop] = 0;
-    } else {
-      mPixelShr[Loop] = 0;
-    }
-    MergedMasks = (UINT32) (MergedMasks | Masks[Loop]);
-    DEBUG ((DEBUG_INFO, "%d: shl:%d shr:%d mask:%x\n", Loop, mPixelShl[Loop], mPixelShr[Loop], Masks[Loop]));
-  }
-  MergedMasks = (UINT32) (MergedMasks | Masks[3]);
-
-  ASSERT (MergedMasks != 0);
-  mBltLibBytesPerPixel = (UINTN) ((HighBitSet32 (MergedMasks) + 7) / 8);
-
-  DEBUG ((DEBUG_INFO, "Bytes per pixel: %d\n", mBltLibBytesPerPixel));
-
-  CopyMem (&mPixelBitMasks, BitMask, sizeof (*BitMask));
-}
+PIXEL_CONVERT_FORMAT            mPixelConvertFormat;
 
 
 /**
@@ -86,29 +50,19 @@ BltLibConfigure (
   IN  EFI_GRAPHICS_OUTPUT_MODE_INFORMATION *FrameBufferInfo
   )
 {
-  STATIC EFI_PIXEL_BITMASK  RgbPixelMasks =
-    { 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 };
-  STATIC EFI_PIXEL_BITMASK  BgrPixelMasks =
-    { 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 };
-
-  switch (FrameBufferInfo->PixelFormat) {
-  case PixelRedGreenBlueReserved8BitPerColor:
-    ConfigurePixelBitMaskFormat (&RgbPixelMasks);
-    break;
-  case PixelBlueGreenRedReserved8BitPerColor:
-    ConfigurePixelBitMaskFormat (&BgrPixelMasks);
-    break;
-  case PixelBitMask:
-    ConfigurePixelBitMaskFormat (&(FrameBufferInfo->PixelInformation));
-    break;
-  case PixelBltOnly:
-    ASSERT (FrameBufferInfo->PixelFormat != PixelBltOnly);
-    return EFI_UNSUPPORTED;
-  default:
-    ASSERT (FALSE);
-    return EFI_INVALID_PARAMETER;
+  EFI_STATUS  Status;
+
+  Status = PixelConvertConfigure (
+             &mPixelConvertFormat,
+             FrameBufferInfo->PixelFormat,
+             &FrameBufferInfo->PixelInformation
+             );
+  if (EFI_ERROR (Status)) {
+    ASSERT_EFI_ERROR (Status);
+    return Status;
   }
   mPixelFormat = FrameBufferInfo->PixelFormat;
+  mBltLibBytesPerPixel = PixelConvertBytesPerPixel (&mPixelConvertFormat);
 
   mBltLibFrameBuffer = (UINT8*) FrameBuffer;
   mBltLibWidthInPixels = (UINTN) FrameBufferInfo->HorizontalResolution;
@@ -233,7 +187,7 @@ BltLibVideoFill (
   VOID                            *BltMemDst;
   UINTN                           X;
   UINT8                           Uint8;
-  UINT32                          Uint32;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL   FillColor;
   UINT64                          WideFill;
   BOOLEAN                         UseWideFill;
   BOOLEAN                         LineBufferReady;
@@ -261,14 +215,15 @@ BltLibVideoFill (
 
   WidthInBytes = Width * mBltLibBytesPerPixel;
 
-  Uint32 = *(UINT32*) Color;
-  WideFill =
-    (UINT32) (
-        (((Uint32 << mPixelShl[0]) >> mPixelShr[0]) & mPixelBitMasks.RedMask) |
-        (((Uint32 << mPixelShl[1]) >> mPixelShr[1]) & mPixelBitMasks.GreenMask) |
-        (((Uint32 << mPixelShl[2]) >> mPixelShr[2]) & mPixelBitMasks.BlueMask)
-      );
-  VDEBUG ((DEBUG_INFO, "VideoFill: color=0x%x, wide-fill=0x%x\n", Uint32, WideFill));
+  //
+  // The reserved byte is never filled, clear it for the BGR format whose
+  // pixels are copied as is.
+  //
+  FillColor = *Color;
+  FillColor.Reserved = 0;
+  WideFill = 0;
+  PixelConvertFromBlt (&mPixelConvertFormat, &WideFill, &FillColor, 1);
+  VDEBUG ((DEBUG_INFO, "VideoFill: color=0x%x, wide-fill=0x%x\n", *(UINT32*) Color, WideFill));
 
   //
   // If the size of the pixel data evenly divides the sizeof
@@ -424,8 +379,6 @@ BltLibVideoToBltBufferEx (
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL   *Blt;
   VOID                            *BltMemSrc;
   VOID                            *BltMemDst;
-  UINTN                           X;
-  UINT32                          Uint32;
   UINTN                           Offset;
   UINTN                           WidthInBytes;
 
@@ -478,16 +431,8 @@ BltLibVideoToBltBufferEx (
     CopyMem (BltMemDst, BltMemSrc, WidthInBytes);
 
     if (mPixelFormat != PixelBlueGreenRedReserved8BitPerColor) {
-      for (X = 0; X < Width; X++) {
-        Blt         = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) ((UINT8 *) BltBuffer + (DstY * Delta) + (DestinationX + X) * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
-        Uint32 = *(UINT32*) (mBltLibLineBuffer + (X * mBltLibBytesPerPixel));
-        *(UINT32*) Blt =
-          (UINT32) (
-              (((Uint32 & mPixelBitMasks.RedMask)   >> mPixelShl[0]) << mPixelShr[0]) |
-              (((Uint32 & mPixelBitMasks.GreenMask) >> mPixelShl[1]) << mPixelShr[1]) |
-              (((Uint32 & mPixelBitMasks.BlueMask)  >> mPixelShl[2]) << mPixelShr[2])
-            );
-      }
+      Blt = (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) ((UINT8 *) BltBuffer + (DstY * Delta) + DestinationX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL));
+      PixelConvertToBlt (&mPixelConvertFormat, Blt, mBltLibLineBuffer, Width);
     }
   }
 
@@ -568,8 +513,6 @@ BltLibBufferToVideoEx (
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL   *Blt;
   VOID                            *BltMemSrc;
   VOID                            *BltMemDst;
-  UINTN                           X;
-  UINT32                          Uint32;
   UINTN                           Offset;
   UINTN                           WidthInBytes;
 
@@ -608,21 +551,13 @@ BltLibBufferToVideoEx (
     if (mPixelFormat == PixelBlueGreenRedReserved8BitPerColor) {
       BltMemSrc = (VOID *) ((UINT8 *) BltBuffer + (SrcY * Delta));
     } else {
-      for (X = 0; X < Width; X++) {
-        Blt =
-          (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) (
-              (UINT8 *) BltBuffer +
-              (SrcY * Delta) +
-              ((SourceX + X) * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL))
-            );
-        Uint32 = *(UINT32*) Blt;
-        *(UINT32*) (mBltLibLineBuffer + (X * mBltLibBytesPerPixel)) =
-          (UINT32) (
-              (((Uint32 << mPixelShl[0]) >> mPixelShr[0]) & mPixelBitMasks.RedMask) |
-              (((Uint32 << mPixelShl[1]) >> mPixelShr[1]) & mPixelBitMasks.GreenMask) |
-              (((Uint32 << mPixelShl[2]) >> mPixelShr[2]) & mPixelBitMasks.BlueMask)
-            );
-      }
+      Blt =
+        (EFI_GRAPHICS_OUTPUT_BLT_PIXEL *) (
+            (UINT8 *) BltBuffer +
+            (SrcY * Delta) +
+            (SourceX * sizeof (EFI_GRAPHICS_OUTPUT_BLT_PIXEL))
+          );
+      PixelConvertFromBlt (&mPixelConvertFormat, mBltLibLineBuffer, Blt, Width);
       BltMemSrc = (VOID *) mBltLibLineBuffer;
     }
 
@@ -0,0 +1,331 @@
+/** @file
+  Per-partition metadata block cache
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "Ext4Dxe.h"
+
+/**
+   Gets the hash bucket a block number belongs to.
+
+   @param[in]      Cache         Pointer to the block cache.
+   @param[in]      BlockNumber   Block number.
+
+   @return Pointer to the head of the bucket's list.
+**/
+STATIC
+LIST_ENTRY *
+Ext4BlockCacheBucket (
+  IN EXT4_BLOCK_CACHE  *Cache,
+  IN EXT4_BLOCK_NR     BlockNumber
+  )
+{
+  // NumberBuckets is always a power of 2
+  return &Cache->Buckets[(UINTN)BlockNumber & (Cache->NumberBuckets - 1)];
+}
+
+/**
+   Initialises the block cache of the partition.
+   The number of cached blocks is derived from PcdExt4BlockCacheSize and the
+   filesystem's block size; if not even a single block fits, the cache is
+   left disabled and every read goes straight to the disk.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+                                 Partition->BlockSize must already be valid.
+
+   @retval EFI_SUCCESS           The cache was initialised (or disabled).
+   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+EFI_STATUS
+Ext4InitBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_BLOCK_CACHE        *Cache;
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+  UINTN                   NumberEntries;
+  UINTN                   Index;
+
+  Cache = &Partition->BlockCache;
+
+  ZeroMem (Cache, sizeof (EXT4_BLOCK_CACHE));
+  InitializeListHead (&Cache->LruList);
+
+  NumberEntries = PcdGet32 (PcdExt4BlockCacheSize) / Partition->BlockSize;
+
+  if (NumberEntries == 0) {
+    DEBUG ((DEBUG_FS, "[ext4] Block cache disabled\n"));
+    return EFI_SUCCESS;
+  }
+
+  Cache->NumberBuckets = (UINTN)GetPowerOfTwo32 ((UINT32)NumberEntries);
+  if (Cache->NumberBuckets < NumberEntries) {
+    Cache->NumberBuckets <<= 1;
+  }
+
+  Cache->Entries = AllocateZeroPool (NumberEntries * sizeof (EXT4_BLOCK_CACHE_ENTRY));
+  Cache->Buckets = AllocatePool (Cache->NumberBuckets * sizeof (LIST_ENTRY));
+  Cache->Data    = AllocatePool (NumberEntries * Partition->BlockSize);
+
+  if ((Cache->Entries == NULL) || (Cache->Buckets == NULL) || (Cache->Data == NULL)) {
+    Ext4FreeBlockCache (Partition);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < Cache->NumberBuckets; Index++) {
+    InitializeListHead (&Cache->Buckets[Index]);
+  }
+
+  for (Index = 0; Index < NumberEntries; Index++) {
+    Entry        = &Cache->Entries[Index];
+    Entry->Data  = (CHAR8 *)Cache->Data + Index * Partition->BlockSize;
+    Entry->Valid = FALSE;
+    InitializeListHead (&Entry->HashNode);
+    InsertTailList (&Cache->LruList, &Entry->LruNode);
+  }
+
+  Cache->NumberEntries = NumberEntries;
+  Cache->MediaId       = EXT4_MEDIA_ID (Partition);
+
+  DEBUG ((DEBUG_FS, "[ext4] Block cache: %lu blocks\n", (UINT64)NumberEntries));
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Drops every block held by the partition's block cache.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4InvalidateBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_BLOCK_CACHE        *Cache;
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+  UINTN                   Index;
+
+  Cache = &Partition->BlockCache;
+
+  for (Index = 0; Index < Cache->NumberEntries; Index++) {
+    Entry = &Cache->Entries[Index];
+
+    if (Entry->Valid) {
+      RemoveEntryList (&Entry->HashNode);
+      InitializeListHead (&Entry->HashNode);
+      Entry->Valid = FALSE;
+    }
+  }
+
+  Cache->MediaId = EXT4_MEDIA_ID (Partition);
+}
+
+/**
+   Frees the partition's block cache.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4FreeBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_BLOCK_CACHE  *Cache;
+
+  Cache = &Partition->BlockCache;
+
+  DEBUG ((
+    DEBUG_FS,
+    "[ext4] Block cache: %lu hits, %lu misses\n",
+    Cache->Hits,
+    Cache->Misses
+    ));
+
+  if (Cache->Entries != NULL) {
+    FreePool (Cache->Entries);
+  }
+
+  if (Cache->Buckets != NULL) {
+    FreePool (Cache->Buckets);
+  }
+
+  if (Cache->Data != NULL) {
+    FreePool (Cache->Data);
+  }
+
+  ZeroMem (Cache, sizeof (EXT4_BLOCK_CACHE));
+  InitializeListHead (&Cache->LruList);
+}
+
+/**
+   Looks up a block in the block cache, reading it from disk on a miss.
+   The least recently used block is evicted to make room for it.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      BlockNumber   Block number.
+   @param[out]     Data          Pointer to where a pointer to the cached block's contents
+                                 will be stored. This pointer is only valid until the next
+                                 call into the block cache.
+
+   @return Status of the lookup.
+**/
+STATIC
+EFI_STATUS
+Ext4GetCachedBlock (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_BLOCK_NR   BlockNumber,
+  OUT VOID            **Data
+  )
+{
+  EXT4_BLOCK_CACHE        *Cache;
+  EXT4_BLOCK_CACHE_ENTRY  *Entry;
+  LIST_ENTRY              *Bucket;
+  LIST_ENTRY              *Node;
+  EFI_STATUS              Status;
+
+  Cache  = &Partition->BlockCache;
+  Bucket = Ext4BlockCacheBucket (Cache, BlockNumber);
+
+  BASE_LIST_FOR_EACH (Node, Bucket) {
+    Entry = EXT4_BLOCK_CACHE_ENTRY_FROM_HASH_NODE (Node);
+
+    if (Entry->BlockNumber == BlockNumber) {
+      // Move it to the front of the LRU list
+      RemoveEntryList (&Entry->LruNode);
+      InsertHeadList (&Cache->LruList, &Entry->LruNode);
+      Cache->Hits++;
+      *Data = Entry->Data;
+      return EFI_SUCCESS;
+    }
+  }
+
+  Cache->Misses++;
+
+  // Recycle the least recently used entry, which is always at the tail.
+  Entry = EXT4_BLOCK_CACHE_ENTRY_FROM_LRU_NODE (GetPreviousNode (&Cache->LruList, &Cache->LruList));
+
+  if (Entry->Valid) {
+    RemoveEntryList (&Entry->HashNode);
+    InitializeListHead (&Entry->HashNode);
+    Entry->Valid = FALSE;
+  }
+
+  Status = Ext4ReadBlocks (Partition, Entry->Data, 1, BlockNumber);
+
+  if (EFI_ERROR (Status)) {
+    // Leave the entry invalid, at the tail, so it gets recycled first.
+    return Status;
+  }
+
+  Entry->BlockNumber = BlockNumber;
+  Entry->Valid       = TRUE;
+  InsertHeadList (Bucket, &Entry->HashNode);
+
+  RemoveEntryList (&Entry->LruNode);
+  InsertHeadList (&Cache->LruList, &Entry->LruNode);
+
+  *Data = Entry->Data;
+  return EFI_SUCCESS;
+}
+
+/**
+   Reads from the partition's disk, going through the block cache.
+   Meant for filesystem metadata (inode tables, directories, extent trees), which
+   tends to be read over and over again in small chunks.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  Length         Length of the destination buffer.
+   @param[in]  Offset         Offset, in bytes, of the location to read.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadCachedDiskIo (
+  IN  EXT4_PARTITION  *Partition,
+  OUT VOID            *Buffer,
+  IN  UINTN           Length,
+  IN  UINT64          Offset
+  )
+{
+  EXT4_BLOCK_CACHE  *Cache;
+  EXT4_BLOCK_NR     BlockNumber;
+  UINT32            BlockOffset;
+  UINTN             ToCopy;
+  VOID              *Data;
+  EFI_STATUS        Status;
+
+  Cache = &Partition->BlockCache;
+
+  if (Cache->NumberEntries == 0) {
+    return Ext4ReadDiskIo (Partition, Buffer, Length, Offset);
+  }
+
+  // Our cached blocks are worthless if the media was swapped under us.
+  if (Cache->MediaId != EXT4_MEDIA_ID (Partition)) {
+    Ext4InvalidateBlockCache (Partition);
+  }
+
+  while (Length != 0) {
+    BlockNumber = DivU64x32Remainder (Offset, Partition->BlockSize, &BlockOffset);
+    ToCopy      = MIN (Length, Partition->BlockSize - BlockOffset);
+
+    Status = Ext4GetCachedBlock (Partition, BlockNumber, &Data);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    CopyMem (Buffer, (CONST CHAR8 *)Data + BlockOffset, ToCopy);
+
+    Buffer  = (CHAR8 *)Buffer + ToCopy;
+    Offset += ToCopy;
+    Length -= ToCopy;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Reads blocks from the partition's disk, going through the block cache.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  NumberBlocks   Length of the read, in filesystem blocks.
+   @param[in]  BlockNumber    Starting block number.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadCachedBlocks (
+  IN  EXT4_PARTITION  *Partition,
+  OUT VOID            *Buffer,
+  IN  UINTN           NumberBlocks,
+  IN  EXT4_BLOCK_NR   BlockNumber
+  )
+{
+  UINT64  Offset;
+  UINTN   Length;
+
+  ASSERT (NumberBlocks != 0);
+  ASSERT (BlockNumber != EXT4_BLOCK_FILE_HOLE);
+
+  Offset = MultU64x32 (BlockNumber, Partition->BlockSize);
+  Length = NumberBlocks * Partition->BlockSize;
+
+  // Check for overflow on the block -> byte conversions.
+  // Partition->BlockSize is never 0, so we don't need to check for that.
+
+  if (DivU64x64Remainder (Offset, BlockNumber, NULL) != Partition->BlockSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (Length / NumberBlocks != Partition->BlockSize) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  return Ext4ReadCachedDiskIo (Partition, Buffer, Length, Offset);
+}
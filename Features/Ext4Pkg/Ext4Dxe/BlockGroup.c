@@ -9,13 +9,137 @@
 
 #include "Ext4Dxe.h"
 
+/**
+   Sets up the block group descriptor table of the partition.
+   Descriptor blocks are only read (and verified) when a block group
+   in them is first needed, see Ext4GetBlockGroupDesc().
+
+   @param[in out]  Partition      Pointer to the ext4 partition.
+
+   @retval EFI_SUCCESS            The table was set up.
+   @retval EFI_OUT_OF_RESOURCES   The table could not be allocated.
+**/
+EFI_STATUS
+Ext4InitBlockGroupDescs (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  UINT64  NrBlocks;
+  UINT32  NrBlocksRem;
+
+  NrBlocks = DivU64x32Remainder (
+               MultU64x32 (Partition->NumberBlockGroups, Partition->DescSize),
+               Partition->BlockSize,
+               &NrBlocksRem
+               );
+
+  if (NrBlocksRem != 0) {
+    NrBlocks++;
+  }
+
+  if ((NrBlocks == 0) || (NrBlocks > MAX_UINTN / sizeof (VOID *))) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Partition->BlockGroupDescBlocks = AllocateZeroPool ((UINTN)NrBlocks * sizeof (VOID *));
+
+  if (Partition->BlockGroupDescBlocks == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Partition->NumberBlockGroupDescBlocks = (UINTN)NrBlocks;
+  // The descriptor table starts right after the superblock's block
+  Partition->BlockGroupDescStart = Partition->BlockSize == 1024 ? 2 : 1;
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Frees the block group descriptor table of the partition,
+   and every descriptor block that was loaded.
+
+   @param[in out]  Partition      Pointer to the ext4 partition.
+**/
+VOID
+Ext4FreeBlockGroupDescs (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  UINTN  Index;
+
+  if (Partition->BlockGroupDescBlocks == NULL) {
+    return;
+  }
+
+  for (Index = 0; Index < Partition->NumberBlockGroupDescBlocks; Index++) {
+    if (Partition->BlockGroupDescBlocks[Index] != NULL) {
+      FreePool (Partition->BlockGroupDescBlocks[Index]);
+    }
+  }
+
+  FreePool (Partition->BlockGroupDescBlocks);
+  Partition->BlockGroupDescBlocks       = NULL;
+  Partition->NumberBlockGroupDescBlocks = 0;
+}
+
+/**
+   Reads a block of the block group descriptor table, and checks the checksum
+   of every descriptor in it.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[in]  BlockIndex     Index of the block in the descriptor table.
+
+   @return A pointer to the block, or NULL if it could not be read or is corrupted.
+**/
+STATIC
+VOID *
+Ext4LoadBlockGroupDescBlock (
+  IN EXT4_PARTITION  *Partition,
+  IN UINTN           BlockIndex
+  )
+{
+  CHAR8   *Block;
+  UINT32  DescsPerBlock;
+  UINT32  Index;
+  UINT64  BlockGroup;
+
+  Block = Ext4AllocAndReadBlocks (Partition, 1, Partition->BlockGroupDescStart + BlockIndex);
+
+  if (Block == NULL) {
+    DEBUG ((DEBUG_ERROR, "[ext4] Error reading block group descriptor block %lu\n", (UINT64)BlockIndex));
+    return NULL;
+  }
+
+  DescsPerBlock = Partition->BlockSize / Partition->DescSize;
+  BlockGroup    = MultU64x32 (BlockIndex, DescsPerBlock);
+
+  // The table's last block may be partially used
+  for (Index = 0; Index < DescsPerBlock && BlockGroup < Partition->NumberBlockGroups; Index++, BlockGroup++) {
+    if (!Ext4VerifyBlockGroupDescChecksum (
+           Partition,
+           (EXT4_BLOCK_GROUP_DESC *)(Block + Index * Partition->DescSize),
+           (UINT32)BlockGroup
+           ))
+    {
+      DEBUG ((DEBUG_ERROR, "[ext4] Block group descriptor %lu has an invalid checksum\n", BlockGroup));
+      FreePool (Block);
+      return NULL;
+    }
+  }
+
+  Partition->BlockGroupDescBlocks[BlockIndex] = Block;
+  return Block;
+}
+
 /**
    Retrieves a block group descriptor of the ext4 filesystem.
+   The descriptor's block is read and verified the first time it's needed.
 
    @param[in]  Partition      Pointer to the opened ext4 partition.
    @param[in]  BlockGroup    Block group number.
 
-   @return A pointer to the block group descriptor.
+   @return A pointer to the block group descriptor, or NULL if the block group
+           number is invalid, or the descriptor could not be read or is corrupted.
 **/
 EXT4_BLOCK_GROUP_DESC *
 Ext4GetBlockGroupDesc (
@@ -23,8 +147,30 @@ Ext4GetBlockGroupDesc (
   IN UINT32          BlockGroup
   )
 {
-  // Maybe assert that the block group nr isn't a nonsense number?
-  return (EXT4_BLOCK_GROUP_DESC *)((CHAR8 *)Partition->BlockGroups + BlockGroup * Partition->DescSize);
+  UINT32  DescsPerBlock;
+  UINTN   BlockIndex;
+  CHAR8   *Block;
+
+  if (BlockGroup >= Partition->NumberBlockGroups) {
+    return NULL;
+  }
+
+  DescsPerBlock = Partition->BlockSize / Partition->DescSize;
+  BlockIndex    = BlockGroup / DescsPerBlock;
+
+  ASSERT (BlockIndex < Partition->NumberBlockGroupDescBlocks);
+
+  Block = Partition->BlockGroupDescBlocks[BlockIndex];
+
+  if (Block == NULL) {
+    Block = Ext4LoadBlockGroupDescBlock (Partition, BlockIndex);
+
+    if (Block == NULL) {
+      return NULL;
+    }
+  }
+
+  return (EXT4_BLOCK_GROUP_DESC *)(Block + (BlockGroup % DescsPerBlock) * Partition->DescSize);
 }
 
 /**
@@ -72,8 +218,19 @@ Ext4ReadInode (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  // Cached inodes were already validated when they were first read
+  if (Ext4GetCachedInode (Partition, InodeNum, Inode)) {
+    *OutIno = Inode;
+    return EFI_SUCCESS;
+  }
+
   BlockGroup = Ext4GetBlockGroupDesc (Partition, BlockGroupNumber);
 
+  if (BlockGroup == NULL) {
+    FreePool (Inode);
+    return EFI_VOLUME_CORRUPTED;
+  }
+
   // Note: We'll need to check INODE_UNINIT and friends when/if we add write support
 
   InodeTableStart = EXT4_BLOCK_NR_FROM_HALFS (
@@ -82,7 +239,7 @@ Ext4ReadInode (
                       BlockGroup->bg_inode_table_hi
                       );
 
-  Status = Ext4ReadDiskIo (
+  Status = Ext4ReadCachedDiskIo (
              Partition,
              Inode,
              Partition->InodeSize,
@@ -114,6 +271,8 @@ Ext4ReadInode (
     return EFI_VOLUME_CORRUPTED;
   }
 
+  Ext4CacheInode (Partition, InodeNum, Inode);
+
   *OutIno = Inode;
   return EFI_SUCCESS;
 }
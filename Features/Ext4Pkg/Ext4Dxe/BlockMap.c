@@ -115,7 +115,7 @@ Ext4GetBlockPath (
       BlockPath[2]  = LogicalBlock % Entries;
       break;
     case EXT4_TYPE_TREBLY_BLOCK:
-      BlockPath[0]  = EXT4_DIND_BLOCK;
+      BlockPath[0]  = EXT4_TIND_BLOCK;
       LogicalBlock -= MinTreblyBlock;
       BlockPath[1]  = LogicalBlock / EntriesEntries;
       BlockPath[2]  = (LogicalBlock % EntriesEntries) / Entries;
@@ -207,7 +207,7 @@ Ext4GetExtentInBlockMap (
    @param[out]     Extent        Pointer to the output buffer, where the extent will be copied to.
 
    @retval EFI_SUCCESS        Retrieval was successful.
-   @retval EFI_NO_MAPPING     Block has no mapping.
+   @retval EFI_NO_MAPPING     Block has no mapping. Extent describes the hole.
 **/
 EFI_STATUS
 Ext4GetBlocks (
@@ -232,6 +232,7 @@ Ext4GetBlocks (
 
   if (BlockPathLength - 1 == EXT4_TYPE_BAD_BLOCK) {
     // Bad logical block (out of range)
+    Ext4SetHoleExtent (Extent, LogicalBlock, LogicalBlock + 1);
     return EFI_NO_MAPPING;
   }
 
@@ -261,10 +262,11 @@ Ext4GetBlocks (
 
     if (Block == EXT4_BLOCK_FILE_HOLE) {
       FreePool (Buffer);
+      Ext4SetHoleExtent (Extent, LogicalBlock, LogicalBlock + 1);
       return EFI_NO_MAPPING;
     }
 
-    Status = Ext4ReadBlocks (Partition, Buffer, 1, Block);
+    Status = Ext4ReadCachedBlocks (Partition, Buffer, 1, Block);
 
     if (EFI_ERROR (Status)) {
       FreePool (Buffer);
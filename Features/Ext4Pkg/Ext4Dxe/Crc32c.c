@@ -0,0 +1,138 @@
+/** @file
+  CRC32C engine used for metadata checksums
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "Crc32c.h"
+
+// Reversed CRC32C (Castagnoli) polynomial
+#define EXT4_CRC32C_POLY  0x82F63B78U
+
+//
+// mExt4Crc32cTable[0] is the classic byte-at-a-time table; mExt4Crc32cTable[N]
+// gives the contribution of a byte that still has N bytes to go through the CRC
+// after it, which lets us fold 8 bytes per iteration (slicing-by-8).
+//
+STATIC UINT32   mExt4Crc32cTable[8][256];
+STATIC BOOLEAN  mExt4Crc32cUseHw;
+
+/**
+   Initialises the CRC32C engine: builds the slicing-by-8 tables and picks
+   the CRC32C instructions if the CPU has them.
+   Must be called before Ext4Crc32c().
+**/
+VOID
+Ext4InitCrc32c (
+  VOID
+  )
+{
+  UINT32  Crc;
+  UINTN   Index;
+  UINTN   Bit;
+  UINTN   Slice;
+
+  for (Index = 0; Index < 256; Index++) {
+    Crc = (UINT32)Index;
+
+    for (Bit = 0; Bit < 8; Bit++) {
+      Crc = (Crc >> 1) ^ ((Crc & 1) != 0 ? EXT4_CRC32C_POLY : 0);
+    }
+
+    mExt4Crc32cTable[0][Index] = Crc;
+  }
+
+  for (Index = 0; Index < 256; Index++) {
+    Crc = mExt4Crc32cTable[0][Index];
+
+    for (Slice = 1; Slice < 8; Slice++) {
+      Crc                            = (Crc >> 8) ^ mExt4Crc32cTable[0][Crc & 0xff];
+      mExt4Crc32cTable[Slice][Index] = Crc;
+    }
+  }
+
+  mExt4Crc32cUseHw = Ext4Crc32cHwSupported ();
+}
+
+/**
+   Updates a CRC32C with the contents of a buffer, using slicing-by-8 tables.
+   Same contract as Ext4Crc32c().
+
+   @param[in]      Crc           Current value of the CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+UINT32
+Ext4Crc32cSlicing8 (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  )
+{
+  CONST UINT8  *Buf;
+  UINT32       Low;
+  UINT32       High;
+
+  Buf = Buffer;
+
+  // Go byte by byte until we're 8-byte aligned
+  while ((Length != 0) && (((UINTN)Buf & 7) != 0)) {
+    Crc = mExt4Crc32cTable[0][(Crc ^ *Buf++) & 0xff] ^ (Crc >> 8);
+    Length--;
+  }
+
+  // Note: This relies on the CPU being little-endian, like every CPU UEFI supports.
+  while (Length >= 8) {
+    Low  = *(CONST UINT32 *)Buf ^ Crc;
+    High = *(CONST UINT32 *)(Buf + 4);
+
+    Crc = mExt4Crc32cTable[7][Low & 0xff] ^
+          mExt4Crc32cTable[6][(Low >> 8) & 0xff] ^
+          mExt4Crc32cTable[5][(Low >> 16) & 0xff] ^
+          mExt4Crc32cTable[4][Low >> 24] ^
+          mExt4Crc32cTable[3][High & 0xff] ^
+          mExt4Crc32cTable[2][(High >> 8) & 0xff] ^
+          mExt4Crc32cTable[1][(High >> 16) & 0xff] ^
+          mExt4Crc32cTable[0][High >> 24];
+
+    Buf    += 8;
+    Length -= 8;
+  }
+
+  while (Length != 0) {
+    Crc = mExt4Crc32cTable[0][(Crc ^ *Buf++) & 0xff] ^ (Crc >> 8);
+    Length--;
+  }
+
+  return Crc;
+}
+
+/**
+   Updates a CRC32C with the contents of a buffer, using the fastest
+   implementation available on this CPU.
+
+   Note that, unlike CalculateCrc32c(), the CRC is neither inverted on entry
+   nor on return: Ext4Crc32c (~Crc, Buffer, Length) == ~CalculateCrc32c (Buffer, Length, Crc).
+
+   @param[in]      Crc           Current value of the CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+UINT32
+Ext4Crc32c (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  )
+{
+  if (mExt4Crc32cUseHw) {
+    return Ext4Crc32cHw (Crc, Buffer, Length);
+  }
+
+  return Ext4Crc32cSlicing8 (Crc, Buffer, Length);
+}
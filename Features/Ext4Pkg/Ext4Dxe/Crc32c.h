@@ -0,0 +1,90 @@
+/** @file
+  CRC32C engine used for metadata checksums
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef EXT4_CRC32C_H_
+#define EXT4_CRC32C_H_
+
+#include <Uefi.h>
+
+/**
+   Initialises the CRC32C engine: builds the slicing-by-8 tables and picks
+   the CRC32C instructions if the CPU has them.
+   Must be called before Ext4Crc32c().
+**/
+VOID
+Ext4InitCrc32c (
+  VOID
+  );
+
+/**
+   Updates a CRC32C with the contents of a buffer, using the fastest
+   implementation available on this CPU.
+
+   Note that, unlike CalculateCrc32c(), the CRC is neither inverted on entry
+   nor on return: Ext4Crc32c (~Crc, Buffer, Length) == ~CalculateCrc32c (Buffer, Length, Crc).
+
+   @param[in]      Crc           Current value of the CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+UINT32
+Ext4Crc32c (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  );
+
+/**
+   Updates a CRC32C with the contents of a buffer, using slicing-by-8 tables.
+   Same contract as Ext4Crc32c().
+
+   @param[in]      Crc           Current value of the CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+UINT32
+Ext4Crc32cSlicing8 (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  );
+
+/**
+   Checks if the CPU has CRC32C instructions Ext4Crc32cHw() can use.
+
+   @return TRUE if they're available, FALSE otherwise.
+**/
+BOOLEAN
+Ext4Crc32cHwSupported (
+  VOID
+  );
+
+/**
+   Updates a CRC32C with the contents of a buffer, using the CPU's CRC32C
+   instructions (SSE4.2 on x64, the CRC32 extension on AArch64).
+   Same contract as Ext4Crc32c(). Must only be called if Ext4Crc32cHwSupported()
+   returned TRUE.
+
+   @param[in]      Crc           Current value of the CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+UINT32
+EFIAPI
+Ext4Crc32cHw (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  );
+
+#endif
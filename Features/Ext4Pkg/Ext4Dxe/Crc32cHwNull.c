@@ -0,0 +1,45 @@
+/** @file
+  CRC32C instruction support for architectures without CRC32C instructions
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Library/DebugLib.h>
+
+#include "Crc32c.h"
+
+/**
+   Checks if the CPU has CRC32C instructions Ext4Crc32cHw() can use.
+
+   @return TRUE if they're available, FALSE otherwise.
+**/
+BOOLEAN
+Ext4Crc32cHwSupported (
+  VOID
+  )
+{
+  return FALSE;
+}
+
+/**
+   Updates a CRC32C with the contents of a buffer, using the CPU's CRC32C
+   instructions. This architecture has none, so it's never used.
+
+   @param[in]      Crc           Current value of the CRC.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      Length        Length of the buffer, in bytes.
+
+   @return The updated CRC.
+**/
+UINT32
+EFIAPI
+Ext4Crc32cHw (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  )
+{
+  ASSERT (FALSE);
+  return Ext4Crc32cSlicing8 (Crc, Buffer, Length);
+}
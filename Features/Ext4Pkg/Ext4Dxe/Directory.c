@@ -90,120 +90,168 @@ Ext4ValidDirent (
 }
 
 /**
-   Retrieves a directory entry.
+   Searches a single directory block for an entry.
 
-   @param[in]      Directory   Pointer to the opened directory.
-   @param[in]      NameUnicode Pointer to the UCS-2 formatted filename.
    @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Block       Pointer to the directory block, Partition->BlockSize bytes long.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename, compared case-insensitively.
+                               Ignored if Utf8Name is not NULL.
+   @param[in]      Utf8Name    Optional pointer to the UTF-8 formatted filename, compared
+                               byte for byte.
    @param[out]     Result      Pointer to the destination directory entry.
 
-   @return The result of the operation.
+   @retval EFI_SUCCESS           The entry was found.
+   @retval EFI_NOT_FOUND         The entry is not in this block.
+   @retval EFI_VOLUME_CORRUPTED  The block is corrupted.
+   @retval !EFI_SUCCESS          Failure.
 **/
 EFI_STATUS
-Ext4RetrieveDirent (
-  IN EXT4_FILE        *Directory,
-  IN CONST CHAR16     *Name,
+Ext4SearchDirentBlock (
   IN EXT4_PARTITION   *Partition,
+  IN CONST CHAR8      *Block,
+  IN CONST CHAR16     *Name,
+  IN CONST CHAR8      *Utf8Name OPTIONAL,
   OUT EXT4_DIR_ENTRY  *Result
   )
 {
   EFI_STATUS      Status;
-  CHAR8           *Buf;
-  UINT64          Off;
-  EXT4_INODE      *Inode;
-  UINT64          DirInoSize;
-  UINT32          BlockRemainder;
-  UINTN           Length;
   EXT4_DIR_ENTRY  *Entry;
   UINTN           RemainingBlock;
   CHAR16          DirentUcs2Name[EXT4_NAME_MAX + 1];
   UINTN           ToCopy;
   UINTN           BlockOffset;
+  UINTN           Utf8NameLen;
 
-  Buf = AllocatePool (Partition->BlockSize);
+  Utf8NameLen = 0;
 
-  if (Buf == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  if (Utf8Name != NULL) {
+    Utf8NameLen = AsciiStrLen (Utf8Name);
   }
 
-  Off = 0;
-
-  Inode      = Directory->Inode;
-  DirInoSize = EXT4_INODE_SIZE (Inode);
-
-  DivU64x32Remainder (DirInoSize, Partition->BlockSize, &BlockRemainder);
-  if (BlockRemainder != 0) {
-    // Directory inodes need to have block aligned sizes
-    Status = EFI_VOLUME_CORRUPTED;
-    goto Out;
-  }
+  for (BlockOffset = 0; BlockOffset < Partition->BlockSize; ) {
+    Entry          = (EXT4_DIR_ENTRY *)(Block + BlockOffset);
+    RemainingBlock = Partition->BlockSize - BlockOffset;
+    // Check if the minimum directory entry fits inside [BlockOffset, EndOfBlock]
+    if (RemainingBlock < EXT4_MIN_DIR_ENTRY_LEN) {
+      return EFI_VOLUME_CORRUPTED;
+    }
 
-  while (Off < DirInoSize) {
-    Length = Partition->BlockSize;
+    if (!Ext4ValidDirent (Entry)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
 
-    Status = Ext4Read (Partition, Directory, Buf, Off, &Length);
+    if ((Entry->name_len > RemainingBlock) || (Entry->rec_len > RemainingBlock)) {
+      // Corrupted filesystem
+      return EFI_VOLUME_CORRUPTED;
+    }
 
-    if (Status != EFI_SUCCESS) {
-      goto Out;
+    // Unused entry
+    if (Entry->inode == 0) {
+      BlockOffset += Entry->rec_len;
+      continue;
     }
 
-    for (BlockOffset = 0; BlockOffset < Partition->BlockSize; ) {
-      Entry          = (EXT4_DIR_ENTRY *)(Buf + BlockOffset);
-      RemainingBlock = Partition->BlockSize - BlockOffset;
-      // Check if the minimum directory entry fits inside [BlockOffset, EndOfBlock]
-      if (RemainingBlock < EXT4_MIN_DIR_ENTRY_LEN) {
-        Status = EFI_VOLUME_CORRUPTED;
-        goto Out;
-      }
+    if (Utf8Name != NULL) {
+      // Exact matches don't need any conversion
+      if ((Entry->name_len == Utf8NameLen) &&
+          (CompareMem (Entry->name, Utf8Name, Utf8NameLen) == 0))
+      {
+        ToCopy = MIN (Entry->rec_len, sizeof (EXT4_DIR_ENTRY));
 
-      if (!Ext4ValidDirent (Entry)) {
-        Status = EFI_VOLUME_CORRUPTED;
-        goto Out;
+        CopyMem (Result, Entry, ToCopy);
+        return EFI_SUCCESS;
       }
 
-      if ((Entry->name_len > RemainingBlock) || (Entry->rec_len > RemainingBlock)) {
-        // Corrupted filesystem
-        Status = EFI_VOLUME_CORRUPTED;
-        goto Out;
-      }
+      BlockOffset += Entry->rec_len;
+      continue;
+    }
 
-      // Unused entry
-      if (Entry->inode == 0) {
+    Status = Ext4GetUcs2DirentName (Entry, DirentUcs2Name);
+
+    /* In theory, this should never fail.
+     * In reality, it's quite possible that it can fail, considering filenames in
+     * Linux (and probably other nixes) are just null-terminated bags of bytes, and don't
+     * need to form valid ASCII/UTF-8 sequences.
+     */
+    if (EFI_ERROR (Status)) {
+      if (Status == EFI_INVALID_PARAMETER) {
+        // If we error out due to a bad UTF-8 sequence (see Ext4GetUcs2DirentName), skip this entry.
+        // I'm not sure if this is correct behaviour, but I don't think there's a precedent here.
         BlockOffset += Entry->rec_len;
         continue;
       }
 
-      Status = Ext4GetUcs2DirentName (Entry, DirentUcs2Name);
-
-      /* In theory, this should never fail.
-       * In reality, it's quite possible that it can fail, considering filenames in
-       * Linux (and probably other nixes) are just null-terminated bags of bytes, and don't
-       * need to form valid ASCII/UTF-8 sequences.
-       */
-      if (EFI_ERROR (Status)) {
-        if (Status == EFI_INVALID_PARAMETER) {
-          // If we error out due to a bad UTF-8 sequence (see Ext4GetUcs2DirentName), skip this entry.
-          // I'm not sure if this is correct behaviour, but I don't think there's a precedent here.
-          BlockOffset += Entry->rec_len;
-          continue;
-        }
+      // Other sorts of errors should just error out.
+      return Status;
+    }
 
-        // Other sorts of errors should just error out.
-        FreePool (Buf);
-        return Status;
-      }
+    if ((Entry->name_len == StrLen (Name)) &&
+        !Ext4StrCmpInsensitive (DirentUcs2Name, (CHAR16 *)Name))
+    {
+      ToCopy = MIN (Entry->rec_len, sizeof (EXT4_DIR_ENTRY));
 
-      if ((Entry->name_len == StrLen (Name)) &&
-          !Ext4StrCmpInsensitive (DirentUcs2Name, (CHAR16 *)Name))
-      {
-        ToCopy = MIN (Entry->rec_len, sizeof (EXT4_DIR_ENTRY));
+      CopyMem (Result, Entry, ToCopy);
+      return EFI_SUCCESS;
+    }
 
-        CopyMem (Result, Entry, ToCopy);
-        Status = EFI_SUCCESS;
-        goto Out;
-      }
+    BlockOffset += Entry->rec_len;
+  }
 
-      BlockOffset += Entry->rec_len;
+  return EFI_NOT_FOUND;
+}
+
+/**
+   Searches every block of a directory for an entry.
+
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename, compared case-insensitively.
+                               Ignored if Utf8Name is not NULL.
+   @param[in]      Utf8Name    Optional pointer to the UTF-8 formatted filename, compared
+                               byte for byte.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[out]     Result      Pointer to the destination directory entry.
+
+   @return The result of the operation.
+**/
+STATIC
+EFI_STATUS
+Ext4ScanDirent (
+  IN EXT4_FILE        *Directory,
+  IN CONST CHAR16     *Name,
+  IN CONST CHAR8      *Utf8Name OPTIONAL,
+  IN EXT4_PARTITION   *Partition,
+  OUT EXT4_DIR_ENTRY  *Result
+  )
+{
+  EFI_STATUS  Status;
+  CHAR8       *Buf;
+  UINT64      Off;
+  UINT64      DirInoSize;
+  UINTN       Length;
+
+  DirInoSize = EXT4_INODE_SIZE (Directory->Inode);
+
+  Buf = AllocatePool (Partition->BlockSize);
+
+  if (Buf == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Off = 0;
+
+  while (Off < DirInoSize) {
+    Length = Partition->BlockSize;
+
+    Status = Ext4Read (Partition, Directory, Buf, Off, &Length);
+
+    if (Status != EFI_SUCCESS) {
+      goto Out;
+    }
+
+    Status = Ext4SearchDirentBlock (Partition, Buf, Name, Utf8Name, Result);
+
+    if (Status != EFI_NOT_FOUND) {
+      goto Out;
     }
 
     Off += Partition->BlockSize;
@@ -217,80 +265,105 @@ Out:
 }
 
 /**
-   Opens a file using a directory entry.
+   Retrieves a directory entry.
 
-   @param[in]      Partition   Pointer to the ext4 partition.
-   @param[in]      OpenMode    Mode in which the file is supposed to be open.
-   @param[out]     OutFile     Pointer to the newly opened file.
-   @param[in]      Entry       Directory entry to be used.
-   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Directory        Pointer to the opened directory.
+   @param[in]      NameUnicode      Pointer to the UCS-2 formatted filename.
+   @param[in]      Partition        Pointer to the ext4 partition.
+   @param[in]      CaseInsensitive  FALSE to only find the exact name, TRUE to find it
+                                    in any case. Callers only ask for the latter once
+                                    the exact name was not found.
+   @param[out]     Result           Pointer to the destination directory entry.
 
-   @retval EFI_STATUS          Result of the operation
+   @return The result of the operation.
 **/
 EFI_STATUS
-Ext4OpenDirent (
-  IN  EXT4_PARTITION  *Partition,
-  IN  UINT64          OpenMode,
-  OUT EXT4_FILE       **OutFile,
-  IN  EXT4_DIR_ENTRY  *Entry,
-  IN  EXT4_FILE       *Directory
+Ext4RetrieveDirent (
+  IN EXT4_FILE        *Directory,
+  IN CONST CHAR16     *Name,
+  IN EXT4_PARTITION   *Partition,
+  IN BOOLEAN          CaseInsensitive,
+  OUT EXT4_DIR_ENTRY  *Result
   )
 {
   EFI_STATUS  Status;
-  CHAR16      FileName[EXT4_NAME_MAX + 1];
-  EXT4_FILE   *File;
+  CHAR8       *Utf8Name;
+  UINT32      BlockRemainder;
 
-  File = AllocateZeroPool (sizeof (EXT4_FILE));
+  DivU64x32Remainder (EXT4_INODE_SIZE (Directory->Inode), Partition->BlockSize, &BlockRemainder);
+  if (BlockRemainder != 0) {
+    // Directory inodes need to have block aligned sizes
+    return EFI_VOLUME_CORRUPTED;
+  }
 
-  if (File == NULL) {
-    Status = EFI_OUT_OF_RESOURCES;
-    goto Error;
+  if (CaseInsensitive) {
+    return Ext4ScanDirent (Directory, Name, NULL, Partition, Result);
   }
 
-  Status = Ext4GetUcs2DirentName (Entry, FileName);
+  // Try the hash tree first; it finds exact matches, like the scan below.
+  Status = Ext4HtreeRetrieveDirent (Directory, Name, Partition, Result);
+
+  if ((Status == EFI_SUCCESS) || (Status == EFI_NOT_FOUND) ||
+      (Status == EFI_OUT_OF_RESOURCES) || (Status == EFI_DEVICE_ERROR))
+  {
+    return Status;
+  }
+
+  Status = UCS2StrToUTF8 ((CHAR16 *)Name, &Utf8Name);
 
   if (EFI_ERROR (Status)) {
-    goto Error;
+    return Status;
   }
 
-  if (StrCmp (FileName, L".") == 0) {
-    // We're using the parent directory's dentry
-    File->Dentry = Directory->Dentry;
+  Status = Ext4ScanDirent (Directory, Name, Utf8Name, Partition, Result);
 
-    ASSERT (File->Dentry != NULL);
+  FreePool (Utf8Name);
+  return Status;
+}
 
-    Ext4RefDentry (File->Dentry);
-  } else if (StrCmp (FileName, L"..") == 0) {
-    // Using the parent's parent's dentry
-    File->Dentry = Directory->Dentry->Parent;
+/**
+   Opens a file using its dentry and inode number.
 
-    if (!File->Dentry) {
-      // Someone tried .. on root, so direct them to /
-      // This is an illegal EFI Open() but is possible to hit from a variety of internal code
-      File->Dentry = Directory->Dentry;
-    }
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Dentry      Pointer to the file's dentry. The reference held by
+                               the caller is handed over to the file, even if the open fails.
+   @param[in]      InodeNum    Inode number of the file.
+   @param[out]     OutFile     Pointer to the newly opened file.
 
-    Ext4RefDentry (File->Dentry);
-  } else {
-    File->Dentry = Ext4CreateDentry (FileName, Directory->Dentry);
+   @retval EFI_STATUS          Result of the operation
+**/
+STATIC
+EFI_STATUS
+Ext4OpenDentry (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_DENTRY     *Dentry,
+  IN  EXT4_INO_NR     InodeNum,
+  OUT EXT4_FILE       **OutFile
+  )
+{
+  EFI_STATUS  Status;
+  EXT4_FILE   *File;
 
-    if (File->Dentry == NULL) {
-      Status = EFI_OUT_OF_RESOURCES;
-      goto Error;
-    }
+  File = AllocateZeroPool (sizeof (EXT4_FILE));
+
+  if (File == NULL) {
+    Ext4UnrefDentry (Dentry);
+    return EFI_OUT_OF_RESOURCES;
   }
 
+  File->Dentry = Dentry;
+
   Status = Ext4InitExtentsMap (File);
 
   if (EFI_ERROR (Status)) {
     goto Error;
   }
 
-  File->InodeNum = Entry->inode;
+  File->InodeNum = InodeNum;
 
   Ext4SetupFile (File, Partition);
 
-  Status = Ext4ReadInode (Partition, Entry->inode, &File->Inode);
+  Status = Ext4ReadInode (Partition, InodeNum, &File->Inode);
 
   if (EFI_ERROR (Status)) {
     goto Error;
@@ -303,19 +376,78 @@ Ext4OpenDirent (
   return EFI_SUCCESS;
 
 Error:
-  if (File != NULL) {
-    if (File->Dentry != NULL) {
-      Ext4UnrefDentry (File->Dentry);
-    }
+  Ext4UnrefDentry (File->Dentry);
+  Ext4FreeExtentsMap (File);
+  FreePool (File);
+
+  return Status;
+}
+
+/**
+   Opens a file using a directory entry.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      OpenMode    Mode in which the file is supposed to be open.
+   @param[out]     OutFile     Pointer to the newly opened file.
+   @param[in]      Entry       Directory entry to be used.
+   @param[in]      Directory   Pointer to the opened directory.
+
+   @retval EFI_STATUS          Result of the operation
+**/
+EFI_STATUS
+Ext4OpenDirent (
+  IN  EXT4_PARTITION  *Partition,
+  IN  UINT64          OpenMode,
+  OUT EXT4_FILE       **OutFile,
+  IN  EXT4_DIR_ENTRY  *Entry,
+  IN  EXT4_FILE       *Directory
+  )
+{
+  EFI_STATUS   Status;
+  CHAR16       FileName[EXT4_NAME_MAX + 1];
+  EXT4_DENTRY  *Dentry;
+
+  Status = Ext4GetUcs2DirentName (Entry, FileName);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (StrCmp (FileName, L".") == 0) {
+    // We're using the parent directory's dentry
+    Dentry = Directory->Dentry;
 
-    if (File->ExtentsMap != NULL) {
-      OrderedCollectionUninit (File->ExtentsMap);
+    ASSERT (Dentry != NULL);
+  } else if (StrCmp (FileName, L"..") == 0) {
+    // Using the parent's parent's dentry
+    Dentry = Directory->Dentry->Parent;
+
+    if (!Dentry) {
+      // Someone tried .. on root, so direct them to /
+      // This is an illegal EFI Open() but is possible to hit from a variety of internal code
+      Dentry = Directory->Dentry;
     }
+  } else {
+    // Dentries must stay unique name-wise, so reuse the one we may already have.
+    Dentry = Ext4LookupDentry (Partition, Directory->Dentry, FileName, FALSE);
+
+    if ((Dentry == NULL) || Dentry->Negative || (Dentry->Inode != Entry->inode)) {
+      Dentry = Ext4CreateDentry (FileName, Directory->Dentry);
+
+      if (Dentry == NULL) {
+        return EFI_OUT_OF_RESOURCES;
+      }
 
-    FreePool (File);
+      Dentry->Inode = Entry->inode;
+      Ext4CacheDentry (Partition, Dentry);
+
+      return Ext4OpenDentry (Partition, Dentry, Entry->inode, OutFile);
+    }
   }
 
-  return Status;
+  Ext4RefDentry (Dentry);
+
+  return Ext4OpenDentry (Partition, Dentry, Entry->inode, OutFile);
 }
 
 /**
@@ -339,11 +471,51 @@ Ext4OpenFile (
   )
 {
   EXT4_DIR_ENTRY  Entry;
+  EXT4_DENTRY     *Dentry;
   EFI_STATUS      Status;
+  BOOLEAN         IsDotOrDotDot;
+
+  IsDotOrDotDot = (BOOLEAN)((StrCmp (Name, L".") == 0) || (StrCmp (Name, L"..") == 0));
+
+  // Try the dentry cache first; "." and ".." are cheap enough as it is.
+  if (!IsDotOrDotDot) {
+    Dentry = Ext4LookupDentry (Partition, Directory->Dentry, Name, FALSE);
+
+    if (Dentry != NULL) {
+      if (Dentry->Negative) {
+        return EFI_NOT_FOUND;
+      }
 
-  Status = Ext4RetrieveDirent (Directory, Name, Partition, &Entry);
+      Ext4RefDentry (Dentry);
+      return Ext4OpenDentry (Partition, Dentry, Dentry->Inode, OutFile);
+    }
+  }
+
+  Status = Ext4RetrieveDirent (Directory, Name, Partition, FALSE, &Entry);
+
+  // The exact name isn't there, so the name may only differ in case.
+  if (Status == EFI_NOT_FOUND) {
+    if (!IsDotOrDotDot) {
+      Dentry = Ext4LookupDentry (Partition, Directory->Dentry, Name, TRUE);
+
+      if (Dentry != NULL) {
+        if (Dentry->Negative) {
+          return EFI_NOT_FOUND;
+        }
+
+        Ext4RefDentry (Dentry);
+        return Ext4OpenDentry (Partition, Dentry, Dentry->Inode, OutFile);
+      }
+    }
+
+    Status = Ext4RetrieveDirent (Directory, Name, Partition, TRUE, &Entry);
+  }
 
   if (EFI_ERROR (Status)) {
+    if ((Status == EFI_NOT_FOUND) && !IsDotOrDotDot) {
+      Ext4CacheNegativeDentry (Partition, Directory->Dentry, Name);
+    }
+
     return Status;
   }
 
@@ -633,6 +805,7 @@ Ext4CreateDentry (
   ASSERT_EFI_ERROR (Status);
 
   InitializeListHead (&Dentry->Children);
+  InitializeListHead (&Dentry->LruNode);
 
   if (Parent != NULL) {
     Ext4AddDentry (Parent, Dentry);
@@ -675,6 +848,9 @@ Ext4DeleteDentry (
   IN OUT EXT4_DENTRY  *Dentry
   )
 {
+  // The dentry cache holds a reference, so cached dentries can't get here
+  ASSERT (IsListEmpty (&Dentry->LruNode));
+
   if (Dentry->Parent) {
     Ext4RemoveDentry (Dentry->Parent, Dentry);
     Ext4UnrefDentry (Dentry->Parent);
@@ -706,3 +882,172 @@ Ext4UnrefDentry (
 
   return FALSE;
 }
+
+/**
+   Removes a dentry from the dentry cache, dropping the cache's reference.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Dentry      Pointer to a cached dentry.
+**/
+STATIC
+VOID
+Ext4UncacheDentry (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_DENTRY     *Dentry
+  )
+{
+  RemoveEntryList (&Dentry->LruNode);
+  InitializeListHead (&Dentry->LruNode);
+  Partition->NumberCachedDentries--;
+
+  Ext4UnrefDentry (Dentry);
+}
+
+/**
+   Adds a dentry to the dentry cache, or marks it as the most recently used if it's
+   already there. The least recently used dentry is evicted once the cache holds
+   more than PcdExt4DentryCacheSize dentries.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Dentry      Pointer to the dentry.
+**/
+VOID
+Ext4CacheDentry (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_DENTRY     *Dentry
+  )
+{
+  UINT32  MaxDentries;
+
+  if (!IsListEmpty (&Dentry->LruNode)) {
+    RemoveEntryList (&Dentry->LruNode);
+    InsertHeadList (&Partition->DentryLru, &Dentry->LruNode);
+    return;
+  }
+
+  MaxDentries = PcdGet32 (PcdExt4DentryCacheSize);
+
+  if (MaxDentries == 0) {
+    return;
+  }
+
+  Ext4RefDentry (Dentry);
+  InsertHeadList (&Partition->DentryLru, &Dentry->LruNode);
+  Partition->NumberCachedDentries++;
+
+  while (Partition->NumberCachedDentries > MaxDentries) {
+    Ext4UncacheDentry (
+      Partition,
+      EXT4_DENTRY_FROM_LRU_NODE (GetPreviousNode (&Partition->DentryLru, &Partition->DentryLru))
+      );
+  }
+}
+
+/**
+   Looks up a child of a dentry in the dentry cache. The cache is flushed first if
+   the media changed since it was filled.
+
+   @param[in]      Partition        Pointer to the ext4 partition.
+   @param[in]      Parent           Pointer to the parent dentry.
+   @param[in]      Name             Name of the child.
+   @param[in]      CaseInsensitive  FALSE to only find the exact name, TRUE to find it
+                                    in any case. Callers only ask for the latter once
+                                    the exact name was not found on disk either.
+
+   @return Pointer to the child dentry (which may be negative), or NULL if it isn't cached.
+           No reference is taken on the returned dentry.
+**/
+EXT4_DENTRY *
+Ext4LookupDentry (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_DENTRY     *Parent,
+  IN CONST CHAR16    *Name,
+  IN BOOLEAN         CaseInsensitive
+  )
+{
+  LIST_ENTRY   *Node;
+  EXT4_DENTRY  *Dentry;
+  EXT4_DENTRY  *Match;
+  INTN         Diff;
+
+  // Our cached dentries are worthless if the media was swapped under us.
+  if (Partition->DentryCacheMediaId != EXT4_MEDIA_ID (Partition)) {
+    Ext4FlushDentryCache (Partition);
+    Partition->DentryCacheMediaId = EXT4_MEDIA_ID (Partition);
+  }
+
+  Match = NULL;
+
+  BASE_LIST_FOR_EACH (Node, &Parent->Children) {
+    Dentry = EXT4_DENTRY_FROM_DENTRY_LIST (Node);
+
+    // Dentries only kept alive by open files may come from a previous media.
+    if (IsListEmpty (&Dentry->LruNode)) {
+      continue;
+    }
+
+    if (CaseInsensitive) {
+      Diff = Ext4StrCmpInsensitive (Dentry->Name, (CHAR16 *)Name);
+    } else {
+      Diff = StrCmp (Dentry->Name, Name);
+    }
+
+    if (Diff == 0) {
+      Match = Dentry;
+      break;
+    }
+  }
+
+  if (Match != NULL) {
+    Ext4CacheDentry (Partition, Match);
+  }
+
+  return Match;
+}
+
+/**
+   Records that a name doesn't exist in a directory, by caching a negative dentry.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Parent      Pointer to the directory's dentry.
+   @param[in]      Name        Name that was not found.
+**/
+VOID
+Ext4CacheNegativeDentry (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_DENTRY     *Parent,
+  IN CONST CHAR16    *Name
+  )
+{
+  EXT4_DENTRY  *Dentry;
+
+  Dentry = Ext4CreateDentry (Name, Parent);
+
+  if (Dentry == NULL) {
+    return;
+  }
+
+  Dentry->Negative = TRUE;
+  Ext4CacheDentry (Partition, Dentry);
+
+  // Only the cache keeps it alive; if the cache is disabled, this frees it.
+  Ext4UnrefDentry (Dentry);
+}
+
+/**
+   Drops every dentry held by the partition's dentry cache.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+**/
+VOID
+Ext4FlushDentryCache (
+  IN EXT4_PARTITION  *Partition
+  )
+{
+  while (!IsListEmpty (&Partition->DentryLru)) {
+    Ext4UncacheDentry (
+      Partition,
+      EXT4_DENTRY_FROM_LRU_NODE (GetPreviousNode (&Partition->DentryLru, &Partition->DentryLru))
+      );
+  }
+}
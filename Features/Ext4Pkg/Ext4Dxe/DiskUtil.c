@@ -6,6 +6,9 @@
 **/
 #include "Ext4Dxe.h"
 
+// Reads shorter than this aren't worth splitting in two to avoid DISK_IO's copy of them
+#define EXT4_DIRECT_READ_SPLIT_MIN  SIZE_64KB
+
 /**
    Reads from the partition's disk using the DISK_IO protocol.
 
@@ -24,6 +27,9 @@ Ext4ReadDiskIo (
   IN UINT64          Offset
   )
 {
+  Partition->DiskReads++;
+  Partition->DiskReadBytes += Length;
+
   return EXT4_DISK_IO (Partition)->ReadDisk (
                                      EXT4_DISK_IO (Partition),
                                      EXT4_MEDIA_ID (Partition),
@@ -33,6 +39,79 @@ Ext4ReadDiskIo (
                                      );
 }
 
+/**
+   Reads from the partition's disk straight into the destination buffer using the
+   BLOCK_IO protocol, if the buffer and offset are aligned as the media requires.
+   DISK_IO would otherwise bounce the read through a buffer of its own, which is a
+   needless copy for large reads such as kernel and initrd loads.
+   Unaligned reads, and any tail that isn't a multiple of the media block size,
+   still go through DISK_IO.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  Length         Length of the destination buffer.
+   @param[in]  Offset         Offset, in bytes, of the location to read.
+
+   @return Success status of the disk read.
+**/
+EFI_STATUS
+Ext4ReadDiskDirect (
+  IN EXT4_PARTITION  *Partition,
+  OUT VOID           *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  )
+{
+  EFI_BLOCK_IO_PROTOCOL  *BlockIo;
+  UINT32                 MediaBlockSize;
+  UINT32                 IoAlign;
+  UINT32                 OffsetRem;
+  UINT64                 Lba;
+  UINTN                  AlignedLength;
+  EFI_STATUS             Status;
+
+  BlockIo        = EXT4_BLOCK_IO (Partition);
+  MediaBlockSize = BlockIo->Media->BlockSize;
+  IoAlign        = BlockIo->Media->IoAlign;
+
+  if (MediaBlockSize == 0) {
+    return Ext4ReadDiskIo (Partition, Buffer, Length, Offset);
+  }
+
+  Lba           = DivU64x32Remainder (Offset, MediaBlockSize, &OffsetRem);
+  AlignedLength = Length - Length % MediaBlockSize;
+
+  // IoAlign values of 0 and 1 mean the buffer may be placed anywhere; others are powers of 2
+  if ((AlignedLength == 0) || (OffsetRem != 0) ||
+      ((AlignedLength != Length) && (AlignedLength < EXT4_DIRECT_READ_SPLIT_MIN)) ||
+      ((IoAlign > 1) && (((UINTN)Buffer & (IoAlign - 1)) != 0)))
+  {
+    return Ext4ReadDiskIo (Partition, Buffer, Length, Offset);
+  }
+
+  Partition->DiskReads++;
+  Partition->DiskReadBytes += AlignedLength;
+
+  Status = BlockIo->ReadBlocks (
+                      BlockIo,
+                      EXT4_MEDIA_ID (Partition),
+                      Lba,
+                      AlignedLength,
+                      Buffer
+                      );
+
+  if (EFI_ERROR (Status) || (AlignedLength == Length)) {
+    return Status;
+  }
+
+  return Ext4ReadDiskIo (
+           Partition,
+           (CHAR8 *)Buffer + AlignedLength,
+           Length - AlignedLength,
+           Offset + AlignedLength
+           );
+}
+
 /**
    Reads blocks from the partition's disk using the DISK_IO protocol.
 
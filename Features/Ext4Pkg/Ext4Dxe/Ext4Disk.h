@@ -68,7 +68,8 @@
           mostly-list of EXT4_DIR_ENTRY.
        2) Hash tree directories: These are used for larger directories, with
           hundreds of entries, and are designed in a backwards compatible way.
-          These are not yet implemented in the Ext4Dxe driver.
+          Ext4Dxe uses them (see EXT4_DX_ROOT) to look up names in large
+          directories, falling back to a linear walk when needed.
 
   7) Journal
      Ext3/4 filesystems have a journal to help protect the filesystem against
@@ -173,7 +174,9 @@
 #define EXT4_NOCOMPR_FL       0x00000400
 #define EXT4_ENCRYPT_FL       0x00000800
 #define EXT4_BTREE_FL         0x00001000
-#define EXT4_INDEX_FL         0x00002000
+// Hash-indexed directory; same bit as EXT4_BTREE_FL
+#define EXT4_INDEX_FL         0x00001000
+#define EXT4_IMAGIC_FL        0x00002000
 #define EXT4_JOURNAL_DATA_FL  0x00004000
 #define EXT4_NOTAIL_FL        0x00008000
 #define EXT4_DIRSYNC_FL       0x00010000
@@ -424,6 +427,81 @@ typedef struct {
 
 #define EXT4_MIN_DIR_ENTRY_LEN  8
 
+// Hash tree (dir_index) directories
+// These are regular directories with an index on top, stored in the directory's
+// blocks in a way that older implementations see as empty/deleted entries.
+// The first block holds an EXT4_DX_ROOT, followed by an array of EXT4_DX_ENTRY
+// sorted by hash; each entry points to either an interior index node (which
+// starts with a fake, empty EXT4_DIR_ENTRY) or a leaf, which is a regular
+// directory block.
+
+#define EXT4_DX_HASH_LEGACY             0
+#define EXT4_DX_HASH_HALF_MD4           1
+#define EXT4_DX_HASH_TEA                2
+#define EXT4_DX_HASH_LEGACY_UNSIGNED    3
+#define EXT4_DX_HASH_HALF_MD4_UNSIGNED  4
+#define EXT4_DX_HASH_TEA_UNSIGNED       5
+
+// s_flags bits that tell us how char was signed on the machine that created the
+// filesystem, which affects the hashes
+#define EXT4_FLAGS_SIGNED_HASH    0x0001
+#define EXT4_FLAGS_UNSIGNED_HASH  0x0002
+
+// The index is incompatible with us if this bit is set in unused_flags
+#define EXT4_DX_FLAG_INCOMPAT  0x1
+
+// Without the largedir feature, the index has at most 2 levels (root + one level of nodes)
+#define EXT4_DX_MAX_LEVELS           2
+#define EXT4_DX_MAX_LEVELS_LARGEDIR  3
+
+// Only the low 28 bits of a dx entry's block are the logical block number
+#define EXT4_DX_BLOCK_MASK  0x0fffffff
+
+typedef struct {
+  UINT32    reserved_zero;
+  // One of EXT4_DX_HASH_*
+  UINT8     hash_version;
+  // Length of this structure, always 8
+  UINT8     info_length;
+  // Depth of the index, not counting the root
+  UINT8     indirect_levels;
+  UINT8     unused_flags;
+} EXT4_DX_ROOT_INFO;
+
+typedef struct {
+  // Fake "." and ".." entries, with ".." spanning the rest of the block
+  UINT32               dot_inode;
+  UINT16               dot_rec_len;
+  UINT8                dot_name_len;
+  UINT8                dot_file_type;
+  CHAR8                dot_name[4];
+  UINT32               dotdot_inode;
+  UINT16               dotdot_rec_len;
+  UINT8                dotdot_name_len;
+  UINT8                dotdot_file_type;
+  CHAR8                dotdot_name[4];
+  EXT4_DX_ROOT_INFO    info;
+  // Followed by an EXT4_DX_COUNT_LIMIT (and then the entries) at info + info_length
+} EXT4_DX_ROOT;
+
+typedef struct {
+  // Hash of the first name in this block. Bit 0 is set if the block is a continuation
+  // of the previous one (hash collisions spilled into it).
+  UINT32    hash;
+  // Logical block (of the directory)
+  UINT32    block;
+} EXT4_DX_ENTRY;
+
+// Overlays the first EXT4_DX_ENTRY of every index block (its hash is always implied to be 0)
+typedef struct {
+  // Maximum number of entries
+  UINT16    limit;
+  // Number of entries, including this one
+  UINT16    count;
+  // Logical block for hashes lower than the second entry's
+  UINT32    block;
+} EXT4_DX_COUNT_LIMIT;
+
 // This on-disk structure is present at the bottom of the extent tree
 typedef struct {
   // First logical block
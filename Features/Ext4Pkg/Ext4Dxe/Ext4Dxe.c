@@ -513,6 +513,8 @@ Ext4EntryPoint (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
+  Ext4InitCrc32c ();
+
   return EfiLibInstallAllDriverProtocols2 (
            ImageHandle,
            SystemTable,
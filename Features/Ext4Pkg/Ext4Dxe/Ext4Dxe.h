@@ -22,7 +22,6 @@
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
-#include <Library/OrderedCollectionLib.h>
 #include <Library/PcdLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiDriverEntryPoint.h>
@@ -30,6 +29,7 @@
 #include <Library/UefiRuntimeServicesTableLib.h>
 
 #include "Ext4Disk.h"
+#include "Crc32c.h"
 
 #define SYMLOOP_MAX  8
 //
@@ -77,6 +77,81 @@ Ext4OpenPartition (
 typedef struct _Ext4File     EXT4_FILE;
 typedef struct _Ext4_Dentry  EXT4_DENTRY;
 
+/**
+   A single filesystem block held by the partition's block cache.
+ */
+typedef struct {
+  EXT4_BLOCK_NR    BlockNumber;
+  BOOLEAN          Valid;
+  VOID             *Data;
+  // Links the entry into the cache's LRU list; most recently used entries are at the head.
+  LIST_ENTRY       LruNode;
+  // Links the entry into its hash bucket, if Valid.
+  LIST_ENTRY       HashNode;
+} EXT4_BLOCK_CACHE_ENTRY;
+
+#define EXT4_BLOCK_CACHE_ENTRY_FROM_LRU_NODE(Node)                             \
+  BASE_CR(Node, EXT4_BLOCK_CACHE_ENTRY, LruNode)
+
+#define EXT4_BLOCK_CACHE_ENTRY_FROM_HASH_NODE(Node)                            \
+  BASE_CR(Node, EXT4_BLOCK_CACHE_ENTRY, HashNode)
+
+/**
+   Bounded cache of metadata blocks (inode tables, directories, extent tree nodes),
+   keyed by physical block number and evicted in LRU order.
+   Its size is controlled by PcdExt4BlockCacheSize.
+ */
+typedef struct {
+  EXT4_BLOCK_CACHE_ENTRY    *Entries;
+  UINTN                     NumberEntries;
+  // Backing storage for every entry's data, NumberEntries * BlockSize bytes long.
+  VOID                      *Data;
+  LIST_ENTRY                *Buckets;
+  UINTN                     NumberBuckets;
+  LIST_ENTRY                LruList;
+  // Media ID the cached contents belong to.
+  UINT32                    MediaId;
+  UINT64                    Hits;
+  UINT64                    Misses;
+} EXT4_BLOCK_CACHE;
+
+/**
+   A single inode held by the partition's inode cache.
+ */
+typedef struct {
+  EXT4_INO_NR    InodeNum;
+  BOOLEAN        Valid;
+  EXT4_INODE     *Inode;
+  // Links the entry into the cache's LRU list; most recently used entries are at the head.
+  LIST_ENTRY     LruNode;
+  // Links the entry into its hash bucket, if Valid.
+  LIST_ENTRY     HashNode;
+} EXT4_INODE_CACHE_ENTRY;
+
+#define EXT4_INODE_CACHE_ENTRY_FROM_LRU_NODE(Node)                             \
+  BASE_CR(Node, EXT4_INODE_CACHE_ENTRY, LruNode)
+
+#define EXT4_INODE_CACHE_ENTRY_FROM_HASH_NODE(Node)                            \
+  BASE_CR(Node, EXT4_INODE_CACHE_ENTRY, HashNode)
+
+/**
+   Bounded cache of validated inodes, keyed by inode number and evicted in LRU order.
+   Its size is controlled by PcdExt4InodeCacheSize.
+ */
+typedef struct {
+  EXT4_INODE_CACHE_ENTRY    *Entries;
+  UINTN                     NumberEntries;
+  // Backing storage for every entry's inode, NumberEntries * InodeSize bytes long.
+  VOID                      *Data;
+  LIST_ENTRY                *Buckets;
+  UINTN                     NumberBuckets;
+  LIST_ENTRY                LruList;
+  // Media ID the cached contents belong to.
+  UINT32                    MediaId;
+  UINT64                    Hits;
+  UINT64                    Misses;
+} EXT4_INODE_CACHE;
+
 typedef struct _Ext4_PARTITION {
   EFI_SIMPLE_FILE_SYSTEM_PROTOCOL    Interface;
   EFI_DISK_IO_PROTOCOL               *DiskIo;
@@ -95,7 +170,11 @@ typedef struct _Ext4_PARTITION {
   UINT64                             NumberBlockGroups;
   EXT4_BLOCK_NR                      NumberBlocks;
 
-  EXT4_BLOCK_GROUP_DESC              *BlockGroups;
+  // Block group descriptor table, read one block at a time when first needed.
+  // Each entry points to a verified block of descriptors, or is NULL.
+  VOID                               **BlockGroupDescBlocks;
+  UINTN                              NumberBlockGroupDescBlocks;
+  EXT4_BLOCK_NR                      BlockGroupDescStart;
   UINT32                             DescSize;
   EXT4_FILE                          *Root;
 
@@ -104,27 +183,46 @@ typedef struct _Ext4_PARTITION {
   LIST_ENTRY                         OpenFiles;
 
   EXT4_DENTRY                        *RootDentry;
+
+  EXT4_BLOCK_CACHE                   BlockCache;
+  EXT4_INODE_CACHE                   InodeCache;
+
+  // Dentries kept alive by the dentry cache, most recently used first.
+  // The cache holds a reference to each of them.
+  LIST_ENTRY                         DentryLru;
+  UINTN                              NumberCachedDentries;
+  UINT32                             DentryCacheMediaId;
+
+  // Number of requests (and bytes) sent to the disk, for debugging purposes
+  UINT64                             DiskReads;
+  UINT64                             DiskReadBytes;
 } EXT4_PARTITION;
 
 /**
    This structure represents a directory entry inside our directory entry tree.
-   For now, it will be used as a way to track file names inside our opening
-   code, but it may very well be used as a directory cache in the future.
-   Because it's not being used as a directory cache right now,
-   an EXT4_DENTRY structure is not necessarily unique name-wise in the list of
-   children. Therefore, the dentry tree does not accurately reflect the
-   filesystem structure.
+   It tracks file names inside our opening code, and doubles as a directory cache:
+   recently used dentries are kept alive by the partition's dentry cache, so
+   opening the same path again doesn't need to search the directories again.
+   Lookups in the list of children look for the exact name first, like the
+   directory search does, and only compare names case-insensitively once the
+   exact name was not found on disk either.
+   Negative dentries record names that were looked up and don't exist.
  */
 struct _Ext4_Dentry {
   UINTN                  RefCount;
   CHAR16                 Name[EXT4_NAME_MAX + 1];
   EXT4_INO_NR            Inode;
+  // TRUE if Name doesn't exist in the parent directory; Inode is meaningless then.
+  BOOLEAN                Negative;
   struct _Ext4_Dentry    *Parent;
   LIST_ENTRY             Children;
   LIST_ENTRY             ListNode;
+  // Links the dentry into the partition's DentryLru, if cached.
+  LIST_ENTRY             LruNode;
 };
 
 #define EXT4_DENTRY_FROM_DENTRY_LIST(Node)  BASE_CR(Node, EXT4_DENTRY, ListNode)
+#define EXT4_DENTRY_FROM_LRU_NODE(Node)     BASE_CR(Node, EXT4_DENTRY, LruNode)
 
 /**
    Creates a new dentry object.
@@ -164,6 +262,66 @@ Ext4UnrefDentry (
   IN OUT EXT4_DENTRY  *Dentry
   );
 
+/**
+   Looks up a child of a dentry in the dentry cache. The cache is flushed first if
+   the media changed since it was filled.
+
+   @param[in]      Partition        Pointer to the ext4 partition.
+   @param[in]      Parent           Pointer to the parent dentry.
+   @param[in]      Name             Name of the child.
+   @param[in]      CaseInsensitive  FALSE to only find the exact name, TRUE to find it
+                                    in any case. Callers only ask for the latter once
+                                    the exact name was not found on disk either.
+
+   @return Pointer to the child dentry (which may be negative), or NULL if it isn't cached.
+           No reference is taken on the returned dentry.
+**/
+EXT4_DENTRY *
+Ext4LookupDentry (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_DENTRY     *Parent,
+  IN CONST CHAR16    *Name,
+  IN BOOLEAN         CaseInsensitive
+  );
+
+/**
+   Adds a dentry to the dentry cache, or marks it as the most recently used if it's
+   already there. The least recently used dentry is evicted once the cache holds
+   more than PcdExt4DentryCacheSize dentries.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Dentry      Pointer to the dentry.
+**/
+VOID
+Ext4CacheDentry (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_DENTRY     *Dentry
+  );
+
+/**
+   Records that a name doesn't exist in a directory, by caching a negative dentry.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Parent      Pointer to the directory's dentry.
+   @param[in]      Name        Name that was not found.
+**/
+VOID
+Ext4CacheNegativeDentry (
+  IN EXT4_PARTITION  *Partition,
+  IN EXT4_DENTRY     *Parent,
+  IN CONST CHAR16    *Name
+  );
+
+/**
+   Drops every dentry held by the partition's dentry cache.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+**/
+VOID
+Ext4FlushDentryCache (
+  IN EXT4_PARTITION  *Partition
+  );
+
 /**
    Opens and parses the superblock.
 
@@ -228,6 +386,27 @@ Ext4ReadDiskIo (
   IN UINT64          Offset
   );
 
+/**
+   Reads from the partition's disk straight into the destination buffer using the
+   BLOCK_IO protocol, if the buffer and offset are aligned as the media requires.
+   Unaligned reads, and any tail that isn't a multiple of the media block size,
+   go through DISK_IO.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  Length         Length of the destination buffer.
+   @param[in]  Offset         Offset, in bytes, of the location to read.
+
+   @return Success status of the disk read.
+**/
+EFI_STATUS
+Ext4ReadDiskDirect (
+  IN EXT4_PARTITION  *Partition,
+  OUT VOID           *Buffer,
+  IN UINTN           Length,
+  IN UINT64          Offset
+  );
+
 /**
    Reads blocks from the partition's disk using the DISK_IO protocol.
 
@@ -264,6 +443,139 @@ Ext4AllocAndReadBlocks (
   IN EXT4_BLOCK_NR   BlockNumber
   );
 
+/**
+   Initialises the block cache of the partition.
+   The number of cached blocks is derived from PcdExt4BlockCacheSize and the
+   filesystem's block size; if not even a single block fits, the cache is
+   left disabled and every read goes straight to the disk.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+                                 Partition->BlockSize must already be valid.
+
+   @retval EFI_SUCCESS           The cache was initialised (or disabled).
+   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+EFI_STATUS
+Ext4InitBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Drops every block held by the partition's block cache.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4InvalidateBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Frees the partition's block cache.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4FreeBlockCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Initialises the inode cache of the partition.
+   The number of cached inodes is PcdExt4InodeCacheSize; if it's 0,
+   the cache is left disabled and every inode is read from the inode table.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+                                 Partition->InodeSize must already be valid.
+
+   @retval EFI_SUCCESS           The cache was initialised (or disabled).
+   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+EFI_STATUS
+Ext4InitInodeCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Frees the partition's inode cache.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4FreeInodeCache (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Looks up an inode in the inode cache.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      InodeNum      Inode number.
+   @param[out]     Inode         Pointer to a buffer, Partition->InodeSize bytes long,
+                                 where the inode will be copied to if it's cached.
+
+   @return TRUE if the inode was cached, FALSE otherwise.
+**/
+BOOLEAN
+Ext4GetCachedInode (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_INO_NR     InodeNum,
+  OUT EXT4_INODE      *Inode
+  );
+
+/**
+   Adds an inode to the inode cache, evicting the least recently used one.
+   The inode must have already been validated.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      InodeNum      Inode number.
+   @param[in]      Inode         Pointer to the inode, Partition->InodeSize bytes long.
+**/
+VOID
+Ext4CacheInode (
+  IN EXT4_PARTITION    *Partition,
+  IN EXT4_INO_NR       InodeNum,
+  IN CONST EXT4_INODE  *Inode
+  );
+
+/**
+   Reads from the partition's disk, going through the block cache.
+   Meant for filesystem metadata (inode tables, directories, extent trees), which
+   tends to be read over and over again in small chunks.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  Length         Length of the destination buffer.
+   @param[in]  Offset         Offset, in bytes, of the location to read.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadCachedDiskIo (
+  IN  EXT4_PARTITION  *Partition,
+  OUT VOID            *Buffer,
+  IN  UINTN           Length,
+  IN  UINT64          Offset
+  );
+
+/**
+   Reads blocks from the partition's disk, going through the block cache.
+
+   @param[in]  Partition      Pointer to the opened ext4 partition.
+   @param[out] Buffer         Pointer to a destination buffer.
+   @param[in]  NumberBlocks   Length of the read, in filesystem blocks.
+   @param[in]  BlockNumber    Starting block number.
+
+   @return Success status of the read.
+**/
+EFI_STATUS
+Ext4ReadCachedBlocks (
+  IN  EXT4_PARTITION  *Partition,
+  OUT VOID            *Buffer,
+  IN  UINTN           NumberBlocks,
+  IN  EXT4_BLOCK_NR   BlockNumber
+  );
+
 /**
    Checks if the opened partition has the 64-bit feature (see
 EXT4_FEATURE_INCOMPAT_64BIT).
@@ -289,11 +601,13 @@ EXT4_FEATURE_INCOMPAT_64BIT).
 
 /**
    Retrieves a block group descriptor of the ext4 filesystem.
+   The descriptor's block is read and verified the first time it's needed.
 
    @param[in]  Partition      Pointer to the opened ext4 partition.
    @param[in]  BlockGroup    Block group number.
 
-   @return A pointer to the block group descriptor.
+   @return A pointer to the block group descriptor, or NULL if the block group
+           number is invalid, or the descriptor could not be read or is corrupted.
 **/
 EXT4_BLOCK_GROUP_DESC *
 Ext4GetBlockGroupDesc (
@@ -301,6 +615,32 @@ Ext4GetBlockGroupDesc (
   IN UINT32          BlockGroup
   );
 
+/**
+   Sets up the block group descriptor table of the partition.
+   Descriptor blocks are only read (and verified) when a block group
+   in them is first needed, see Ext4GetBlockGroupDesc().
+
+   @param[in out]  Partition      Pointer to the ext4 partition.
+
+   @retval EFI_SUCCESS            The table was set up.
+   @retval EFI_OUT_OF_RESOURCES   The table could not be allocated.
+**/
+EFI_STATUS
+Ext4InitBlockGroupDescs (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
+/**
+   Frees the block group descriptor table of the partition,
+   and every descriptor block that was loaded.
+
+   @param[in out]  Partition      Pointer to the ext4 partition.
+**/
+VOID
+Ext4FreeBlockGroupDescs (
+  IN OUT EXT4_PARTITION  *Partition
+  );
+
 /**
    Checks inode number validity across superblock of the opened partition.
 
@@ -360,6 +700,42 @@ Ext4Read (
   IN OUT UINTN           *Length
   );
 
+/**
+   Reads from a regular file, going through its read-ahead window.
+   Reads that continue where the previous one left off start a non-blocking
+   read of the data that comes next. If the disk has no DISK_IO2 or read-ahead
+   is disabled, this is the same as Ext4Read.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[out]     Buffer        Pointer to the buffer.
+   @param[in]      Offset        Offset of the read.
+   @param[in out]  Length        Pointer to the length of the buffer, in bytes.
+                                 After a successful read, it's updated to the
+number of read bytes.
+
+   @return Status of the read operation.
+**/
+EFI_STATUS
+Ext4ReadWithReadAhead (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *File,
+  OUT    VOID            *Buffer,
+  IN     UINT64          Offset,
+  IN OUT UINTN           *Length
+  );
+
+/**
+   Frees a file's read-ahead window. A request still in flight is not waited
+   for, it's freed by its event once it completes.
+
+   @param[in out]  File          Pointer to the opened file.
+**/
+VOID
+Ext4FreeReadAhead (
+  IN OUT EXT4_FILE  *File
+  );
+
 /**
    Retrieves the size of the inode.
 
@@ -380,7 +756,8 @@ cover.
 will be copied to.
 
    @retval EFI_SUCCESS        Retrieval was successful.
-   @retval EFI_NO_MAPPING     Block has no mapping.
+   @retval EFI_NO_MAPPING     Block has no mapping. Extent describes the hole, starting at
+                              LogicalBlock (see Ext4SetHoleExtent).
 **/
 EFI_STATUS
 Ext4GetExtent (
@@ -390,6 +767,53 @@ Ext4GetExtent (
   OUT EXT4_EXTENT    *Extent
   );
 
+/**
+   DISK_IO2 request of a read-ahead window, and the buffer it reads into.
+   It's allocated separately from the file, so that a file closed while the
+   request is in flight can leave it to the token's event to free.
+ */
+typedef struct {
+  EFI_DISK_IO2_TOKEN    Token;
+  VOID                  *Buffer;
+  // Set by the token's event once the request completes
+  volatile BOOLEAN      Done;
+  // Set if the file was closed while the request was in flight; the token's event frees it then
+  BOOLEAN               Orphaned;
+} EXT4_READ_AHEAD_REQUEST;
+
+/**
+   Read-ahead window of a regular file.
+   While the caller consumes what it read, the next chunk of the file is fetched
+   with a non-blocking DISK_IO2 request into Request->Buffer. A window never spans
+   more than one extent, so it's always a single, physically contiguous request.
+   Its size is controlled by PcdExt4ReadAheadSize.
+ */
+typedef struct {
+  EXT4_READ_AHEAD_REQUEST    *Request;
+  UINTN                      BufferSize;
+  // File offset and length of the window
+  UINT64                     Offset;
+  UINTN                      Length;
+  // TRUE if the request is in flight, and Request may not be touched
+  BOOLEAN                    Pending;
+  // TRUE if Request->Buffer holds [Offset, Offset + Length) of the file
+  BOOLEAN                    Valid;
+  // Where the next read should start if the file is being read sequentially
+  UINT64                     NextOffset;
+} EXT4_READ_AHEAD;
+
+//
+// Cache of a file's extents: a flat array, sorted by logical block, of
+// extents that don't overlap each other.
+//
+typedef struct {
+  EXT4_EXTENT    *Extents;
+  UINTN          NumberExtents;
+  UINTN          Capacity;
+  // Index of the extent the last lookup found, so sequential reads don't need to search
+  UINTN          LastHit;
+} EXT4_EXTENTS_MAP;
+
 struct _Ext4File {
   EFI_FILE_PROTOCOL     Protocol;
   EXT4_INODE            *Inode;
@@ -401,12 +825,14 @@ struct _Ext4File {
 
   EXT4_PARTITION        *Partition;
 
-  ORDERED_COLLECTION    *ExtentsMap;
+  EXT4_EXTENTS_MAP      ExtentsMap;
 
   LIST_ENTRY            OpenFilesListNode;
 
   // Owning reference to this file's directory entry.
   EXT4_DENTRY           *Dentry;
+
+  EXT4_READ_AHEAD       ReadAhead;
 };
 
 #define EXT4_FILE_FROM_THIS(This)  BASE_CR ((This), EXT4_FILE, Protocol)
@@ -417,10 +843,13 @@ struct _Ext4File {
 /**
    Retrieves a directory entry.
 
-   @param[in]      Directory   Pointer to the opened directory.
-   @param[in]      NameUnicode Pointer to the UCS-2 formatted filename.
-   @param[in]      Partition   Pointer to the ext4 partition.
-   @param[out]     Result      Pointer to the destination directory entry.
+   @param[in]      Directory        Pointer to the opened directory.
+   @param[in]      NameUnicode      Pointer to the UCS-2 formatted filename.
+   @param[in]      Partition        Pointer to the ext4 partition.
+   @param[in]      CaseInsensitive  FALSE to only find the exact name, TRUE to find it
+                                    in any case. Callers only ask for the latter once
+                                    the exact name was not found.
+   @param[out]     Result           Pointer to the destination directory entry.
 
    @return The result of the operation.
 **/
@@ -429,6 +858,55 @@ Ext4RetrieveDirent (
   IN EXT4_FILE        *Directory,
   IN CONST CHAR16     *NameUnicode,
   IN EXT4_PARTITION   *Partition,
+  IN BOOLEAN          CaseInsensitive,
+  OUT EXT4_DIR_ENTRY  *Result
+  );
+
+/**
+   Searches a single directory block for an entry.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Block       Pointer to the directory block, Partition->BlockSize bytes long.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename, compared case-insensitively.
+                               Ignored if Utf8Name is not NULL.
+   @param[in]      Utf8Name    Optional pointer to the UTF-8 formatted filename, compared
+                               byte for byte.
+   @param[out]     Result      Pointer to the destination directory entry.
+
+   @retval EFI_SUCCESS           The entry was found.
+   @retval EFI_NOT_FOUND         The entry is not in this block.
+   @retval EFI_VOLUME_CORRUPTED  The block is corrupted.
+   @retval !EFI_SUCCESS          Failure.
+**/
+EFI_STATUS
+Ext4SearchDirentBlock (
+  IN EXT4_PARTITION   *Partition,
+  IN CONST CHAR8      *Block,
+  IN CONST CHAR16     *Name,
+  IN CONST CHAR8      *Utf8Name OPTIONAL,
+  OUT EXT4_DIR_ENTRY  *Result
+  );
+
+/**
+   Retrieves a directory entry using the directory's hash tree index.
+   Only exact (case-sensitive) matches are found.
+
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[out]     Result      Pointer to the destination directory entry.
+
+   @retval EFI_SUCCESS           The entry was found.
+   @retval EFI_NOT_FOUND         There's no entry with this exact name.
+   @retval EFI_UNSUPPORTED       The directory isn't indexed, or its index can't be used.
+   @retval EFI_VOLUME_CORRUPTED  The index is corrupted.
+   @retval !EFI_SUCCESS          Failure.
+**/
+EFI_STATUS
+Ext4HtreeRetrieveDirent (
+  IN EXT4_FILE        *Directory,
+  IN CONST CHAR16     *Name,
+  IN EXT4_PARTITION   *Partition,
   OUT EXT4_DIR_ENTRY  *Result
   );
 
@@ -1040,6 +1518,36 @@ Ext4FreeExtentsMap (
   IN EXT4_FILE  *File
   );
 
+/**
+   Caches a range of extents, by inserting them into the file's extents map.
+   Extents that overlap ones already cached are trimmed or skipped.
+
+   @param[in]      File          Pointer to the open file.
+   @param[in]      Extents       Pointer to an array of extents.
+   @param[in]      NumberExtents Length of the array.
+**/
+VOID
+Ext4CacheExtents (
+  IN EXT4_FILE          *File,
+  IN CONST EXT4_EXTENT  *Extents,
+  IN UINT16             NumberExtents
+  );
+
+/**
+   Gets an extent from the extents cache of the file.
+
+   @param[in]      File          Pointer to the open file.
+   @param[in]      Block         Block we want to grab.
+
+   @return Pointer to the extent, or NULL if it was not found.
+           The pointer is only valid until the next call to Ext4CacheExtents().
+**/
+EXT4_EXTENT *
+Ext4GetExtentFromMap (
+  IN EXT4_FILE  *File,
+  IN UINT32     Block
+  );
+
 /**
    Calculates the checksum of the given buffer.
    @param[in]      Partition     Pointer to the opened EXT4 partition.
@@ -1221,6 +1729,16 @@ Ext4SuperblockCheckMagic (
 #define EXT4_EXTENT_IS_UNINITIALIZED(Extent)                                   \
   ((Extent)->ee_len > EXT4_EXTENT_MAX_INITIALIZED)
 
+/**
+   Retrieves the first physical block of an extent.
+
+   @param[in] Extent      Pointer to the EXT4_EXTENT
+
+   @returns The extent's first physical block.
+**/
+#define EXT4_EXTENT_PHYSICAL_BLOCK(Extent)                                     \
+  (LShiftU64 ((Extent)->ee_start_hi, 32) | (Extent)->ee_start_lo)
+
 /**
    Retrieves the extent's length, dealing with uninitialized extents in the
 process.
@@ -1234,6 +1752,22 @@ Ext4GetExtentLength (
   IN CONST EXT4_EXTENT  *Extent
   );
 
+/**
+   Fills in an extent that describes a file hole.
+   Holes are described as uninitialized extents, since both read back as zeroes.
+
+   @param[out]     Extent        Pointer to the extent.
+   @param[in]      LogicalBlock  First block of the hole.
+   @param[in]      EndBlock      Block where the hole ends (exclusive). Holes longer than
+                                 what an uninitialized extent can describe are truncated.
+**/
+VOID
+Ext4SetHoleExtent (
+  OUT EXT4_EXTENT    *Extent,
+  IN  EXT4_BLOCK_NR  LogicalBlock,
+  IN  EXT4_BLOCK_NR  EndBlock
+  );
+
 /**
    Retrieves an extent from an EXT2/3 inode (with a blockmap).
    @param[in]      Partition     Pointer to the opened EXT4 partition.
@@ -1242,7 +1776,7 @@ Ext4GetExtentLength (
    @param[out]     Extent        Pointer to the output buffer, where the extent will be copied to.
 
    @retval EFI_SUCCESS        Retrieval was successful.
-   @retval EFI_NO_MAPPING     Block has no mapping.
+   @retval EFI_NO_MAPPING     Block has no mapping. Extent describes the hole.
 **/
 EFI_STATUS
 Ext4GetBlocks (
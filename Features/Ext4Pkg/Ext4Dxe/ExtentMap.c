@@ -0,0 +1,259 @@
+/** @file
+  Per-file cache of extents
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "Ext4Dxe.h"
+
+// The inode itself holds up to 4 extents, which is all most files ever need
+#define EXT4_EXTENTS_MAP_MIN_CAPACITY  4
+
+/**
+   Retrieves the extent's length, dealing with uninitialized extents in the process.
+
+   @param[in] Extent      Pointer to the EXT4_EXTENT
+
+   @returns Extent's length, in filesystem blocks.
+**/
+EXT4_BLOCK_NR
+Ext4GetExtentLength (
+  IN CONST EXT4_EXTENT  *Extent
+  )
+{
+  // If it's an uninitialized extent, the true length is ee_len - 2^15
+  if (EXT4_EXTENT_IS_UNINITIALIZED (Extent)) {
+    return Extent->ee_len - EXT4_EXTENT_MAX_INITIALIZED;
+  }
+
+  return Extent->ee_len;
+}
+
+/**
+   Checks if an extent contains a logical block.
+
+   @param[in] Extent      Pointer to the EXT4_EXTENT
+   @param[in] Block       Logical block.
+
+   @return TRUE if the block is inside the extent, FALSE otherwise.
+**/
+STATIC
+BOOLEAN
+Ext4ExtentContains (
+  IN CONST EXT4_EXTENT  *Extent,
+  IN UINT32             Block
+  )
+{
+  // Note that logical blocks are 32-bits in size, so this can't overflow.
+  return (BOOLEAN)((Block >= Extent->ee_block) && (Block - Extent->ee_block < Ext4GetExtentLength (Extent)));
+}
+
+/**
+   Finds the first extent in the map that starts after a logical block.
+
+   @param[in]      Map           Pointer to the extents map.
+   @param[in]      Block         Logical block.
+
+   @return Index of the extent, or the number of extents if every extent
+           starts at or before Block.
+**/
+STATIC
+UINTN
+Ext4ExtentsMapUpperBound (
+  IN CONST EXT4_EXTENTS_MAP  *Map,
+  IN UINT32                  Block
+  )
+{
+  UINTN  Low;
+  UINTN  High;
+  UINTN  Middle;
+
+  Low  = 0;
+  High = Map->NumberExtents;
+
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+
+    if (Map->Extents[Middle].ee_block <= Block) {
+      Low = Middle + 1;
+    } else {
+      High = Middle;
+    }
+  }
+
+  return Low;
+}
+
+/**
+   Initialises the (empty) extents map, that will work as a cache of extents.
+
+   @param[in]      File        Pointer to the open file.
+
+   @return Result of the operation.
+**/
+EFI_STATUS
+Ext4InitExtentsMap (
+  IN EXT4_FILE  *File
+  )
+{
+  // The array is only allocated once there's something to cache
+  ZeroMem (&File->ExtentsMap, sizeof (EXT4_EXTENTS_MAP));
+  return EFI_SUCCESS;
+}
+
+/**
+   Frees the extents map, deleting every extent stored.
+
+   @param[in]      File        Pointer to the open file.
+**/
+VOID
+Ext4FreeExtentsMap (
+  IN EXT4_FILE  *File
+  )
+{
+  if (File->ExtentsMap.Extents != NULL) {
+    FreePool (File->ExtentsMap.Extents);
+  }
+
+  ZeroMem (&File->ExtentsMap, sizeof (EXT4_EXTENTS_MAP));
+}
+
+/**
+   Caches a range of extents, by inserting them into the file's extents map.
+   Extents that overlap ones already cached are trimmed or skipped.
+
+   @param[in]      File          Pointer to the open file.
+   @param[in]      Extents       Pointer to an array of extents.
+   @param[in]      NumberExtents Length of the array.
+**/
+VOID
+Ext4CacheExtents (
+  IN EXT4_FILE          *File,
+  IN CONST EXT4_EXTENT  *Extents,
+  IN UINT16             NumberExtents
+  )
+{
+  EXT4_EXTENTS_MAP   *Map;
+  CONST EXT4_EXTENT  *Neighbour;
+  EXT4_EXTENT        Extent;
+  EXT4_EXTENT        *NewExtents;
+  EXT4_BLOCK_NR      Length;
+  UINTN              NewCapacity;
+  UINTN              Index;
+  UINT16             Idx;
+
+  Map = &File->ExtentsMap;
+
+  /* Note that any out of memory condition might mean we don't get to cache a whole leaf of extents,
+   * which is fine, since it's only a cache.
+   */
+
+  for (Idx = 0; Idx < NumberExtents; Idx++, Extents++) {
+    CopyMem (&Extent, Extents, sizeof (EXT4_EXTENT));
+
+    Length = Ext4GetExtentLength (&Extent);
+
+    if (Length == 0) {
+      continue;
+    }
+
+    Index = Ext4ExtentsMapUpperBound (Map, Extent.ee_block);
+
+    // If the previous extent covers our start (or starts at the same block), it's already cached.
+    if (Index != 0) {
+      Neighbour = &Map->Extents[Index - 1];
+
+      if (Ext4ExtentContains (Neighbour, Extent.ee_block) || (Neighbour->ee_block == Extent.ee_block)) {
+        continue;
+      }
+    }
+
+    // If the next extent starts before we end, keep the part that comes before it.
+    // Extents of files that use block maps are built on demand, and can overlap.
+    if (Index < Map->NumberExtents) {
+      Neighbour = &Map->Extents[Index];
+
+      if (Neighbour->ee_block - Extent.ee_block < Length) {
+        Length         = Neighbour->ee_block - Extent.ee_block;
+        Extent.ee_len  = (UINT16)(EXT4_EXTENT_IS_UNINITIALIZED (&Extent) ? EXT4_EXTENT_MAX_INITIALIZED : 0);
+        Extent.ee_len += (UINT16)Length;
+      }
+    }
+
+    if (Map->NumberExtents == Map->Capacity) {
+      NewCapacity = MAX (Map->Capacity * 2, EXT4_EXTENTS_MAP_MIN_CAPACITY);
+      NewExtents  = ReallocatePool (
+                      Map->Capacity * sizeof (EXT4_EXTENT),
+                      NewCapacity * sizeof (EXT4_EXTENT),
+                      Map->Extents
+                      );
+
+      if (NewExtents == NULL) {
+        return;
+      }
+
+      Map->Extents  = NewExtents;
+      Map->Capacity = NewCapacity;
+    }
+
+    // Leaves are sorted and usually read in order, so this tends to be an append.
+    CopyMem (
+      &Map->Extents[Index + 1],
+      &Map->Extents[Index],
+      (Map->NumberExtents - Index) * sizeof (EXT4_EXTENT)
+      );
+    CopyMem (&Map->Extents[Index], &Extent, sizeof (EXT4_EXTENT));
+    Map->NumberExtents++;
+
+    if ((Index <= Map->LastHit) && (Map->NumberExtents > 1)) {
+      Map->LastHit++;
+    }
+  }
+}
+
+/**
+   Gets an extent from the extents cache of the file.
+
+   @param[in]      File          Pointer to the open file.
+   @param[in]      Block         Block we want to grab.
+
+   @return Pointer to the extent, or NULL if it was not found.
+           The pointer is only valid until the next call to Ext4CacheExtents().
+**/
+EXT4_EXTENT *
+Ext4GetExtentFromMap (
+  IN EXT4_FILE  *File,
+  IN UINT32     Block
+  )
+{
+  EXT4_EXTENTS_MAP  *Map;
+  UINTN             Index;
+
+  Map = &File->ExtentsMap;
+
+  if (Map->NumberExtents == 0) {
+    return NULL;
+  }
+
+  // Sequential reads keep hitting the same extent, and then move on to the next one.
+  if (Map->LastHit < Map->NumberExtents) {
+    if (Ext4ExtentContains (&Map->Extents[Map->LastHit], Block)) {
+      return &Map->Extents[Map->LastHit];
+    }
+
+    if ((Map->LastHit + 1 < Map->NumberExtents) && Ext4ExtentContains (&Map->Extents[Map->LastHit + 1], Block)) {
+      Map->LastHit++;
+      return &Map->Extents[Map->LastHit];
+    }
+  }
+
+  Index = Ext4ExtentsMapUpperBound (Map, Block);
+
+  if ((Index == 0) || !Ext4ExtentContains (&Map->Extents[Index - 1], Block)) {
+    return NULL;
+  }
+
+  Map->LastHit = Index - 1;
+  return &Map->Extents[Map->LastHit];
+}
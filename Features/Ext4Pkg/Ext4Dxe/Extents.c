@@ -33,34 +33,6 @@ Ext4CalculateExtentChecksum (
   IN CONST EXT4_FILE           *File
   );
 
-/**
-   Caches a range of extents, by allocating pool memory for each extent and adding it to the tree.
-
-   @param[in]      File        Pointer to the open file.
-   @param[in]      Extents     Pointer to an array of extents.
-   @param[in]      NumberExtents Length of the array.
-**/
-VOID
-Ext4CacheExtents (
-  IN EXT4_FILE          *File,
-  IN CONST EXT4_EXTENT  *Extents,
-  IN UINT16             NumberExtents
-  );
-
-/**
-   Gets an extent from the extents cache of the file.
-
-   @param[in]      File          Pointer to the open file.
-   @param[in]      Block         Block we want to grab.
-
-   @return Pointer to the extent, or NULL if it was not found.
-**/
-EXT4_EXTENT *
-Ext4GetExtentFromMap (
-  IN EXT4_FILE  *File,
-  IN UINT32     Block
-  );
-
 /**
    Retrieves the pointer to the top of the extent tree.
    @param[in]      Inode         Pointer to the inode structure.
@@ -237,7 +209,8 @@ Ext4ExtentIdxLeafBlock (
    @param[out]     Extent        Pointer to the output buffer, where the extent will be copied to.
 
    @retval EFI_SUCCESS        Retrieval was successful.
-   @retval EFI_NO_MAPPING     Block has no mapping.
+   @retval EFI_NO_MAPPING     Block has no mapping. Extent describes the hole, starting at
+                              LogicalBlock (see Ext4SetHoleExtent).
 **/
 EFI_STATUS
 Ext4GetExtent (
@@ -256,6 +229,7 @@ Ext4GetExtent (
   EFI_STATUS          Status;
   UINT32              MaxExtentsPerNode;
   EXT4_BLOCK_NR       BlockNumber;
+  UINT64              HoleEnd;
 
   Inode  = File->Inode;
   Ext    = NULL;
@@ -265,6 +239,7 @@ Ext4GetExtent (
 
   // ext4 does not have support for logical block numbers bigger than UINT32_MAX
   if (LogicalBlock > (UINT32)-1) {
+    Ext4SetHoleExtent (Extent, LogicalBlock, LogicalBlock + 1);
     return EFI_NO_MAPPING;
   }
 
@@ -304,6 +279,10 @@ Ext4GetExtent (
   // and so are individual entries.
   MaxExtentsPerNode = (Partition->BlockSize / sizeof (EXT4_EXTENT)) - 1;
 
+  // If the block turns out to be a hole, it can't extend past the start of the next
+  // subtree, as far as the indices we walk through can tell.
+  HoleEnd = (UINT64)(UINT32)-1 + 1;
+
   while (ExtHeader->eh_depth != 0) {
     CurrentDepth--;
     // While depth != 0, we're traversing the tree itself and not any leaves
@@ -315,6 +294,10 @@ Ext4GetExtent (
     Index       = Ext4BinsearchExtentIndex (ExtHeader, LogicalBlock);
     BlockNumber = Ext4ExtentIdxLeafBlock (Index);
 
+    if (Index + 1 < (EXT4_EXTENT_INDEX *)(ExtHeader + 1) + ExtHeader->eh_entries) {
+      HoleEnd = MIN (HoleEnd, Index[1].ei_block);
+    }
+
     // Check that block isn't file hole
     if (BlockNumber == EXT4_BLOCK_FILE_HOLE) {
       if (Buffer != NULL) {
@@ -333,7 +316,7 @@ Ext4GetExtent (
 
     // Read the leaf block onto the previously-allocated buffer.
 
-    Status = Ext4ReadBlocks (Partition, Buffer, 1, BlockNumber);
+    Status = Ext4ReadCachedBlocks (Partition, Buffer, 1, BlockNumber);
     if (EFI_ERROR (Status)) {
       FreePool (Buffer);
       return Status;
@@ -367,16 +350,23 @@ Ext4GetExtent (
 
   Ext = Ext4BinsearchExtentExt (ExtHeader, LogicalBlock);
 
-  if (!Ext) {
-    if (Buffer != NULL) {
-      FreePool (Buffer);
+  if ((Ext == NULL) || (LogicalBlock < Ext->ee_block) ||
+      (Ext->ee_block + Ext4GetExtentLength (Ext) <= LogicalBlock))
+  {
+    // This extent does not cover the block, so it's a hole that goes up to the next extent.
+    // Note that the binary search may land before the first extent.
+    if (Ext == NULL) {
+      Ext = (EXT4_EXTENT *)(ExtHeader + 1) + ExtHeader->eh_entries;
+    } else if (LogicalBlock >= Ext->ee_block) {
+      Ext++;
     }
 
-    return EFI_NO_MAPPING;
-  }
+    if (Ext < (EXT4_EXTENT *)(ExtHeader + 1) + ExtHeader->eh_entries) {
+      HoleEnd = MIN (HoleEnd, Ext->ee_block);
+    }
+
+    Ext4SetHoleExtent (Extent, LogicalBlock, HoleEnd);
 
-  if (!((LogicalBlock >= Ext->ee_block) && (Ext->ee_block + Ext4GetExtentLength (Ext) > LogicalBlock))) {
-    // This extent does not cover the block
     if (Buffer != NULL) {
       FreePool (Buffer);
     }
@@ -393,196 +383,6 @@ Ext4GetExtent (
   return EFI_SUCCESS;
 }
 
-/**
-  Compare two EXT4_EXTENT structs.
-  Used in the extent map's ORDERED_COLLECTION.
-
-  @param[in] UserStruct1  Pointer to the first user structure.
-
-  @param[in] UserStruct2  Pointer to the second user structure.
-
-  @retval <0  If UserStruct1 compares less than UserStruct2.
-
-  @retval  0  If UserStruct1 compares equal to UserStruct2.
-
-  @retval >0  If UserStruct1 compares greater than UserStruct2.
-**/
-STATIC
-INTN
-EFIAPI
-Ext4ExtentsMapStructCompare (
-  IN CONST VOID  *UserStruct1,
-  IN CONST VOID  *UserStruct2
-  )
-{
-  CONST EXT4_EXTENT  *Extent1;
-  CONST EXT4_EXTENT  *Extent2;
-
-  Extent1 = UserStruct1;
-  Extent2 = UserStruct2;
-
-  return Extent1->ee_block < Extent2->ee_block ? -1 :
-         Extent1->ee_block > Extent2->ee_block ? 1 : 0;
-}
-
-/**
-  Compare a standalone key against a EXT4_EXTENT containing an embedded key.
-  Used in the extent map's ORDERED_COLLECTION.
-
-  @param[in] StandaloneKey  Pointer to the bare key.
-
-  @param[in] UserStruct     Pointer to the user structure with the embedded
-                            key.
-
-  @retval <0  If StandaloneKey compares less than UserStruct's key.
-
-  @retval  0  If StandaloneKey compares equal to UserStruct's key.
-
-  @retval >0  If StandaloneKey compares greater than UserStruct's key.
-**/
-STATIC
-INTN
-EFIAPI
-Ext4ExtentsMapKeyCompare (
-  IN CONST VOID  *StandaloneKey,
-  IN CONST VOID  *UserStruct
-  )
-{
-  CONST EXT4_EXTENT  *Extent;
-  UINT32             Block;
-
-  // Note that logical blocks are 32-bits in size so no truncation can happen here
-  // with regards to 32-bit architectures.
-  Extent = UserStruct;
-  Block  = (UINT32)(UINTN)StandaloneKey;
-
-  if ((Block >= Extent->ee_block) && (Block - Extent->ee_block < Ext4GetExtentLength (Extent))) {
-    return 0;
-  }
-
-  return Block < Extent->ee_block ? -1 :
-         Block > Extent->ee_block ? 1 : 0;
-}
-
-/**
-   Initialises the (empty) extents map, that will work as a cache of extents.
-
-   @param[in]      File        Pointer to the open file.
-
-   @return Result of the operation.
-**/
-EFI_STATUS
-Ext4InitExtentsMap (
-  IN EXT4_FILE  *File
-  )
-{
-  File->ExtentsMap = OrderedCollectionInit (Ext4ExtentsMapStructCompare, Ext4ExtentsMapKeyCompare);
-  if (!File->ExtentsMap) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  return EFI_SUCCESS;
-}
-
-/**
-   Frees the extents map, deleting every extent stored.
-
-   @param[in]      File        Pointer to the open file.
-**/
-VOID
-Ext4FreeExtentsMap (
-  IN EXT4_FILE  *File
-  )
-{
-  // Keep calling Min(), so we get an arbitrary node we can delete.
-  // If Min() returns NULL, it's empty.
-
-  ORDERED_COLLECTION_ENTRY  *MinEntry;
-  EXT4_EXTENT               *Ext;
-
-  MinEntry = NULL;
-
-  while ((MinEntry = OrderedCollectionMin (File->ExtentsMap)) != NULL) {
-    OrderedCollectionDelete (File->ExtentsMap, MinEntry, (VOID **)&Ext);
-    FreePool (Ext);
-  }
-
-  ASSERT (OrderedCollectionIsEmpty (File->ExtentsMap));
-
-  OrderedCollectionUninit (File->ExtentsMap);
-  File->ExtentsMap = NULL;
-}
-
-/**
-   Caches a range of extents, by allocating pool memory for each extent and adding it to the tree.
-
-   @param[in]      File        Pointer to the open file.
-   @param[in]      Extents     Pointer to an array of extents.
-   @param[in]      NumberExtents Length of the array.
-**/
-VOID
-Ext4CacheExtents (
-  IN EXT4_FILE          *File,
-  IN CONST EXT4_EXTENT  *Extents,
-  IN UINT16             NumberExtents
-  )
-{
-  UINT16       Idx;
-  EXT4_EXTENT  *Extent;
-  EFI_STATUS   Status;
-
-  /* Note that any out of memory condition might mean we don't get to cache a whole leaf of extents
-   * in which case, future insertions might fail.
-   */
-
-  for (Idx = 0; Idx < NumberExtents; Idx++, Extents++) {
-    Extent = AllocatePool (sizeof (EXT4_EXTENT));
-
-    if (Extent == NULL) {
-      return;
-    }
-
-    CopyMem (Extent, Extents, sizeof (EXT4_EXTENT));
-    Status = OrderedCollectionInsert (File->ExtentsMap, NULL, Extent);
-
-    // EFI_ALREADY_STARTED = already exists in the tree.
-    if (EFI_ERROR (Status)) {
-      FreePool (Extent);
-
-      if (Status == EFI_ALREADY_STARTED) {
-        continue;
-      }
-
-      return;
-    }
-  }
-}
-
-/**
-   Gets an extent from the extents cache of the file.
-
-   @param[in]      File          Pointer to the open file.
-   @param[in]      Block         Block we want to grab.
-
-   @return Pointer to the extent, or NULL if it was not found.
-**/
-EXT4_EXTENT *
-Ext4GetExtentFromMap (
-  IN EXT4_FILE  *File,
-  IN UINT32     Block
-  )
-{
-  ORDERED_COLLECTION_ENTRY  *Entry;
-
-  Entry = OrderedCollectionFind (File->ExtentsMap, (CONST VOID *)(UINTN)Block);
-
-  if (Entry == NULL) {
-    return NULL;
-  }
-
-  return OrderedCollectionUserStruct (Entry);
-}
-
 /**
    Calculates the checksum of the extent data block.
    @param[in]      ExtHeader     Pointer to the EXT4_EXTENT_HEADER.
@@ -638,21 +438,31 @@ Ext4CheckExtentChecksum (
 }
 
 /**
-   Retrieves the extent's length, dealing with uninitialized extents in the process.
+   Fills in an extent that describes a file hole.
+   Holes are described as uninitialized extents, since both read back as zeroes.
 
-   @param[in] Extent      Pointer to the EXT4_EXTENT
-
-   @returns Extent's length, in filesystem blocks.
+   @param[out]     Extent        Pointer to the extent.
+   @param[in]      LogicalBlock  First block of the hole.
+   @param[in]      EndBlock      Block where the hole ends (exclusive). Holes longer than
+                                 what an uninitialized extent can describe are truncated.
 **/
-EXT4_BLOCK_NR
-Ext4GetExtentLength (
-  IN CONST EXT4_EXTENT  *Extent
+VOID
+Ext4SetHoleExtent (
+  OUT EXT4_EXTENT    *Extent,
+  IN  EXT4_BLOCK_NR  LogicalBlock,
+  IN  EXT4_BLOCK_NR  EndBlock
   )
 {
-  // If it's an uninitialized extent, the true length is ee_len - 2^15
-  if (EXT4_EXTENT_IS_UNINITIALIZED (Extent)) {
-    return Extent->ee_len - EXT4_EXTENT_MAX_INITIALIZED;
+  EXT4_BLOCK_NR  Length;
+
+  Length = 1;
+
+  if (EndBlock > LogicalBlock) {
+    Length = MIN (EndBlock - LogicalBlock, EXT4_EXTENT_MAX_INITIALIZED - 1);
   }
 
-  return Extent->ee_len;
+  Extent->ee_block    = (UINT32)LogicalBlock;
+  Extent->ee_len      = (UINT16)(EXT4_EXTENT_MAX_INITIALIZED + Length);
+  Extent->ee_start_hi = 0;
+  Extent->ee_start_lo = 0;
 }
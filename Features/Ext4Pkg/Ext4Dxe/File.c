@@ -435,6 +435,7 @@ Ext4CloseInternal (
 
   DEBUG ((DEBUG_FS, "[ext4] Closed file %p (inode %lu)\n", File, File->InodeNum));
   RemoveEntryList (&File->OpenFilesListNode);
+  Ext4FreeReadAhead (File);
   FreePool (File->Inode);
   Ext4FreeExtentsMap (File);
   Ext4UnrefDentry (File->Dentry);
@@ -501,7 +502,7 @@ Ext4ReadFile (
   ASSERT (Ext4FileIsOpenable (File));
 
   if (Ext4FileIsReg (File)) {
-    Status = Ext4Read (Partition, File, Buffer, File->Position, BufferSize);
+    Status = Ext4ReadWithReadAhead (Partition, File, Buffer, File->Position, BufferSize);
     if (Status == EFI_SUCCESS) {
       File->Position += *BufferSize;
     }
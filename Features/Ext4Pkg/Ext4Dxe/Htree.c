@@ -0,0 +1,618 @@
+/** @file
+  Hash tree (dir_index) directory lookups
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "Ext4Dxe.h"
+
+#include <Library/BaseUcs2Utf8Lib.h>
+
+// Hashes are always even (bit 0 is the continuation bit), and this is reserved
+// as the "end of directory" hash.
+#define EXT4_HTREE_EOF_32BIT  0x7fffffffU
+
+#define EXT4_TEA_DELTA  0x9E3779B9
+
+#define EXT4_MD4_K1  0
+#define EXT4_MD4_K2  013240474631UL
+#define EXT4_MD4_K3  015666365641UL
+
+#define EXT4_MD4_F(x, y, z)  ((z) ^ ((x) & ((y) ^ (z))))
+#define EXT4_MD4_G(x, y, z)  (((x) & (y)) + (((x) ^ (y)) & (z)))
+#define EXT4_MD4_H(x, y, z)  ((x) ^ (y) ^ (z))
+
+#define EXT4_MD4_ROUND(f, a, b, c, d, x, s)  \
+  ((a) += f ((b), (c), (d)) + (x), (a) = LRotU32 ((a), (s)))
+
+// A level of the index, as we walk down it
+typedef struct {
+  CHAR8            *Block;
+  EXT4_DX_ENTRY    *Entries;
+  UINT16           Count;
+  UINT16           At;
+} EXT4_DX_FRAME;
+
+/**
+   Runs the TEA block cipher over Buffer, as the ext4 TEA hash does.
+
+   @param[in out]  Buffer      Hash state.
+   @param[in]      In          Data to hash.
+**/
+STATIC
+VOID
+Ext4TeaTransform (
+  IN OUT UINT32  Buffer[4],
+  IN CONST UINT32  In[4]
+  )
+{
+  UINT32  Sum;
+  UINT32  B0;
+  UINT32  B1;
+  UINTN   Round;
+
+  Sum = 0;
+  B0  = Buffer[0];
+  B1  = Buffer[1];
+
+  for (Round = 0; Round < 16; Round++) {
+    Sum += EXT4_TEA_DELTA;
+    B0  += ((B1 << 4) + In[0]) ^ (B1 + Sum) ^ ((B1 >> 5) + In[1]);
+    B1  += ((B0 << 4) + In[2]) ^ (B0 + Sum) ^ ((B0 >> 5) + In[3]);
+  }
+
+  Buffer[0] += B0;
+  Buffer[1] += B1;
+}
+
+/**
+   Runs the cut-down MD4 transform used by the half_md4 hash.
+
+   @param[in out]  Buffer      Hash state.
+   @param[in]      In          Data to hash.
+**/
+STATIC
+VOID
+Ext4HalfMd4Transform (
+  IN OUT UINT32  Buffer[4],
+  IN CONST UINT32  In[8]
+  )
+{
+  UINT32  A;
+  UINT32  B;
+  UINT32  C;
+  UINT32  D;
+
+  A = Buffer[0];
+  B = Buffer[1];
+  C = Buffer[2];
+  D = Buffer[3];
+
+  // Round 1
+  EXT4_MD4_ROUND (EXT4_MD4_F, A, B, C, D, In[0] + EXT4_MD4_K1, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_F, D, A, B, C, In[1] + EXT4_MD4_K1, 7);
+  EXT4_MD4_ROUND (EXT4_MD4_F, C, D, A, B, In[2] + EXT4_MD4_K1, 11);
+  EXT4_MD4_ROUND (EXT4_MD4_F, B, C, D, A, In[3] + EXT4_MD4_K1, 19);
+  EXT4_MD4_ROUND (EXT4_MD4_F, A, B, C, D, In[4] + EXT4_MD4_K1, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_F, D, A, B, C, In[5] + EXT4_MD4_K1, 7);
+  EXT4_MD4_ROUND (EXT4_MD4_F, C, D, A, B, In[6] + EXT4_MD4_K1, 11);
+  EXT4_MD4_ROUND (EXT4_MD4_F, B, C, D, A, In[7] + EXT4_MD4_K1, 19);
+
+  // Round 2
+  EXT4_MD4_ROUND (EXT4_MD4_G, A, B, C, D, In[1] + EXT4_MD4_K2, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_G, D, A, B, C, In[3] + EXT4_MD4_K2, 5);
+  EXT4_MD4_ROUND (EXT4_MD4_G, C, D, A, B, In[5] + EXT4_MD4_K2, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_G, B, C, D, A, In[7] + EXT4_MD4_K2, 13);
+  EXT4_MD4_ROUND (EXT4_MD4_G, A, B, C, D, In[0] + EXT4_MD4_K2, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_G, D, A, B, C, In[2] + EXT4_MD4_K2, 5);
+  EXT4_MD4_ROUND (EXT4_MD4_G, C, D, A, B, In[4] + EXT4_MD4_K2, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_G, B, C, D, A, In[6] + EXT4_MD4_K2, 13);
+
+  // Round 3
+  EXT4_MD4_ROUND (EXT4_MD4_H, A, B, C, D, In[3] + EXT4_MD4_K3, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_H, D, A, B, C, In[7] + EXT4_MD4_K3, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_H, C, D, A, B, In[2] + EXT4_MD4_K3, 11);
+  EXT4_MD4_ROUND (EXT4_MD4_H, B, C, D, A, In[6] + EXT4_MD4_K3, 15);
+  EXT4_MD4_ROUND (EXT4_MD4_H, A, B, C, D, In[1] + EXT4_MD4_K3, 3);
+  EXT4_MD4_ROUND (EXT4_MD4_H, D, A, B, C, In[5] + EXT4_MD4_K3, 9);
+  EXT4_MD4_ROUND (EXT4_MD4_H, C, D, A, B, In[0] + EXT4_MD4_K3, 11);
+  EXT4_MD4_ROUND (EXT4_MD4_H, B, C, D, A, In[4] + EXT4_MD4_K3, 15);
+
+  Buffer[0] += A;
+  Buffer[1] += B;
+  Buffer[2] += C;
+  Buffer[3] += D;
+}
+
+/**
+   Calculates the legacy directory hash.
+
+   @param[in]      Name        Pointer to the name.
+   @param[in]      Length      Length of the name.
+   @param[in]      Unsigned    TRUE if chars are to be treated as unsigned.
+
+   @return The hash.
+**/
+STATIC
+UINT32
+Ext4LegacyHash (
+  IN CONST CHAR8  *Name,
+  IN UINTN        Length,
+  IN BOOLEAN      Unsigned
+  )
+{
+  UINT32  Hash;
+  UINT32  Hash0;
+  UINT32  Hash1;
+  INT32   Char;
+
+  Hash0 = 0x12a3fe2d;
+  Hash1 = 0x37abe8f9;
+
+  while (Length-- != 0) {
+    Char = Unsigned ? (INT32)(UINT8)*Name : (INT32)(INT8)*Name;
+    Name++;
+
+    Hash = Hash1 + (Hash0 ^ (UINT32)(Char * 7152373));
+
+    if ((Hash & 0x80000000) != 0) {
+      Hash -= 0x7fffffff;
+    }
+
+    Hash1 = Hash0;
+    Hash0 = Hash;
+  }
+
+  return Hash0 << 1;
+}
+
+/**
+   Packs (part of) a name into 32-bit words, padding with the name's length.
+
+   @param[in]      Name        Pointer to the name.
+   @param[in]      Length      Remaining length of the name.
+   @param[out]     Buffer      Destination words.
+   @param[in]      NumWords    Number of words in Buffer.
+   @param[in]      Unsigned    TRUE if chars are to be treated as unsigned.
+**/
+STATIC
+VOID
+Ext4StrToHashBuf (
+  IN CONST CHAR8  *Name,
+  IN UINTN        Length,
+  OUT UINT32      *Buffer,
+  IN UINTN        NumWords,
+  IN BOOLEAN      Unsigned
+  )
+{
+  UINT32  Pad;
+  UINT32  Value;
+  UINTN   Index;
+  INT32   Char;
+
+  Pad  = (UINT32)Length | ((UINT32)Length << 8);
+  Pad |= Pad << 16;
+
+  Value = Pad;
+
+  if (Length > NumWords * 4) {
+    Length = NumWords * 4;
+  }
+
+  for (Index = 0; Index < Length; Index++) {
+    Char  = Unsigned ? (INT32)(UINT8)Name[Index] : (INT32)(INT8)Name[Index];
+    Value = (UINT32)Char + (Value << 8);
+
+    if ((Index % 4) == 3) {
+      *Buffer++ = Value;
+      Value     = Pad;
+      NumWords--;
+    }
+  }
+
+  if (NumWords != 0) {
+    *Buffer++ = Value;
+    NumWords--;
+  }
+
+  while (NumWords-- != 0) {
+    *Buffer++ = Pad;
+  }
+}
+
+/**
+   Calculates the hash tree hash of a name.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Name        Pointer to the name.
+   @param[in]      Length      Length of the name.
+   @param[in]      HashVersion One of EXT4_DX_HASH_*.
+
+   @return The hash, with bit 0 clear.
+**/
+STATIC
+UINT32
+Ext4HtreeHash (
+  IN CONST EXT4_PARTITION  *Partition,
+  IN CONST CHAR8           *Name,
+  IN UINTN                 Length,
+  IN UINT8                 HashVersion
+  )
+{
+  UINT32   Buffer[4];
+  UINT32   In[8];
+  UINT32   Hash;
+  UINTN    Index;
+  BOOLEAN  Unsigned;
+
+  // Default seed, used if the superblock's one is all zeroes
+  Buffer[0] = 0x67452301;
+  Buffer[1] = 0xefcdab89;
+  Buffer[2] = 0x98badcfe;
+  Buffer[3] = 0x10325476;
+
+  for (Index = 0; Index < 4; Index++) {
+    if (Partition->SuperBlock.s_hash_seed[Index] != 0) {
+      CopyMem (Buffer, Partition->SuperBlock.s_hash_seed, sizeof (Buffer));
+      break;
+    }
+  }
+
+  Unsigned = (BOOLEAN)(HashVersion >= EXT4_DX_HASH_LEGACY_UNSIGNED);
+
+  switch (HashVersion) {
+    case EXT4_DX_HASH_LEGACY:
+    case EXT4_DX_HASH_LEGACY_UNSIGNED:
+      Hash = Ext4LegacyHash (Name, Length, Unsigned);
+      break;
+    case EXT4_DX_HASH_HALF_MD4:
+    case EXT4_DX_HASH_HALF_MD4_UNSIGNED:
+      do {
+        Ext4StrToHashBuf (Name, Length, In, 8, Unsigned);
+        Ext4HalfMd4Transform (Buffer, In);
+        Name  += 32;
+        Length = Length > 32 ? Length - 32 : 0;
+      } while (Length != 0);
+
+      Hash = Buffer[1];
+      break;
+    case EXT4_DX_HASH_TEA:
+    case EXT4_DX_HASH_TEA_UNSIGNED:
+      do {
+        Ext4StrToHashBuf (Name, Length, In, 4, Unsigned);
+        Ext4TeaTransform (Buffer, In);
+        Name  += 16;
+        Length = Length > 16 ? Length - 16 : 0;
+      } while (Length != 0);
+
+      Hash = Buffer[0];
+      break;
+    default:
+      ASSERT (FALSE);
+      return 0;
+  }
+
+  Hash &= ~1U;
+
+  if (Hash == (EXT4_HTREE_EOF_32BIT << 1)) {
+    Hash = (EXT4_HTREE_EOF_32BIT - 1) << 1;
+  }
+
+  return Hash;
+}
+
+/**
+   Reads a block of the directory.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Block       Logical block number.
+   @param[out]     Buffer      Pointer to a buffer of Partition->BlockSize bytes.
+
+   @return Status of the read.
+**/
+STATIC
+EFI_STATUS
+Ext4HtreeReadBlock (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_FILE       *Directory,
+  IN  UINT32          Block,
+  OUT CHAR8           *Buffer
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Length;
+
+  Block &= EXT4_DX_BLOCK_MASK;
+
+  if (EXT4_BLOCK_TO_BYTES (Partition, Block) >= EXT4_INODE_SIZE (Directory->Inode)) {
+    DEBUG ((DEBUG_ERROR, "[ext4] htree block %u out of range\n", Block));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Length = Partition->BlockSize;
+
+  Status = Ext4Read (Partition, Directory, Buffer, EXT4_BLOCK_TO_BYTES (Partition, Block), &Length);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  return Length == Partition->BlockSize ? EFI_SUCCESS : EFI_VOLUME_CORRUPTED;
+}
+
+/**
+   Sets up a frame for an index block and finds the entry covering Hash.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in out]  Frame       Pointer to the frame; Frame->Block must hold the index block.
+   @param[in]      Offset      Offset of the EXT4_DX_COUNT_LIMIT inside the block.
+   @param[in]      Hash        Hash we're looking for.
+
+   @retval EFI_SUCCESS           The frame was set up.
+   @retval EFI_VOLUME_CORRUPTED  The index block is corrupted.
+**/
+STATIC
+EFI_STATUS
+Ext4HtreeProbeNode (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT EXT4_DX_FRAME   *Frame,
+  IN     UINTN           Offset,
+  IN     UINT32          Hash
+  )
+{
+  EXT4_DX_COUNT_LIMIT  *CountLimit;
+  UINTN                Low;
+  UINTN                High;
+  UINTN                Middle;
+
+  if (Offset + sizeof (EXT4_DX_COUNT_LIMIT) > Partition->BlockSize) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  CountLimit = (EXT4_DX_COUNT_LIMIT *)(Frame->Block + Offset);
+
+  if ((CountLimit->count == 0) || (CountLimit->count > CountLimit->limit) ||
+      (CountLimit->limit > (Partition->BlockSize - Offset) / sizeof (EXT4_DX_ENTRY)))
+  {
+    DEBUG ((DEBUG_ERROR, "[ext4] Bad htree count/limit %u/%u\n", CountLimit->count, CountLimit->limit));
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  Frame->Entries = (EXT4_DX_ENTRY *)CountLimit;
+  Frame->Count   = CountLimit->count;
+
+  // Entries are sorted by hash, and the first one (the count/limit) has an implied hash of 0.
+  // Find the last entry whose hash is <= Hash.
+  Low  = 1;
+  High = Frame->Count;
+
+  while (Low < High) {
+    Middle = Low + (High - Low) / 2;
+
+    if (Frame->Entries[Middle].hash > Hash) {
+      High = Middle;
+    } else {
+      Low = Middle + 1;
+    }
+  }
+
+  Frame->At = (UINT16)(Low - 1);
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Walks down the index from Level + 1, following the entries the frames above point to.
+
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in out]  Frames      Pointer to the frames.
+   @param[in]      Level       Level to start from; its frame must already be set up.
+   @param[in]      Levels      Number of levels of the index.
+   @param[in]      Hash        Hash we're looking for.
+
+   @return Status of the walk.
+**/
+STATIC
+EFI_STATUS
+Ext4HtreeWalkDown (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *Directory,
+  IN OUT EXT4_DX_FRAME   *Frames,
+  IN     UINTN           Level,
+  IN     UINTN           Levels,
+  IN     UINT32          Hash
+  )
+{
+  EFI_STATUS  Status;
+
+  for (Level++; Level < Levels; Level++) {
+    Status = Ext4HtreeReadBlock (
+               Partition,
+               Directory,
+               Frames[Level - 1].Entries[Frames[Level - 1].At].block,
+               Frames[Level].Block
+               );
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    // Interior nodes start with a fake, empty dirent that spans the whole block
+    Status = Ext4HtreeProbeNode (Partition, &Frames[Level], EXT4_MIN_DIR_ENTRY_LEN, Hash);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Retrieves a directory entry using the directory's hash tree index.
+   Only exact (case-sensitive) matches are found.
+
+   @param[in]      Directory   Pointer to the opened directory.
+   @param[in]      Name        Pointer to the UCS-2 formatted filename.
+   @param[in]      Partition   Pointer to the ext4 partition.
+   @param[out]     Result      Pointer to the destination directory entry.
+
+   @retval EFI_SUCCESS           The entry was found.
+   @retval EFI_NOT_FOUND         There's no entry with this exact name.
+   @retval EFI_UNSUPPORTED       The directory isn't indexed, or its index can't be used.
+   @retval EFI_VOLUME_CORRUPTED  The index is corrupted.
+   @retval !EFI_SUCCESS          Failure.
+**/
+EFI_STATUS
+Ext4HtreeRetrieveDirent (
+  IN EXT4_FILE        *Directory,
+  IN CONST CHAR16     *Name,
+  IN EXT4_PARTITION   *Partition,
+  OUT EXT4_DIR_ENTRY  *Result
+  )
+{
+  EFI_STATUS     Status;
+  CHAR8          *Utf8Name;
+  UINTN          Utf8NameLen;
+  CHAR8          *Buf;
+  CHAR8          *Leaf;
+  EXT4_DX_ROOT   *Root;
+  EXT4_DX_FRAME  Frames[EXT4_DX_MAX_LEVELS_LARGEDIR];
+  UINTN          Levels;
+  UINTN          MaxLevels;
+  UINTN          Level;
+  UINTN          Index;
+  UINT8          HashVersion;
+  UINT32         Hash;
+
+  if (!EXT4_HAS_COMPAT (Partition, EXT4_FEATURE_COMPAT_DIR_INDEX) ||
+      ((Directory->Inode->i_flags & EXT4_INDEX_FL) == 0))
+  {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = UCS2StrToUTF8 ((CHAR16 *)Name, &Utf8Name);
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Utf8NameLen = AsciiStrLen (Utf8Name);
+
+  if ((Utf8NameLen == 0) || (Utf8NameLen > EXT4_NAME_MAX)) {
+    FreePool (Utf8Name);
+    return EFI_NOT_FOUND;
+  }
+
+  // One block per level of the index, plus one for the leaf
+  Buf = AllocatePool ((EXT4_DX_MAX_LEVELS_LARGEDIR + 1) * Partition->BlockSize);
+
+  if (Buf == NULL) {
+    FreePool (Utf8Name);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < EXT4_DX_MAX_LEVELS_LARGEDIR; Index++) {
+    Frames[Index].Block = Buf + Index * Partition->BlockSize;
+  }
+
+  Leaf = Buf + EXT4_DX_MAX_LEVELS_LARGEDIR * Partition->BlockSize;
+
+  Status = Ext4HtreeReadBlock (Partition, Directory, 0, Frames[0].Block);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  Root = (EXT4_DX_ROOT *)Frames[0].Block;
+
+  MaxLevels = EXT4_HAS_INCOMPAT (Partition, EXT4_FEATURE_INCOMPAT_LARGEDIR) ?
+              EXT4_DX_MAX_LEVELS_LARGEDIR : EXT4_DX_MAX_LEVELS;
+  Levels      = Root->info.indirect_levels + 1;
+  HashVersion = Root->info.hash_version;
+
+  if ((HashVersion > EXT4_DX_HASH_TEA) || (Levels > MaxLevels) ||
+      ((Root->info.unused_flags & EXT4_DX_FLAG_INCOMPAT) != 0) ||
+      (Root->info.info_length < sizeof (EXT4_DX_ROOT_INFO)))
+  {
+    DEBUG ((
+      DEBUG_FS,
+      "[ext4] Unusable htree root (hash %u, levels %lu, flags %x)\n",
+      HashVersion,
+      (UINT64)Levels,
+      Root->info.unused_flags
+      ));
+    Status = EFI_UNSUPPORTED;
+    goto Out;
+  }
+
+  if ((Partition->SuperBlock.s_flags & EXT4_FLAGS_UNSIGNED_HASH) != 0) {
+    HashVersion += EXT4_DX_HASH_LEGACY_UNSIGNED;
+  }
+
+  Hash = Ext4HtreeHash (Partition, Utf8Name, Utf8NameLen, HashVersion);
+
+  Status = Ext4HtreeProbeNode (
+             Partition,
+             &Frames[0],
+             OFFSET_OF (EXT4_DX_ROOT, info) + Root->info.info_length,
+             Hash
+             );
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  Status = Ext4HtreeWalkDown (Partition, Directory, Frames, 0, Levels, Hash);
+
+  if (EFI_ERROR (Status)) {
+    goto Out;
+  }
+
+  while (TRUE) {
+    Level  = Levels - 1;
+    Status = Ext4HtreeReadBlock (Partition, Directory, Frames[Level].Entries[Frames[Level].At].block, Leaf);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+
+    Status = Ext4SearchDirentBlock (Partition, Leaf, Name, Utf8Name, Result);
+
+    if (Status != EFI_NOT_FOUND) {
+      goto Out;
+    }
+
+    // Names with the same hash may have spilled over into the next leaf, which then
+    // has the continuation bit set. Find the next leaf, going up as many levels as needed.
+    while (Frames[Level].At + 1 >= Frames[Level].Count) {
+      if (Level == 0) {
+        goto Out;
+      }
+
+      Level--;
+    }
+
+    Frames[Level].At++;
+
+    if ((Frames[Level].Entries[Frames[Level].At].hash & ~1U) != Hash) {
+      goto Out;
+    }
+
+    // Every hash in the subtree we're entering is >= (Hash | 1), so probing for Hash
+    // takes the leftmost path down, which is exactly where the continuation is.
+    Status = Ext4HtreeWalkDown (Partition, Directory, Frames, Level, Levels, Hash);
+
+    if (EFI_ERROR (Status)) {
+      goto Out;
+    }
+  }
+
+Out:
+  FreePool (Buf);
+  FreePool (Utf8Name);
+  return Status;
+}
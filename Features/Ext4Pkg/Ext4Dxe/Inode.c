@@ -89,31 +89,32 @@ Ext4Read (
   IN OUT UINTN           *Length
   )
 {
-  EXT4_INODE   *Inode;
-  UINT64       InodeSize;
-  UINT64       CurrentSeek;
-  UINTN        RemainingRead;
-  UINTN        BeenRead;
-  UINTN        WasRead;
-  EXT4_EXTENT  Extent;
-  UINT32       BlockOff;
-  EFI_STATUS   Status;
-  BOOLEAN      HasBackingExtent;
-  UINT32       HoleOff;
-  UINT64       HoleLen;
-  UINT64       ExtentStartBytes;
-  UINT64       ExtentLengthBytes;
-  UINT64       ExtentLogicalBytes;
-
-  // Our extent offset is the difference between CurrentSeek and ExtentLogicalBytes
+  EXT4_INODE     *Inode;
+  UINT64         InodeSize;
+  UINT64         CurrentSeek;
+  UINTN          RemainingRead;
+  UINTN          BeenRead;
+  UINTN          WasRead;
+  EXT4_EXTENT    Extent;
+  BOOLEAN        HaveExtent;
+  EFI_STATUS     ExtentStatus;
+  EXT4_BLOCK_NR  LogicalBlock;
+  EXT4_BLOCK_NR  NextPhysicalBlock;
+  UINT32         BlockOff;
+  EFI_STATUS     Status;
+  UINT64         ReadStartBytes;
+  UINT64         ExtentMayRead;
+
+  // Our extent offset is the difference between CurrentSeek and the extent's first logical byte
   UINT64  ExtentOffset;
-  UINTN   ExtentMayRead;
 
   Inode         = File->Inode;
   InodeSize     = EXT4_INODE_SIZE (Inode);
   CurrentSeek   = Offset;
   RemainingRead = *Length;
   BeenRead      = 0;
+  HaveExtent    = FALSE;
+  ExtentStatus  = EFI_SUCCESS;
 
   DEBUG ((DEBUG_FS, "[ext4] Ext4Read(%s, Offset %lu, Length %lu)\n", File->Dentry->Name, Offset, *Length));
 
@@ -129,58 +130,85 @@ Ext4Read (
     WasRead = 0;
 
     // The algorithm here is to get the extent corresponding to the current block
-    // and then read as much as we can from the current extent.
+    // and then read as much as we can from the current extent, along with any
+    // following extents that are physically contiguous with it.
 
-    Status = Ext4GetExtent (
-               Partition,
-               File,
-               DivU64x32Remainder (CurrentSeek, Partition->BlockSize, &BlockOff),
-               &Extent
-               );
+    LogicalBlock = DivU64x32Remainder (CurrentSeek, Partition->BlockSize, &BlockOff);
 
-    if ((Status != EFI_SUCCESS) && (Status != EFI_NO_MAPPING)) {
-      return Status;
+    // We may have already looked up this extent while trying to merge it with the previous one.
+    if (!HaveExtent) {
+      ExtentStatus = Ext4GetExtent (Partition, File, LogicalBlock, &Extent);
+
+      if ((ExtentStatus != EFI_SUCCESS) && (ExtentStatus != EFI_NO_MAPPING)) {
+        return ExtentStatus;
+      }
     }
 
-    HasBackingExtent = Status != EFI_NO_MAPPING;
+    HaveExtent = FALSE;
 
-    if (!HasBackingExtent || EXT4_EXTENT_IS_UNINITIALIZED (&Extent)) {
-      HoleOff = BlockOff;
+    if (ExtentStatus == EFI_NO_MAPPING) {
+      // Holes are described starting at the block we asked for
+      ExtentOffset = BlockOff;
+    } else {
+      ExtentOffset = CurrentSeek - MultU64x32 (Extent.ee_block, Partition->BlockSize);
+    }
 
-      if (!HasBackingExtent) {
-        HoleLen = Partition->BlockSize - HoleOff;
-      } else {
-        // Uninitialized extents behave exactly the same as file holes, except they have
-        // blocks already allocated to them.
-        HoleLen = MultU64x32 (Ext4GetExtentLength (&Extent), Partition->BlockSize) - HoleOff;
-      }
+    ExtentMayRead = MultU64x32 (Ext4GetExtentLength (&Extent), Partition->BlockSize) - ExtentOffset;
+    WasRead       = ExtentMayRead > RemainingRead ? RemainingRead : (UINTN)ExtentMayRead;
 
-      WasRead = HoleLen > RemainingRead ? RemainingRead : (UINTN)HoleLen;
-      // Potential improvement: In the future, we could get the file hole's total
-      // size and memset all that
+    if (EXT4_EXTENT_IS_UNINITIALIZED (&Extent)) {
+      // Uninitialized extents behave exactly the same as file holes, except they have
+      // blocks already allocated to them. Ext4GetExtent describes holes as uninitialized
+      // extents spanning the whole hole, so both get zeroed in one go.
       ZeroMem (Buffer, WasRead);
     } else {
-      ExtentStartBytes = MultU64x32 (
-                           LShiftU64 (Extent.ee_start_hi, 32) |
-                           Extent.ee_start_lo,
-                           Partition->BlockSize
-                           );
-      ExtentLengthBytes  = Extent.ee_len * Partition->BlockSize;
-      ExtentLogicalBytes = MultU64x32 ((UINT64)Extent.ee_block, Partition->BlockSize);
-      ExtentOffset       = CurrentSeek - ExtentLogicalBytes;
-      ExtentMayRead      = (UINTN)(ExtentLengthBytes - ExtentOffset);
-
-      WasRead = ExtentMayRead > RemainingRead ? RemainingRead : ExtentMayRead;
+      ReadStartBytes = MultU64x32 (EXT4_EXTENT_PHYSICAL_BLOCK (&Extent), Partition->BlockSize) + ExtentOffset;
+
+      // Merge the following extents into this read for as long as they're physically
+      // contiguous. These are usually in the extent map already, so this is cheap.
+      while (WasRead < RemainingRead) {
+        NextPhysicalBlock = EXT4_EXTENT_PHYSICAL_BLOCK (&Extent) + Ext4GetExtentLength (&Extent);
+
+        ExtentStatus = Ext4GetExtent (
+                         Partition,
+                         File,
+                         (EXT4_BLOCK_NR)Extent.ee_block + Ext4GetExtentLength (&Extent),
+                         &Extent
+                         );
+
+        if ((ExtentStatus != EFI_SUCCESS) && (ExtentStatus != EFI_NO_MAPPING)) {
+          return ExtentStatus;
+        }
+
+        HaveExtent = TRUE;
+
+        if ((ExtentStatus != EFI_SUCCESS) || EXT4_EXTENT_IS_UNINITIALIZED (&Extent) ||
+            (EXT4_EXTENT_PHYSICAL_BLOCK (&Extent) != NextPhysicalBlock))
+        {
+          // Leave it for the next iteration
+          break;
+        }
+
+        HaveExtent    = FALSE;
+        ExtentMayRead = MultU64x32 (Ext4GetExtentLength (&Extent), Partition->BlockSize);
+        WasRead      += ExtentMayRead > RemainingRead - WasRead ? RemainingRead - WasRead : (UINTN)ExtentMayRead;
+      }
 
-      Status = Ext4ReadDiskIo (Partition, Buffer, WasRead, ExtentStartBytes + ExtentOffset);
+      if (Ext4FileIsDir (File)) {
+        // Directory blocks are metadata and get looked up over and over again.
+        Status = Ext4ReadCachedDiskIo (Partition, Buffer, WasRead, ReadStartBytes);
+      } else {
+        // File data is read straight into the caller's buffer whenever alignment allows
+        Status = Ext4ReadDiskDirect (Partition, Buffer, WasRead, ReadStartBytes);
+      }
 
       if (EFI_ERROR (Status)) {
         DEBUG ((
           DEBUG_ERROR,
           "[ext4] Error %r reading [%lu, %lu]\n",
           Status,
-          ExtentStartBytes + ExtentOffset,
-          ExtentStartBytes + ExtentOffset + WasRead - 1
+          ReadStartBytes,
+          ReadStartBytes + WasRead - 1
           ));
         return Status;
       }
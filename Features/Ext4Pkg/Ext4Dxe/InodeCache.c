@@ -0,0 +1,250 @@
+/** @file
+  Per-partition inode cache
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "Ext4Dxe.h"
+
+/**
+   Gets the hash bucket an inode number belongs to.
+
+   @param[in]      Cache         Pointer to the inode cache.
+   @param[in]      InodeNum      Inode number.
+
+   @return Pointer to the head of the bucket's list.
+**/
+STATIC
+LIST_ENTRY *
+Ext4InodeCacheBucket (
+  IN EXT4_INODE_CACHE  *Cache,
+  IN EXT4_INO_NR       InodeNum
+  )
+{
+  // NumberBuckets is always a power of 2
+  return &Cache->Buckets[(UINTN)InodeNum & (Cache->NumberBuckets - 1)];
+}
+
+/**
+   Initialises the inode cache of the partition.
+   The number of cached inodes is PcdExt4InodeCacheSize; if it's 0,
+   the cache is left disabled and every inode is read from the inode table.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+                                 Partition->InodeSize must already be valid.
+
+   @retval EFI_SUCCESS           The cache was initialised (or disabled).
+   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+EFI_STATUS
+Ext4InitInodeCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_INODE_CACHE        *Cache;
+  EXT4_INODE_CACHE_ENTRY  *Entry;
+  UINTN                   NumberEntries;
+  UINTN                   Index;
+
+  Cache = &Partition->InodeCache;
+
+  ZeroMem (Cache, sizeof (EXT4_INODE_CACHE));
+  InitializeListHead (&Cache->LruList);
+
+  NumberEntries = PcdGet32 (PcdExt4InodeCacheSize);
+
+  if (NumberEntries == 0) {
+    DEBUG ((DEBUG_FS, "[ext4] Inode cache disabled\n"));
+    return EFI_SUCCESS;
+  }
+
+  Cache->NumberBuckets = (UINTN)GetPowerOfTwo32 ((UINT32)NumberEntries);
+  if (Cache->NumberBuckets < NumberEntries) {
+    Cache->NumberBuckets <<= 1;
+  }
+
+  Cache->Entries = AllocateZeroPool (NumberEntries * sizeof (EXT4_INODE_CACHE_ENTRY));
+  Cache->Buckets = AllocatePool (Cache->NumberBuckets * sizeof (LIST_ENTRY));
+  Cache->Data    = AllocatePool (NumberEntries * Partition->InodeSize);
+
+  if ((Cache->Entries == NULL) || (Cache->Buckets == NULL) || (Cache->Data == NULL)) {
+    Ext4FreeInodeCache (Partition);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  for (Index = 0; Index < Cache->NumberBuckets; Index++) {
+    InitializeListHead (&Cache->Buckets[Index]);
+  }
+
+  for (Index = 0; Index < NumberEntries; Index++) {
+    Entry        = &Cache->Entries[Index];
+    Entry->Inode = (EXT4_INODE *)((CHAR8 *)Cache->Data + Index * Partition->InodeSize);
+    Entry->Valid = FALSE;
+    InitializeListHead (&Entry->HashNode);
+    InsertTailList (&Cache->LruList, &Entry->LruNode);
+  }
+
+  Cache->NumberEntries = NumberEntries;
+  Cache->MediaId       = EXT4_MEDIA_ID (Partition);
+
+  DEBUG ((DEBUG_FS, "[ext4] Inode cache: %lu inodes\n", (UINT64)NumberEntries));
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Frees the partition's inode cache.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+VOID
+Ext4FreeInodeCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_INODE_CACHE  *Cache;
+
+  Cache = &Partition->InodeCache;
+
+  DEBUG ((
+    DEBUG_FS,
+    "[ext4] Inode cache: %lu hits, %lu misses\n",
+    Cache->Hits,
+    Cache->Misses
+    ));
+
+  if (Cache->Entries != NULL) {
+    FreePool (Cache->Entries);
+  }
+
+  if (Cache->Buckets != NULL) {
+    FreePool (Cache->Buckets);
+  }
+
+  if (Cache->Data != NULL) {
+    FreePool (Cache->Data);
+  }
+
+  ZeroMem (Cache, sizeof (EXT4_INODE_CACHE));
+  InitializeListHead (&Cache->LruList);
+}
+
+/**
+   Drops every inode held by the partition's inode cache.
+
+   @param[in out]  Partition     Pointer to the opened EXT4 partition.
+**/
+STATIC
+VOID
+Ext4InvalidateInodeCache (
+  IN OUT EXT4_PARTITION  *Partition
+  )
+{
+  EXT4_INODE_CACHE        *Cache;
+  EXT4_INODE_CACHE_ENTRY  *Entry;
+  UINTN                   Index;
+
+  Cache = &Partition->InodeCache;
+
+  for (Index = 0; Index < Cache->NumberEntries; Index++) {
+    Entry = &Cache->Entries[Index];
+
+    if (Entry->Valid) {
+      RemoveEntryList (&Entry->HashNode);
+      InitializeListHead (&Entry->HashNode);
+      Entry->Valid = FALSE;
+    }
+  }
+
+  Cache->MediaId = EXT4_MEDIA_ID (Partition);
+}
+
+/**
+   Looks up an inode in the inode cache.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      InodeNum      Inode number.
+   @param[out]     Inode         Pointer to a buffer, Partition->InodeSize bytes long,
+                                 where the inode will be copied to if it's cached.
+
+   @return TRUE if the inode was cached, FALSE otherwise.
+**/
+BOOLEAN
+Ext4GetCachedInode (
+  IN  EXT4_PARTITION  *Partition,
+  IN  EXT4_INO_NR     InodeNum,
+  OUT EXT4_INODE      *Inode
+  )
+{
+  EXT4_INODE_CACHE        *Cache;
+  EXT4_INODE_CACHE_ENTRY  *Entry;
+  LIST_ENTRY              *Node;
+
+  Cache = &Partition->InodeCache;
+
+  if (Cache->NumberEntries == 0) {
+    return FALSE;
+  }
+
+  // Our cached inodes are worthless if the media was swapped under us.
+  if (Cache->MediaId != EXT4_MEDIA_ID (Partition)) {
+    Ext4InvalidateInodeCache (Partition);
+  }
+
+  BASE_LIST_FOR_EACH (Node, Ext4InodeCacheBucket (Cache, InodeNum)) {
+    Entry = EXT4_INODE_CACHE_ENTRY_FROM_HASH_NODE (Node);
+
+    if (Entry->InodeNum == InodeNum) {
+      // Move it to the front of the LRU list
+      RemoveEntryList (&Entry->LruNode);
+      InsertHeadList (&Cache->LruList, &Entry->LruNode);
+      Cache->Hits++;
+      CopyMem (Inode, Entry->Inode, Partition->InodeSize);
+      return TRUE;
+    }
+  }
+
+  Cache->Misses++;
+  return FALSE;
+}
+
+/**
+   Adds an inode to the inode cache, evicting the least recently used one.
+   The inode must have already been validated.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      InodeNum      Inode number.
+   @param[in]      Inode         Pointer to the inode, Partition->InodeSize bytes long.
+**/
+VOID
+Ext4CacheInode (
+  IN EXT4_PARTITION    *Partition,
+  IN EXT4_INO_NR       InodeNum,
+  IN CONST EXT4_INODE  *Inode
+  )
+{
+  EXT4_INODE_CACHE        *Cache;
+  EXT4_INODE_CACHE_ENTRY  *Entry;
+
+  Cache = &Partition->InodeCache;
+
+  if (Cache->NumberEntries == 0) {
+    return;
+  }
+
+  // Recycle the least recently used entry, which is always at the tail.
+  Entry = EXT4_INODE_CACHE_ENTRY_FROM_LRU_NODE (GetPreviousNode (&Cache->LruList, &Cache->LruList));
+
+  if (Entry->Valid) {
+    RemoveEntryList (&Entry->HashNode);
+  }
+
+  CopyMem (Entry->Inode, Inode, Partition->InodeSize);
+  Entry->InodeNum = InodeNum;
+  Entry->Valid    = TRUE;
+  InsertHeadList (Ext4InodeCacheBucket (Cache, InodeNum), &Entry->HashNode);
+
+  RemoveEntryList (&Entry->LruNode);
+  InsertHeadList (&Cache->LruList, &Entry->LruNode);
+}
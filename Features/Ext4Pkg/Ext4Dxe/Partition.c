@@ -119,13 +119,26 @@ Ext4UnmountAndFreePartition (
     Ext4CloseInternal (File);
   }
 
+  // The dentry cache holds references to the root's descendants (and, through them, to the root)
+  Ext4FlushDentryCache (Partition);
+
   DeletedRootDentry = Ext4UnrefDentry (Partition->RootDentry);
 
   if (!DeletedRootDentry) {
     DEBUG ((DEBUG_ERROR, "[ext4] Failed to delete root dentry - resource leak present.\n"));
   }
 
-  FreePool (Partition->BlockGroups);
+  DEBUG ((
+    DEBUG_FS,
+    "[ext4] %lu disk reads, %lu bytes read\n",
+    Partition->DiskReads,
+    Partition->DiskReadBytes
+    ));
+
+  Ext4FreeInodeCache (Partition);
+  Ext4FreeBlockCache (Partition);
+
+  Ext4FreeBlockGroupDescs (Partition);
   FreePool (Partition);
 
   return EFI_SUCCESS;
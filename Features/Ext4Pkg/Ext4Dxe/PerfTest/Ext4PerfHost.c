@@ -0,0 +1,652 @@
+/** @file
+  Host-based performance harness of Ext4Dxe
+
+  Mounts ext4 images through a file-backed EFI_DISK_IO_PROTOCOL and reports the
+  mount time, path lookup latency, directory enumeration rate and sequential
+  read throughput, along with the number of requests each of them sent to the disk.
+  MakeCorpus.py generates a set of images that exercise the driver's hot paths.
+
+  Usage: Ext4PerfHost [-a] [-c ChunkKiB] [-n Iterations] Image...
+    -a  Also expose EFI_DISK_IO2_PROTOCOL, which enables read-ahead.
+    -c  Size of each Read() of the sequential read test, in KiB (default 1024).
+    -n  Number of times each path is opened by the warm lookup test (default 4).
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "HostDisk.h"
+
+#define PERF_DEFAULT_CHUNK_KIB   1024
+#define PERF_DEFAULT_ITERATIONS  4
+#define PERF_MISSING_SUFFIX      L".missing"
+// Lookups in huge directories are slow enough that only a sample of the files is opened and read
+#define PERF_MAX_SAMPLES         1024
+#define PERF_DIR_INFO_SIZE       (SIZE_OF_EFI_FILE_INFO + (EXT4_NAME_MAX + 1) * sizeof (CHAR16))
+
+typedef struct {
+  BOOLEAN    UseDiskIo2;
+  UINTN      ChunkSize;
+  UINTN      Iterations;
+} PERF_OPTIONS;
+
+//
+// What the directory walk found: the path of every file, and how much there is to read.
+//
+typedef struct {
+  CHAR16    **Paths;
+  UINTN     NumberPaths;
+  UINTN     Capacity;
+  UINT64    TotalBytes;
+  UINTN     NumberDirectories;
+  UINTN     NumberEntries;
+} PERF_TREE;
+
+typedef struct {
+  clock_t    Start;
+  UINT64     Reads;
+  UINT64     ReadBytes;
+} PERF_SAMPLE;
+
+/**
+   Converts a path to ASCII, so it can be printed.
+   Characters that aren't ASCII are replaced with '?'.
+
+   @param[in]      Path          Path to convert.
+
+   @return Pointer to a static buffer with the converted path.
+**/
+STATIC
+CONST CHAR8 *
+PerfAsciiPath (
+  IN CONST CHAR16  *Path
+  )
+{
+  STATIC CHAR8  AsciiPath[EXT4_EFI_PATH_MAX + ARRAY_SIZE (PERF_MISSING_SUFFIX)];
+  UINTN         Index;
+
+  for (Index = 0; Path[Index] != L'\0' && Index < ARRAY_SIZE (AsciiPath) - 1; Index++) {
+    AsciiPath[Index] = Path[Index] < 0x80 ? (CHAR8)Path[Index] : '?';
+  }
+
+  AsciiPath[Index] = '\0';
+  return AsciiPath;
+}
+
+/**
+   Starts measuring a test.
+
+   @param[in]      Disk          Pointer to the disk.
+   @param[out]     Sample        Pointer to the sample.
+**/
+STATIC
+VOID
+PerfStart (
+  IN  HOST_DISK    *Disk,
+  OUT PERF_SAMPLE  *Sample
+  )
+{
+  Sample->Reads     = Disk->Reads;
+  Sample->ReadBytes = Disk->ReadBytes;
+  Sample->Start     = clock ();
+}
+
+/**
+   Stops measuring a test and prints its results.
+
+   @param[in]      Disk          Pointer to the disk.
+   @param[in]      Sample        Pointer to the sample started by PerfStart().
+   @param[in]      Name          Name of the test.
+   @param[in]      Count         Number of things (operations, entries, bytes) the test went through.
+   @param[in]      Unit          Unit of Count.
+   @param[in]      Scale         Count is divided by Scale before computing the rate.
+**/
+STATIC
+VOID
+PerfStop (
+  IN HOST_DISK          *Disk,
+  IN CONST PERF_SAMPLE  *Sample,
+  IN CONST CHAR8        *Name,
+  IN UINT64             Count,
+  IN CONST CHAR8        *Unit,
+  IN UINT64             Scale
+  )
+{
+  UINT64  ElapsedUs;
+  double  Rate;
+
+  ElapsedUs = (UINT64)(clock () - Sample->Start) * 1000000 / CLOCKS_PER_SEC;
+  Rate      = ElapsedUs != 0 ? ((double)Count / Scale) * 1000000.0 / ElapsedUs : 0.0;
+
+  printf (
+    "  %-14s %10.3f ms %14.1f %-10s %8llu DiskIo calls %12llu bytes\n",
+    Name,
+    ElapsedUs / 1000.0,
+    Rate,
+    Unit,
+    (unsigned long long)(Disk->Reads - Sample->Reads),
+    (unsigned long long)(Disk->ReadBytes - Sample->ReadBytes)
+    );
+}
+
+/**
+   Adds a file to the tree.
+
+   @param[in out]  Tree          Pointer to the tree.
+   @param[in]      Path          Path of the file.
+
+   @retval EFI_SUCCESS           The file was added.
+   @retval EFI_OUT_OF_RESOURCES  Memory allocation failed.
+**/
+STATIC
+EFI_STATUS
+PerfAddPath (
+  IN OUT PERF_TREE     *Tree,
+  IN     CONST CHAR16  *Path
+  )
+{
+  CHAR16  **NewPaths;
+  UINTN   NewCapacity;
+
+  if (Tree->NumberPaths == Tree->Capacity) {
+    NewCapacity = MAX (Tree->Capacity * 2, 64);
+    NewPaths    = ReallocatePool (
+                    Tree->Capacity * sizeof (CHAR16 *),
+                    NewCapacity * sizeof (CHAR16 *),
+                    Tree->Paths
+                    );
+
+    if (NewPaths == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    Tree->Paths    = NewPaths;
+    Tree->Capacity = NewCapacity;
+  }
+
+  Tree->Paths[Tree->NumberPaths] = AllocateCopyPool (StrSize (Path), Path);
+
+  if (Tree->Paths[Tree->NumberPaths] == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Tree->NumberPaths++;
+  return EFI_SUCCESS;
+}
+
+/**
+   Frees the tree.
+
+   @param[in out]  Tree          Pointer to the tree.
+**/
+STATIC
+VOID
+PerfFreeTree (
+  IN OUT PERF_TREE  *Tree
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < Tree->NumberPaths; Index++) {
+    FreePool (Tree->Paths[Index]);
+  }
+
+  if (Tree->Paths != NULL) {
+    FreePool (Tree->Paths);
+  }
+
+  ZeroMem (Tree, sizeof (PERF_TREE));
+}
+
+/**
+   Enumerates a directory, and every directory below it.
+
+   @param[in]      Directory     Pointer to the opened directory.
+   @param[in out]  Path          Path of the directory, in a buffer of EXT4_EFI_PATH_MAX characters.
+                                 Restored before returning.
+   @param[in]      PathLength    Length of Path.
+   @param[in out]  Tree          Pointer to the tree, where the files are added.
+
+   @return Number of errors found.
+**/
+STATIC
+UINTN
+PerfWalk (
+  IN     EFI_FILE_PROTOCOL  *Directory,
+  IN OUT CHAR16             *Path,
+  IN     UINTN              PathLength,
+  IN OUT PERF_TREE          *Tree
+  )
+{
+  EFI_FILE_INFO      *Info;
+  EFI_FILE_PROTOCOL  *Child;
+  EFI_STATUS         Status;
+  UINTN              Size;
+  UINTN              NameLength;
+  UINTN              Errors;
+
+  Info = AllocatePool (PERF_DIR_INFO_SIZE);
+
+  if (Info == NULL) {
+    return 1;
+  }
+
+  Errors = 0;
+  Tree->NumberDirectories++;
+
+  while (TRUE) {
+    Size   = PERF_DIR_INFO_SIZE;
+    Status = Directory->Read (Directory, &Size, Info);
+
+    if (EFI_ERROR (Status)) {
+      printf ("  error: reading %s: %lx\n", PerfAsciiPath (Path), (unsigned long)Status);
+      Errors++;
+      break;
+    }
+
+    if (Size == 0) {
+      break;
+    }
+
+    Tree->NumberEntries++;
+
+    if ((StrCmp (Info->FileName, L".") == 0) || (StrCmp (Info->FileName, L"..") == 0)) {
+      continue;
+    }
+
+    NameLength = StrLen (Info->FileName);
+
+    if (PathLength + 1 + NameLength >= EXT4_EFI_PATH_MAX) {
+      continue;
+    }
+
+    Path[PathLength] = L'\\';
+    CopyMem (&Path[PathLength + 1], Info->FileName, (NameLength + 1) * sizeof (CHAR16));
+
+    if ((Info->Attribute & EFI_FILE_DIRECTORY) != 0) {
+      Status = Directory->Open (Directory, &Child, Info->FileName, EFI_FILE_MODE_READ, 0);
+
+      if (EFI_ERROR (Status)) {
+        printf ("  error: opening %s: %lx\n", PerfAsciiPath (Path), (unsigned long)Status);
+        Errors++;
+        continue;
+      }
+
+      Errors += PerfWalk (Child, Path, PathLength + 1 + NameLength, Tree);
+      Child->Close (Child);
+    } else {
+      if (EFI_ERROR (PerfAddPath (Tree, Path))) {
+        Errors++;
+        break;
+      }
+
+      Tree->TotalBytes += Info->FileSize;
+    }
+  }
+
+  Path[PathLength] = L'\0';
+  FreePool (Info);
+
+  return Errors;
+}
+
+/**
+   Gets the distance between two files of the sample of PERF_MAX_SAMPLES files
+   (or every file, if there are fewer) the lookup and read tests go through.
+
+   @param[in]      Tree          Pointer to the tree.
+
+   @return Distance between two sampled files, in Tree->Paths.
+**/
+STATIC
+UINTN
+PerfSampleStride (
+  IN CONST PERF_TREE  *Tree
+  )
+{
+  return MAX ((Tree->NumberPaths + PERF_MAX_SAMPLES - 1) / PERF_MAX_SAMPLES, 1);
+}
+
+/**
+   Opens every sampled file of the tree, once.
+
+   @param[in]      Root          Pointer to the root directory.
+   @param[in]      Tree          Pointer to the tree.
+   @param[in]      Missing       If TRUE, look up names that don't exist instead:
+                                 each path with PERF_MISSING_SUFFIX appended.
+   @param[out]     Lookups       Number of files that were opened.
+
+   @return Number of errors found.
+**/
+STATIC
+UINTN
+PerfOpenSample (
+  IN  EFI_FILE_PROTOCOL  *Root,
+  IN  CONST PERF_TREE    *Tree,
+  IN  BOOLEAN            Missing,
+  OUT UINTN              *Lookups
+  )
+{
+  STATIC CHAR16      MissingPath[EXT4_EFI_PATH_MAX + ARRAY_SIZE (PERF_MISSING_SUFFIX)];
+  EFI_FILE_PROTOCOL  *File;
+  EFI_STATUS         Status;
+  CHAR16             *Path;
+  UINTN              Index;
+  UINTN              Stride;
+  UINTN              Errors;
+
+  Errors   = 0;
+  Stride   = PerfSampleStride (Tree);
+  *Lookups = 0;
+
+  for (Index = 0; Index < Tree->NumberPaths; Index += Stride) {
+    Path = Tree->Paths[Index];
+    (*Lookups)++;
+
+    if (Missing) {
+      CopyMem (MissingPath, Path, StrLen (Path) * sizeof (CHAR16));
+      CopyMem (&MissingPath[StrLen (Path)], PERF_MISSING_SUFFIX, sizeof (PERF_MISSING_SUFFIX));
+      Path = MissingPath;
+    }
+
+    Status = Root->Open (Root, &File, Path, EFI_FILE_MODE_READ, 0);
+
+    if (Missing) {
+      if (Status != EFI_NOT_FOUND) {
+        printf ("  error: looking up %s: %lx\n", PerfAsciiPath (Path), (unsigned long)Status);
+        Errors++;
+      }
+    } else if (EFI_ERROR (Status)) {
+      printf ("  error: opening %s: %lx\n", PerfAsciiPath (Path), (unsigned long)Status);
+      Errors++;
+    }
+
+    if (!EFI_ERROR (Status)) {
+      File->Close (File);
+    }
+  }
+
+  return Errors;
+}
+
+/**
+   Reads every sampled file of the tree from start to end.
+
+   @param[in]      Root          Pointer to the root directory.
+   @param[in]      Tree          Pointer to the tree.
+   @param[in]      Buffer        Pointer to the buffer.
+   @param[in]      ChunkSize     Size of the buffer, and of each read.
+   @param[out]     BytesRead     Number of bytes read.
+
+   @return Number of errors found.
+**/
+STATIC
+UINTN
+PerfReadSample (
+  IN  EFI_FILE_PROTOCOL  *Root,
+  IN  CONST PERF_TREE    *Tree,
+  IN  VOID               *Buffer,
+  IN  UINTN              ChunkSize,
+  OUT UINT64             *BytesRead
+  )
+{
+  EFI_FILE_PROTOCOL  *File;
+  EFI_STATUS         Status;
+  UINTN              Size;
+  UINTN              Index;
+  UINTN              Stride;
+  UINTN              Errors;
+
+  Errors     = 0;
+  Stride     = PerfSampleStride (Tree);
+  *BytesRead = 0;
+
+  for (Index = 0; Index < Tree->NumberPaths; Index += Stride) {
+    Status = Root->Open (Root, &File, Tree->Paths[Index], EFI_FILE_MODE_READ, 0);
+
+    if (EFI_ERROR (Status)) {
+      printf ("  error: opening %s: %lx\n", PerfAsciiPath (Tree->Paths[Index]), (unsigned long)Status);
+      Errors++;
+      continue;
+    }
+
+    do {
+      Size   = ChunkSize;
+      Status = File->Read (File, &Size, Buffer);
+
+      if (EFI_ERROR (Status)) {
+        printf ("  error: reading %s: %lx\n", PerfAsciiPath (Tree->Paths[Index]), (unsigned long)Status);
+        Errors++;
+        break;
+      }
+
+      *BytesRead += Size;
+    } while (Size != 0);
+
+    File->Close (File);
+  }
+
+  return Errors;
+}
+
+/**
+   Mounts an image.
+
+   @param[in]      Disk          Pointer to the disk.
+   @param[in]      Options       Pointer to the options.
+   @param[out]     Root          Pointer to the opened root directory.
+
+   @return Result of the operation.
+**/
+STATIC
+EFI_STATUS
+PerfMount (
+  IN  HOST_DISK           *Disk,
+  IN  CONST PERF_OPTIONS  *Options,
+  OUT EFI_FILE_PROTOCOL   **Root
+  )
+{
+  EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *FileSystem;
+  EFI_STATUS                       Status;
+
+  Status = Ext4OpenPartition (
+             (EFI_HANDLE)Disk,
+             &Disk->DiskIo,
+             Options->UseDiskIo2 ? &Disk->DiskIo2 : NULL,
+             &Disk->BlockIo
+             );
+
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  FileSystem = HostGetFileSystem ();
+
+  Status = FileSystem->OpenVolume (FileSystem, Root);
+
+  if (EFI_ERROR (Status)) {
+    Ext4UnmountAndFreePartition ((EXT4_PARTITION *)FileSystem);
+  }
+
+  return Status;
+}
+
+/**
+   Unmounts the image mounted by the last PerfMount().
+
+   @param[in]      Root          Pointer to the opened root directory.
+**/
+STATIC
+VOID
+PerfUnmount (
+  IN EFI_FILE_PROTOCOL  *Root
+  )
+{
+  Root->Close (Root);
+  Ext4UnmountAndFreePartition ((EXT4_PARTITION *)HostGetFileSystem ());
+}
+
+/**
+   Runs every test on an image.
+
+   @param[in]      ImagePath     Path of the image on the host.
+   @param[in]      Options       Pointer to the options.
+
+   @return Number of errors found.
+**/
+STATIC
+UINTN
+PerfRunImage (
+  IN CONST CHAR8         *ImagePath,
+  IN CONST PERF_OPTIONS  *Options
+  )
+{
+  STATIC CHAR16      Path[EXT4_EFI_PATH_MAX];
+  HOST_DISK          Disk;
+  PERF_TREE          Tree;
+  PERF_SAMPLE        Sample;
+  EFI_FILE_PROTOCOL  *Root;
+  EFI_STATUS         Status;
+  VOID               *Buffer;
+  UINT64             BytesRead;
+  UINTN              Errors;
+  UINTN              Lookups;
+  UINTN              Iteration;
+
+  Status = HostDiskOpen (ImagePath, &Disk);
+
+  if (EFI_ERROR (Status)) {
+    printf ("%s: could not open the image\n", ImagePath);
+    return 1;
+  }
+
+  printf ("%s (%llu MiB)\n", ImagePath, (unsigned long long)(Disk.Size / SIZE_1MB));
+
+  ZeroMem (&Tree, sizeof (Tree));
+  Errors = 0;
+
+  // Cold mount, and the enumeration of the whole tree
+  PerfStart (&Disk, &Sample);
+  Status = PerfMount (&Disk, Options, &Root);
+
+  if (EFI_ERROR (Status)) {
+    printf ("  error: mounting: %lx\n", (unsigned long)Status);
+    HostDiskClose (&Disk);
+    return 1;
+  }
+
+  PerfStop (&Disk, &Sample, "mount", 1, "mounts/s", 1);
+
+  PerfStart (&Disk, &Sample);
+  Path[0] = L'\0';
+  Errors += PerfWalk (Root, Path, 0, &Tree);
+  PerfStop (&Disk, &Sample, "enumerate", Tree.NumberEntries, "entries/s", 1);
+
+  printf (
+    "  %lu directories, %lu entries, %lu files, %llu bytes\n",
+    (unsigned long)Tree.NumberDirectories,
+    (unsigned long)Tree.NumberEntries,
+    (unsigned long)Tree.NumberPaths,
+    (unsigned long long)Tree.TotalBytes
+    );
+
+  PerfUnmount (Root);
+
+  // Lookups on a fresh mount, so the first round starts with cold caches
+  Status = PerfMount (&Disk, Options, &Root);
+
+  if (EFI_ERROR (Status)) {
+    printf ("  error: mounting: %lx\n", (unsigned long)Status);
+    PerfFreeTree (&Tree);
+    HostDiskClose (&Disk);
+    return Errors + 1;
+  }
+
+  PerfStart (&Disk, &Sample);
+  Errors += PerfOpenSample (Root, &Tree, FALSE, &Lookups);
+  PerfStop (&Disk, &Sample, "open (cold)", Lookups, "opens/s", 1);
+
+  PerfStart (&Disk, &Sample);
+
+  for (Iteration = 0; Iteration < Options->Iterations; Iteration++) {
+    Errors += PerfOpenSample (Root, &Tree, FALSE, &Lookups);
+  }
+
+  PerfStop (&Disk, &Sample, "open (warm)", Lookups * Options->Iterations, "opens/s", 1);
+
+  PerfStart (&Disk, &Sample);
+  Errors += PerfOpenSample (Root, &Tree, TRUE, &Lookups);
+  PerfStop (&Disk, &Sample, "open (missing)", Lookups, "lookups/s", 1);
+
+  Buffer = AllocatePool (Options->ChunkSize);
+
+  if (Buffer == NULL) {
+    Errors++;
+  } else {
+    PerfStart (&Disk, &Sample);
+    Errors += PerfReadSample (Root, &Tree, Buffer, Options->ChunkSize, &BytesRead);
+    PerfStop (&Disk, &Sample, "read", BytesRead, "MB/s", 1000000);
+    FreePool (Buffer);
+  }
+
+  PerfUnmount (Root);
+
+  if (Errors != 0) {
+    printf ("  %lu errors\n", (unsigned long)Errors);
+  }
+
+  PerfFreeTree (&Tree);
+  HostDiskClose (&Disk);
+
+  return Errors;
+}
+
+/**
+  Standard POSIX C entry point.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  PERF_OPTIONS  Options;
+  UINTN         Errors;
+  int           Index;
+
+  Options.UseDiskIo2 = FALSE;
+  Options.ChunkSize  = PERF_DEFAULT_CHUNK_KIB * SIZE_1KB;
+  Options.Iterations = PERF_DEFAULT_ITERATIONS;
+
+  for (Index = 1; Index < argc && argv[Index][0] == '-'; Index++) {
+    if (strcmp (argv[Index], "-a") == 0) {
+      Options.UseDiskIo2 = TRUE;
+    } else if ((strcmp (argv[Index], "-c") == 0) && (Index + 1 < argc)) {
+      Options.ChunkSize = (UINTN)strtoul (argv[++Index], NULL, 0) * SIZE_1KB;
+    } else if ((strcmp (argv[Index], "-n") == 0) && (Index + 1 < argc)) {
+      Options.Iterations = (UINTN)strtoul (argv[++Index], NULL, 0);
+    } else {
+      break;
+    }
+  }
+
+  if ((Index == argc) || (Options.ChunkSize == 0)) {
+    printf ("Usage: %s [-a] [-c ChunkKiB] [-n Iterations] Image...\n", argv[0]);
+    return 2;
+  }
+
+  HostInitBootServices ();
+  Ext4InitCrc32c ();
+
+  Errors = 0;
+
+  for ( ; Index < argc; Index++) {
+    Errors += PerfRunImage (argv[Index], &Options);
+  }
+
+  return Errors != 0 ? 1 : 0;
+}
@@ -0,0 +1,529 @@
+/** @file
+  File-backed disk and boot services stand-ins used by the Ext4Dxe host harness
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <wctype.h>
+
+#include "HostDisk.h"
+
+#ifdef _MSC_VER
+#define HOST_FSEEK  _fseeki64
+#define HOST_FTELL  _ftelli64
+#else
+#define HOST_FSEEK  fseeko
+#define HOST_FTELL  ftello
+#endif
+
+typedef struct {
+  BOOLEAN             Signalled;
+  EFI_EVENT_NOTIFY    NotifyFunction;
+  VOID                *NotifyContext;
+} HOST_EVENT;
+
+EFI_BOOT_SERVICES  *gBS;
+
+STATIC EFI_BOOT_SERVICES                mHostBootServices;
+STATIC EFI_SIMPLE_FILE_SYSTEM_PROTOCOL  *mHostFileSystem;
+
+/**
+   Reads from the disk image, keeping count of the requests.
+
+   @param[in]      Disk          Pointer to the disk.
+   @param[in]      Offset        Offset of the read, in bytes.
+   @param[in]      Length        Length of the read, in bytes.
+   @param[out]     Buffer        Pointer to the buffer.
+
+   @retval EFI_SUCCESS           The data was read.
+   @retval EFI_DEVICE_ERROR      The read goes past the end of the image.
+**/
+STATIC
+EFI_STATUS
+HostDiskRead (
+  IN  HOST_DISK  *Disk,
+  IN  UINT64     Offset,
+  IN  UINTN      Length,
+  OUT VOID       *Buffer
+  )
+{
+  Disk->Reads++;
+  Disk->ReadBytes += Length;
+
+  if ((Offset > Disk->Size) || (Length > Disk->Size - Offset)) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (HOST_FSEEK (Disk->Image, Offset, SEEK_SET) != 0) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (fread (Buffer, 1, Length, Disk->Image) != Length) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   EFI_DISK_IO_PROTOCOL.ReadDisk() of the disk image.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostReadDisk (
+  IN  EFI_DISK_IO_PROTOCOL  *This,
+  IN  UINT32                MediaId,
+  IN  UINT64                Offset,
+  IN  UINTN                 BufferSize,
+  OUT VOID                  *Buffer
+  )
+{
+  return HostDiskRead (BASE_CR (This, HOST_DISK, DiskIo), Offset, BufferSize, Buffer);
+}
+
+/**
+   EFI_DISK_IO_PROTOCOL.WriteDisk() of the disk image, which is read-only.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostWriteDisk (
+  IN EFI_DISK_IO_PROTOCOL  *This,
+  IN UINT32                MediaId,
+  IN UINT64                Offset,
+  IN UINTN                 BufferSize,
+  IN VOID                  *Buffer
+  )
+{
+  return EFI_WRITE_PROTECTED;
+}
+
+/**
+   EFI_DISK_IO2_PROTOCOL.ReadDiskEx() of the disk image.
+   The read is done right away; the token's event is signalled before returning.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostReadDiskEx (
+  IN     EFI_DISK_IO2_PROTOCOL  *This,
+  IN     UINT32                 MediaId,
+  IN     UINT64                 Offset,
+  IN OUT EFI_DISK_IO2_TOKEN     *Token,
+  IN     UINTN                  BufferSize,
+  OUT    VOID                   *Buffer
+  )
+{
+  EFI_STATUS  Status;
+
+  Status = HostDiskRead (BASE_CR (This, HOST_DISK, DiskIo2), Offset, BufferSize, Buffer);
+
+  if ((Token == NULL) || (Token->Event == NULL)) {
+    return Status;
+  }
+
+  Token->TransactionStatus = Status;
+  gBS->SignalEvent (Token->Event);
+
+  return EFI_SUCCESS;
+}
+
+/**
+   EFI_DISK_IO2_PROTOCOL.WriteDiskEx() of the disk image, which is read-only.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostWriteDiskEx (
+  IN     EFI_DISK_IO2_PROTOCOL  *This,
+  IN     UINT32                 MediaId,
+  IN     UINT64                 Offset,
+  IN OUT EFI_DISK_IO2_TOKEN     *Token,
+  IN     UINTN                  BufferSize,
+  IN     VOID                   *Buffer
+  )
+{
+  return EFI_WRITE_PROTECTED;
+}
+
+/**
+   EFI_DISK_IO2_PROTOCOL.Cancel() of the disk image. Nothing is ever in flight.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostCancelDiskEx (
+  IN EFI_DISK_IO2_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+   EFI_DISK_IO2_PROTOCOL.FlushDiskEx() of the disk image.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostFlushDiskEx (
+  IN     EFI_DISK_IO2_PROTOCOL  *This,
+  IN OUT EFI_DISK_IO2_TOKEN     *Token
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+   EFI_BLOCK_IO_PROTOCOL.Reset() of the disk image.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostResetBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN BOOLEAN                ExtendedVerification
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+   EFI_BLOCK_IO_PROTOCOL.ReadBlocks() of the disk image.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostReadBlocks (
+  IN  EFI_BLOCK_IO_PROTOCOL  *This,
+  IN  UINT32                 MediaId,
+  IN  EFI_LBA                Lba,
+  IN  UINTN                  BufferSize,
+  OUT VOID                   *Buffer
+  )
+{
+  if ((BufferSize % HOST_DISK_BLOCK_SIZE) != 0) {
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  return HostDiskRead (BASE_CR (This, HOST_DISK, BlockIo), Lba * HOST_DISK_BLOCK_SIZE, BufferSize, Buffer);
+}
+
+/**
+   EFI_BLOCK_IO_PROTOCOL.WriteBlocks() of the disk image, which is read-only.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostWriteBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This,
+  IN UINT32                 MediaId,
+  IN EFI_LBA                Lba,
+  IN UINTN                  BufferSize,
+  IN VOID                   *Buffer
+  )
+{
+  return EFI_WRITE_PROTECTED;
+}
+
+/**
+   EFI_BLOCK_IO_PROTOCOL.FlushBlocks() of the disk image.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostFlushBlocks (
+  IN EFI_BLOCK_IO_PROTOCOL  *This
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+   Opens a disk image and sets up the protocols that read from it.
+
+   @param[in]      Path          Path of the image on the host.
+   @param[out]     Disk          Pointer to the disk to set up.
+
+   @retval EFI_SUCCESS           The image was opened.
+   @retval EFI_NOT_FOUND         The image could not be opened.
+**/
+EFI_STATUS
+HostDiskOpen (
+  IN  CONST CHAR8  *Path,
+  OUT HOST_DISK    *Disk
+  )
+{
+  ZeroMem (Disk, sizeof (HOST_DISK));
+
+  Disk->Image = fopen (Path, "rb");
+
+  if (Disk->Image == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (HOST_FSEEK (Disk->Image, 0, SEEK_END) != 0) {
+    fclose (Disk->Image);
+    return EFI_NOT_FOUND;
+  }
+
+  Disk->Size = (UINT64)HOST_FTELL (Disk->Image);
+
+  Disk->DiskIo.Revision  = EFI_DISK_IO_PROTOCOL_REVISION;
+  Disk->DiskIo.ReadDisk  = HostReadDisk;
+  Disk->DiskIo.WriteDisk = HostWriteDisk;
+
+  Disk->DiskIo2.Revision    = EFI_DISK_IO2_PROTOCOL_REVISION;
+  Disk->DiskIo2.Cancel      = HostCancelDiskEx;
+  Disk->DiskIo2.ReadDiskEx  = HostReadDiskEx;
+  Disk->DiskIo2.WriteDiskEx = HostWriteDiskEx;
+  Disk->DiskIo2.FlushDiskEx = HostFlushDiskEx;
+
+  Disk->Media.MediaId          = 1;
+  Disk->Media.MediaPresent     = TRUE;
+  Disk->Media.LogicalPartition = TRUE;
+  Disk->Media.ReadOnly         = TRUE;
+  Disk->Media.BlockSize        = HOST_DISK_BLOCK_SIZE;
+  Disk->Media.LastBlock        = Disk->Size / HOST_DISK_BLOCK_SIZE - 1;
+
+  Disk->BlockIo.Revision    = EFI_BLOCK_IO_PROTOCOL_REVISION;
+  Disk->BlockIo.Media       = &Disk->Media;
+  Disk->BlockIo.Reset       = HostResetBlocks;
+  Disk->BlockIo.ReadBlocks  = HostReadBlocks;
+  Disk->BlockIo.WriteBlocks = HostWriteBlocks;
+  Disk->BlockIo.FlushBlocks = HostFlushBlocks;
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Closes a disk image.
+
+   @param[in out]  Disk          Pointer to the disk.
+**/
+VOID
+HostDiskClose (
+  IN OUT HOST_DISK  *Disk
+  )
+{
+  if (Disk->Image != NULL) {
+    fclose (Disk->Image);
+  }
+
+  ZeroMem (Disk, sizeof (HOST_DISK));
+}
+
+/**
+   EFI_BOOT_SERVICES.CreateEvent(). Only EVT_NOTIFY_SIGNAL notification
+   functions are supported.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostCreateEvent (
+  IN  UINT32            Type,
+  IN  EFI_TPL           NotifyTpl,
+  IN  EFI_EVENT_NOTIFY  NotifyFunction OPTIONAL,
+  IN  VOID              *NotifyContext OPTIONAL,
+  OUT EFI_EVENT         *Event
+  )
+{
+  HOST_EVENT  *HostEvent;
+
+  if ((Type & ~EVT_NOTIFY_SIGNAL) != 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (((Type & EVT_NOTIFY_SIGNAL) != 0) != (NotifyFunction != NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  HostEvent = AllocateZeroPool (sizeof (HOST_EVENT));
+
+  if (HostEvent == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  HostEvent->NotifyFunction = NotifyFunction;
+  HostEvent->NotifyContext  = NotifyContext;
+
+  *Event = HostEvent;
+  return EFI_SUCCESS;
+}
+
+/**
+   EFI_BOOT_SERVICES.CloseEvent().
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostCloseEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  FreePool (Event);
+  return EFI_SUCCESS;
+}
+
+/**
+   EFI_BOOT_SERVICES.SignalEvent(). The harness always runs at TPL_APPLICATION,
+   so the notification function, if any, runs right away.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostSignalEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  HOST_EVENT  *HostEvent;
+
+  HostEvent = Event;
+
+  if (HostEvent->NotifyFunction != NULL) {
+    HostEvent->NotifyFunction (Event, HostEvent->NotifyContext);
+    return EFI_SUCCESS;
+  }
+
+  HostEvent->Signalled = TRUE;
+  return EFI_SUCCESS;
+}
+
+/**
+   EFI_BOOT_SERVICES.CheckEvent().
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostCheckEvent (
+  IN EFI_EVENT  Event
+  )
+{
+  HOST_EVENT  *HostEvent;
+
+  HostEvent = Event;
+
+  if (!HostEvent->Signalled) {
+    return EFI_NOT_READY;
+  }
+
+  HostEvent->Signalled = FALSE;
+  return EFI_SUCCESS;
+}
+
+/**
+   EFI_BOOT_SERVICES.RaiseTPL(). The harness always runs at TPL_APPLICATION.
+**/
+STATIC
+EFI_TPL
+EFIAPI
+HostRaiseTpl (
+  IN EFI_TPL  NewTpl
+  )
+{
+  return TPL_APPLICATION;
+}
+
+/**
+   EFI_BOOT_SERVICES.RestoreTPL().
+**/
+STATIC
+VOID
+EFIAPI
+HostRestoreTpl (
+  IN EFI_TPL  OldTpl
+  )
+{
+}
+
+/**
+   EFI_BOOT_SERVICES.InstallMultipleProtocolInterfaces(). Only remembers
+   the Simple File System protocol, so the harness can get to it.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+HostInstallMultipleProtocolInterfaces (
+  IN OUT EFI_HANDLE  *Handle,
+  ...
+  )
+{
+  VA_LIST   Args;
+  EFI_GUID  *Protocol;
+  VOID      *Interface;
+
+  VA_START (Args, Handle);
+
+  for (Protocol = VA_ARG (Args, EFI_GUID *); Protocol != NULL; Protocol = VA_ARG (Args, EFI_GUID *)) {
+    Interface = VA_ARG (Args, VOID *);
+
+    if (CompareGuid (Protocol, &gEfiSimpleFileSystemProtocolGuid)) {
+      mHostFileSystem = Interface;
+    }
+  }
+
+  VA_END (Args);
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Sets up gBS with the handful of boot services Ext4Dxe uses.
+   Events are never signalled asynchronously: DISK_IO2 requests complete
+   before ReadDiskEx() returns, and signal their event right away, which
+   runs its notification function.
+**/
+VOID
+HostInitBootServices (
+  VOID
+  )
+{
+  mHostBootServices.CreateEvent                       = HostCreateEvent;
+  mHostBootServices.CloseEvent                        = HostCloseEvent;
+  mHostBootServices.SignalEvent                       = HostSignalEvent;
+  mHostBootServices.CheckEvent                        = HostCheckEvent;
+  mHostBootServices.RaiseTPL                          = HostRaiseTpl;
+  mHostBootServices.RestoreTPL                        = HostRestoreTpl;
+  mHostBootServices.InstallMultipleProtocolInterfaces = HostInstallMultipleProtocolInterfaces;
+
+  gBS = &mHostBootServices;
+}
+
+/**
+   Gets the Simple File System protocol installed by the last Ext4OpenPartition().
+
+   @return Pointer to the protocol, or NULL if no partition was opened.
+**/
+EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *
+HostGetFileSystem (
+  VOID
+  )
+{
+  return mHostFileSystem;
+}
+
+/**
+   Stand-in for Collation.c, which needs EFI_UNICODE_COLLATION_PROTOCOL:
+   folds the case of both strings with the host's C library.
+
+   @param[in]  Str1   Pointer to a null terminated string.
+   @param[in]  Str2   Pointer to a null terminated string.
+
+   @retval 0   Str1 is equivalent to Str2.
+   @retval >0  Str1 is lexically greater than Str2.
+   @retval <0  Str1 is lexically less than Str2.
+**/
+INTN
+Ext4StrCmpInsensitive (
+  IN CHAR16  *Str1,
+  IN CHAR16  *Str2
+  )
+{
+  while ((*Str1 != L'\0') && (towupper (*Str1) == towupper (*Str2))) {
+    Str1++;
+    Str2++;
+  }
+
+  return (INTN)towupper (*Str1) - (INTN)towupper (*Str2);
+}
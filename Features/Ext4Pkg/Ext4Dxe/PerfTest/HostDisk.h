@@ -0,0 +1,79 @@
+/** @file
+  File-backed disk and boot services stand-ins used by the Ext4Dxe host harness
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef EXT4_HOST_DISK_H_
+#define EXT4_HOST_DISK_H_
+
+#include <stdio.h>
+
+#include "../Ext4Dxe.h"
+
+//
+// Disk images are exposed with 512-byte blocks, like most real disks.
+//
+#define HOST_DISK_BLOCK_SIZE  512
+
+typedef struct {
+  EFI_DISK_IO_PROTOCOL     DiskIo;
+  EFI_DISK_IO2_PROTOCOL    DiskIo2;
+  EFI_BLOCK_IO_PROTOCOL    BlockIo;
+  EFI_BLOCK_IO_MEDIA       Media;
+
+  FILE                     *Image;
+  UINT64                   Size;
+
+  // Number of read requests (through any of the protocols) and bytes read
+  UINT64                   Reads;
+  UINT64                   ReadBytes;
+} HOST_DISK;
+
+/**
+   Opens a disk image and sets up the protocols that read from it.
+
+   @param[in]      Path          Path of the image on the host.
+   @param[out]     Disk          Pointer to the disk to set up.
+
+   @retval EFI_SUCCESS           The image was opened.
+   @retval EFI_NOT_FOUND         The image could not be opened.
+**/
+EFI_STATUS
+HostDiskOpen (
+  IN  CONST CHAR8  *Path,
+  OUT HOST_DISK    *Disk
+  );
+
+/**
+   Closes a disk image.
+
+   @param[in out]  Disk          Pointer to the disk.
+**/
+VOID
+HostDiskClose (
+  IN OUT HOST_DISK  *Disk
+  );
+
+/**
+   Sets up gBS with the handful of boot services Ext4Dxe uses.
+   Events are never signalled asynchronously: DISK_IO2 requests complete
+   before ReadDiskEx() returns, and signal their event right away.
+**/
+VOID
+HostInitBootServices (
+  VOID
+  );
+
+/**
+   Gets the Simple File System protocol installed by the last Ext4OpenPartition().
+
+   @return Pointer to the protocol, or NULL if no partition was opened.
+**/
+EFI_SIMPLE_FILE_SYSTEM_PROTOCOL *
+HostGetFileSystem (
+  VOID
+  );
+
+#endif
@@ -0,0 +1,173 @@
+## @file
+# Generates the ext4 images used by Ext4PerfHost.
+#
+# Every image is built from scratch with e2fsprogs (mke2fs -d, debugfs and
+# e2fsck, 1.43 or newer), with pseudo-random but reproducible contents, so no
+# image needs to be checked in. Each image stresses one of the driver's hot paths:
+#
+#   hugedir      One directory with tens of thousands of entries, indexed (htree).
+#   lineardir    The same directory, without the index.
+#   deeppath     Directories nested 64 levels deep, with a few files at each level.
+#   fragmented   A large file whose blocks are scattered across the disk.
+#   deepextents  A sparse file with so many extents that its extent tree is 2 levels deep.
+#   blockmap     An ext2 (no extents) file system with files that need triple indirect blocks.
+#
+# Usage: MakeCorpus.py [--only Name[,Name...]] OutputDir
+#
+# Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+# SPDX-License-Identifier: BSD-2-Clause-Patent
+##
+
+import argparse
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+
+BLOCK_SIZE = 4096
+
+
+def run(*args):
+    subprocess.run(args, check=True, stdout=subprocess.DEVNULL)
+
+
+def random_bytes(seed, length):
+    return random.Random(seed).getrandbits(length * 8).to_bytes(length, 'little')
+
+
+def write_file(path, data):
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, 'wb') as f:
+        f.write(data)
+
+
+def mkfs(image, size_mib, source, fs_type='ext4', extra=()):
+    if os.path.exists(image):
+        os.remove(image)
+
+    run('mke2fs', '-q', '-F', '-t', fs_type, '-E', 'root_owner=0:0',
+        *extra, '-d', source, image, '%dM' % size_mib)
+
+
+def debugfs(image, commands, work):
+    script = os.path.join(work, 'debugfs.cmd')
+
+    with open(script, 'w') as f:
+        f.write('\n'.join(commands) + '\n')
+
+    run('debugfs', '-w', '-f', script, image)
+
+
+def make_hugedir(image, work, indexed=True):
+    for index in range(30000):
+        write_file(os.path.join(work, 'dir', 'file_%05d.txt' % index),
+                   b'%d\n' % index)
+
+    mkfs(image, 128, work)
+
+    # mke2fs -d writes linear directories; e2fsck -D indexes them.
+    if indexed:
+        subprocess.run(('e2fsck', '-f', '-y', '-D', image),
+                       stdout=subprocess.DEVNULL)
+
+
+def make_lineardir(image, work):
+    make_hugedir(image, work, indexed=False)
+
+
+def make_deeppath(image, work):
+    path = work
+
+    for level in range(64):
+        path = os.path.join(path, 'level_%02d' % level)
+
+        for index in range(4):
+            write_file(os.path.join(path, 'file_%d.bin' % index),
+                       random_bytes(level * 4 + index, 16384))
+
+    mkfs(image, 32, work)
+
+
+def make_fragmented(image, work):
+    source = os.path.join(work, 'source')
+    blocks = 4096
+
+    # Fill the disk with one block files, delete every other one, and write the
+    # big file into the holes that are left.
+    for index in range(blocks * 2):
+        write_file(os.path.join(source, 'fill', 'f_%05d' % index),
+                   random_bytes(index, BLOCK_SIZE))
+
+    mkfs(image, 64, source)
+
+    data = os.path.join(work, 'fragmented.bin')
+    write_file(data, random_bytes(blocks * 2, blocks * BLOCK_SIZE))
+
+    commands = ['rm fill/f_%05d' % index for index in range(0, blocks * 2, 2)]
+    commands.append('write %s fragmented.bin' % data)
+    debugfs(image, commands, work)
+
+
+def make_deepextents(image, work):
+    path = os.path.join(work, 'source', 'sparse.bin')
+    os.makedirs(os.path.dirname(path))
+
+    # One block of data every other block: each one is an extent of its own.
+    with open(path, 'wb') as f:
+        for index in range(20000):
+            f.seek(index * 2 * BLOCK_SIZE)
+            f.write(random_bytes(index, BLOCK_SIZE))
+
+    mkfs(image, 256, os.path.dirname(path))
+
+
+def make_blockmap(image, work):
+    # With 1 KiB blocks, anything past 64 MiB needs triple indirect blocks.
+    write_file(os.path.join(work, 'big.bin'), random_bytes(1, 80 * 1024 * 1024))
+
+    for index in range(64):
+        write_file(os.path.join(work, 'small', 's_%02d.bin' % index),
+                   random_bytes(index + 2, 1024 * (index + 1)))
+
+    mkfs(image, 128, work, fs_type='ext2', extra=('-b', '1024'))
+
+
+IMAGES = {
+    'hugedir': make_hugedir,
+    'lineardir': make_lineardir,
+    'deeppath': make_deeppath,
+    'fragmented': make_fragmented,
+    'deepextents': make_deepextents,
+    'blockmap': make_blockmap,
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generates the Ext4PerfHost image corpus.')
+    parser.add_argument('--only', help='comma-separated list of images to generate')
+    parser.add_argument('output', help='directory where the images are written')
+    args = parser.parse_args()
+
+    names = args.only.split(',') if args.only else list(IMAGES)
+
+    for name in names:
+        if name not in IMAGES:
+            sys.exit('unknown image %s, pick from: %s' % (name, ', '.join(IMAGES)))
+
+    os.makedirs(args.output, exist_ok=True)
+
+    for name in names:
+        image = os.path.join(args.output, name + '.img')
+        work = tempfile.mkdtemp()
+
+        try:
+            print('Generating %s' % image)
+            IMAGES[name](image, work)
+        finally:
+            shutil.rmtree(work)
+
+
+if __name__ == '__main__':
+    main()
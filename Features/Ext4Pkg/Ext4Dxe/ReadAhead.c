@@ -0,0 +1,367 @@
+/** @file
+  Asynchronous read-ahead of regular files
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include "Ext4Dxe.h"
+
+/**
+   Frees a read-ahead request, its buffer and its event.
+
+   @param[in]      Request       Pointer to the request, which must not be in flight.
+**/
+STATIC
+VOID
+Ext4FreeReadAheadRequest (
+  IN EXT4_READ_AHEAD_REQUEST  *Request
+  )
+{
+  gBS->CloseEvent (Request->Token.Event);
+  FreePool (Request->Buffer);
+  FreePool (Request);
+}
+
+/**
+   Notification function of the read-ahead token's event, run when the request completes.
+
+   @param[in]      Event         The token's event.
+   @param[in]      Context       Pointer to the EXT4_READ_AHEAD_REQUEST.
+**/
+STATIC
+VOID
+EFIAPI
+Ext4ReadAheadDone (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EXT4_READ_AHEAD_REQUEST  *Request;
+
+  Request = Context;
+
+  // Nobody is left to consume the data if the file was closed
+  if (Request->Orphaned) {
+    Ext4FreeReadAheadRequest (Request);
+    return;
+  }
+
+  Request->Done = TRUE;
+}
+
+/**
+   Checks if the caller can wait for a read-ahead request to complete. The wait spins
+   until the token's event has run, which can't happen at or above its TPL.
+
+   @return TRUE if the current TPL is below TPL_CALLBACK.
+**/
+STATIC
+BOOLEAN
+Ext4CanWaitForReadAhead (
+  VOID
+  )
+{
+  EFI_TPL  OldTpl;
+
+  OldTpl = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+  gBS->RestoreTPL (OldTpl);
+
+  return (BOOLEAN)(OldTpl < TPL_CALLBACK);
+}
+
+/**
+   Waits for the file's read-ahead request to complete, if there's one in flight.
+   The caller must have checked Ext4CanWaitForReadAhead.
+
+   @param[in out]  ReadAhead     Pointer to the read-ahead window.
+**/
+STATIC
+VOID
+Ext4WaitForReadAhead (
+  IN OUT EXT4_READ_AHEAD  *ReadAhead
+  )
+{
+  if (!ReadAhead->Pending) {
+    return;
+  }
+
+  ASSERT (Ext4CanWaitForReadAhead ());
+
+  while (!ReadAhead->Request->Done) {
+    CpuPause ();
+  }
+
+  ReadAhead->Pending = FALSE;
+  ReadAhead->Valid   = !EFI_ERROR (ReadAhead->Request->Token.TransactionStatus);
+
+  if (!ReadAhead->Valid) {
+    DEBUG ((DEBUG_FS, "[ext4] Read-ahead failed: %r\n", ReadAhead->Request->Token.TransactionStatus));
+  }
+}
+
+/**
+   Checks if the read-ahead window covers (or will cover, once its request completes)
+   a file offset.
+
+   @param[in]      ReadAhead     Pointer to the read-ahead window.
+   @param[in]      Offset        File offset.
+
+   @return TRUE if the offset is inside the window.
+**/
+STATIC
+BOOLEAN
+Ext4ReadAheadCovers (
+  IN CONST EXT4_READ_AHEAD  *ReadAhead,
+  IN UINT64                 Offset
+  )
+{
+  if (!ReadAhead->Pending && !ReadAhead->Valid) {
+    return FALSE;
+  }
+
+  return (BOOLEAN)((Offset >= ReadAhead->Offset) && (Offset - ReadAhead->Offset < ReadAhead->Length));
+}
+
+/**
+   Starts reading the window that starts at the file's NextOffset, without waiting for it.
+   The window is clamped to the end of the extent it starts in, and to the end of the file.
+   Nothing is done for holes and uninitialized extents, since there's nothing to read.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in out]  File          Pointer to the opened file.
+**/
+STATIC
+VOID
+Ext4StartReadAhead (
+  IN     EXT4_PARTITION  *Partition,
+  IN OUT EXT4_FILE       *File
+  )
+{
+  EXT4_READ_AHEAD          *ReadAhead;
+  EXT4_READ_AHEAD_REQUEST  *Request;
+  EXT4_EXTENT              Extent;
+  EFI_STATUS               Status;
+  UINT64                   Offset;
+  UINT64                   InodeSize;
+  UINT64                   ExtentOffset;
+  UINT64                   DiskOffset;
+  UINT64                   Length;
+  UINT32                   BlockOff;
+  EXT4_BLOCK_NR            LogicalBlock;
+
+  ReadAhead = &File->ReadAhead;
+  Offset    = ReadAhead->NextOffset;
+  InodeSize = EXT4_INODE_SIZE (File->Inode);
+
+  if (Offset >= InodeSize) {
+    return;
+  }
+
+  // Reading the window needs waiting for the request, which can't be done at raised TPL
+  if (!Ext4CanWaitForReadAhead ()) {
+    return;
+  }
+
+  // Whatever is in flight is of no use now, but the disk owns the buffer until it's done
+  Ext4WaitForReadAhead (ReadAhead);
+  ReadAhead->Valid = FALSE;
+
+  if (ReadAhead->Request == NULL) {
+    Request = AllocateZeroPool (sizeof (EXT4_READ_AHEAD_REQUEST));
+
+    if (Request == NULL) {
+      return;
+    }
+
+    ReadAhead->BufferSize = PcdGet32 (PcdExt4ReadAheadSize);
+    Request->Buffer       = AllocatePool (ReadAhead->BufferSize);
+
+    if (Request->Buffer == NULL) {
+      FreePool (Request);
+      return;
+    }
+
+    Status = gBS->CreateEvent (
+                    EVT_NOTIFY_SIGNAL,
+                    TPL_CALLBACK,
+                    Ext4ReadAheadDone,
+                    Request,
+                    &Request->Token.Event
+                    );
+
+    if (EFI_ERROR (Status)) {
+      FreePool (Request->Buffer);
+      FreePool (Request);
+      return;
+    }
+
+    ReadAhead->Request = Request;
+  }
+
+  Request = ReadAhead->Request;
+
+  LogicalBlock = DivU64x32Remainder (Offset, Partition->BlockSize, &BlockOff);
+
+  Status = Ext4GetExtent (Partition, File, LogicalBlock, &Extent);
+
+  if ((Status != EFI_SUCCESS) || EXT4_EXTENT_IS_UNINITIALIZED (&Extent)) {
+    return;
+  }
+
+  ExtentOffset = Offset - EXT4_BLOCK_TO_BYTES (Partition, Extent.ee_block);
+  DiskOffset   = EXT4_BLOCK_TO_BYTES (Partition, EXT4_EXTENT_PHYSICAL_BLOCK (&Extent)) + ExtentOffset;
+  Length       = EXT4_BLOCK_TO_BYTES (Partition, Ext4GetExtentLength (&Extent)) - ExtentOffset;
+  Length       = MIN (Length, InodeSize - Offset);
+  Length       = MIN (Length, ReadAhead->BufferSize);
+
+  ReadAhead->Offset                = Offset;
+  ReadAhead->Length                = (UINTN)Length;
+  Request->Token.TransactionStatus = EFI_SUCCESS;
+  Request->Done                    = FALSE;
+
+  Status = EXT4_DISK_IO2 (Partition)->ReadDiskEx (
+                                        EXT4_DISK_IO2 (Partition),
+                                        EXT4_MEDIA_ID (Partition),
+                                        DiskOffset,
+                                        &Request->Token,
+                                        ReadAhead->Length,
+                                        Request->Buffer
+                                        );
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_FS, "[ext4] ReadDiskEx failed: %r\n", Status));
+    return;
+  }
+
+  Partition->DiskReads++;
+  Partition->DiskReadBytes += ReadAhead->Length;
+
+  ReadAhead->Pending = TRUE;
+}
+
+/**
+   Reads from a regular file, going through its read-ahead window.
+   Reads that continue where the previous one left off start a non-blocking
+   read of the data that comes next. If the disk has no DISK_IO2 or read-ahead
+   is disabled, this is the same as Ext4Read.
+
+   @param[in]      Partition     Pointer to the opened EXT4 partition.
+   @param[in]      File          Pointer to the opened file.
+   @param[out]     Buffer        Pointer to the buffer.
+   @param[in]      Offset        Offset of the read.
+   @param[in out]  Length        Pointer to the length of the buffer, in bytes.
+                                 After a successful read, it's updated to the number of read bytes.
+
+   @return Status of the read operation.
+**/
+EFI_STATUS
+Ext4ReadWithReadAhead (
+  IN     EXT4_PARTITION  *Partition,
+  IN     EXT4_FILE       *File,
+  OUT    VOID            *Buffer,
+  IN     UINT64          Offset,
+  IN OUT UINTN           *Length
+  )
+{
+  EXT4_READ_AHEAD  *ReadAhead;
+  EFI_STATUS       Status;
+  BOOLEAN          Sequential;
+  UINT64           InodeSize;
+  UINTN            Remaining;
+  UINTN            ToCopy;
+  UINTN            WasRead;
+
+  ReadAhead = &File->ReadAhead;
+
+  if ((EXT4_DISK_IO2 (Partition) == NULL) || (PcdGet32 (PcdExt4ReadAheadSize) == 0)) {
+    return Ext4Read (Partition, File, Buffer, Offset, Length);
+  }
+
+  InodeSize = EXT4_INODE_SIZE (File->Inode);
+
+  if (Offset > InodeSize) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  Remaining = *Length;
+
+  if (Remaining > InodeSize - Offset) {
+    Remaining = (UINTN)(InodeSize - Offset);
+  }
+
+  Sequential = (BOOLEAN)(Offset == ReadAhead->NextOffset);
+  WasRead    = 0;
+
+  // Take whatever we can from the window. It's only useful if it contains the start of the read.
+  // A request still in flight can only be waited for below TPL_CALLBACK.
+  if ((Remaining != 0) && Ext4ReadAheadCovers (ReadAhead, Offset) &&
+      (!ReadAhead->Pending || Ext4CanWaitForReadAhead ()))
+  {
+    Ext4WaitForReadAhead (ReadAhead);
+
+    if (ReadAhead->Valid) {
+      ToCopy = (UINTN)MIN (Remaining, ReadAhead->Offset + ReadAhead->Length - Offset);
+      CopyMem (Buffer, (CONST CHAR8 *)ReadAhead->Request->Buffer + (Offset - ReadAhead->Offset), ToCopy);
+      WasRead = ToCopy;
+    }
+  }
+
+  // And read the rest ourselves
+  if (WasRead < Remaining) {
+    *Length = Remaining - WasRead;
+    Status  = Ext4Read (Partition, File, (CHAR8 *)Buffer + WasRead, Offset + WasRead, Length);
+
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    WasRead += *Length;
+  }
+
+  *Length               = WasRead;
+  ReadAhead->NextOffset = Offset + WasRead;
+
+  // If the file is being read sequentially and the window has been consumed (or
+  // doesn't hold what comes next), start fetching the next one.
+  if (Sequential && !Ext4ReadAheadCovers (ReadAhead, ReadAhead->NextOffset)) {
+    Ext4StartReadAhead (Partition, File);
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+   Frees a file's read-ahead window. A request still in flight is not waited
+   for, it's freed by its event once it completes.
+
+   @param[in out]  File          Pointer to the opened file.
+**/
+VOID
+Ext4FreeReadAhead (
+  IN OUT EXT4_FILE  *File
+  )
+{
+  EXT4_READ_AHEAD          *ReadAhead;
+  EXT4_READ_AHEAD_REQUEST  *Request;
+  EFI_TPL                  OldTpl;
+  BOOLEAN                  InFlight;
+
+  ReadAhead = &File->ReadAhead;
+  Request   = ReadAhead->Request;
+
+  if (Request != NULL) {
+    // Close can be called at any TPL, so don't wait: the disk owns the request until it
+    // completes, and the event can't run between the check and setting Orphaned.
+    OldTpl            = gBS->RaiseTPL (TPL_HIGH_LEVEL);
+    InFlight          = (BOOLEAN)(ReadAhead->Pending && !Request->Done);
+    Request->Orphaned = InFlight;
+    gBS->RestoreTPL (OldTpl);
+
+    if (!InFlight) {
+      Ext4FreeReadAheadRequest (Request);
+    }
+  }
+
+  ZeroMem (ReadAhead, sizeof (EXT4_READ_AHEAD));
+}
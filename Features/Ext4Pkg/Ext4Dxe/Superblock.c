@@ -21,7 +21,7 @@ STATIC CONST UINT32  gSupportedIncompatFeat =
   EXT4_FEATURE_INCOMPAT_MMP | EXT4_FEATURE_INCOMPAT_RECOVER | EXT4_FEATURE_INCOMPAT_CSUM_SEED;
 
 // Future features that may be nice additions in the future:
-// 1) Btree support: Required for write support and would speed up lookups in large directories.
+// 1) Btree updates: Required for write support (lookups already use the hash tree index).
 // 2) meta_bg: Required to mount meta_bg-enabled partitions.
 
 // Note: We ignore MMP because it's impossible that it's mapped elsewhere,
@@ -159,13 +159,9 @@ Ext4OpenSuperblock (
   OUT EXT4_PARTITION  *Partition
   )
 {
-  UINT32                 Index;
-  EFI_STATUS             Status;
-  EXT4_SUPERBLOCK        *Sb;
-  UINT32                 NrBlocksRem;
-  UINTN                  NrBlocks;
-  UINT32                 UnsupportedRoCompat;
-  EXT4_BLOCK_GROUP_DESC  *Desc;
+  EFI_STATUS       Status;
+  EXT4_SUPERBLOCK  *Sb;
+  UINT32           UnsupportedRoCompat;
 
   Status = Ext4ReadDiskIo (
              Partition,
@@ -277,6 +273,11 @@ Ext4OpenSuperblock (
       return EFI_VOLUME_CORRUPTED;
     }
 
+    // Descriptors must not straddle block boundaries, as blocks of descriptors are read separately
+    if (((Sb->s_desc_size & (Sb->s_desc_size - 1)) != 0) || (Sb->s_desc_size > Partition->BlockSize)) {
+      return EFI_VOLUME_CORRUPTED;
+    }
+
     Partition->DescSize = Sb->s_desc_size;
   } else {
     Partition->DescSize = EXT4_OLD_BLOCK_DESC_SIZE;
@@ -287,36 +288,40 @@ Ext4OpenSuperblock (
     return EFI_VOLUME_CORRUPTED;
   }
 
-  NrBlocks = (UINTN)DivU64x32Remainder (
-                      MultU64x32 (Partition->NumberBlockGroups, Partition->DescSize),
-                      Partition->BlockSize,
-                      &NrBlocksRem
-                      );
+  // Block group descriptors are read and verified on demand, a block at a time, so mounting
+  // doesn't need to go through the whole descriptor table of huge filesystems.
+  Status = Ext4InitBlockGroupDescs (Partition);
 
-  if (NrBlocksRem != 0) {
-    NrBlocks++;
+  if (EFI_ERROR (Status)) {
+    return Status;
   }
 
-  Partition->BlockGroups = Ext4AllocAndReadBlocks (Partition, NrBlocks, Partition->BlockSize == 1024 ? 2 : 1);
+  Status = Ext4InitBlockCache (Partition);
 
-  if (Partition->BlockGroups == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  if (EFI_ERROR (Status)) {
+    Ext4FreeBlockGroupDescs (Partition);
+    return Status;
   }
 
-  for (Index = 0; Index < Partition->NumberBlockGroups; Index++) {
-    Desc = Ext4GetBlockGroupDesc (Partition, Index);
-    if (!Ext4VerifyBlockGroupDescChecksum (Partition, Desc, Index)) {
-      DEBUG ((DEBUG_ERROR, "[ext4] Block group descriptor %u has an invalid checksum\n", Index));
-      FreePool (Partition->BlockGroups);
-      return EFI_VOLUME_CORRUPTED;
-    }
+  Status = Ext4InitInodeCache (Partition);
+
+  if (EFI_ERROR (Status)) {
+    Ext4FreeBlockCache (Partition);
+    Ext4FreeBlockGroupDescs (Partition);
+    return Status;
   }
 
+  InitializeListHead (&Partition->DentryLru);
+  Partition->NumberCachedDentries = 0;
+  Partition->DentryCacheMediaId   = EXT4_MEDIA_ID (Partition);
+
   // RootDentry will serve as the basis of our directory entry tree.
   Partition->RootDentry = Ext4CreateDentry (L"\\", NULL);
 
   if (Partition->RootDentry == NULL) {
-    FreePool (Partition->BlockGroups);
+    Ext4FreeInodeCache (Partition);
+    Ext4FreeBlockCache (Partition);
+    Ext4FreeBlockGroupDescs (Partition);
     return EFI_OUT_OF_RESOURCES;
   }
 
@@ -325,7 +330,9 @@ Ext4OpenSuperblock (
 
   if (EFI_ERROR (Status)) {
     Ext4UnrefDentry (Partition->RootDentry);
-    FreePool (Partition->BlockGroups);
+    Ext4FreeInodeCache (Partition);
+    Ext4FreeBlockCache (Partition);
+    Ext4FreeBlockGroupDescs (Partition);
   }
 
   return Status;
@@ -355,7 +362,8 @@ Ext4CalculateChecksum (
   switch (Partition->SuperBlock.s_checksum_type) {
     case EXT4_CHECKSUM_CRC32C:
       // For some reason, EXT4 really likes non-inverted CRC32C checksums, so we stick to that here.
-      return ~CalculateCrc32c(Buffer, Length, ~InitialValue);
+      // Ext4Crc32c doesn't invert the CRC, unlike CalculateCrc32c.
+      return Ext4Crc32c (InitialValue, Buffer, Length);
     default:
       ASSERT (FALSE);
       return 0;
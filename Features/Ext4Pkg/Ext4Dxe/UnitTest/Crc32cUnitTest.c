@@ -0,0 +1,267 @@
+/** @file
+  Host-based unit tests of the CRC32C engine used for metadata checksums
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Uefi.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/UnitTestLib.h>
+
+#include "../Crc32c.h"
+
+#define UNIT_TEST_NAME     "Ext4Dxe CRC32C Unit Tests"
+#define UNIT_TEST_VERSION  "1.0"
+
+//
+// Big enough to cover every head/body/tail split of the 8-byte loops,
+// plus something resembling a real metadata block.
+//
+#define CRC32C_TEST_MAX_LENGTH   4096
+#define CRC32C_TEST_MAX_OFFSET   8
+#define CRC32C_TEST_SHORT_LIMIT  80
+
+typedef UINT32 (*CRC32C_TEST_FUNC)(
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  );
+
+STATIC UINT8  mCrc32cTestBuffer[CRC32C_TEST_MAX_LENGTH + CRC32C_TEST_MAX_OFFSET];
+
+/**
+   Wrapper so the EFIAPI hardware routine can be called through a CRC32C_TEST_FUNC.
+**/
+STATIC
+UINT32
+Crc32cTestHw (
+  IN UINT32      Crc,
+  IN CONST VOID  *Buffer,
+  IN UINTN       Length
+  )
+{
+  return Ext4Crc32cHw (Crc, Buffer, Length);
+}
+
+/**
+   Fills the test buffer with reproducible pseudo-random contents.
+**/
+STATIC
+VOID
+Crc32cTestFillBuffer (
+  VOID
+  )
+{
+  UINT32  Seed;
+  UINTN   Index;
+
+  Seed = 0x12345678;
+
+  for (Index = 0; Index < sizeof (mCrc32cTestBuffer); Index++) {
+    Seed                     = Seed * 1103515245 + 12345;
+    mCrc32cTestBuffer[Index] = (UINT8)(Seed >> 16);
+  }
+}
+
+/**
+   Checks a CRC32C implementation against CalculateCrc32c() for every buffer
+   alignment and a range of lengths and initial values.
+
+   @param[in]  Func     The implementation under test.
+
+   @retval  UNIT_TEST_PASSED             Every checksum matched.
+   @retval  UNIT_TEST_ERROR_TEST_FAILED  A checksum differed.
+**/
+STATIC
+UNIT_TEST_STATUS
+Crc32cTestAgainstReference (
+  IN CRC32C_TEST_FUNC  Func
+  )
+{
+  STATIC CONST UINT32  Seeds[] = { 0, 0xFFFFFFFF, 0x82F63B78, 0xDEADBEEF };
+  UINTN                Offset;
+  UINTN                Length;
+  UINTN                SeedIndex;
+  UINT32               Expected;
+  UINT32               Crc;
+
+  for (SeedIndex = 0; SeedIndex < ARRAY_SIZE (Seeds); SeedIndex++) {
+    for (Offset = 0; Offset < CRC32C_TEST_MAX_OFFSET; Offset++) {
+      for (Length = 0; Length <= CRC32C_TEST_MAX_LENGTH; Length++) {
+        // Every length up to a few 8-byte rounds, then a sampling of the rest
+        if ((Length > CRC32C_TEST_SHORT_LIMIT) && ((Length % 61) != 0) && ((Length & (Length - 1)) != 0)) {
+          continue;
+        }
+
+        Expected = CalculateCrc32c (mCrc32cTestBuffer + Offset, Length, Seeds[SeedIndex]);
+        Crc      = ~Func (~Seeds[SeedIndex], mCrc32cTestBuffer + Offset, Length);
+
+        UT_ASSERT_EQUAL (Crc, Expected);
+      }
+    }
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks the well-known CRC32C check value.
+
+  @param[in]  Context    Unused.
+
+  @retval  UNIT_TEST_PASSED             The test case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+Crc32cCheckValue (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  STATIC CONST CHAR8  Check[] = "123456789";
+
+  UT_ASSERT_EQUAL (~Ext4Crc32cSlicing8 (~0U, Check, sizeof (Check) - 1), 0xE3069283);
+  UT_ASSERT_EQUAL (~Ext4Crc32c (~0U, Check, sizeof (Check) - 1), 0xE3069283);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Checks the slicing-by-8 implementation against CalculateCrc32c().
+
+  @param[in]  Context    Unused.
+
+  @retval  UNIT_TEST_PASSED             The test case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+Crc32cSlicing8MatchesReference (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  return Crc32cTestAgainstReference (Ext4Crc32cSlicing8);
+}
+
+/**
+  Checks the CRC32C instruction implementation against CalculateCrc32c().
+
+  @param[in]  Context    Unused.
+
+  @retval  UNIT_TEST_PASSED             The test case was successful.
+  @retval  UNIT_TEST_SKIPPED            The CPU has no CRC32C instructions.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+Crc32cHwMatchesReference (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  if (!Ext4Crc32cHwSupported ()) {
+    UT_LOG_INFO ("No CRC32C instructions on this CPU\n");
+    return UNIT_TEST_SKIPPED;
+  }
+
+  return Crc32cTestAgainstReference (Crc32cTestHw);
+}
+
+/**
+  Checks that a checksum can be computed in pieces, like Ext4Dxe does for
+  checksums over several fields.
+
+  @param[in]  Context    Unused.
+
+  @retval  UNIT_TEST_PASSED             The test case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+Crc32cChained (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  UINTN   Split;
+  UINT32  Expected;
+  UINT32  Crc;
+
+  Expected = ~CalculateCrc32c (mCrc32cTestBuffer, 1024, 0);
+
+  for (Split = 0; Split <= 1024; Split += 13) {
+    Crc = Ext4Crc32c (~0U, mCrc32cTestBuffer, Split);
+    Crc = Ext4Crc32c (Crc, mCrc32cTestBuffer + Split, 1024 - Split);
+
+    UT_ASSERT_EQUAL (Crc, Expected);
+  }
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  CRC32C engine and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      Crc32cSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&Crc32cSuite, Framework, "CRC32C Tests", "Ext4Dxe.Crc32c", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for CRC32C Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  Ext4InitCrc32c ();
+  Crc32cTestFillBuffer ();
+
+  AddTestCase (Crc32cSuite, "CRC32C check value", "CheckValue", Crc32cCheckValue, NULL, NULL, NULL);
+  AddTestCase (Crc32cSuite, "Slicing-by-8 matches CalculateCrc32c", "Slicing8", Crc32cSlicing8MatchesReference, NULL, NULL, NULL);
+  AddTestCase (Crc32cSuite, "CRC32C instructions match CalculateCrc32c", "Hw", Crc32cHwMatchesReference, NULL, NULL, NULL);
+  AddTestCase (Crc32cSuite, "Chained checksums match a single pass", "Chained", Crc32cChained, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
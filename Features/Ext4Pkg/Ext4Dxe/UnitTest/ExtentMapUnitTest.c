@@ -0,0 +1,480 @@
+/** @file
+  Host-based unit tests and micro-benchmark of the per-file extents map
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <time.h>
+
+#include "../Ext4Dxe.h"
+
+#include <Library/OrderedCollectionLib.h>
+#include <Library/UnitTestLib.h>
+
+#define UNIT_TEST_NAME     "Ext4Dxe Extents Map Unit Tests"
+#define UNIT_TEST_VERSION  "1.0"
+
+//
+// Shape of the file used by the benchmark: lots of small extents with
+// holes between them, like a heavily fragmented file.
+//
+#define BENCH_NUMBER_EXTENTS  8192
+#define BENCH_EXTENT_LENGTH   8
+#define BENCH_EXTENT_STRIDE   10
+#define BENCH_LEAF_EXTENTS    340
+#define BENCH_RANDOM_LOOKUPS  (1 << 20)
+
+/**
+   Fills in an extent.
+
+   @param[out]     Extent        Pointer to the extent.
+   @param[in]      Block         First logical block.
+   @param[in]      Length        Length, in blocks.
+   @param[in]      Physical      First physical block.
+**/
+STATIC
+VOID
+ExtentMapTestSetExtent (
+  OUT EXT4_EXTENT  *Extent,
+  IN  UINT32       Block,
+  IN  UINT16       Length,
+  IN  UINT32       Physical
+  )
+{
+  Extent->ee_block    = Block;
+  Extent->ee_len      = Length;
+  Extent->ee_start_hi = 0;
+  Extent->ee_start_lo = Physical;
+}
+
+/**
+   Builds the extents of the benchmark file.
+
+   @return Pointer to BENCH_NUMBER_EXTENTS extents, sorted by logical block.
+**/
+STATIC
+EXT4_EXTENT *
+ExtentMapTestBuildFile (
+  VOID
+  )
+{
+  EXT4_EXTENT  *Extents;
+  UINT32       Index;
+
+  Extents = AllocatePool (BENCH_NUMBER_EXTENTS * sizeof (EXT4_EXTENT));
+
+  if (Extents == NULL) {
+    return NULL;
+  }
+
+  for (Index = 0; Index < BENCH_NUMBER_EXTENTS; Index++) {
+    ExtentMapTestSetExtent (
+      &Extents[Index],
+      Index * BENCH_EXTENT_STRIDE,
+      BENCH_EXTENT_LENGTH,
+      1000000 + Index * 3 * BENCH_EXTENT_STRIDE
+      );
+  }
+
+  return Extents;
+}
+
+/**
+   Checks that every block of the benchmark file is found in the right extent,
+   and that blocks in holes aren't found at all.
+
+   @param[in]  Context    Unused.
+
+   @retval  UNIT_TEST_PASSED             The test case was successful.
+   @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ExtentMapLookup (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EXT4_FILE    File;
+  EXT4_EXTENT  *Extents;
+  EXT4_EXTENT  *Extent;
+  UINT32       Block;
+  UINTN        Leaf;
+
+  Extents = ExtentMapTestBuildFile ();
+  UT_ASSERT_NOT_NULL (Extents);
+
+  ZeroMem (&File, sizeof (File));
+  UT_ASSERT_NOT_EFI_ERROR (Ext4InitExtentsMap (&File));
+
+  // Cache leaves out of order, the way a file read backwards would
+  for (Leaf = BENCH_NUMBER_EXTENTS / BENCH_LEAF_EXTENTS + 1; Leaf-- > 0;) {
+    Ext4CacheExtents (
+      &File,
+      Extents + Leaf * BENCH_LEAF_EXTENTS,
+      (UINT16)MIN (BENCH_LEAF_EXTENTS, BENCH_NUMBER_EXTENTS - MIN (Leaf * BENCH_LEAF_EXTENTS, BENCH_NUMBER_EXTENTS))
+      );
+  }
+
+  UT_ASSERT_EQUAL (File.ExtentsMap.NumberExtents, BENCH_NUMBER_EXTENTS);
+
+  // Caching the same extents again doesn't change anything
+  Ext4CacheExtents (&File, Extents, BENCH_LEAF_EXTENTS);
+  UT_ASSERT_EQUAL (File.ExtentsMap.NumberExtents, BENCH_NUMBER_EXTENTS);
+
+  for (Block = 0; Block < BENCH_NUMBER_EXTENTS * BENCH_EXTENT_STRIDE + 16; Block++) {
+    Extent = Ext4GetExtentFromMap (&File, Block);
+
+    if ((Block >= BENCH_NUMBER_EXTENTS * BENCH_EXTENT_STRIDE) || (Block % BENCH_EXTENT_STRIDE >= BENCH_EXTENT_LENGTH)) {
+      UT_ASSERT_TRUE (Extent == NULL);
+      continue;
+    }
+
+    UT_ASSERT_NOT_NULL (Extent);
+    UT_ASSERT_EQUAL (Extent->ee_block, Block - Block % BENCH_EXTENT_STRIDE);
+    UT_ASSERT_EQUAL (Extent->ee_start_lo, Extents[Block / BENCH_EXTENT_STRIDE].ee_start_lo);
+  }
+
+  Ext4FreeExtentsMap (&File);
+  FreePool (Extents);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+   Checks that overlapping extents (which files that use block maps can produce)
+   are trimmed or skipped, and that uninitialized extents stay uninitialized.
+
+   @param[in]  Context    Unused.
+
+   @retval  UNIT_TEST_PASSED             The test case was successful.
+   @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ExtentMapOverlaps (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EXT4_FILE    File;
+  EXT4_EXTENT  Extent;
+  EXT4_EXTENT  *Found;
+
+  ZeroMem (&File, sizeof (File));
+  UT_ASSERT_NOT_EFI_ERROR (Ext4InitExtentsMap (&File));
+
+  // [10, 20)
+  ExtentMapTestSetExtent (&Extent, 10, 10, 100);
+  Ext4CacheExtents (&File, &Extent, 1);
+
+  // [5, 15), uninitialized: trimmed to [5, 10)
+  ExtentMapTestSetExtent (&Extent, 5, EXT4_EXTENT_MAX_INITIALIZED + 10, 200);
+  Ext4CacheExtents (&File, &Extent, 1);
+
+  // [12, 30): starts inside [10, 20), skipped
+  ExtentMapTestSetExtent (&Extent, 12, 18, 300);
+  Ext4CacheExtents (&File, &Extent, 1);
+
+  UT_ASSERT_EQUAL (File.ExtentsMap.NumberExtents, 2);
+
+  Found = Ext4GetExtentFromMap (&File, 9);
+  UT_ASSERT_NOT_NULL (Found);
+  UT_ASSERT_EQUAL (Found->ee_block, 5);
+  UT_ASSERT_TRUE (EXT4_EXTENT_IS_UNINITIALIZED (Found));
+  UT_ASSERT_EQUAL (Ext4GetExtentLength (Found), 5);
+
+  Found = Ext4GetExtentFromMap (&File, 12);
+  UT_ASSERT_NOT_NULL (Found);
+  UT_ASSERT_EQUAL (Found->ee_start_lo, 100);
+
+  UT_ASSERT_TRUE (Ext4GetExtentFromMap (&File, 20) == NULL);
+  UT_ASSERT_TRUE (Ext4GetExtentFromMap (&File, 4) == NULL);
+
+  Ext4FreeExtentsMap (&File);
+
+  return UNIT_TEST_PASSED;
+}
+
+//
+// The extents map as it used to be: one pool allocation per extent, kept in an
+// ORDERED_COLLECTION. Only here to be compared against.
+//
+
+/**
+  Compare two EXT4_EXTENT structs.
+
+  @param[in] UserStruct1  Pointer to the first user structure.
+  @param[in] UserStruct2  Pointer to the second user structure.
+
+  @return <0, 0 or >0 if UserStruct1 compares less than, equal to or greater than UserStruct2.
+**/
+STATIC
+INTN
+EFIAPI
+ExtentMapTestStructCompare (
+  IN CONST VOID  *UserStruct1,
+  IN CONST VOID  *UserStruct2
+  )
+{
+  CONST EXT4_EXTENT  *Extent1;
+  CONST EXT4_EXTENT  *Extent2;
+
+  Extent1 = UserStruct1;
+  Extent2 = UserStruct2;
+
+  return Extent1->ee_block < Extent2->ee_block ? -1 :
+         Extent1->ee_block > Extent2->ee_block ? 1 : 0;
+}
+
+/**
+  Compare a standalone key against a EXT4_EXTENT containing an embedded key.
+
+  @param[in] StandaloneKey  Pointer to the bare key.
+  @param[in] UserStruct     Pointer to the user structure with the embedded key.
+
+  @return <0, 0 or >0 if StandaloneKey compares less than, equal to or greater than UserStruct's key.
+**/
+STATIC
+INTN
+EFIAPI
+ExtentMapTestKeyCompare (
+  IN CONST VOID  *StandaloneKey,
+  IN CONST VOID  *UserStruct
+  )
+{
+  CONST EXT4_EXTENT  *Extent;
+  UINT32             Block;
+
+  Extent = UserStruct;
+  Block  = (UINT32)(UINTN)StandaloneKey;
+
+  if ((Block >= Extent->ee_block) && (Block - Extent->ee_block < Ext4GetExtentLength (Extent))) {
+    return 0;
+  }
+
+  return Block < Extent->ee_block ? -1 :
+         Block > Extent->ee_block ? 1 : 0;
+}
+
+/**
+   Gets the time elapsed since Start, in microseconds.
+
+   @param[in]  Start     Value of clock() at the start.
+
+   @return Elapsed time, in microseconds.
+**/
+STATIC
+UINT64
+ExtentMapTestElapsedUs (
+  IN clock_t  Start
+  )
+{
+  return (UINT64)(clock () - Start) * 1000000 / CLOCKS_PER_SEC;
+}
+
+/**
+   Compares the cost of building and looking up a fragmented file's extents
+   in the ORDERED_COLLECTION the map used to be and in the sorted array.
+   Both must find the same extents.
+
+   @param[in]  Context    Unused.
+
+   @retval  UNIT_TEST_PASSED             The test case was successful.
+   @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+ExtentMapBenchmark (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EXT4_FILE                 File;
+  ORDERED_COLLECTION        *Tree;
+  ORDERED_COLLECTION_ENTRY  *Entry;
+  EXT4_EXTENT               *Extents;
+  EXT4_EXTENT               *Extent;
+  EXT4_EXTENT               *TreeExtent;
+  UINT32                    *Blocks;
+  UINT32                    Seed;
+  UINTN                     Index;
+  UINTN                     Round;
+  UINT64                    TreeTime[3];
+  UINT64                    ArrayTime[3];
+  UINT64                    TreeHits;
+  UINT64                    ArrayHits;
+  clock_t                   Start;
+
+  Extents = ExtentMapTestBuildFile ();
+  Blocks  = AllocatePool (BENCH_RANDOM_LOOKUPS * sizeof (UINT32));
+  UT_ASSERT_NOT_NULL (Extents);
+  UT_ASSERT_NOT_NULL (Blocks);
+
+  Seed = 0x12345678;
+
+  for (Index = 0; Index < BENCH_RANDOM_LOOKUPS; Index++) {
+    Seed          = Seed * 1103515245 + 12345;
+    Blocks[Index] = (Seed >> 8) % (BENCH_NUMBER_EXTENTS * BENCH_EXTENT_STRIDE);
+  }
+
+  // Insertion
+  Start = clock ();
+  Tree  = OrderedCollectionInit (ExtentMapTestStructCompare, ExtentMapTestKeyCompare);
+  UT_ASSERT_NOT_NULL (Tree);
+
+  for (Index = 0; Index < BENCH_NUMBER_EXTENTS; Index++) {
+    TreeExtent = AllocateCopyPool (sizeof (EXT4_EXTENT), &Extents[Index]);
+    UT_ASSERT_NOT_NULL (TreeExtent);
+    UT_ASSERT_NOT_EFI_ERROR (OrderedCollectionInsert (Tree, NULL, TreeExtent));
+  }
+
+  TreeTime[0] = ExtentMapTestElapsedUs (Start);
+
+  Start = clock ();
+  ZeroMem (&File, sizeof (File));
+  Ext4InitExtentsMap (&File);
+
+  for (Index = 0; Index < BENCH_NUMBER_EXTENTS; Index += BENCH_LEAF_EXTENTS) {
+    Ext4CacheExtents (&File, &Extents[Index], (UINT16)MIN (BENCH_LEAF_EXTENTS, BENCH_NUMBER_EXTENTS - Index));
+  }
+
+  ArrayTime[0] = ExtentMapTestElapsedUs (Start);
+
+  // Sequential lookups, a block at a time, like Ext4Read going through a file
+  TreeHits  = 0;
+  ArrayHits = 0;
+  Start     = clock ();
+
+  for (Round = 0; Round < 16; Round++) {
+    for (Index = 0; Index < BENCH_NUMBER_EXTENTS * BENCH_EXTENT_STRIDE; Index++) {
+      TreeHits += OrderedCollectionFind (Tree, (CONST VOID *)Index) != NULL;
+    }
+  }
+
+  TreeTime[1] = ExtentMapTestElapsedUs (Start);
+  Start       = clock ();
+
+  for (Round = 0; Round < 16; Round++) {
+    for (Index = 0; Index < BENCH_NUMBER_EXTENTS * BENCH_EXTENT_STRIDE; Index++) {
+      ArrayHits += Ext4GetExtentFromMap (&File, (UINT32)Index) != NULL;
+    }
+  }
+
+  ArrayTime[1] = ExtentMapTestElapsedUs (Start);
+  UT_ASSERT_EQUAL (TreeHits, ArrayHits);
+
+  // Random lookups
+  TreeHits  = 0;
+  ArrayHits = 0;
+  Start     = clock ();
+
+  for (Index = 0; Index < BENCH_RANDOM_LOOKUPS; Index++) {
+    TreeHits += OrderedCollectionFind (Tree, (CONST VOID *)(UINTN)Blocks[Index]) != NULL;
+  }
+
+  TreeTime[2] = ExtentMapTestElapsedUs (Start);
+  Start       = clock ();
+
+  for (Index = 0; Index < BENCH_RANDOM_LOOKUPS; Index++) {
+    ArrayHits += Ext4GetExtentFromMap (&File, Blocks[Index]) != NULL;
+  }
+
+  ArrayTime[2] = ExtentMapTestElapsedUs (Start);
+  UT_ASSERT_EQUAL (TreeHits, ArrayHits);
+
+  // Both must agree on every lookup
+  for (Index = 0; Index < BENCH_RANDOM_LOOKUPS; Index += 97) {
+    Entry  = OrderedCollectionFind (Tree, (CONST VOID *)(UINTN)Blocks[Index]);
+    Extent = Ext4GetExtentFromMap (&File, Blocks[Index]);
+
+    UT_ASSERT_EQUAL (Entry == NULL, Extent == NULL);
+
+    if (Extent != NULL) {
+      UT_ASSERT_MEM_EQUAL (OrderedCollectionUserStruct (Entry), Extent, sizeof (EXT4_EXTENT));
+    }
+  }
+
+  UT_LOG_INFO (
+    "%u extents: insert tree %luus array %luus; sequential tree %luus array %luus; random tree %luus array %luus\n",
+    BENCH_NUMBER_EXTENTS,
+    TreeTime[0],
+    ArrayTime[0],
+    TreeTime[1],
+    ArrayTime[1],
+    TreeTime[2],
+    ArrayTime[2]
+    );
+
+  while ((Entry = OrderedCollectionMin (Tree)) != NULL) {
+    OrderedCollectionDelete (Tree, Entry, (VOID **)&TreeExtent);
+    FreePool (TreeExtent);
+  }
+
+  OrderedCollectionUninit (Tree);
+  Ext4FreeExtentsMap (&File);
+  FreePool (Blocks);
+  FreePool (Extents);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Initialize the unit test framework, suite, and unit tests for the
+  extents map and run the unit tests.
+
+  @retval  EFI_SUCCESS           All test cases were dispatched.
+  @retval  EFI_OUT_OF_RESOURCES  There are not enough resources available to
+                                 initialize the unit tests.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+UnitTestingEntry (
+  VOID
+  )
+{
+  EFI_STATUS                  Status;
+  UNIT_TEST_FRAMEWORK_HANDLE  Framework;
+  UNIT_TEST_SUITE_HANDLE      ExtentMapSuite;
+
+  Framework = NULL;
+
+  DEBUG ((DEBUG_INFO, "%a v%a\n", UNIT_TEST_NAME, UNIT_TEST_VERSION));
+
+  Status = InitUnitTestFramework (&Framework, UNIT_TEST_NAME, gEfiCallerBaseName, UNIT_TEST_VERSION);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in InitUnitTestFramework. Status = %r\n", Status));
+    goto EXIT;
+  }
+
+  Status = CreateUnitTestSuite (&ExtentMapSuite, Framework, "Extents Map Tests", "Ext4Dxe.ExtentMap", NULL, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "Failed in CreateUnitTestSuite for Extents Map Tests\n"));
+    Status = EFI_OUT_OF_RESOURCES;
+    goto EXIT;
+  }
+
+  AddTestCase (ExtentMapSuite, "Lookups find the right extent", "Lookup", ExtentMapLookup, NULL, NULL, NULL);
+  AddTestCase (ExtentMapSuite, "Overlapping extents are trimmed", "Overlaps", ExtentMapOverlaps, NULL, NULL, NULL);
+  AddTestCase (ExtentMapSuite, "Sorted array vs ORDERED_COLLECTION benchmark", "Benchmark", ExtentMapBenchmark, NULL, NULL, NULL);
+
+  Status = RunAllTestSuites (Framework);
+
+EXIT:
+  if (Framework) {
+    FreeUnitTestFramework (Framework);
+  }
+
+  return Status;
+}
+
+/**
+  Standard POSIX C entry point for host based unit test execution.
+**/
+int
+main (
+  int   argc,
+  char  *argv[]
+  )
+{
+  return UnitTestingEntry ();
+}
@@ -0,0 +1,30 @@
+/** @file
+  CRC32C instruction detection for x64
+
+  Copyright (c) 2021 - 2023 Pedro Falcato All rights reserved.
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Library/BaseLib.h>
+
+#include "../Crc32c.h"
+
+// CPUID.01h:ECX.SSE4_2[bit 20]
+#define EXT4_CPUID_SSE42  BIT20
+
+/**
+   Checks if the CPU has CRC32C instructions Ext4Crc32cHw() can use.
+
+   @return TRUE if they're available, FALSE otherwise.
+**/
+BOOLEAN
+Ext4Crc32cHwSupported (
+  VOID
+  )
+{
+  UINT32  Ecx;
+
+  AsmCpuid (1, NULL, NULL, &Ecx, NULL);
+
+  return (BOOLEAN)((Ecx & EXT4_CPUID_SSE42) != 0);
+}
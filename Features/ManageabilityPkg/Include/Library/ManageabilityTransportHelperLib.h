@@ -29,6 +29,25 @@ typedef struct {
   MANAGEABILITY_TRANSMISSION_PACKAGE_ATTR    MultiPackages[];
 } MANAGEABILITY_TRANSMISSION_MULTI_PACKAGES;
 
+//
+// A pool of fixed size buffers kept in the module that owns the pool, so
+// a transport can have the contiguous buffers it needs without allocating
+// memory on each transfer. The pool is not reentrant, the owner serializes
+// the accesses to it.
+// The pool can't be used by a module that runs from read-only memory.
+//
+typedef struct {
+  UINT8     *Storage;     ///< BufferCount buffers of BufferSize bytes each.
+  UINT32    BufferSize;   ///< Size of each buffer in byte.
+  UINT32    BufferCount;  ///< Number of buffers, up to MANAGEABILITY_BUFFER_POOL_MAX_BUFFERS.
+  UINT32    InUse;        ///< Bitmap of the buffers handed out.
+} MANAGEABILITY_BUFFER_POOL;
+
+#define MANAGEABILITY_BUFFER_POOL_MAX_BUFFERS  32
+
+#define MANAGEABILITY_BUFFER_POOL_INIT(Storage, BufferSize, BufferCount) \
+  { (UINT8 *)(Storage), (BufferSize), (BufferCount), 0 }
+
 /**
   Helper function returns the human readable name of Manageability specification.
 
@@ -137,6 +156,82 @@ HelperManageabilitySplitPayload (
   OUT MANAGEABILITY_TRANSMISSION_MULTI_PACKAGES  **MultiplePackages
   );
 
+/**
+  This function returns the payload of a transfer token, along with its header
+  and trailer, as a list of segments in the order they are sent. Empty parts
+  are left out. No memory is allocated and no data is copied.
+
+  @param[in]      TransferToken  The transfer token.
+  @param[out]     Segments       Pointer to receive the segments.
+  @param[in, out] SegmentCount   When IN, the number of entries in Segments.
+                                 When OUT, the number of segments returned,
+                                 or the number of entries required if
+                                 EFI_BUFFER_TOO_SMALL is returned.
+  @param[out]     TotalSize      Pointer to receive the size of all segments
+                                 in byte. Optional.
+
+  @retval   EFI_SUCCESS            The segments are returned.
+  @retval   EFI_INVALID_PARAMETER  TransferToken, Segments or SegmentCount is
+                                   NULL, or TransferToken has a buffer which
+                                   doesn't match its size.
+  @retval   EFI_BUFFER_TOO_SMALL   Segments is too small for the segments.
+**/
+EFI_STATUS
+HelperManageabilityGetTransmitSegments (
+  IN     MANAGEABILITY_TRANSFER_TOKEN    *TransferToken,
+  OUT    MANAGEABILITY_TRANSMIT_SEGMENT  *Segments,
+  IN OUT UINT32                          *SegmentCount,
+  OUT    UINT32                          *TotalSize OPTIONAL
+  );
+
+/**
+  This function copies the segments into a contiguous buffer.
+
+  @param[in]  Segments      The segments.
+  @param[in]  SegmentCount  Number of segments.
+  @param[out] Buffer        The buffer to copy the segments to.
+  @param[in]  BufferSize    Size of Buffer in byte.
+
+  @retval  The number of bytes copied to Buffer. It is less than the size of
+           the segments if Buffer is too small.
+**/
+UINT32
+HelperManageabilityGatherSegments (
+  IN  MANAGEABILITY_TRANSMIT_SEGMENT  *Segments,
+  IN  UINT32                          SegmentCount,
+  OUT UINT8                           *Buffer,
+  IN  UINT32                          BufferSize
+  );
+
+/**
+  This function gets a buffer from the buffer pool. The buffer is allocated
+  from the memory pool instead when it doesn't fit in a buffer of the buffer
+  pool, or when all of them are in use.
+
+  @param[in, out] Pool   The buffer pool.
+  @param[in]      Size   Size of the buffer in byte.
+
+  @retval  !NULL  The buffer. Return it with HelperManageabilityFreeBuffer().
+  @retval   NULL  Out of resources.
+**/
+VOID *
+HelperManageabilityAllocateBuffer (
+  IN OUT MANAGEABILITY_BUFFER_POOL  *Pool,
+  IN     UINT32                     Size
+  );
+
+/**
+  This function returns a buffer got from HelperManageabilityAllocateBuffer().
+
+  @param[in, out] Pool    The buffer pool.
+  @param[in]      Buffer  The buffer.
+**/
+VOID
+HelperManageabilityFreeBuffer (
+  IN OUT MANAGEABILITY_BUFFER_POOL  *Pool,
+  IN     VOID                       *Buffer
+  );
+
 /**
   This function generates CRC8 with given polynomial.
 
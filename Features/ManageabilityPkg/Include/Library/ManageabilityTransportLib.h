@@ -11,7 +11,7 @@
 #define MANAGEABILITY_TRANSPORT_LIB_H_
 
 #define MANAGEABILITY_TRANSPORT_TOKEN_VERSION_MAJOR  1
-#define MANAGEABILITY_TRANSPORT_TOKEN_VERSION_MINOR  0
+#define MANAGEABILITY_TRANSPORT_TOKEN_VERSION_MINOR  1
 #define MANAGEABILITY_TRANSPORT_TOKEN_VERSION        ((MANAGEABILITY_TRANSPORT_TOKEN_VERSION_MAJOR << 8) |\
                                                 MANAGEABILITY_TRANSPORT_TOKEN_VERSION_MINOR)
 
@@ -96,7 +96,8 @@ typedef UINT32 MANAGEABILITY_TRANSPORT_CAPABILITY;
 #define MANAGEABILITY_TRANSPORT_CAPABILITY_MULTIPLE_TRANSFER_TOKENS  0x00000001
 /// Bit 1
 #define MANAGEABILITY_TRANSPORT_CAPABILITY_ASYNCHRONOUS_TRANSFER  0x00000002
-/// Bit 2   - Reserved
+/// Bit 2
+#define MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER  0x00000004
 /// Bit 7:3 - Transport interface maximum payload size, which is (2 ^ bit[7:3] - 1)
 ///           bit[7:3] means no maximum payload.
 #define MANAGEABILITY_TRANSPORT_CAPABILITY_MAXIMUM_PAYLOAD_MASK           0x000000f8
@@ -136,6 +137,14 @@ typedef struct {
   UINT32    TransmitTimeoutInMillisecond;
 } MANAGEABILITY_TRANSMIT_PACKAGE;
 
+///
+/// A segment of the payload that is scattered in memory.
+///
+typedef struct {
+  UINT8     *Data;
+  UINT32    SizeInByte;
+} MANAGEABILITY_TRANSMIT_SEGMENT;
+
 typedef struct {
   UINT8     *ReceiveBuffer;
   UINT32    ReceiveSizeInByte;
@@ -200,6 +209,17 @@ struct _MANAGEABILITY_TRANSFER_TOKEN {
   EFI_STATUS                                   TransferStatus;            ///< The EFI Status of the transfer.
   MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS    TransportAdditionalStatus; ///< The additional status of transport
                                                                           ///< interface.
+  MANAGEABILITY_TRANSMIT_SEGMENT               *TransmitSegments;         ///< The payload scattered in segments,
+                                                                          ///< which are sent in order between the
+                                                                          ///< header and the trailer. The transport
+                                                                          ///< streams them without copying them into
+                                                                          ///< a contiguous buffer.
+                                                                          ///< Only valid with the transport that has
+                                                                          ///< MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER.
+                                                                          ///< TransmitPackage.TransmitPayload must be
+                                                                          ///< NULL when this field is used.
+  UINT32                                       TransmitSegmentCount;      ///< Number of segments in TransmitSegments,
+                                                                          ///< 0 if the payload is in TransmitPackage.
 };
 
 /**
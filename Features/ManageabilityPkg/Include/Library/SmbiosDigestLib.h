@@ -0,0 +1,128 @@
+/** @file
+  This library keeps a digest of every SMBIOS structure in a UEFI variable,
+  so the drivers that send the SMBIOS table to the BMC can tell which
+  structures were added, changed or removed since the last transfer.
+
+  Copyright (C) 2023 Advanced Micro Devices, Inc. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#ifndef SMBIOS_DIGEST_LIB_H_
+#define SMBIOS_DIGEST_LIB_H_
+
+typedef struct _SMBIOS_DIGEST_INDEX SMBIOS_DIGEST_INDEX;
+
+typedef enum {
+  SmbiosStructureAdded,
+  SmbiosStructureChanged,
+  SmbiosStructureRemoved
+} SMBIOS_STRUCTURE_CHANGE_TYPE;
+
+///
+/// A structure that differs from the last transfer.
+///
+typedef struct {
+  SMBIOS_STRUCTURE_CHANGE_TYPE    Change;
+  UINT16                          Handle;
+  UINT8                           Type;
+  ///
+  /// The structure, including its strings, in the current table.
+  /// NULL when the structure was removed.
+  ///
+  UINT8                           *Structure;
+  ///
+  /// Size of Structure in bytes, 0 when the structure was removed.
+  ///
+  UINT32                          Size;
+} SMBIOS_STRUCTURE_CHANGE;
+
+/**
+  Build the digest index of an SMBIOS structure table.
+
+  @param[in]  VariableName    Name of the UEFI variable the index is kept in,
+                              under gManageabilityVariableGuid.
+  @param[in]  Structures      The SMBIOS structures, up to and including the
+                              end-of-table structure.
+  @param[in]  StructuresSize  Size of Structures in bytes.
+  @param[out] Index           Pointer to receive the index. Free it with
+                              SmbiosDigestIndexFree().
+
+  @retval EFI_SUCCESS            The index is returned.
+  @retval EFI_INVALID_PARAMETER  A parameter is NULL, or a structure is malformed.
+  @retval EFI_OUT_OF_RESOURCES   Not enough memory for the index.
+  @retval EFI_DEVICE_ERROR       Failed to compute a digest.
+**/
+EFI_STATUS
+EFIAPI
+SmbiosDigestIndexCreate (
+  IN  CHAR16               *VariableName,
+  IN  UINT8                *Structures,
+  IN  UINTN                StructuresSize,
+  OUT SMBIOS_DIGEST_INDEX  **Index
+  );
+
+/**
+  Compare an index with the one saved by the last SmbiosDigestIndexSave().
+
+  The changes are sorted by handle. Changes is NULL when ChangeCount is 0,
+  that is when the table is the same as the one last saved.
+
+  @param[in]  Index        The index of the current table.
+  @param[out] Changes      Pointer to receive the changed structures. Free it
+                           with FreePool().
+  @param[out] ChangeCount  Pointer to receive the number of changed structures.
+
+  @retval EFI_SUCCESS            The changes are returned.
+  @retval EFI_NOT_FOUND          No valid index was saved, the whole table must
+                                 be considered changed.
+  @retval EFI_INVALID_PARAMETER  A parameter is NULL.
+  @retval EFI_OUT_OF_RESOURCES   Not enough memory for the changes.
+**/
+EFI_STATUS
+EFIAPI
+SmbiosDigestIndexCompare (
+  IN  SMBIOS_DIGEST_INDEX      *Index,
+  OUT SMBIOS_STRUCTURE_CHANGE  **Changes,
+  OUT UINTN                    *ChangeCount
+  );
+
+/**
+  Save an index to its UEFI variable. Call it once the table is known to have
+  reached the BMC.
+
+  @param[in]  Index        The index to save.
+
+  @retval EFI_SUCCESS            The index is saved.
+  @retval EFI_INVALID_PARAMETER  Index is NULL.
+  @retval Others                 The status SetVariable() returned.
+**/
+EFI_STATUS
+EFIAPI
+SmbiosDigestIndexSave (
+  IN  SMBIOS_DIGEST_INDEX  *Index
+  );
+
+/**
+  Delete the index saved in the UEFI variable of an index, so the next
+  comparison reports the whole table as changed.
+
+  @param[in]  Index        The index.
+**/
+VOID
+EFIAPI
+SmbiosDigestIndexInvalidate (
+  IN  SMBIOS_DIGEST_INDEX  *Index
+  );
+
+/**
+  Free an index built by SmbiosDigestIndexCreate().
+
+  @param[in]  Index        The index to free.
+**/
+VOID
+EFIAPI
+SmbiosDigestIndexFree (
+  IN  SMBIOS_DIGEST_INDEX  *Index
+  );
+
+#endif // SMBIOS_DIGEST_LIB_H_
@@ -245,6 +245,30 @@ EFI_STATUS
   IN  UINT32      WriteLength
   );
 
+/**
+  This function writes a buffer of any size to a blob over the IPMI.
+  Unlike BlobWrite, the buffer is not limited to BLOB_MAX_DATA_PER_PACKET bytes:
+  it is sent in the largest packets the BMC and the transport accept.
+
+  @param[in]         SessionId       The session ID returned from a call to BlobOpen
+  @param[in]         Offset          The offset of the blob from which to start writing
+  @param[in]         Data            A pointer to the data to write
+  @param[in]         WriteLength     The length to write
+
+  @retval EFI_SUCCESS                Successfully wrote to the blob.
+  @retval EFI_INVALID_PARAMETER      Data is NULL, WriteLength is 0, or the write goes
+                                     past the largest blob offset.
+  @retval Other                      An error occurred
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_BULK_WRITE)(
+  IN  UINT16      SessionId,
+  IN  UINT32      Offset,
+  IN  UINT8       *Data,
+  IN  UINT32      WriteLength
+  );
+
 //
 // Structure of EDKII_IPMI_BLOB_TRANSFER_PROTOCOL
 //
@@ -260,6 +284,7 @@ struct _EDKII_IPMI_BLOB_TRANSFER_PROTOCOL {
   EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_STAT            BlobStat;
   EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_SESSION_STAT    BlobSessionStat;
   EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_WRITE_META      BlobWriteMeta;
+  EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_BULK_WRITE      BlobBulkWrite;
 };
 
 typedef struct _EDKII_IPMI_BLOB_TRANSFER_PROTOCOL EDKII_IPMI_BLOB_TRANSFER_PROTOCOL;
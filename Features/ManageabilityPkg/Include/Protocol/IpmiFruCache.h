@@ -0,0 +1,149 @@
+/** @file
+  Protocol of EDKII IPMI FRU Cache Protocol.
+
+  The IpmiFru driver reads the FRU inventory of a FRU device from the BMC
+  once, in chunks as large as the BMC accepts, and keeps it in memory.
+  Consumers can get the FRU data and the FRU information areas from this
+  protocol instead of sending an IPMI Read FRU Data command for every field
+  they need.
+
+  Copyright (C) 2023 Advanced Micro Devices, Inc. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef EDKII_IPMI_FRU_CACHE_PROTOCOL_H_
+#define EDKII_IPMI_FRU_CACHE_PROTOCOL_H_
+
+typedef struct  _EDKII_IPMI_FRU_CACHE_PROTOCOL EDKII_IPMI_FRU_CACHE_PROTOCOL;
+
+#define EDKII_IPMI_FRU_CACHE_PROTOCOL_GUID \
+  { \
+    0x0208A699, 0xD34A, 0x4516, 0xBF, 0xD7, 0x7D, 0x88, 0x73, 0x11, 0x07, 0xC5 \
+  }
+
+#define EDKII_IPMI_FRU_CACHE_PROTOCOL_VERSION_MAJOR  1
+#define EDKII_IPMI_FRU_CACHE_PROTOCOL_VERSION_MINOR  0
+#define EDKII_IPMI_FRU_CACHE_PROTOCOL_VERSION        ((EDKII_IPMI_FRU_CACHE_PROTOCOL_VERSION_MAJOR << 8) |\
+                                                      EDKII_IPMI_FRU_CACHE_PROTOCOL_VERSION_MINOR)
+
+///
+/// The areas of a FRU inventory, see Platform Management FRU Information
+/// Storage Definition.
+///
+typedef enum {
+  IpmiFruAreaAll,          ///< The whole FRU inventory, including the common header.
+  IpmiFruAreaInternalUse,
+  IpmiFruAreaChassisInfo,
+  IpmiFruAreaBoardInfo,
+  IpmiFruAreaProductInfo,
+  IpmiFruAreaMultiRecord,  ///< All the MultiRecords, up to the end of list record.
+  IpmiFruAreaMaximum
+} EDKII_IPMI_FRU_AREA_TYPE;
+
+/**
+  This service returns an area of the FRU inventory of a FRU device.
+
+  The FRU inventory is read from the BMC on the first request for the FRU
+  device. The later requests are served from memory.
+
+  @param[in]  This                 EDKII_IPMI_FRU_CACHE_PROTOCOL instance.
+  @param[in]  FruDeviceId          The FRU device ID.
+  @param[in]  AreaType             The area to return.
+  @param[out] Area                 Pointer to receive the area. The area is
+                                   owned by the protocol and must not be
+                                   modified or freed.
+  @param[out] AreaSize             Pointer to receive the size of the area in
+                                   bytes.
+
+  @retval     EFI_SUCCESS          The area is returned.
+  @retval     EFI_NOT_FOUND        The FRU inventory has no such area.
+  @retval     EFI_INVALID_PARAMETER  A parameter is NULL or AreaType is invalid.
+  @retval     EFI_VOLUME_CORRUPTED The common header of the FRU inventory is
+                                   invalid.
+  @retval     EFI_OUT_OF_RESOURCES Not enough memory to cache the FRU inventory.
+  @retval     Others               The FRU inventory could not be read from the
+                                   BMC.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_IPMI_FRU_CACHE_GET_AREA)(
+  IN  EDKII_IPMI_FRU_CACHE_PROTOCOL  *This,
+  IN  UINT8                          FruDeviceId,
+  IN  EDKII_IPMI_FRU_AREA_TYPE       AreaType,
+  OUT CONST UINT8                    **Area,
+  OUT UINT32                         *AreaSize
+  );
+
+/**
+  This service copies data of the FRU inventory of a FRU device, as the IPMI
+  Read FRU Data command does.
+
+  @param[in]      This             EDKII_IPMI_FRU_CACHE_PROTOCOL instance.
+  @param[in]      FruDeviceId      The FRU device ID.
+  @param[in]      Offset           The offset in the FRU inventory, in bytes.
+  @param[in, out] Size             On input, the size of Buffer in bytes. On
+                                   output, the number of bytes copied, which is
+                                   less than the input only when the end of the
+                                   FRU inventory is reached.
+  @param[out]     Buffer           The buffer to receive the FRU data.
+
+  @retval     EFI_SUCCESS          The data is copied.
+  @retval     EFI_INVALID_PARAMETER  A parameter is NULL, or Offset is beyond
+                                   the end of the FRU inventory.
+  @retval     EFI_OUT_OF_RESOURCES Not enough memory to cache the FRU inventory.
+  @retval     Others               The FRU inventory could not be read from the
+                                   BMC.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_IPMI_FRU_CACHE_READ)(
+  IN     EDKII_IPMI_FRU_CACHE_PROTOCOL  *This,
+  IN     UINT8                          FruDeviceId,
+  IN     UINT32                         Offset,
+  IN OUT UINT32                         *Size,
+  OUT    VOID                           *Buffer
+  );
+
+/**
+  This service drops the cached FRU inventory of a FRU device, so it is read
+  from the BMC again on the next request. Call it after writing the FRU
+  inventory.
+
+  @param[in]  This                 EDKII_IPMI_FRU_CACHE_PROTOCOL instance.
+  @param[in]  FruDeviceId          The FRU device ID.
+**/
+typedef
+VOID
+(EFIAPI *EDKII_IPMI_FRU_CACHE_INVALIDATE)(
+  IN  EDKII_IPMI_FRU_CACHE_PROTOCOL  *This,
+  IN  UINT8                          FruDeviceId
+  );
+
+//
+// EDKII_IPMI_FRU_CACHE_PROTOCOL Version 1.0
+//
+typedef struct {
+  EDKII_IPMI_FRU_CACHE_GET_AREA      GetArea;
+  EDKII_IPMI_FRU_CACHE_READ          Read;
+  EDKII_IPMI_FRU_CACHE_INVALIDATE    Invalidate;
+} EDKII_IPMI_FRU_CACHE_PROTOCOL_V1_0;
+
+///
+/// Definitions of EDKII_IPMI_FRU_CACHE_PROTOCOL.
+/// The new added function must has its own EDKII_IPMI_FRU_CACHE_PROTOCOL
+/// structure with the incremental version number.
+///   e.g., EDKII_IPMI_FRU_CACHE_PROTOCOL_V1_1.
+///
+typedef union {
+  EDKII_IPMI_FRU_CACHE_PROTOCOL_V1_0    *Version1_0;
+} EDKII_IPMI_FRU_CACHE_PROTOCOL_FUNCTION;
+
+struct _EDKII_IPMI_FRU_CACHE_PROTOCOL {
+  UINT16                                    ProtocolVersion;
+  EDKII_IPMI_FRU_CACHE_PROTOCOL_FUNCTION    Functions;
+};
+
+extern EFI_GUID  gEdkiiIpmiFruCacheProtocolGuid;
+
+#endif // EDKII_IPMI_FRU_CACHE_PROTOCOL_H_
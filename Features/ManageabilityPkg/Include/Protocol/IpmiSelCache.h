@@ -0,0 +1,112 @@
+/** @file
+  Protocol of EDKII IPMI SEL Cache Protocol.
+
+  The BmcElog driver reads the System Event Log from the BMC in one pass and
+  keeps the records in memory. The cache is checked against the most recent
+  addition and erase timestamps of the SEL, so only the records added since
+  the last pass are read again.
+
+  Copyright (C) 2023 Advanced Micro Devices, Inc. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef EDKII_IPMI_SEL_CACHE_PROTOCOL_H_
+#define EDKII_IPMI_SEL_CACHE_PROTOCOL_H_
+
+#include <IndustryStandard/Ipmi.h>
+
+typedef struct  _EDKII_IPMI_SEL_CACHE_PROTOCOL EDKII_IPMI_SEL_CACHE_PROTOCOL;
+
+#define EDKII_IPMI_SEL_CACHE_PROTOCOL_GUID \
+  { \
+    0x28C3DC76, 0x79F3, 0x44E4, 0xA9, 0xCF, 0x94, 0xFA, 0x11, 0xA2, 0x12, 0xC2 \
+  }
+
+#define EDKII_IPMI_SEL_CACHE_PROTOCOL_VERSION_MAJOR  1
+#define EDKII_IPMI_SEL_CACHE_PROTOCOL_VERSION_MINOR  0
+#define EDKII_IPMI_SEL_CACHE_PROTOCOL_VERSION        ((EDKII_IPMI_SEL_CACHE_PROTOCOL_VERSION_MAJOR << 8) |\
+                                                      EDKII_IPMI_SEL_CACHE_PROTOCOL_VERSION_MINOR)
+
+///
+/// The record ID of the first and the last SEL entry, as in the IPMI Get SEL
+/// Entry command.
+///
+#define EDKII_IPMI_SEL_CACHE_FIRST_ENTRY  0x0000
+#define EDKII_IPMI_SEL_CACHE_LAST_ENTRY   0xFFFF
+
+/**
+  This service returns the SEL information, and brings the cached SEL up to
+  date with the BMC.
+
+  @param[in]  This                 EDKII_IPMI_SEL_CACHE_PROTOCOL instance.
+  @param[out] SelInfo              Pointer to receive the response of the IPMI
+                                   Get SEL Info command.
+
+  @retval     EFI_SUCCESS          The SEL information is returned.
+  @retval     EFI_INVALID_PARAMETER  SelInfo is NULL.
+  @retval     EFI_OUT_OF_RESOURCES Not enough memory to cache the SEL.
+  @retval     Others               The SEL could not be read from the BMC.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_IPMI_SEL_CACHE_GET_INFO)(
+  IN  EDKII_IPMI_SEL_CACHE_PROTOCOL  *This,
+  OUT IPMI_GET_SEL_INFO_RESPONSE     *SelInfo
+  );
+
+/**
+  This service returns a SEL entry, as the IPMI Get SEL Entry command does.
+
+  The cached SEL is brought up to date with the BMC when the first or the
+  last entry is requested, that is at the start of a walk through the SEL.
+  The other entries are served from memory.
+
+  @param[in]  This                 EDKII_IPMI_SEL_CACHE_PROTOCOL instance.
+  @param[in]  RecordId             The record ID of the entry, or
+                                   EDKII_IPMI_SEL_CACHE_FIRST_ENTRY or
+                                   EDKII_IPMI_SEL_CACHE_LAST_ENTRY.
+  @param[out] SelEntry             Pointer to receive the response of the IPMI
+                                   Get SEL Entry command for the entry, which
+                                   carries the record ID of the next entry.
+
+  @retval     EFI_SUCCESS          The entry is returned.
+  @retval     EFI_NOT_FOUND        The SEL has no such entry.
+  @retval     EFI_INVALID_PARAMETER  SelEntry is NULL.
+  @retval     EFI_OUT_OF_RESOURCES Not enough memory to cache the SEL.
+  @retval     Others               The SEL could not be read from the BMC.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_IPMI_SEL_CACHE_GET_ENTRY)(
+  IN  EDKII_IPMI_SEL_CACHE_PROTOCOL  *This,
+  IN  UINT16                         RecordId,
+  OUT IPMI_GET_SEL_ENTRY_RESPONSE    *SelEntry
+  );
+
+//
+// EDKII_IPMI_SEL_CACHE_PROTOCOL Version 1.0
+//
+typedef struct {
+  EDKII_IPMI_SEL_CACHE_GET_INFO     GetInfo;
+  EDKII_IPMI_SEL_CACHE_GET_ENTRY    GetEntry;
+} EDKII_IPMI_SEL_CACHE_PROTOCOL_V1_0;
+
+///
+/// Definitions of EDKII_IPMI_SEL_CACHE_PROTOCOL.
+/// The new added function must has its own EDKII_IPMI_SEL_CACHE_PROTOCOL
+/// structure with the incremental version number.
+///   e.g., EDKII_IPMI_SEL_CACHE_PROTOCOL_V1_1.
+///
+typedef union {
+  EDKII_IPMI_SEL_CACHE_PROTOCOL_V1_0    *Version1_0;
+} EDKII_IPMI_SEL_CACHE_PROTOCOL_FUNCTION;
+
+struct _EDKII_IPMI_SEL_CACHE_PROTOCOL {
+  UINT16                                    ProtocolVersion;
+  EDKII_IPMI_SEL_CACHE_PROTOCOL_FUNCTION    Functions;
+};
+
+extern EFI_GUID  gEdkiiIpmiSelCacheProtocolGuid;
+
+#endif // EDKII_IPMI_SEL_CACHE_PROTOCOL_H_
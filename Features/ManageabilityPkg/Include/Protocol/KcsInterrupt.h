@@ -0,0 +1,75 @@
+/** @file
+  Protocol of EDKII KCS Interrupt Protocol.
+
+  A platform that routes the KCS interrupt of the BMC to the host installs
+  this protocol. The KCS instance of ManageabilityTransportLib then waits for
+  the interrupt instead of sleeping for the whole polling interval, when the
+  BMC takes long to respond.
+
+  Copyright (C) 2023 Advanced Micro Devices, Inc. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef EDKII_KCS_INTERRUPT_PROTOCOL_H_
+#define EDKII_KCS_INTERRUPT_PROTOCOL_H_
+
+typedef struct  _EDKII_KCS_INTERRUPT_PROTOCOL EDKII_KCS_INTERRUPT_PROTOCOL;
+
+#define EDKII_KCS_INTERRUPT_PROTOCOL_GUID \
+  { \
+    0x2419AB97, 0x4050, 0x46D1, 0xBB, 0x49, 0x40, 0x5C, 0x7D, 0x81, 0xB2, 0x7C \
+  }
+
+#define EDKII_KCS_INTERRUPT_PROTOCOL_VERSION_MAJOR  1
+#define EDKII_KCS_INTERRUPT_PROTOCOL_VERSION_MINOR  0
+#define EDKII_KCS_INTERRUPT_PROTOCOL_VERSION        ((EDKII_KCS_INTERRUPT_PROTOCOL_VERSION_MAJOR << 8) |\
+                                                     EDKII_KCS_INTERRUPT_PROTOCOL_VERSION_MINOR)
+
+/**
+  This service waits for the KCS interrupt of the BMC, which the BMC raises
+  when it sets OBF.
+
+  The caller checks the KCS status register after this service returns, so
+  spurious or missed interrupts only delay the transfer, at most by Timeout.
+
+  @param[in]  This                 EDKII_KCS_INTERRUPT_PROTOCOL instance.
+  @param[in]  Timeout              Longest time to wait, in microseconds.
+
+  @retval     EFI_SUCCESS          The KCS interrupt fired.
+  @retval     EFI_TIMEOUT          Timeout elapsed before the KCS interrupt fired.
+  @retval     EFI_DEVICE_ERROR     The interrupt could not be waited for. The
+                                   service returns right away in this case.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *EDKII_KCS_INTERRUPT_WAIT)(
+  IN  EDKII_KCS_INTERRUPT_PROTOCOL  *This,
+  IN  UINT32                        Timeout
+  );
+
+//
+// EDKII_KCS_INTERRUPT_PROTOCOL Version 1.0
+//
+typedef struct {
+  EDKII_KCS_INTERRUPT_WAIT    WaitForInterrupt;
+} EDKII_KCS_INTERRUPT_PROTOCOL_V1_0;
+
+///
+/// Definitions of EDKII_KCS_INTERRUPT_PROTOCOL.
+/// The new added function must has its own EDKII_KCS_INTERRUPT_PROTOCOL
+/// structure with the incremental version number.
+///   e.g., EDKII_KCS_INTERRUPT_PROTOCOL_V1_1.
+///
+typedef union {
+  EDKII_KCS_INTERRUPT_PROTOCOL_V1_0    *Version1_0;
+} EDKII_KCS_INTERRUPT_PROTOCOL_FUNCTION;
+
+struct _EDKII_KCS_INTERRUPT_PROTOCOL {
+  UINT16                                   ProtocolVersion;
+  EDKII_KCS_INTERRUPT_PROTOCOL_FUNCTION    Functions;
+};
+
+extern EFI_GUID  gEdkiiKcsInterruptProtocolGuid;
+
+#endif // EDKII_KCS_INTERRUPT_PROTOCOL_H_
@@ -19,7 +19,7 @@ typedef struct  _EDKII_PLDM_PROTOCOL EDKII_PLDM_PROTOCOL;
   }
 
 #define EDKII_PLDM_PROTOCOL_VERSION_MAJOR  1
-#define EDKII_PLDM_PROTOCOL_VERSION_MINOR  0
+#define EDKII_PLDM_PROTOCOL_VERSION_MINOR  1
 #define EDKII_PLDM_PROTOCOL_VERSION        ((EDKII_PLDM_PROTOCOL_VERSION_MAJOR << 8) |\
                                        EDKII_PLDM_PROTOCOL_VERSION_MINOR)
 
@@ -66,6 +66,73 @@ typedef struct {
   PLDM_SUBMIT_COMMAND    PldmSubmitCommand;
 } EDKII_PLDM_PROTOCOL_V1_0;
 
+///
+/// Completion token of PldmSubmitCommandAsync().
+///
+typedef struct {
+  ///
+  /// Event signaled when the command completes. It is created by the caller.
+  ///
+  EFI_EVENT     Event;
+  ///
+  /// Status of the command, valid once Event is signaled. The values are the
+  /// ones PldmSubmitCommand() returns.
+  ///
+  EFI_STATUS    Status;
+} EDKII_PLDM_COMPLETION_TOKEN;
+
+/**
+  This service queues a command to be submitted via EDKII PLDM protocol, and
+  returns without waiting for the response.
+
+  Each queued command has its own PLDM instance ID, so up to 32 commands can
+  be outstanding. They are sent one after the other from a timer event at
+  TPL_CALLBACK. Token->Event is signaled when the response of the command is
+  received or the command fails.
+
+  @param[in]         This                       EDKII_PLDM_PROTOCOL instance.
+  @param[in]         PldmType                   PLDM message type.
+  @param[in]         Command                    PLDM Command of PLDM message type.
+  @param[in]         PldmTerminusSourceId       PLDM source teminus ID.
+  @param[in]         PldmTerminusDestinationId  PLDM destination teminus ID.
+  @param[in]         RequestData                Command Request Data. It is copied, the
+                                                caller can free it once this service returns.
+  @param[in]         RequestDataSize            Size of Command Request Data.
+  @param[out]        ResponseData               Command Response Data. The completion code is the first
+                                                byte of response data. It must remain valid until
+                                                Token->Event is signaled.
+  @param[in, out]    ResponseDataSize           Size of Command Response Data. It must remain valid until
+                                                Token->Event is signaled.
+  @param[in]         Token                      Completion token of the command.
+
+  @retval EFI_SUCCESS            The command is queued.
+  @retval EFI_NOT_READY          32 commands are already outstanding.
+  @retval EFI_OUT_OF_RESOURCES   The resource allcation is out of resource.
+  @retval EFI_INVALID_PARAMETER  One of the parameters is invalid.
+**/
+typedef
+EFI_STATUS
+(EFIAPI *PLDM_SUBMIT_COMMAND_ASYNC)(
+  IN     EDKII_PLDM_PROTOCOL          *This,
+  IN     UINT8                        PldmType,
+  IN     UINT8                        Command,
+  IN     UINT8                        PldmTerminusSourceId,
+  IN     UINT8                        PldmTerminusDestinationId,
+  IN     UINT8                        *RequestData,
+  IN     UINT32                       RequestDataSize,
+  OUT    UINT8                        *ResponseData,
+  IN OUT UINT32                       *ResponseDataSize,
+  IN     EDKII_PLDM_COMPLETION_TOKEN  *Token
+  );
+
+//
+// EDKII_PLDM_PROTOCOL Version 1.1
+//
+typedef struct {
+  PLDM_SUBMIT_COMMAND          PldmSubmitCommand;
+  PLDM_SUBMIT_COMMAND_ASYNC    PldmSubmitCommandAsync;
+} EDKII_PLDM_PROTOCOL_V1_1;
+
 ///
 /// Definitions of EDKII_PLDM_PROTOCOL.
 /// This is a union that can accommodate the new functionalities defined
@@ -79,6 +146,7 @@ typedef struct {
 ///
 typedef union {
   EDKII_PLDM_PROTOCOL_V1_0    *Version1_0;
+  EDKII_PLDM_PROTOCOL_V1_1    *Version1_1;
 } EDKII_PLDM_PROTOCOL_FUNCTION;
 
 struct _EDKII_PLDM_PROTOCOL {
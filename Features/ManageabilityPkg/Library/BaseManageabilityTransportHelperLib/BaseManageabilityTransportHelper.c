@@ -383,6 +383,202 @@ HelperManageabilitySplitPayload (
   return EFI_SUCCESS;
 }
 
+/**
+  This function returns the payload of a transfer token, along with its header
+  and trailer, as a list of segments in the order they are sent. Empty parts
+  are left out. No memory is allocated and no data is copied.
+
+  @param[in]      TransferToken  The transfer token.
+  @param[out]     Segments       Pointer to receive the segments.
+  @param[in, out] SegmentCount   When IN, the number of entries in Segments.
+                                 When OUT, the number of segments returned,
+                                 or the number of entries required if
+                                 EFI_BUFFER_TOO_SMALL is returned.
+  @param[out]     TotalSize      Pointer to receive the size of all segments
+                                 in byte. Optional.
+
+  @retval   EFI_SUCCESS            The segments are returned.
+  @retval   EFI_INVALID_PARAMETER  TransferToken, Segments or SegmentCount is
+                                   NULL, or TransferToken has a buffer which
+                                   doesn't match its size.
+  @retval   EFI_BUFFER_TOO_SMALL   Segments is too small for the segments.
+**/
+EFI_STATUS
+HelperManageabilityGetTransmitSegments (
+  IN     MANAGEABILITY_TRANSFER_TOKEN    *TransferToken,
+  OUT    MANAGEABILITY_TRANSMIT_SEGMENT  *Segments,
+  IN OUT UINT32                          *SegmentCount,
+  OUT    UINT32                          *TotalSize OPTIONAL
+  )
+{
+  MANAGEABILITY_TRANSMIT_SEGMENT  Parts[3];
+  MANAGEABILITY_TRANSMIT_SEGMENT  *ThisSegment;
+  UINT32                          PartIndex;
+  UINT32                          SegmentIndex;
+  UINT32                          Count;
+  UINT32                          Size;
+
+  if ((TransferToken == NULL) || (Segments == NULL) || (SegmentCount == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((TransferToken->TransmitSegmentCount != 0) &&
+      ((TransferToken->TransmitSegments == NULL) || (TransferToken->TransmitPackage.TransmitPayload != NULL)))
+  {
+    DEBUG ((DEBUG_ERROR, "%a: Either TransmitSegments is NULL or TransmitPayload is not NULL.\n", __func__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // The header, the payload in TransmitPackage and the trailer. The segments
+  // in TransmitSegments go in place of the payload.
+  //
+  Parts[0].Data       = (UINT8 *)TransferToken->TransmitHeader;
+  Parts[0].SizeInByte = TransferToken->TransmitHeaderSize;
+  Parts[1].Data       = TransferToken->TransmitPackage.TransmitPayload;
+  Parts[1].SizeInByte = TransferToken->TransmitPackage.TransmitSizeInByte;
+  Parts[2].Data       = (UINT8 *)TransferToken->TransmitTrailer;
+  Parts[2].SizeInByte = TransferToken->TransmitTrailerSize;
+
+  Count = 0;
+  Size  = 0;
+  for (PartIndex = 0; PartIndex < ARRAY_SIZE (Parts); PartIndex++) {
+    if ((PartIndex == 1) && (TransferToken->TransmitSegmentCount != 0)) {
+      ThisSegment  = TransferToken->TransmitSegments;
+      SegmentIndex = TransferToken->TransmitSegmentCount;
+    } else {
+      ThisSegment  = &Parts[PartIndex];
+      SegmentIndex = 1;
+    }
+
+    for ( ; SegmentIndex != 0; SegmentIndex--, ThisSegment++) {
+      if ((ThisSegment->Data == NULL) != (ThisSegment->SizeInByte == 0)) {
+        DEBUG ((DEBUG_ERROR, "%a: Mismatched values of segment data and size.\n", __func__));
+        return EFI_INVALID_PARAMETER;
+      }
+
+      if (ThisSegment->SizeInByte == 0) {
+        continue;
+      }
+
+      if (Count < *SegmentCount) {
+        Segments[Count] = *ThisSegment;
+      }
+
+      Count++;
+      Size += ThisSegment->SizeInByte;
+    }
+  }
+
+  if (Count > *SegmentCount) {
+    *SegmentCount = Count;
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  *SegmentCount = Count;
+  if (TotalSize != NULL) {
+    *TotalSize = Size;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  This function copies the segments into a contiguous buffer.
+
+  @param[in]  Segments      The segments.
+  @param[in]  SegmentCount  Number of segments.
+  @param[out] Buffer        The buffer to copy the segments to.
+  @param[in]  BufferSize    Size of Buffer in byte.
+
+  @retval  The number of bytes copied to Buffer. It is less than the size of
+           the segments if Buffer is too small.
+**/
+UINT32
+HelperManageabilityGatherSegments (
+  IN  MANAGEABILITY_TRANSMIT_SEGMENT  *Segments,
+  IN  UINT32                          SegmentCount,
+  OUT UINT8                           *Buffer,
+  IN  UINT32                          BufferSize
+  )
+{
+  UINT32  Index;
+  UINT32  Copied;
+  UINT32  Size;
+
+  Copied = 0;
+  for (Index = 0; (Index < SegmentCount) && (Copied < BufferSize); Index++) {
+    Size = MIN (Segments[Index].SizeInByte, BufferSize - Copied);
+    CopyMem (Buffer + Copied, Segments[Index].Data, Size);
+    Copied += Size;
+  }
+
+  return Copied;
+}
+
+/**
+  This function gets a buffer from the buffer pool. The buffer is allocated
+  from the memory pool instead when it doesn't fit in a buffer of the buffer
+  pool, or when all of them are in use.
+
+  @param[in, out] Pool   The buffer pool.
+  @param[in]      Size   Size of the buffer in byte.
+
+  @retval  !NULL  The buffer. Return it with HelperManageabilityFreeBuffer().
+  @retval   NULL  Out of resources.
+**/
+VOID *
+HelperManageabilityAllocateBuffer (
+  IN OUT MANAGEABILITY_BUFFER_POOL  *Pool,
+  IN     UINT32                     Size
+  )
+{
+  UINT32  Index;
+
+  ASSERT (Pool->BufferCount <= MANAGEABILITY_BUFFER_POOL_MAX_BUFFERS);
+  if (Size <= Pool->BufferSize) {
+    for (Index = 0; Index < Pool->BufferCount; Index++) {
+      if ((Pool->InUse & ((UINT32)1 << Index)) == 0) {
+        Pool->InUse |= ((UINT32)1 << Index);
+        return Pool->Storage + Index * Pool->BufferSize;
+      }
+    }
+  }
+
+  DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: Allocate 0x%x bytes out of the buffer pool.\n", __func__, Size));
+  return AllocatePool (Size);
+}
+
+/**
+  This function returns a buffer got from HelperManageabilityAllocateBuffer().
+
+  @param[in, out] Pool    The buffer pool.
+  @param[in]      Buffer  The buffer.
+**/
+VOID
+HelperManageabilityFreeBuffer (
+  IN OUT MANAGEABILITY_BUFFER_POOL  *Pool,
+  IN     VOID                       *Buffer
+  )
+{
+  UINTN  Offset;
+
+  if (Buffer == NULL) {
+    return;
+  }
+
+  if (((UINT8 *)Buffer >= Pool->Storage) &&
+      ((UINT8 *)Buffer < Pool->Storage + Pool->BufferCount * Pool->BufferSize))
+  {
+    Offset = (UINT8 *)Buffer - Pool->Storage;
+    ASSERT ((Offset % Pool->BufferSize) == 0);
+    Pool->InUse &= ~((UINT32)1 << (Offset / Pool->BufferSize));
+    return;
+  }
+
+  FreePool (Buffer);
+}
+
 /**
   Print out manageability transmit payload to the debug output device.
 
@@ -15,42 +15,98 @@
 #include <Library/ManageabilityTransportHelperLib.h>
 #include <Library/ManageabilityTransportMctpLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
 #include <Library/TimerLib.h>
+#include <Protocol/KcsInterrupt.h>
 
 #include "ManageabilityTransportKcs.h"
 
 extern MANAGEABILITY_TRANSPORT_KCS_HARDWARE_INFO  mKcsHardwareInfo;
 extern MANAGEABILITY_TRANSPORT_KCS                *mSingleSessionToken;
+extern EDKII_KCS_INTERRUPT_PROTOCOL               *mKcsInterrupt;
+
+///
+/// The KCS response header of the manageability protocols.
+///
+typedef union {
+  MANAGEABILITY_MCTP_KCS_HEADER    Mctp;
+  IPMI_KCS_RESPONSE_HEADER         Ipmi;
+} KCS_RESPONSE_HEADER;
 
 /**
-  This function waits for parameter Flag to set.
-  Checks status flag in every 1ms internal till 5 seconds elapses.
+  This function waits for parameter Flag to become set or clear.
+
+  The status register is polled every IPMI_KCS_POLL_MIN_INTERVAL microseconds
+  for the first PcdIpmiKcsPollSpinTime microseconds, as BMCs usually update
+  IBF and OBF within a few microseconds. After that the polling interval doubles
+  on every poll, up to PcdIpmiKcsPollMaxInterval. If the platform provides the
+  KCS interrupt, the wait between two polls ends as soon as it fires.
 
   @param[in]  Flag        KCS Flag to test.
-  @retval     EFI_SUCCESS The KCS flag under test is set.
-  @retval     EFI_TIMEOUT The KCS flag didn't set in 5 second windows.
+  @param[in]  Set         TRUE to wait for Flag to be set, FALSE to wait for
+                          Flag to be clear.
+
+  @retval     EFI_SUCCESS The KCS flag under test is in the expected state.
+  @retval     EFI_TIMEOUT The KCS flag didn't change in 5 second windows.
 **/
+STATIC
 EFI_STATUS
-WaitStatusSet (
-  IN  UINT8  Flag
+WaitStatus (
+  IN  UINT8    Flag,
+  IN  BOOLEAN  Set
   )
 {
-  UINT64  Timeout = 0;
+  EFI_STATUS  Status;
+  UINT64      Timeout;
+  UINT32      Interval;
+  UINT32      MaxInterval;
 
-  while (!(KcsRegisterRead8 (KCS_REG_STATUS) & Flag)) {
-    MicroSecondDelay (IPMI_KCS_TIMEOUT_1MS);
-    Timeout = Timeout + IPMI_KCS_TIMEOUT_1MS;
+  Timeout     = 0;
+  Interval    = IPMI_KCS_POLL_MIN_INTERVAL;
+  MaxInterval = MAX (FixedPcdGet32 (PcdIpmiKcsPollMaxInterval), IPMI_KCS_POLL_MIN_INTERVAL);
+
+  while (((KcsRegisterRead8 (KCS_REG_STATUS) & Flag) != 0) != Set) {
     if (Timeout >= IPMI_KCS_TIMEOUT_5_SEC) {
       return EFI_TIMEOUT;
     }
+
+    Status = EFI_UNSUPPORTED;
+    if (mKcsInterrupt != NULL) {
+      Status = mKcsInterrupt->Functions.Version1_0->WaitForInterrupt (mKcsInterrupt, Interval);
+    }
+
+    if (EFI_ERROR (Status) && (Status != EFI_TIMEOUT)) {
+      MicroSecondDelay (Interval);
+    }
+
+    Timeout = Timeout + Interval;
+    if (Timeout >= FixedPcdGet32 (PcdIpmiKcsPollSpinTime)) {
+      Interval = MIN (Interval * 2, MaxInterval);
+    }
   }
 
   return EFI_SUCCESS;
 }
 
+/**
+  This function waits for parameter Flag to set.
+  Checks status flag with adaptive polling till 5 seconds elapses.
+
+  @param[in]  Flag        KCS Flag to test.
+  @retval     EFI_SUCCESS The KCS flag under test is set.
+  @retval     EFI_TIMEOUT The KCS flag didn't set in 5 second windows.
+**/
+EFI_STATUS
+WaitStatusSet (
+  IN  UINT8  Flag
+  )
+{
+  return WaitStatus (Flag, TRUE);
+}
+
 /**
   This function waits for parameter Flag to get cleared.
-  Checks status flag in every 1ms internal till 5 seconds elapses.
+  Checks status flag with adaptive polling till 5 seconds elapses.
 
   @param[in]  Flag        KCS Flag to test.
 
@@ -62,17 +118,7 @@ WaitStatusClear (
   IN  UINT8  Flag
   )
 {
-  UINT64  Timeout = 0;
-
-  while (KcsRegisterRead8 (KCS_REG_STATUS) & Flag) {
-    MicroSecondDelay (IPMI_KCS_TIMEOUT_1MS);
-    Timeout = Timeout + IPMI_KCS_TIMEOUT_1MS;
-    if (Timeout >= IPMI_KCS_TIMEOUT_5_SEC) {
-      return EFI_TIMEOUT;
-    }
-  }
-
-  return EFI_SUCCESS;
+  return WaitStatus (Flag, FALSE);
 }
 
 /**
@@ -97,19 +143,42 @@ ClearOBF (
   return EFI_SUCCESS;
 }
 
+/**
+  This function returns the next byte of the segments to send, and moves past
+  it. Empty segments are skipped.
+
+  @param[in]      Segments        The segments.
+  @param[in, out] SegmentIndex    Index of the segment of the next byte.
+  @param[in, out] Offset          Offset of the next byte in the segment.
+
+  @retval         UINT8           The next byte.
+**/
+STATIC
+UINT8
+KcsNextTransmitByte (
+  IN     MANAGEABILITY_TRANSMIT_SEGMENT  *Segments,
+  IN OUT UINT32                          *SegmentIndex,
+  IN OUT UINT32                          *Offset
+  )
+{
+  while (*Offset >= Segments[*SegmentIndex].SizeInByte) {
+    (*SegmentIndex)++;
+    *Offset = 0;
+  }
+
+  return Segments[*SegmentIndex].Data[(*Offset)++];
+}
+
 /**
   This function writes/sends data to the KCS port.
   Algorithm is based on flow chart provided in IPMI spec 2.0
   Figure 9-6, KCS Interface BMC to SMS Write Transfer Flow Chart
 
-  @param[in]      TransmitHeader        KCS packet header.
-  @param[in]      TransmitHeaderSize    KCS packet header size in byte.
-  @param[in]      TransmitTrailer       KCS packet trailer.
-  @param[in]      TransmitTrailerSize   KCS packet trailer size in byte.
-  @param[in]      RequestData           Command Request Data, could be NULL.
-                                        RequestDataSize must be zero, if RequestData
-                                        is NULL.
-  @param[in]      RequestDataSize       Size of Command Request Data.
+  The bytes are written straight from the segments, in order, so the
+  header, payload and trailer of a request are never copied.
+
+  @param[in]      Segments              The segments of the request.
+  @param[in]      SegmentCount          Number of segments.
 
   @retval     EFI_SUCCESS           The command byte stream was successfully
                                     submit to the device and a response was
@@ -123,94 +192,46 @@ ClearOBF (
   @retval     EFI_TIMEOUT           The command time out.
   @retval     EFI_UNSUPPORTED       The command was not successfully sent to
                                     the device.
-  @retval     EFI_OUT_OF_RESOURCES  The resource allocation is out of resource or
-                                    data size error.
+  @retval     EFI_INVALID_PARAMETER A segment doesn't match its size, or the
+                                    request is empty.
 **/
 EFI_STATUS
 KcsTransportWrite (
-  IN  MANAGEABILITY_TRANSPORT_HEADER   TransmitHeader,
-  IN  UINT16                           TransmitHeaderSize,
-  IN  MANAGEABILITY_TRANSPORT_TRAILER  TransmitTrailer OPTIONAL,
-  IN  UINT16                           TransmitTrailerSize,
-  IN  UINT8                            *RequestData OPTIONAL,
-  IN  UINT32                           RequestDataSize
+  IN  MANAGEABILITY_TRANSMIT_SEGMENT  *Segments,
+  IN  UINT32                          SegmentCount
   )
 {
   EFI_STATUS  Status;
   UINT32      Length;
-  UINT8       *Buffer;
-  UINT8       *BufferPtr;
+  UINT32      SegmentIndex;
+  UINT32      Offset;
+
+  Length = 0;
+  for (SegmentIndex = 0; SegmentIndex < SegmentCount; SegmentIndex++) {
+    if ((Segments[SegmentIndex].Data == NULL) && (Segments[SegmentIndex].SizeInByte != 0)) {
+      DEBUG ((DEBUG_ERROR, "%a: Mismatched values of segment data and size.\n", __func__));
+      return EFI_INVALID_PARAMETER;
+    }
 
-  // Validation on RequestData and RequestDataSize.
-  if (((RequestData == NULL) && (RequestDataSize != 0)) ||
-      ((RequestData != NULL) && (RequestDataSize == 0))
-      )
-  {
-    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of RequestData or RequestDataSize.\n", __func__));
-    return EFI_INVALID_PARAMETER;
+    Length += Segments[SegmentIndex].SizeInByte;
   }
 
-  // Validation on TransmitHeader and TransmitHeaderSize.
-  if (((TransmitHeader == NULL) && (TransmitHeaderSize != 0)) ||
-      ((TransmitHeader != NULL) && (TransmitHeaderSize == 0))
-      )
-  {
-    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of TransmitHeader or TransmitHeaderSize.\n", __func__));
+  if (Length == 0) {
+    DEBUG ((DEBUG_ERROR, "%a: Nothing to write.\n", __func__));
     return EFI_INVALID_PARAMETER;
   }
 
-  // Validation on TransmitHeader and TransmitHeaderSize.
-  if (((TransmitTrailer == NULL) && (TransmitTrailerSize != 0)) ||
-      ((TransmitTrailer != NULL) && (TransmitTrailerSize == 0))
-      )
-  {
-    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of TransmitTrailer or TransmitTrailerSize.\n", __func__));
-    return EFI_INVALID_PARAMETER;
-  }
-
-  Length = TransmitHeaderSize;
-  if (RequestData != NULL) {
-    Length = Length + RequestDataSize;
-  }
-
-  if ((TransmitTrailer != NULL) && (TransmitTrailerSize != 0)) {
-    Length += TransmitTrailerSize;
-  }
-
-  Buffer = AllocateZeroPool (Length);
-  if (Buffer == NULL) {
-    return EFI_OUT_OF_RESOURCES;
-  }
-
-  //
-  // Buffer[0..(TransmitHeaderSize - 1)] = TransmitHeader
-  // Buffer [TransmitHeader..(TransmitHeader + RequestDataSize - 1)] = RequestData
-  // Buffer [(TransmitHeader + RequestDataSize)..(TransmitHeader + RequestDataSize + TransmitTrailerSize - 1)] = TransmitTrailer
-  //
-  BufferPtr = Buffer;
-  CopyMem ((VOID *)BufferPtr, (VOID *)TransmitHeader, TransmitHeaderSize);
-  BufferPtr += TransmitHeaderSize;
-  if (RequestData != NULL) {
-    CopyMem (BufferPtr, RequestData, RequestDataSize);
-  }
-
-  BufferPtr += RequestDataSize;
-  if (TransmitTrailer != NULL) {
-    CopyMem (BufferPtr, (VOID *)TransmitTrailer, TransmitTrailerSize);
-  }
-
-  BufferPtr = Buffer;
+  SegmentIndex = 0;
+  Offset       = 0;
 
   // Step 1. wait for IBF to get clear
   Status = WaitStatusClear (IPMI_KCS_IBF);
   if (EFI_ERROR (Status)) {
-    FreePool (Buffer);
     return Status;
   }
 
   // Step 2. clear OBF
   if (EFI_ERROR (ClearOBF ())) {
-    FreePool (Buffer);
     return EFI_NOT_READY;
   }
 
@@ -220,44 +241,37 @@ KcsTransportWrite (
   // Step 4. wait for IBF to get clear
   Status = WaitStatusClear (IPMI_KCS_IBF);
   if (EFI_ERROR (Status)) {
-    FreePool (Buffer);
     return Status;
   }
 
   // Step 5. check state it should be WRITE_STATE, else exit with error
   if (IPMI_KCS_GET_STATE (KcsRegisterRead8 (KCS_REG_STATUS)) != IpmiKcsWriteState) {
-    FreePool (Buffer);
     return EFI_NOT_READY;
   }
 
   // Step 6, Clear OBF
   if (EFI_ERROR (ClearOBF ())) {
-    FreePool (Buffer);
     return EFI_NOT_READY;
   }
 
   while (Length > 1) {
     // Step 7, phase wr_data, write one byte of Data
-    KcsRegisterWrite8 (KCS_REG_DATA_OUT, *BufferPtr);
+    KcsRegisterWrite8 (KCS_REG_DATA_OUT, KcsNextTransmitByte (Segments, &SegmentIndex, &Offset));
     Length--;
-    BufferPtr++;
 
     // Step 8. wait for IBF clear
     Status = WaitStatusClear (IPMI_KCS_IBF);
     if (EFI_ERROR (Status)) {
-      FreePool (Buffer);
       return Status;
     }
 
     // Step 9. check state it should be WRITE_STATE, else exit with error
     if (IPMI_KCS_GET_STATE (KcsRegisterRead8 (KCS_REG_STATUS)) != IpmiKcsWriteState) {
-      FreePool (Buffer);
       return EFI_NOT_READY;
     }
 
     // Step 10
     if (EFI_ERROR (ClearOBF ())) {
-      FreePool (Buffer);
       return EFI_NOT_READY;
     }
 
@@ -273,25 +287,21 @@ KcsTransportWrite (
   // Step 13. wait for IBF to get clear
   Status = WaitStatusClear (IPMI_KCS_IBF);
   if (EFI_ERROR (Status)) {
-    FreePool (Buffer);
     return Status;
   }
 
   // Step 14. check state it should be WRITE_STATE, else exit with error
   if (IPMI_KCS_GET_STATE (KcsRegisterRead8 (KCS_REG_STATUS)) != IpmiKcsWriteState) {
-    FreePool (Buffer);
     return EFI_NOT_READY;
   }
 
   // Step 15
   if (EFI_ERROR (ClearOBF ())) {
-    FreePool (Buffer);
     return EFI_NOT_READY;
   }
 
   // Step 16, write the last byte
-  KcsRegisterWrite8 (KCS_REG_DATA_OUT, *BufferPtr);
-  FreePool (Buffer);
+  KcsRegisterWrite8 (KCS_REG_DATA_OUT, KcsNextTransmitByte (Segments, &SegmentIndex, &Offset));
   return EFI_SUCCESS;
 }
 
@@ -467,21 +477,19 @@ KcsCheckResponseData (
 
 /**
   This funciton reads the KCS response header according to
-  manageability protocol. Caller has to free the memory
-  allocated for response header.
+  manageability protocol.
 
-  @param[in]      ResponseHeader         Pointer to receive the response header.
+  @param[out]     ResponseHeader         Pointer to receive the response header.
   @param[out]     AdditionalStatus       Pointer to receive the additional status.
 
   @retval         EFI_SUCCESS            KCS response header is checked and returned
                                          to caller.
   @retval         EFI_INVALID_PARAMETER  One of the given parameter is incorrect.
-  @retval         EFI_OUT_OF_RESOURCE    Memory allocation is failed for ResponseHeader.
   @retval         EFI_DEVICE_ERROR       Incorrect response header.
 **/
 EFI_STATUS
 KcsReadResponseHeader (
-  IN   UINT8                                      **ResponseHeader,
+  OUT  KCS_RESPONSE_HEADER                        *ResponseHeader,
   OUT  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  *AdditionalStatus
   )
 {
@@ -494,7 +502,6 @@ KcsReadResponseHeader (
     return EFI_INVALID_PARAMETER;
   }
 
-  *ResponseHeader = NULL;
   if (CompareGuid (&gManageabilityProtocolMctpGuid, mSingleSessionToken->Token.ManageabilityProtocolSpecification)) {
     // For MCTP over KCS
     ExpectedHeaderSize = sizeof (MANAGEABILITY_MCTP_KCS_HEADER);
@@ -522,12 +529,8 @@ KcsReadResponseHeader (
     return EFI_INVALID_PARAMETER;
   }
 
-  RspHeader = (UINT8 *)AllocateZeroPool (ExpectedHeaderSize);
-  if (RspHeader == NULL) {
-    DEBUG ((DEBUG_ERROR, "Memory allocation failed for KCS response header!\n"));
-    return EFI_OUT_OF_RESOURCES;
-  }
-
+  RspHeader = (UINT8 *)ResponseHeader;
+  ZeroMem (RspHeader, sizeof (KCS_RESPONSE_HEADER));
   RspHeaderSize = ExpectedHeaderSize;
   Status        = KcsTransportRead (RspHeader, &RspHeaderSize);
   if (EFI_ERROR (Status)) {
@@ -537,7 +540,6 @@ KcsReadResponseHeader (
       __func__,
       Status
       ));
-    FreePool (RspHeader);
     *AdditionalStatus = MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS_ERROR;
     return Status;
   }
@@ -553,7 +555,6 @@ KcsReadResponseHeader (
       RspHeaderSize,
       ExpectedHeaderSize
       ));
-    FreePool (RspHeader);
     return EFI_DEVICE_ERROR;
   }
 
@@ -569,7 +570,6 @@ KcsReadResponseHeader (
         ((MANAGEABILITY_MCTP_KCS_HEADER *)RspHeader)->NetFunc,
         MCTP_KCS_NETFN_LUN
         ));
-      FreePool (RspHeader);
       *AdditionalStatus = MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS_ERROR;
       return EFI_DEVICE_ERROR;
     }
@@ -582,31 +582,28 @@ KcsReadResponseHeader (
         ((MANAGEABILITY_MCTP_KCS_HEADER *)RspHeader)->DefiningBody,
         DEFINING_BODY_DMTF_PRE_OS_WORKING_GROUP
         ));
-      FreePool (RspHeader);
       *AdditionalStatus = MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS_ERROR;
       return EFI_DEVICE_ERROR;
     }
   }
 
-  *ResponseHeader   = RspHeader;
   *AdditionalStatus = MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS_NO_ERRORS;
   return EFI_SUCCESS;
 }
 
 /**
-  This service communicates with BMC using KCS protocol.
+  This service communicates with BMC using KCS protocol. The request is
+  written straight from the segments it is scattered in.
 
-  @param[in]      TransmitHeader        KCS packet header.
-  @param[in]      TransmitHeaderSize    KCS packet header size in byte.
-  @param[in]      TransmitTrailer       KCS packet trailer.
-  @param[in]      TransmitTrailerSize   KCS packet trailer size in byte.
-  @param[in]      RequestData           Command Request Data.
-  @param[in]      RequestDataSize       Size of Command Request Data.
+  @param[in]      Segments              The segments of the request, in order.
+                                        Could be NULL if SegmentCount is 0.
+  @param[in]      SegmentCount          Number of segments, 0 means only the
+                                        response is read.
   @param[out]     ResponseData          Command Response Data. The completion
                                         code is the first byte of response
                                         data.
   @param[in, out] ResponseDataSize      Size of Command Response Data.
-  @param[out]     AdditionalStatus       Additional status of this transaction.
+  @param[out]     AdditionalStatus      Additional status of this transaction.
 
   @retval         EFI_SUCCESS           The command byte stream was
                                         successfully submit to the device and a
@@ -620,29 +617,26 @@ KcsReadResponseHeader (
   @retval         EFI_TIMEOUT           The command time out.
   @retval         EFI_UNSUPPORTED       The command was not successfully sent to
                                         the device.
-  @retval         EFI_OUT_OF_RESOURCES  The resource allocation is out of
-                                        resource or data size error.
+  @retval         EFI_INVALID_PARAMETER One of the given parameter is incorrect.
 **/
 EFI_STATUS
 EFIAPI
-KcsTransportSendCommand (
-  IN  MANAGEABILITY_TRANSPORT_HEADER              TransmitHeader OPTIONAL,
-  IN  UINT16                                      TransmitHeaderSize,
-  IN  MANAGEABILITY_TRANSPORT_TRAILER             TransmitTrailer OPTIONAL,
-  IN  UINT16                                      TransmitTrailerSize,
-  IN  UINT8                                       *RequestData OPTIONAL,
-  IN  UINT32                                      RequestDataSize,
+KcsTransportSendSegments (
+  IN  MANAGEABILITY_TRANSMIT_SEGMENT              *Segments OPTIONAL,
+  IN  UINT32                                      SegmentCount,
   OUT UINT8                                       *ResponseData OPTIONAL,
   IN  OUT UINT32                                  *ResponseDataSize OPTIONAL,
   OUT  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  *AdditionalStatus
   )
 {
-  EFI_STATUS  Status;
-  UINT8       *RspHeader;
-  UINT32      ExpectedResponseDataSize;
-
-  if ((RequestData != NULL) && (RequestDataSize == 0)) {
-    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of RequestData and RequestDataSize\n", __func__));
+  EFI_STATUS           Status;
+  UINT32               Index;
+  KCS_RESPONSE_HEADER  RspHeader;
+  UINT32               ExpectedResponseDataSize;
+
+  Status = EFI_SUCCESS;
+  if ((Segments == NULL) && (SegmentCount != 0)) {
+    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of Segments and SegmentCount\n", __func__));
     return EFI_INVALID_PARAMETER;
   }
 
@@ -656,28 +650,15 @@ KcsTransportSendCommand (
     return EFI_INVALID_PARAMETER;
   }
 
-  // Print out the request payloads.
-  if ((TransmitHeader != NULL) && (TransmitHeaderSize != 0)) {
-    HelperManageabilityDebugPrint ((VOID *)TransmitHeader, (UINT32)TransmitHeaderSize, "KCS Transmit Header:\n");
-  }
-
-  if (RequestData != NULL) {
-    HelperManageabilityDebugPrint ((VOID *)RequestData, RequestDataSize, "KCS Request Data:\n");
-  }
-
-  if ((TransmitTrailer != NULL) && (TransmitTrailerSize != 0)) {
-    HelperManageabilityDebugPrint ((VOID *)TransmitTrailer, (UINT32)TransmitTrailerSize, "KCS Transmit Trailer:\n");
-  }
+  if (SegmentCount != 0) {
+    // Print out the request payloads.
+    for (Index = 0; Index < SegmentCount; Index++) {
+      if (Segments[Index].SizeInByte != 0) {
+        HelperManageabilityDebugPrint ((VOID *)Segments[Index].Data, Segments[Index].SizeInByte, "KCS Request Segment %d:\n", Index);
+      }
+    }
 
-  if ((TransmitHeader != NULL) || (RequestData != NULL)) {
-    Status = KcsTransportWrite (
-               TransmitHeader,
-               TransmitHeaderSize,
-               TransmitTrailer,
-               TransmitTrailerSize,
-               RequestData,
-               RequestDataSize
-               );
+    Status = KcsTransportWrite (Segments, SegmentCount);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "KCS Write Failed with Status(%r)\n", Status));
       return Status;
@@ -697,22 +678,20 @@ KcsTransportSendCommand (
     // Override ResposeDataSize if the manageability protocol is MCTP.
     //
     if (CompareGuid (&gManageabilityProtocolMctpGuid, mSingleSessionToken->Token.ManageabilityProtocolSpecification)) {
-      if (*ResponseDataSize < ((MANAGEABILITY_MCTP_KCS_HEADER *)RspHeader)->ByteCount) {
+      if (*ResponseDataSize < RspHeader.Mctp.ByteCount) {
         DEBUG ((
           DEBUG_ERROR,
           "%a: Error! MANAGEABILITY_MCTP_KCS_HEADER.ByteCount (0x%02x) is bigger than provided buffer (0x%02x)\n",
           __func__,
-          ((MANAGEABILITY_MCTP_KCS_HEADER *)RspHeader)->ByteCount,
+          RspHeader.Mctp.ByteCount,
           *ResponseDataSize
           ));
         return EFI_INVALID_PARAMETER;
       }
 
-      *ResponseDataSize = ((MANAGEABILITY_MCTP_KCS_HEADER *)RspHeader)->ByteCount;
+      *ResponseDataSize = RspHeader.Mctp.ByteCount;
     }
 
-    FreePool (RspHeader);
-
     ExpectedResponseDataSize = *ResponseDataSize;
     Status                   = KcsTransportRead (ResponseData, ResponseDataSize);
     if (EFI_ERROR (Status)) {
@@ -736,13 +715,96 @@ KcsTransportSendCommand (
     } else {
       DEBUG ((DEBUG_ERROR, "No response, can't determine Completion Code.\n"));
     }
-  } else {
+  } else if (ResponseDataSize != NULL) {
     *ResponseDataSize = 0;
   }
 
   return Status;
 }
 
+/**
+  This service communicates with BMC using KCS protocol.
+
+  @param[in]      TransmitHeader        KCS packet header.
+  @param[in]      TransmitHeaderSize    KCS packet header size in byte.
+  @param[in]      TransmitTrailer       KCS packet trailer.
+  @param[in]      TransmitTrailerSize   KCS packet trailer size in byte.
+  @param[in]      RequestData           Command Request Data.
+  @param[in]      RequestDataSize       Size of Command Request Data.
+  @param[out]     ResponseData          Command Response Data. The completion
+                                        code is the first byte of response
+                                        data.
+  @param[in, out] ResponseDataSize      Size of Command Response Data.
+  @param[out]     AdditionalStatus       Additional status of this transaction.
+
+  @retval         EFI_SUCCESS           The command byte stream was
+                                        successfully submit to the device and a
+                                        response was successfully received.
+  @retval         EFI_NOT_FOUND         The command was not successfully sent
+                                        to the device or a response was not
+                                        successfully received from the device.
+  @retval         EFI_NOT_READY         Ipmi Device is not ready for Ipmi
+                                        command access.
+  @retval         EFI_DEVICE_ERROR      Ipmi Device hardware error.
+  @retval         EFI_TIMEOUT           The command time out.
+  @retval         EFI_UNSUPPORTED       The command was not successfully sent to
+                                        the device.
+  @retval         EFI_INVALID_PARAMETER One of the given parameter is incorrect.
+**/
+EFI_STATUS
+EFIAPI
+KcsTransportSendCommand (
+  IN  MANAGEABILITY_TRANSPORT_HEADER              TransmitHeader OPTIONAL,
+  IN  UINT16                                      TransmitHeaderSize,
+  IN  MANAGEABILITY_TRANSPORT_TRAILER             TransmitTrailer OPTIONAL,
+  IN  UINT16                                      TransmitTrailerSize,
+  IN  UINT8                                       *RequestData OPTIONAL,
+  IN  UINT32                                      RequestDataSize,
+  OUT UINT8                                       *ResponseData OPTIONAL,
+  IN  OUT UINT32                                  *ResponseDataSize OPTIONAL,
+  OUT  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  *AdditionalStatus
+  )
+{
+  MANAGEABILITY_TRANSMIT_SEGMENT  Segments[3];
+  UINT32                          SegmentCount;
+
+  // Validation on RequestData and RequestDataSize.
+  if ((RequestData == NULL) != (RequestDataSize == 0)) {
+    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of RequestData and RequestDataSize\n", __func__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // Validation on TransmitHeader and TransmitHeaderSize.
+  if ((TransmitHeader == NULL) != (TransmitHeaderSize == 0)) {
+    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of TransmitHeader or TransmitHeaderSize.\n", __func__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  // Validation on TransmitTrailer and TransmitTrailerSize.
+  if ((TransmitTrailer == NULL) != (TransmitTrailerSize == 0)) {
+    DEBUG ((DEBUG_ERROR, "%a: Mismatched values of TransmitTrailer or TransmitTrailerSize.\n", __func__));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  SegmentCount = 0;
+  if ((TransmitHeader != NULL) || (RequestData != NULL)) {
+    Segments[SegmentCount].Data         = (UINT8 *)TransmitHeader;
+    Segments[SegmentCount++].SizeInByte = TransmitHeaderSize;
+    Segments[SegmentCount].Data         = RequestData;
+    Segments[SegmentCount++].SizeInByte = RequestDataSize;
+    Segments[SegmentCount].Data         = (UINT8 *)TransmitTrailer;
+    Segments[SegmentCount++].SizeInByte = TransmitTrailerSize;
+  }
+
+  return KcsTransportSendSegments (
+           Segments,
+           SegmentCount,
+           ResponseData,
+           ResponseDataSize,
+           AdditionalStatus
+           );
+}
+
 /**
   This function reads 8-bit value from register address.
 
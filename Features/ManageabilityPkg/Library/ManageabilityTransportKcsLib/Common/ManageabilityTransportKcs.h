@@ -34,10 +34,17 @@ typedef struct {
 
 #define MCTP_KCS_MTU_IN_POWER_OF_2  8
 
+/// Maximum number of segments of a request, including its header and trailer.
+#define KCS_MAX_TRANSMIT_SEGMENTS  8
+
 /// 5 sec, according to IPMI spec
 #define IPMI_KCS_TIMEOUT_5_SEC  5000*1000
 #define IPMI_KCS_TIMEOUT_1MS    1000
 
+/// Interval between two polls of the KCS status register, in microseconds,
+/// while waiting for the BMC within PcdIpmiKcsPollSpinTime.
+#define IPMI_KCS_POLL_MIN_INTERVAL  1
+
 /**
   This service communicates with BMC using KCS protocol.
 
@@ -83,6 +90,44 @@ KcsTransportSendCommand (
   OUT  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  *AdditionalStatus
   );
 
+/**
+  This service communicates with BMC using KCS protocol. The request is
+  written straight from the segments it is scattered in.
+
+  @param[in]      Segments              The segments of the request, in order.
+                                        Could be NULL if SegmentCount is 0.
+  @param[in]      SegmentCount          Number of segments, 0 means only the
+                                        response is read.
+  @param[out]     ResponseData          Command Response Data. The completion
+                                        code is the first byte of response
+                                        data.
+  @param[in, out] ResponseDataSize      Size of Command Response Data.
+  @param[out]     AdditionalStatus      Additional status of this transaction.
+
+  @retval         EFI_SUCCESS           The command byte stream was
+                                        successfully submit to the device and a
+                                        response was successfully received.
+  @retval         EFI_NOT_FOUND         The command was not successfully sent
+                                        to the device or a response was not
+                                        successfully received from the device.
+  @retval         EFI_NOT_READY         Ipmi Device is not ready for Ipmi
+                                        command access.
+  @retval         EFI_DEVICE_ERROR      Ipmi Device hardware error.
+  @retval         EFI_TIMEOUT           The command time out.
+  @retval         EFI_UNSUPPORTED       The command was not successfully sent to
+                                        the device.
+  @retval         EFI_INVALID_PARAMETER One of the given parameter is incorrect.
+**/
+EFI_STATUS
+EFIAPI
+KcsTransportSendSegments (
+  IN  MANAGEABILITY_TRANSMIT_SEGMENT              *Segments OPTIONAL,
+  IN  UINT32                                      SegmentCount,
+  OUT UINT8                                       *ResponseData OPTIONAL,
+  IN  OUT UINT32                                  *ResponseDataSize OPTIONAL,
+  OUT  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  *AdditionalStatus
+  );
+
 /**
   This function reads 8-bit value from register address.
 
@@ -16,6 +16,8 @@
 #include <Library/ManageabilityTransportLib.h>
 #include <Library/ManageabilityTransportIpmiLib.h>
 #include <Library/ManageabilityTransportHelperLib.h>
+#include <Library/UefiBootServicesTableLib.h>
+#include <Protocol/KcsInterrupt.h>
 
 #include "ManageabilityTransportKcs.h"
 
@@ -29,6 +31,7 @@ EFI_GUID  *SupportedManageabilityProtocol[] = {
 UINT8  NumberOfSupportedProtocol = (sizeof (SupportedManageabilityProtocol)/sizeof (EFI_GUID *));
 
 MANAGEABILITY_TRANSPORT_KCS_HARDWARE_INFO  mKcsHardwareInfo;
+EDKII_KCS_INTERRUPT_PROTOCOL               *mKcsInterrupt = NULL;
 
 /**
   This function initializes the transport interface.
@@ -55,7 +58,8 @@ KcsTransportInit (
   IN  MANAGEABILITY_TRANSPORT_HARDWARE_INFORMATION  HardwareInfo OPTIONAL
   )
 {
-  CHAR16  *ManageabilityProtocolName;
+  EFI_STATUS  Status;
+  CHAR16      *ManageabilityProtocolName;
 
   if (TransportToken == NULL) {
     DEBUG ((DEBUG_ERROR, "%a: Invalid transport token.\n", __func__));
@@ -79,6 +83,17 @@ KcsTransportInit (
     mKcsHardwareInfo.IoStatusAddress  = ((MANAGEABILITY_TRANSPORT_KCS_HARDWARE_INFO *)HardwareInfo.Kcs)->IoStatusAddress;
   }
 
+  //
+  // Wait for the KCS interrupt between status polls if the platform provides it,
+  // or keep polling only.
+  //
+  Status = gBS->LocateProtocol (&gEdkiiKcsInterruptProtocolGuid, NULL, (VOID **)&mKcsInterrupt);
+  if (EFI_ERROR (Status)) {
+    mKcsInterrupt = NULL;
+  } else {
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: KCS interrupt is used to wait for BMC.\n", __func__));
+  }
+
   // Get protocol specification name.
   ManageabilityProtocolName = HelperManageabilitySpecName (TransportToken->ManageabilityProtocolSpecification);
 
@@ -221,23 +236,32 @@ KcsTransportTransmitReceive (
 {
   EFI_STATUS                                 Status;
   MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  AdditionalStatus;
+  MANAGEABILITY_TRANSMIT_SEGMENT             Segments[KCS_MAX_TRANSMIT_SEGMENTS];
+  UINT32                                     SegmentCount;
 
   if ((TransportToken == NULL) || (TransferToken == NULL)) {
     DEBUG ((DEBUG_ERROR, "%a: Invalid transport token or transfer token.\n", __func__));
     return;
   }
 
-  Status = KcsTransportSendCommand (
-             TransferToken->TransmitHeader,
-             TransferToken->TransmitHeaderSize,
-             TransferToken->TransmitTrailer,
-             TransferToken->TransmitTrailerSize,
-             TransferToken->TransmitPackage.TransmitPayload,
-             TransferToken->TransmitPackage.TransmitSizeInByte,
-             TransferToken->ReceivePackage.ReceiveBuffer,
-             &TransferToken->ReceivePackage.ReceiveSizeInByte,
-             &AdditionalStatus
-             );
+  //
+  // The header, payload and trailer are written to KCS from where they are,
+  // without gathering them into one buffer.
+  //
+  AdditionalStatus = MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS_NO_ERRORS;
+  SegmentCount     = ARRAY_SIZE (Segments);
+  Status           = HelperManageabilityGetTransmitSegments (TransferToken, Segments, &SegmentCount, NULL);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Invalid transmit segments - (%r).\n", __func__, Status));
+  } else {
+    Status = KcsTransportSendSegments (
+               Segments,
+               SegmentCount,
+               TransferToken->ReceivePackage.ReceiveBuffer,
+               &TransferToken->ReceivePackage.ReceiveSizeInByte,
+               &AdditionalStatus
+               );
+  }
 
   TransferToken->TransferStatus = Status;
   KcsTransportStatus (TransportToken, &TransferToken->TransportAdditionalStatus);
@@ -350,7 +374,7 @@ GetTransportCapability (
     return EFI_INVALID_PARAMETER;
   }
 
-  *TransportCapability = 0;
+  *TransportCapability = MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER;
   if (CompareGuid (
         TransportToken->ManageabilityProtocolSpecification,
         &gManageabilityProtocolIpmiGuid
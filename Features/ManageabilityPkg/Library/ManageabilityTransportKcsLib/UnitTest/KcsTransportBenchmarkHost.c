@@ -0,0 +1,531 @@
+/** @file
+  Latency and throughput benchmark of the KCS instance of
+  ManageabilityTransportLib, run from a host environment.
+
+  The KCS registers are backed by a simulated BMC, and time is simulated as
+  well: MicroSecondDelay() and every register access advance a virtual clock.
+  The figures are therefore reproducible, do not need a BMC, and show the
+  time the KCS transport spends in a transfer for a given BMC responsiveness.
+
+  Copyright (C) 2023 Advanced Micro Devices, Inc. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <Uefi.h>
+#include <IndustryStandard/Ipmi.h>
+#include <IndustryStandard/IpmiKcs.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/IoLib.h>
+#include <Library/ManageabilityTransportLib.h>
+#include <Library/TimerLib.h>
+#include <Protocol/KcsInterrupt.h>
+
+#include "../Common/ManageabilityTransportKcs.h"
+
+//
+// Cost of one KCS register access, in microseconds. LPC and eSPI I/O cycles
+// take about that long.
+//
+#define SIM_IO_ACCESS_TIME  1
+
+#define SIM_KCS_IO_BASE         0xCA2
+#define SIM_MAX_MESSAGE_SIZE    512
+#define SIM_NO_EVENT            MAX_UINT64
+#define SIM_IPMI_NETFN_OEM      0x2E
+#define SIM_IPMI_COMMAND        0x80
+#define SIM_TRANSFERS_PER_TEST  16
+
+///
+/// What the simulated BMC does when it consumes the byte that set IBF.
+///
+typedef enum {
+  SimActionNone,
+  SimActionWriteStart,
+  SimActionWriteEnd,
+  SimActionWriteData,
+  SimActionRead
+} SIM_BMC_ACTION;
+
+///
+/// State of the simulated BMC.
+///
+typedef struct {
+  UINT64            Now;            ///< Virtual time, in microseconds.
+  UINT32            Latency;        ///< Time the BMC takes to consume a byte.
+  UINT32            ProcessTime;    ///< Time the BMC takes to execute a request.
+  UINT8             Status;
+  UINT8             DataIn;
+  SIM_BMC_ACTION    Action;
+  UINT8             ActionData;
+  UINT64            IbfClearTime;
+  UINT64            ObfSetTime;
+  UINT8             ObfData;
+  BOOLEAN           ObfRaised;      ///< OBF got set since the last interrupt wait.
+  BOOLEAN           LastByte;
+  UINT8             Request[SIM_MAX_MESSAGE_SIZE];
+  UINT32            RequestLength;
+  UINT8             Response[SIM_MAX_MESSAGE_SIZE];
+  UINT32            ResponseLength;
+  UINT32            ResponseIndex;
+  UINT32            ResponseDataSize;
+  UINT64            StatusReads;
+  UINT64            Interrupts;
+} SIM_BMC;
+
+STATIC SIM_BMC  mBmc;
+
+MANAGEABILITY_TRANSPORT_KCS_HARDWARE_INFO  mKcsHardwareInfo;
+MANAGEABILITY_TRANSPORT_KCS                *mSingleSessionToken;
+EDKII_KCS_INTERRUPT_PROTOCOL               *mKcsInterrupt;
+
+STATIC MANAGEABILITY_TRANSPORT_KCS  mKcsSession;
+
+/**
+  Sets the KCS state bits of the simulated status register.
+
+  @param[in]  State   IPMI KCS state.
+**/
+STATIC
+VOID
+SimSetState (
+  IN  IPMI_KCS_STATE  State
+  )
+{
+  mBmc.Status = (UINT8)((mBmc.Status & ~IPMI_KCS_SET_STATE (0x3)) | IPMI_KCS_SET_STATE (State));
+}
+
+/**
+  Builds the response of the simulated BMC to the request it received:
+  the IPMI response header, a completion code and ResponseDataSize - 1
+  bytes of data.
+**/
+STATIC
+VOID
+SimBuildResponse (
+  VOID
+  )
+{
+  UINT32  Index;
+
+  mBmc.Response[0] = (UINT8)(mBmc.Request[0] + (1 << 2));
+  mBmc.Response[1] = mBmc.Request[1];
+  mBmc.Response[2] = IPMI_COMP_CODE_NORMAL;
+  for (Index = 1; Index < mBmc.ResponseDataSize; Index++) {
+    mBmc.Response[2 + Index] = (UINT8)(Index + mBmc.RequestLength);
+  }
+
+  mBmc.ResponseLength = 2 + mBmc.ResponseDataSize;
+  mBmc.ResponseIndex  = 0;
+}
+
+/**
+  Lets the simulated BMC act on everything that is due at the current time.
+**/
+STATIC
+VOID
+SimAdvance (
+  VOID
+  )
+{
+  UINT64  ClearTime;
+
+  if (mBmc.IbfClearTime <= mBmc.Now) {
+    ClearTime         = mBmc.IbfClearTime;
+    mBmc.IbfClearTime = SIM_NO_EVENT;
+    mBmc.Status      &= ~IPMI_KCS_IBF;
+    switch (mBmc.Action) {
+      case SimActionWriteStart:
+        mBmc.RequestLength = 0;
+        mBmc.LastByte      = FALSE;
+        SimSetState (IpmiKcsWriteState);
+        break;
+
+      case SimActionWriteEnd:
+        mBmc.LastByte = TRUE;
+        break;
+
+      case SimActionWriteData:
+        if (mBmc.RequestLength < SIM_MAX_MESSAGE_SIZE) {
+          mBmc.Request[mBmc.RequestLength++] = mBmc.ActionData;
+        }
+
+        if (mBmc.LastByte) {
+          SimSetState (IpmiKcsReadState);
+          SimBuildResponse ();
+          mBmc.ObfData    = mBmc.Response[mBmc.ResponseIndex++];
+          mBmc.ObfSetTime = ClearTime + mBmc.ProcessTime;
+        }
+
+        break;
+
+      case SimActionRead:
+        if (mBmc.ResponseIndex < mBmc.ResponseLength) {
+          mBmc.ObfData = mBmc.Response[mBmc.ResponseIndex++];
+        } else {
+          SimSetState (IpmiKcsIdleState);
+          mBmc.ObfData = 0;
+        }
+
+        mBmc.ObfSetTime = ClearTime;
+        break;
+
+      default:
+        break;
+    }
+
+    mBmc.Action = SimActionNone;
+  }
+
+  if (mBmc.ObfSetTime <= mBmc.Now) {
+    mBmc.ObfSetTime = SIM_NO_EVENT;
+    mBmc.DataIn     = mBmc.ObfData;
+    mBmc.Status    |= IPMI_KCS_OBF;
+    mBmc.ObfRaised  = TRUE;
+  }
+}
+
+/**
+  Makes the simulated BMC consume a byte the host wrote.
+
+  @param[in]  Action  What the BMC does with the byte.
+  @param[in]  Data    The byte.
+**/
+STATIC
+VOID
+SimWrite (
+  IN  SIM_BMC_ACTION  Action,
+  IN  UINT8           Data
+  )
+{
+  mBmc.Status      |= IPMI_KCS_IBF;
+  mBmc.Action       = Action;
+  mBmc.ActionData   = Data;
+  mBmc.IbfClearTime = mBmc.Now + mBmc.Latency;
+}
+
+/**
+  Simulated I/O port read.
+
+  @param[in]  Port  The I/O port to read.
+
+  @return The value read.
+**/
+UINT8
+EFIAPI
+IoRead8 (
+  IN  UINTN  Port
+  )
+{
+  mBmc.Now += SIM_IO_ACCESS_TIME;
+  SimAdvance ();
+  if (Port == SIM_KCS_IO_BASE + IPMI_KCS_STATUS_REGISTER_OFFSET) {
+    mBmc.StatusReads++;
+    return mBmc.Status;
+  }
+
+  mBmc.Status &= ~IPMI_KCS_OBF;
+  return mBmc.DataIn;
+}
+
+/**
+  Simulated I/O port write.
+
+  @param[in]  Port    The I/O port to write.
+  @param[in]  Value   The value to write.
+
+  @return The value written.
+**/
+UINT8
+EFIAPI
+IoWrite8 (
+  IN  UINTN  Port,
+  IN  UINT8  Value
+  )
+{
+  mBmc.Now += SIM_IO_ACCESS_TIME;
+  SimAdvance ();
+  if (Port == SIM_KCS_IO_BASE + IPMI_KCS_COMMAND_REGISTER_OFFSET) {
+    if (Value == IPMI_KCS_CONTROL_CODE_WRITE_START) {
+      SimWrite (SimActionWriteStart, Value);
+    } else if (Value == IPMI_KCS_CONTROL_CODE_WRITE_END) {
+      SimWrite (SimActionWriteEnd, Value);
+    } else {
+      SimWrite (SimActionNone, Value);
+    }
+  } else if (IPMI_KCS_GET_STATE (mBmc.Status) == IpmiKcsReadState) {
+    SimWrite (SimActionRead, Value);
+  } else {
+    SimWrite (SimActionWriteData, Value);
+  }
+
+  return Value;
+}
+
+/**
+  The simulated KCS interface is I/O mapped only.
+
+  @param[in]  Address   The MMIO address to read.
+
+  @return The value read.
+**/
+UINT8
+EFIAPI
+MmioRead8 (
+  IN  UINTN  Address
+  )
+{
+  return IoRead8 (Address);
+}
+
+/**
+  The simulated KCS interface is I/O mapped only.
+
+  @param[in]  Address   The MMIO address to write.
+  @param[in]  Value     The value to write.
+
+  @return The value written.
+**/
+UINT8
+EFIAPI
+MmioWrite8 (
+  IN  UINTN  Address,
+  IN  UINT8  Value
+  )
+{
+  return IoWrite8 (Address, Value);
+}
+
+/**
+  Advances the virtual clock.
+
+  @param[in]  MicroSeconds  The number of microseconds to delay.
+
+  @return The value of MicroSeconds.
+**/
+UINTN
+EFIAPI
+MicroSecondDelay (
+  IN  UINTN  MicroSeconds
+  )
+{
+  mBmc.Now += MicroSeconds;
+  SimAdvance ();
+  return MicroSeconds;
+}
+
+/**
+  Simulated KCS interrupt: the BMC raises it when it sets OBF.
+
+  @param[in]  This      EDKII_KCS_INTERRUPT_PROTOCOL instance.
+  @param[in]  Timeout   Longest time to wait, in microseconds.
+
+  @retval     EFI_SUCCESS   The KCS interrupt fired.
+  @retval     EFI_TIMEOUT   Timeout elapsed before the KCS interrupt fired.
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+SimWaitForInterrupt (
+  IN  EDKII_KCS_INTERRUPT_PROTOCOL  *This,
+  IN  UINT32                        Timeout
+  )
+{
+  UINT64  End;
+
+  End            = mBmc.Now + Timeout;
+  mBmc.ObfRaised = FALSE;
+  while (mBmc.Now < End) {
+    mBmc.Now++;
+    SimAdvance ();
+    if (mBmc.ObfRaised) {
+      mBmc.Interrupts++;
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_TIMEOUT;
+}
+
+STATIC EDKII_KCS_INTERRUPT_PROTOCOL_V1_0  mSimKcsInterruptV1_0 = {
+  SimWaitForInterrupt
+};
+
+STATIC EDKII_KCS_INTERRUPT_PROTOCOL  mSimKcsInterrupt = {
+  EDKII_KCS_INTERRUPT_PROTOCOL_VERSION,
+  { &mSimKcsInterruptV1_0 }
+};
+
+/**
+  Runs SIM_TRANSFERS_PER_TEST IPMI transfers through the KCS transport and
+  prints the time they took.
+
+  @param[in]  Name              Name of the test.
+  @param[in]  RequestDataSize   Size of the request data.
+  @param[in]  ResponseDataSize  Size of the response data, completion code
+                                included.
+  @param[in]  Latency           Time the BMC takes to consume a byte.
+  @param[in]  ProcessTime       Time the BMC takes to execute a request.
+  @param[in]  UseInterrupt      Whether the KCS interrupt is available.
+
+  @retval     EFI_SUCCESS       All transfers succeeded.
+  @retval     Others            A transfer failed.
+**/
+STATIC
+EFI_STATUS
+RunTest (
+  IN  CONST CHAR8  *Name,
+  IN  UINT32       RequestDataSize,
+  IN  UINT32       ResponseDataSize,
+  IN  UINT32       Latency,
+  IN  UINT32       ProcessTime,
+  IN  BOOLEAN      UseInterrupt
+  )
+{
+  EFI_STATUS                                 Status;
+  UINT8                                      Header[2];
+  UINT8                                      RequestData[SIM_MAX_MESSAGE_SIZE];
+  UINT8                                      ResponseData[SIM_MAX_MESSAGE_SIZE];
+  UINT32                                     Size;
+  UINT32                                     Index;
+  MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  AdditionalStatus;
+  UINT64                                     Bytes;
+  UINT64                                     Time;
+
+  ZeroMem (&mBmc, sizeof (mBmc));
+  mBmc.Latency          = Latency;
+  mBmc.ProcessTime      = ProcessTime;
+  mBmc.IbfClearTime     = SIM_NO_EVENT;
+  mBmc.ObfSetTime       = SIM_NO_EVENT;
+  mBmc.ResponseDataSize = ResponseDataSize;
+  mKcsInterrupt         = UseInterrupt ? &mSimKcsInterrupt : NULL;
+
+  Header[0] = SIM_IPMI_NETFN_OEM << 2;
+  Header[1] = SIM_IPMI_COMMAND;
+  for (Index = 0; Index < RequestDataSize; Index++) {
+    RequestData[Index] = (UINT8)Index;
+  }
+
+  for (Index = 0; Index < SIM_TRANSFERS_PER_TEST; Index++) {
+    Size   = ResponseDataSize;
+    Status = KcsTransportSendCommand (
+               Header,
+               sizeof (Header),
+               NULL,
+               0,
+               (RequestDataSize != 0) ? RequestData : NULL,
+               RequestDataSize,
+               ResponseData,
+               &Size,
+               &AdditionalStatus
+               );
+    if (EFI_ERROR (Status) || (Size != ResponseDataSize) || (ResponseData[0] != IPMI_COMP_CODE_NORMAL)) {
+      printf ("%s: transfer %u failed, status 0x%llx, %u bytes\n", Name, Index, (UINT64)Status, Size);
+      return EFI_ERROR (Status) ? Status : EFI_DEVICE_ERROR;
+    }
+  }
+
+  Bytes = (UINT64)(sizeof (Header) + RequestDataSize + sizeof (Header) + ResponseDataSize) * SIM_TRANSFERS_PER_TEST;
+  Time  = MAX (mBmc.Now, 1);
+  printf (
+    "  %-16s %5u %7u  %-9s %10.1f us %10.1f KB/s %8llu %8llu\n",
+    Name,
+    Latency,
+    ProcessTime,
+    UseInterrupt ? "interrupt" : "polled",
+    (double)Time / SIM_TRANSFERS_PER_TEST,
+    (double)Bytes * 1000000 / 1024 / Time,
+    mBmc.StatusReads / SIM_TRANSFERS_PER_TEST,
+    mBmc.Interrupts / SIM_TRANSFERS_PER_TEST
+    );
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Runs the benchmark.
+
+  Usage: KcsTransportBenchmarkHost [Latency [ProcessTime]]
+  Latency is the time, in microseconds, the simulated BMC takes to consume a
+  byte and ProcessTime the time it takes to execute a request. Without them,
+  a range of typical values is measured.
+
+  @param[in]  Argc  Number of arguments.
+  @param[in]  Argv  Arguments.
+
+  @retval     0     All the transfers succeeded.
+  @retval     1     A transfer failed.
+**/
+int
+main (
+  int   Argc,
+  char  *Argv[]
+  )
+{
+  STATIC CONST struct {
+    CONST CHAR8    *Name;
+    UINT32         RequestDataSize;
+    UINT32         ResponseDataSize;
+  } Tests[] = {
+    { "Get Device ID", 0,   16  },
+    { "Blob write 224", 230, 3   },
+    { "Read 240",       8,   241 },
+  };
+  STATIC CONST UINT32  Latencies[]    = { 2, 20, 200 };
+  STATIC CONST UINT32  ProcessTimes[] = { 100, 2000 };
+  UINT32               Latency;
+  UINT32               ProcessTime;
+  UINTN                TestIndex;
+  UINTN                LatencyIndex;
+  UINTN                ProcessIndex;
+  UINTN                Mode;
+
+  mKcsHardwareInfo.MemoryMap                    = MANAGEABILITY_TRANSPORT_KCS_IO_MAP_IO;
+  mKcsHardwareInfo.IoBaseAddress.IoAddress16    = SIM_KCS_IO_BASE;
+  mKcsHardwareInfo.IoDataInAddress.IoAddress16  = SIM_KCS_IO_BASE + IPMI_KCS_DATA_IN_REGISTER_OFFSET;
+  mKcsHardwareInfo.IoDataOutAddress.IoAddress16 = SIM_KCS_IO_BASE + IPMI_KCS_DATA_OUT_REGISTER_OFFSET;
+  mKcsHardwareInfo.IoCommandAddress.IoAddress16 = SIM_KCS_IO_BASE + IPMI_KCS_COMMAND_REGISTER_OFFSET;
+  mKcsHardwareInfo.IoStatusAddress.IoAddress16  = SIM_KCS_IO_BASE + IPMI_KCS_STATUS_REGISTER_OFFSET;
+
+  mKcsSession.Signature                                = MANAGEABILITY_TRANSPORT_KCS_SIGNATURE;
+  mKcsSession.Token.ManageabilityProtocolSpecification = &gManageabilityProtocolIpmiGuid;
+  mSingleSessionToken                                  = &mKcsSession;
+
+  printf ("  %-16s %5s %7s  %-9s %13s %15s %8s %8s\n", "Transfer", "Lat", "Process", "Mode", "Time", "Throughput", "Polls", "IRQs");
+  for (TestIndex = 0; TestIndex < ARRAY_SIZE (Tests); TestIndex++) {
+    for (LatencyIndex = 0; LatencyIndex < ARRAY_SIZE (Latencies); LatencyIndex++) {
+      for (ProcessIndex = 0; ProcessIndex < ARRAY_SIZE (ProcessTimes); ProcessIndex++) {
+        Latency     = (Argc > 1) ? (UINT32)strtoul (Argv[1], NULL, 0) : Latencies[LatencyIndex];
+        ProcessTime = (Argc > 2) ? (UINT32)strtoul (Argv[2], NULL, 0) : ProcessTimes[ProcessIndex];
+        for (Mode = 0; Mode < 2; Mode++) {
+          if (EFI_ERROR (
+                RunTest (
+                  Tests[TestIndex].Name,
+                  Tests[TestIndex].RequestDataSize,
+                  Tests[TestIndex].ResponseDataSize,
+                  Latency,
+                  ProcessTime,
+                  Mode != 0
+                  )
+                ))
+          {
+            return 1;
+          }
+        }
+
+        if (Argc > 2) {
+          break;
+        }
+      }
+
+      if (Argc > 1) {
+        break;
+      }
+    }
+  }
+
+  return 0;
+}
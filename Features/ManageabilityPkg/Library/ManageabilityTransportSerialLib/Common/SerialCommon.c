@@ -213,14 +213,14 @@ SerialTransportWrite (
   EFI_STATUS          Status;
   IPMI_SERIAL_HEADER  *HeaderPtr;
   UINT8               *BufferPtr;
-  UINT8               *Buffer;
+  UINT8               Buffer[IPMI_SERIAL_MAXIMUM_PACKET_SIZE_IN_BYTES];
   UINT32              BufferLength;
-  UINT8               *Request;
+  UINT8               Request[IPMI_SERIAL_MAXIMUM_PACKET_SIZE_IN_BYTES * 2 + 2];
   UINT32              RequestLength;
   UINT8               RetryCount;
-  UINT8               Index;
+  UINT32              Index;
   UINT8               Character;
-  UINT8               EscapedCharacterCount;
+  UINT32              EscapedCharacterCount;
   UINT8               NetFunction;
 
   // Validation on RequestData and RequestDataSize.
@@ -253,12 +253,18 @@ SerialTransportWrite (
   NetFunction = ((MANAGEABILITY_IPMI_TRANSPORT_HEADER *)TransmitHeader)->NetFn;
   ASSERT (NetFunction <= MANAGEABILITY_IPMI_NET_FUNC_MAX);
 
-  BufferLength = RequestDataSize + IPMI_SERIAL_MIN_REQUEST_LENGTH;
-  Buffer       = AllocateZeroPool (BufferLength);
-  if (Buffer == NULL) {
-    return EFI_OUT_OF_RESOURCES;
+  //
+  // The request is framed in buffers on the stack, so no memory is allocated
+  // on each command. Every byte of the request may be escaped, hence twice
+  // the size plus the start and stop characters.
+  //
+  if (RequestDataSize > IPMI_SERIAL_MAXIMUM_PACKET_SIZE_IN_BYTES - IPMI_SERIAL_MIN_REQUEST_LENGTH) {
+    DEBUG ((DEBUG_ERROR, "%a: Request data size 0x%x is too large.\n", __func__, RequestDataSize));
+    return EFI_INVALID_PARAMETER;
   }
 
+  BufferLength = RequestDataSize + IPMI_SERIAL_MIN_REQUEST_LENGTH;
+  ZeroMem (Buffer, BufferLength);
   HeaderPtr = (IPMI_SERIAL_HEADER *)Buffer;
 
   // Fill IPMI Serial basic format data bytes
@@ -288,13 +294,8 @@ SerialTransportWrite (
     }
   }
 
-  // Allocate memory buffer include escaped characters
+  // Request length including the escaped characters
   RequestLength = BufferLength + EscapedCharacterCount + 2; // start + stop byte
-  Request       = AllocateZeroPool (RequestLength);
-  if (Request == NULL) {
-    DEBUG ((DEBUG_ERROR, "Out Of Resource \n"));
-    return EFI_OUT_OF_RESOURCES;
-  }
 
   BufferPtr = Request;
 
@@ -332,9 +333,6 @@ SerialTransportWrite (
     MicroSecondDelay (IPMI_SERIAL_REQUEST_RETRY_INTERVAL);
   }
 
-  FreePool (Buffer);
-  FreePool (Request);
-
   return EFI_SUCCESS;
 }
 
@@ -300,11 +300,15 @@ SsifCommonSendCommand (
 {
   EFI_STATUS  Status;
   UINT32      TempLength;
-  UINT8       *RequestTemp;
+  UINT8       RequestTemp[MAX_UINT8];
   UINT8       RetryCount;
 
-  RequestTemp = AllocateZeroPool (RequestDataSize + sizeof (IPMI_SSIF_REQUEST_HEADER));
-  if (RequestTemp == NULL) {
+  //
+  // The request can't be longer than mMaxRequestSize, which fits in the
+  // buffer on the stack, so no memory is allocated for it.
+  //
+  if ((RequestData != NULL) && (RequestDataSize + sizeof (IPMI_SSIF_REQUEST_HEADER) > mMaxRequestSize)) {
+    DEBUG ((DEBUG_ERROR, "%a: Request size defeats BMC capability\n", __func__));
     return EFI_OUT_OF_RESOURCES;
   }
 
@@ -318,25 +322,17 @@ SsifCommonSendCommand (
       CopyMem (RequestTemp + TempLength, RequestData, RequestDataSize);
       TempLength += RequestDataSize;
     } else {
-      Status = EFI_OUT_OF_RESOURCES;
       DEBUG ((DEBUG_ERROR, "%a: Invalid request info\n", __func__));
-      goto Cleanup;
+      return EFI_OUT_OF_RESOURCES;
     }
   }
 
-  if (TempLength > mMaxRequestSize) {
-    Status = EFI_OUT_OF_RESOURCES;
-    DEBUG ((DEBUG_ERROR, "%a: Request size defeats BMC capability\n", __func__));
-    goto Cleanup;
-  }
-
   if (  (ResponseData == NULL)
      || (ResponseDataSize == NULL)
      || (*ResponseDataSize == 0))
   {
-    Status = EFI_OUT_OF_RESOURCES;
     DEBUG ((DEBUG_ERROR, "%a: Invalid response info\n", __func__));
-    goto Cleanup;
+    return EFI_OUT_OF_RESOURCES;
   }
 
   //
@@ -351,7 +347,7 @@ SsifCommonSendCommand (
 
     if (++RetryCount > IPMI_SSIF_REQUEST_RETRY_COUNT) {
       DEBUG ((DEBUG_ERROR, "%a: Write request error %r\n", __func__, Status));
-      goto Cleanup;
+      return Status;
     }
 
     MicroSecondDelay (IPMI_SSIF_REQUEST_RETRY_INTERVAL);
@@ -373,7 +369,7 @@ SsifCommonSendCommand (
     if (++RetryCount > IPMI_SSIF_RESPONSE_RETRY_COUNT) {
       DEBUG ((DEBUG_ERROR, "%a: Read response error %r\n", __func__, Status));
       *ResponseDataSize = 0;
-      goto Cleanup;
+      return Status;
     }
 
     *ResponseDataSize = TempLength;
@@ -381,9 +377,6 @@ SsifCommonSendCommand (
     DEBUG ((DEBUG_INFO, "%a: Read response retry %d\n", __func__, RetryCount));
   }
 
-Cleanup:
-  FreePool (RequestTemp);
-
   return Status;
 }
 
@@ -0,0 +1,486 @@
+/** @file
+  DXE instance of SMBIOS Digest Library.
+
+  The index saved in the UEFI variable is a SMBIOS_DIGEST_INDEX_HEADER,
+  followed by one SMBIOS_STRUCTURE_DIGEST per structure, sorted by handle.
+
+  Copyright (C) 2023 Advanced Micro Devices, Inc. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+**/
+
+#include <Uefi.h>
+#include <IndustryStandard/SmBios.h>
+#include <Library/BaseCryptLib.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/SmbiosDigestLib.h>
+#include <Library/UefiRuntimeServicesTableLib.h>
+
+#define SMBIOS_DIGEST_INDEX_SIGNATURE  SIGNATURE_32 ('S', 'M', 'D', 'I')
+#define SMBIOS_DIGEST_INDEX_VERSION    1
+
+//
+// The digest of a structure is the first bytes of its SHA-256.
+//
+#define SMBIOS_STRUCTURE_DIGEST_SIZE  8
+
+#pragma pack(1)
+typedef struct {
+  UINT32    Signature;
+  UINT16    Version;
+  UINT16    NumberOfStructures;
+  UINT8     TableDigest[SHA256_DIGEST_SIZE];
+} SMBIOS_DIGEST_INDEX_HEADER;
+
+typedef struct {
+  UINT16    Handle;
+  UINT8     Type;
+  UINT8     Reserved;
+  UINT32    Size;
+  UINT8     Digest[SMBIOS_STRUCTURE_DIGEST_SIZE];
+} SMBIOS_STRUCTURE_DIGEST;
+#pragma pack()
+
+typedef struct {
+  SMBIOS_STRUCTURE_DIGEST    Digest;
+  UINT8                      *Structure;
+} SMBIOS_STRUCTURE_RECORD;
+
+struct _SMBIOS_DIGEST_INDEX {
+  CHAR16                        *VariableName;
+  ///
+  /// Variable data, the header followed by the structure digests.
+  ///
+  SMBIOS_DIGEST_INDEX_HEADER    *Header;
+  UINTN                         HeaderSize;
+  ///
+  /// The structures of the table, in the same order as the digests.
+  ///
+  UINT8                         **Structures;
+};
+
+#define SMBIOS_DIGEST_INDEX_ENTRIES(Header)  ((SMBIOS_STRUCTURE_DIGEST *)((SMBIOS_DIGEST_INDEX_HEADER *)(Header) + 1))
+
+/**
+  Get the size of an SMBIOS structure, including its strings.
+
+  @param[in]  Structure     The structure.
+  @param[in]  MaximumSize   Number of bytes from Structure to the end of the table.
+
+  @return Size of the structure, or 0 if it does not fit in MaximumSize.
+**/
+STATIC
+UINTN
+SmbiosDigestStructureSize (
+  IN UINT8  *Structure,
+  IN UINTN  MaximumSize
+  )
+{
+  UINTN  Size;
+
+  if ((MaximumSize < sizeof (SMBIOS_STRUCTURE) + 2) ||
+      (((SMBIOS_STRUCTURE *)Structure)->Length < sizeof (SMBIOS_STRUCTURE)))
+  {
+    return 0;
+  }
+
+  //
+  // The strings end with two zero bytes, right after the formatted area.
+  //
+  for (Size = ((SMBIOS_STRUCTURE *)Structure)->Length; Size + 1 < MaximumSize; Size++) {
+    if ((Structure[Size] == 0) && (Structure[Size + 1] == 0)) {
+      return Size + 2;
+    }
+  }
+
+  return 0;
+}
+
+/**
+  Compare two structure records by handle, for QuickSort().
+
+  @param[in]  Buffer1   The first SMBIOS_STRUCTURE_RECORD.
+  @param[in]  Buffer2   The second SMBIOS_STRUCTURE_RECORD.
+
+  @return <0, 0 or >0 as the handle of Buffer1 is lower, equal or higher.
+**/
+STATIC
+INTN
+EFIAPI
+SmbiosDigestCompareHandle (
+  IN CONST VOID  *Buffer1,
+  IN CONST VOID  *Buffer2
+  )
+{
+  return (INTN)((SMBIOS_STRUCTURE_RECORD *)Buffer1)->Digest.Handle - (INTN)((SMBIOS_STRUCTURE_RECORD *)Buffer2)->Digest.Handle;
+}
+
+/**
+  Build the digest index of an SMBIOS structure table.
+
+  @param[in]  VariableName    Name of the UEFI variable the index is kept in,
+                              under gManageabilityVariableGuid.
+  @param[in]  Structures      The SMBIOS structures, up to and including the
+                              end-of-table structure.
+  @param[in]  StructuresSize  Size of Structures in bytes.
+  @param[out] Index           Pointer to receive the index. Free it with
+                              SmbiosDigestIndexFree().
+
+  @retval EFI_SUCCESS            The index is returned.
+  @retval EFI_INVALID_PARAMETER  A parameter is NULL, or a structure is malformed.
+  @retval EFI_OUT_OF_RESOURCES   Not enough memory for the index.
+  @retval EFI_DEVICE_ERROR       Failed to compute a digest.
+**/
+EFI_STATUS
+EFIAPI
+SmbiosDigestIndexCreate (
+  IN  CHAR16               *VariableName,
+  IN  UINT8                *Structures,
+  IN  UINTN                StructuresSize,
+  OUT SMBIOS_DIGEST_INDEX  **Index
+  )
+{
+  SMBIOS_DIGEST_INDEX      *NewIndex;
+  SMBIOS_STRUCTURE_RECORD  *Records;
+  SMBIOS_STRUCTURE_RECORD  SortBuffer;
+  SMBIOS_STRUCTURE_DIGEST  *Entries;
+  UINT8                    Digest[SHA256_DIGEST_SIZE];
+  UINTN                    Count;
+  UINTN                    Offset;
+  UINTN                    Size;
+  UINTN                    Entry;
+
+  if ((VariableName == NULL) || (Structures == NULL) || (Index == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // Count the structures first.
+  //
+  Count = 0;
+  for (Offset = 0; Offset < StructuresSize; Offset += Size) {
+    Size = SmbiosDigestStructureSize (Structures + Offset, StructuresSize - Offset);
+    if (Size == 0) {
+      DEBUG ((DEBUG_ERROR, "%a: Malformed SMBIOS structure at offset 0x%x.\n", __func__, Offset));
+      return EFI_INVALID_PARAMETER;
+    }
+
+    Count++;
+    if (((SMBIOS_STRUCTURE *)(Structures + Offset))->Type == EFI_SMBIOS_TYPE_END_OF_TABLE) {
+      Offset += Size;
+      break;
+    }
+  }
+
+  if ((Count == 0) || (Count > MAX_UINT16)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  StructuresSize = Offset;
+  Records        = AllocatePool (Count * sizeof (SMBIOS_STRUCTURE_RECORD));
+  NewIndex       = AllocateZeroPool (sizeof (SMBIOS_DIGEST_INDEX));
+  if ((Records == NULL) || (NewIndex == NULL)) {
+    if (Records != NULL) {
+      FreePool (Records);
+    }
+
+    SmbiosDigestIndexFree (NewIndex);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Offset = 0;
+  for (Entry = 0; Entry < Count; Entry++) {
+    Size = SmbiosDigestStructureSize (Structures + Offset, StructuresSize - Offset);
+    if (!Sha256HashAll (Structures + Offset, Size, Digest)) {
+      FreePool (Records);
+      SmbiosDigestIndexFree (NewIndex);
+      return EFI_DEVICE_ERROR;
+    }
+
+    Records[Entry].Structure       = Structures + Offset;
+    Records[Entry].Digest.Handle   = ((SMBIOS_STRUCTURE *)(Structures + Offset))->Handle;
+    Records[Entry].Digest.Type     = ((SMBIOS_STRUCTURE *)(Structures + Offset))->Type;
+    Records[Entry].Digest.Reserved = 0;
+    Records[Entry].Digest.Size     = (UINT32)Size;
+    CopyMem (Records[Entry].Digest.Digest, Digest, SMBIOS_STRUCTURE_DIGEST_SIZE);
+    Offset += Size;
+  }
+
+  QuickSort (Records, Count, sizeof (SMBIOS_STRUCTURE_RECORD), SmbiosDigestCompareHandle, &SortBuffer);
+
+  NewIndex->VariableName = VariableName;
+  NewIndex->HeaderSize   = sizeof (SMBIOS_DIGEST_INDEX_HEADER) + Count * sizeof (SMBIOS_STRUCTURE_DIGEST);
+  NewIndex->Header       = AllocateZeroPool (NewIndex->HeaderSize);
+  NewIndex->Structures   = AllocateZeroPool (Count * sizeof (UINT8 *));
+  if ((NewIndex->Header == NULL) || (NewIndex->Structures == NULL)) {
+    FreePool (Records);
+    SmbiosDigestIndexFree (NewIndex);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (!Sha256HashAll (Structures, StructuresSize, NewIndex->Header->TableDigest)) {
+    FreePool (Records);
+    SmbiosDigestIndexFree (NewIndex);
+    return EFI_DEVICE_ERROR;
+  }
+
+  NewIndex->Header->Signature          = SMBIOS_DIGEST_INDEX_SIGNATURE;
+  NewIndex->Header->Version            = SMBIOS_DIGEST_INDEX_VERSION;
+  NewIndex->Header->NumberOfStructures = (UINT16)Count;
+
+  Entries = SMBIOS_DIGEST_INDEX_ENTRIES (NewIndex->Header);
+  for (Entry = 0; Entry < Count; Entry++) {
+    CopyMem (&Entries[Entry], &Records[Entry].Digest, sizeof (SMBIOS_STRUCTURE_DIGEST));
+    NewIndex->Structures[Entry] = Records[Entry].Structure;
+  }
+
+  FreePool (Records);
+  *Index = NewIndex;
+  return EFI_SUCCESS;
+}
+
+/**
+  Compare an index with the one saved by the last SmbiosDigestIndexSave().
+
+  The changes are sorted by handle. Changes is NULL when ChangeCount is 0,
+  that is when the table is the same as the one last saved.
+
+  @param[in]  Index        The index of the current table.
+  @param[out] Changes      Pointer to receive the changed structures. Free it
+                           with FreePool().
+  @param[out] ChangeCount  Pointer to receive the number of changed structures.
+
+  @retval EFI_SUCCESS            The changes are returned.
+  @retval EFI_NOT_FOUND          No valid index was saved, the whole table must
+                                 be considered changed.
+  @retval EFI_INVALID_PARAMETER  A parameter is NULL.
+  @retval EFI_OUT_OF_RESOURCES   Not enough memory for the changes.
+**/
+EFI_STATUS
+EFIAPI
+SmbiosDigestIndexCompare (
+  IN  SMBIOS_DIGEST_INDEX      *Index,
+  OUT SMBIOS_STRUCTURE_CHANGE  **Changes,
+  OUT UINTN                    *ChangeCount
+  )
+{
+  EFI_STATUS                  Status;
+  SMBIOS_DIGEST_INDEX_HEADER  *Saved;
+  UINTN                       SavedSize;
+  SMBIOS_STRUCTURE_DIGEST     *Old;
+  SMBIOS_STRUCTURE_DIGEST     *New;
+  SMBIOS_STRUCTURE_CHANGE     *Change;
+  UINTN                       OldIndex;
+  UINTN                       NewIndex;
+  UINTN                       OldCount;
+  UINTN                       NewCount;
+  UINTN                       Count;
+
+  if ((Index == NULL) || (Changes == NULL) || (ChangeCount == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *Changes     = NULL;
+  *ChangeCount = 0;
+
+  SavedSize = 0;
+  Saved     = NULL;
+  Status    = gRT->GetVariable (Index->VariableName, &gManageabilityVariableGuid, NULL, &SavedSize, NULL);
+  if (Status != EFI_BUFFER_TOO_SMALL) {
+    DEBUG ((DEBUG_INFO, "%a: No SMBIOS digest index in %s - %r\n", __func__, Index->VariableName, Status));
+    return EFI_NOT_FOUND;
+  }
+
+  Saved = AllocatePool (SavedSize);
+  if (Saved == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = gRT->GetVariable (Index->VariableName, &gManageabilityVariableGuid, NULL, &SavedSize, Saved);
+  if (EFI_ERROR (Status) ||
+      (SavedSize < sizeof (SMBIOS_DIGEST_INDEX_HEADER)) ||
+      (Saved->Signature != SMBIOS_DIGEST_INDEX_SIGNATURE) ||
+      (Saved->Version != SMBIOS_DIGEST_INDEX_VERSION) ||
+      (SavedSize != sizeof (SMBIOS_DIGEST_INDEX_HEADER) + Saved->NumberOfStructures * sizeof (SMBIOS_STRUCTURE_DIGEST)))
+  {
+    DEBUG ((DEBUG_INFO, "%a: SMBIOS digest index in %s is invalid.\n", __func__, Index->VariableName));
+    FreePool (Saved);
+    return EFI_NOT_FOUND;
+  }
+
+  if (CompareMem (Saved->TableDigest, Index->Header->TableDigest, SHA256_DIGEST_SIZE) == 0) {
+    FreePool (Saved);
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Both lists are sorted by handle, walk them side by side. There are at
+  // most as many changes as the two lists have entries together.
+  //
+  Old      = SMBIOS_DIGEST_INDEX_ENTRIES (Saved);
+  New      = SMBIOS_DIGEST_INDEX_ENTRIES (Index->Header);
+  OldCount = Saved->NumberOfStructures;
+  NewCount = Index->Header->NumberOfStructures;
+  Change   = AllocateZeroPool ((OldCount + NewCount) * sizeof (SMBIOS_STRUCTURE_CHANGE));
+  if (Change == NULL) {
+    FreePool (Saved);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Count    = 0;
+  OldIndex = 0;
+  NewIndex = 0;
+  while ((OldIndex < OldCount) || (NewIndex < NewCount)) {
+    if ((NewIndex == NewCount) ||
+        ((OldIndex < OldCount) && (Old[OldIndex].Handle < New[NewIndex].Handle)))
+    {
+      Change[Count].Change = SmbiosStructureRemoved;
+      Change[Count].Handle = Old[OldIndex].Handle;
+      Change[Count].Type   = Old[OldIndex].Type;
+      Count++;
+      OldIndex++;
+      continue;
+    }
+
+    if ((OldIndex == OldCount) || (New[NewIndex].Handle < Old[OldIndex].Handle)) {
+      Change[Count].Change = SmbiosStructureAdded;
+    } else {
+      OldIndex++;
+      if ((Old[OldIndex - 1].Size == New[NewIndex].Size) &&
+          (CompareMem (Old[OldIndex - 1].Digest, New[NewIndex].Digest, SMBIOS_STRUCTURE_DIGEST_SIZE) == 0))
+      {
+        NewIndex++;
+        continue;
+      }
+
+      Change[Count].Change = SmbiosStructureChanged;
+    }
+
+    Change[Count].Handle    = New[NewIndex].Handle;
+    Change[Count].Type      = New[NewIndex].Type;
+    Change[Count].Structure = Index->Structures[NewIndex];
+    Change[Count].Size      = New[NewIndex].Size;
+    Count++;
+    NewIndex++;
+  }
+
+  FreePool (Saved);
+
+  //
+  // The table digest differs, yet no structure does: the table was reordered.
+  // Report every structure so the receiver rebuilds the same order.
+  //
+  if (Count == 0) {
+    for (NewIndex = 0; NewIndex < NewCount; NewIndex++) {
+      Change[NewIndex].Change    = SmbiosStructureChanged;
+      Change[NewIndex].Handle    = New[NewIndex].Handle;
+      Change[NewIndex].Type      = New[NewIndex].Type;
+      Change[NewIndex].Structure = Index->Structures[NewIndex];
+      Change[NewIndex].Size      = New[NewIndex].Size;
+    }
+
+    Count = NewCount;
+  }
+
+  *Changes     = Change;
+  *ChangeCount = Count;
+  return EFI_SUCCESS;
+}
+
+/**
+  Save an index to its UEFI variable. Call it once the table is known to have
+  reached the BMC.
+
+  @param[in]  Index        The index to save.
+
+  @retval EFI_SUCCESS            The index is saved.
+  @retval EFI_INVALID_PARAMETER  Index is NULL.
+  @retval Others                 The status SetVariable() returned.
+**/
+EFI_STATUS
+EFIAPI
+SmbiosDigestIndexSave (
+  IN  SMBIOS_DIGEST_INDEX  *Index
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Index == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = gRT->SetVariable (
+                  Index->VariableName,
+                  &gManageabilityVariableGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  Index->HeaderSize,
+                  Index->Header
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failed to set UEFI Variable %s %r\n", __func__, Index->VariableName, Status));
+    //
+    // Do not leave an index behind that does not match the table on the BMC.
+    //
+    SmbiosDigestIndexInvalidate (Index);
+  }
+
+  return Status;
+}
+
+/**
+  Delete the index saved in the UEFI variable of an index, so the next
+  comparison reports the whole table as changed.
+
+  @param[in]  Index        The index.
+**/
+VOID
+EFIAPI
+SmbiosDigestIndexInvalidate (
+  IN  SMBIOS_DIGEST_INDEX  *Index
+  )
+{
+  EFI_STATUS  Status;
+
+  if (Index == NULL) {
+    return;
+  }
+
+  Status = gRT->SetVariable (
+                  Index->VariableName,
+                  &gManageabilityVariableGuid,
+                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
+                  0,
+                  NULL
+                  );
+  if (EFI_ERROR (Status) && (Status != EFI_NOT_FOUND)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failed to delete UEFI Variable %s %r\n", __func__, Index->VariableName, Status));
+  }
+}
+
+/**
+  Free an index built by SmbiosDigestIndexCreate().
+
+  @param[in]  Index        The index to free.
+**/
+VOID
+EFIAPI
+SmbiosDigestIndexFree (
+  IN  SMBIOS_DIGEST_INDEX  *Index
+  )
+{
+  if (Index == NULL) {
+    return;
+  }
+
+  if (Index->Header != NULL) {
+    FreePool (Index->Header);
+  }
+
+  if (Index->Structures != NULL) {
+    FreePool (Index->Structures);
+  }
+
+  FreePool (Index);
+}
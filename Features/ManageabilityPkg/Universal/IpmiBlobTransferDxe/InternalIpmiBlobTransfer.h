@@ -20,6 +20,11 @@
 
 #define PROTOCOL_RESPONSE_OVERHEAD  (4 * sizeof (UINT8))       // 1 byte completion code + 3 bytes OEN
 
+//
+// Initial CRC-16-CCITT value equivalent to 0xFFFF with two trailing zero bytes of data
+//
+#define CRC16_CCITT_INIT  0x1D0F
+
 // Subcommands for this protocol
 typedef enum {
   IpmiBlobTransferSubcommandGetCount = 0,
@@ -178,6 +183,15 @@ typedef struct {
 
   #pragma pack()
 
+//
+// IPMI messages are commonly limited to 255 bytes, 2 of which hold the NetFn/LUN and
+// the command. A BmcBlobWrite request adds the header, the CRC, the session ID and the
+// offset to its data, which leaves this much data per bulk write packet.
+//
+#define BLOB_MAX_IPMI_REQUEST_DATA_SIZE  253
+#define BLOB_MAX_BULK_DATA_PER_PACKET    (BLOB_MAX_IPMI_REQUEST_DATA_SIZE - sizeof (IPMI_BLOB_TRANSFER_HEADER) - \
+                                          sizeof (UINT16) - OFFSET_OF (IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA, Data))
+
 /**
   Calculate CRC-16-CCITT with poly of 0x1021
 
@@ -313,6 +327,35 @@ IpmiBlobTransferWrite (
   IN  UINT32  WriteLength
   );
 
+/**
+  This function writes a buffer of any size to a blob over the IPMI.
+
+  The buffer is split into as few BmcBlobWrite commands as possible: packets of up to
+  PcdIpmiBlobTransferMaxDataPerPacket bytes (at most BLOB_MAX_BULK_DATA_PER_PACKET)
+  are tried first. If the BMC rejects the length of one, or the transport fails to
+  deliver it, the packet is sent again in halves (down to BLOB_MAX_DATA_PER_PACKET).
+  Other errors are returned at once. When a full size packet needed smaller packets,
+  the smaller size that worked is kept for later calls.
+
+  @param[in]         SessionId       The session ID returned from a call to BlobOpen
+  @param[in]         Offset          The offset of the blob from which to start writing
+  @param[in]         Data            A pointer to the data to write
+  @param[in]         WriteLength     The length to write
+
+  @retval EFI_SUCCESS                Successfully wrote to the blob.
+  @retval EFI_INVALID_PARAMETER      Data is NULL, WriteLength is 0, or the write goes
+                                     past the largest blob offset.
+  @retval EFI_OUT_OF_RESOURCES       Memory allocation fails.
+  @retval Other                      An error occurred
+**/
+EFI_STATUS
+IpmiBlobTransferBulkWrite (
+  IN  UINT16  SessionId,
+  IN  UINT32  Offset,
+  IN  UINT8   *Data,
+  IN  UINT32  WriteLength
+  );
+
 /**
   This function commits data to a blob over the IPMI.
 
@@ -24,12 +24,63 @@ STATIC CONST EDKII_IPMI_BLOB_TRANSFER_PROTOCOL  mIpmiBlobTransfer = {
   (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_DELETE)*IpmiBlobTransferDelete,
   (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_STAT)*IpmiBlobTransferStat,
   (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_SESSION_STAT)*IpmiBlobTransferSessionStat,
-  (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_WRITE_META)*IpmiBlobTransferWriteMeta
+  (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_WRITE_META)*IpmiBlobTransferWriteMeta,
+  (EDKII_IPMI_BLOB_TRANSFER_PROTOCOL_BULK_WRITE)*IpmiBlobTransferBulkWrite
 };
 
+//
+// CRC-16-CCITT (poly 0x1021) lookup table, one entry per byte value.
+//
+STATIC CONST UINT16  mCrc16CcittTable[256] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+  0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+  0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+  0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+  0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+  0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+  0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+  0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+  0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+  0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+  0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+  0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+  0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+  0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+  0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+  0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+  0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+  0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+  0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+  0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+  0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+  0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+  0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+  0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+  0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+  0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+  0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+  0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+  0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+  0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+  0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+//
+// Size of the packets bulk writes are split into. It starts at PcdIpmiBlobTransferMaxDataPerPacket,
+// clamped to [BLOB_MAX_DATA_PER_PACKET, BLOB_MAX_BULK_DATA_PER_PACKET], and shrinks, down to
+// BLOB_MAX_DATA_PER_PACKET, when a packet of this size is rejected for its length or lost by
+// the transport, and the same data then goes through in smaller packets.
+//
+STATIC UINT32  mBulkWriteDataPerPacket = 0;
+
 /**
   Calculate CRC-16-CCITT with poly of 0x1021
 
+  The BMC expects the CRC of the data followed by two zero bytes, with an initial value
+  of 0xFFFF. This is the same as the CRC of the data alone with an initial value of
+  CRC16_CCITT_INIT, which a table-driven implementation can compute one byte at a time.
+
   @param[in]  Data              The target data.
   @param[in]  DataSize          The target data size.
 
@@ -42,28 +93,13 @@ CalculateCrc16Ccitt (
   IN UINTN  DataSize
   )
 {
-  UINTN    Index;
-  UINTN    BitIndex;
-  UINT16   Crc;
-  UINT16   Poly;
-  BOOLEAN  XorFlag;
-
-  Crc     = 0xFFFF;
-  Poly    = 0x1021;
-  XorFlag = FALSE;
-
-  for (Index = 0; Index < (DataSize + 2); ++Index) {
-    for (BitIndex = 0; BitIndex < 8; ++BitIndex) {
-      XorFlag = (Crc & 0x8000) ? TRUE : FALSE;
-      Crc   <<= 1;
-      if ((Index < DataSize) && (Data[Index] & (1 << (7 - BitIndex)))) {
-        Crc++;
-      }
+  UINTN   Index;
+  UINT16  Crc;
 
-      if (XorFlag == TRUE) {
-        Crc ^= Poly;
-      }
-    }
+  Crc = CRC16_CCITT_INIT;
+
+  for (Index = 0; Index < DataSize; ++Index) {
+    Crc = (UINT16)((Crc << 8) ^ mCrc16CcittTable[(UINT8)(Crc >> 8) ^ Data[Index]]);
   }
 
   DEBUG ((BLOB_TRANSFER_DEBUG, "%a: CRC-16-CCITT %x\n", __func__, Crc));
@@ -87,6 +123,7 @@ CalculateCrc16Ccitt (
   @retval EFI_SUCCESS            Successfully sends blob data.
   @retval EFI_OUT_OF_RESOURCES   Memory allocation fails.
   @retval EFI_PROTOCOL_ERROR     Communication errors.
+  @retval EFI_BAD_BUFFER_SIZE    The BMC rejected the length of the request.
   @retval EFI_CRC_ERROR          Data integrity checks fail.
   @retval Other                  An error occurred
 
@@ -147,7 +184,7 @@ IpmiBlobTransferSendIpmi (
   DEBUG_CODE_BEGIN ();
   DEBUG ((BLOB_TRANSFER_DEBUG, "%a: Inputs:\n", __func__));
   DEBUG ((BLOB_TRANSFER_DEBUG, "%a: SendDataSize: %02x\nData: ", __func__, SendDataSize));
-  UINT8  i;
+  UINTN  i;
 
   for (i = 0; i < SendDataSize; i++) {
     DEBUG ((BLOB_TRANSFER_DEBUG, "%02x", *((UINT8 *)SendData + i)));
@@ -190,7 +227,7 @@ IpmiBlobTransferSendIpmi (
   DEBUG_CODE_BEGIN ();
   DEBUG ((BLOB_TRANSFER_DEBUG, "%a: IPMI Response:\n", __func__));
   DEBUG ((BLOB_TRANSFER_DEBUG, "%a: ResponseDataSize: %02x\nData: ", __func__, IpmiResponseDataSize));
-  UINT8  i;
+  UINTN  i;
 
   for (i = 0; i < IpmiResponseDataSize; i++) {
     DEBUG ((BLOB_TRANSFER_DEBUG, "%02x", *(ModifiedResponseData + i)));
@@ -207,6 +244,13 @@ IpmiBlobTransferSendIpmi (
   if (CompletionCode != IPMI_COMP_CODE_NORMAL) {
     DEBUG ((DEBUG_ERROR, "%a: Returning because CompletionCode = 0x%x\n", __func__, CompletionCode));
     FreePool (IpmiResponseData);
+    if ((CompletionCode == IPMI_COMP_CODE_REQUEST_DATA_TRUNCATED) ||
+        (CompletionCode == IPMI_COMP_CODE_INVALID_REQUEST_DATA_LENGTH) ||
+        (CompletionCode == IPMI_COMP_CODE_REQUEST_EXCEED_LIMIT))
+    {
+      return EFI_BAD_BUFFER_SIZE;
+    }
+
     return EFI_PROTOCOL_ERROR;
   }
 
@@ -569,6 +613,124 @@ IpmiBlobTransferWrite (
   return Status;
 }
 
+/**
+  This function writes a buffer of any size to a blob over the IPMI.
+
+  The buffer is split into as few BmcBlobWrite commands as possible: packets of up to
+  PcdIpmiBlobTransferMaxDataPerPacket bytes (at most BLOB_MAX_BULK_DATA_PER_PACKET)
+  are tried first. If the BMC rejects the length of one, or the transport fails to
+  deliver it, the packet is sent again in halves (down to BLOB_MAX_DATA_PER_PACKET).
+  Other errors are returned at once. When a full size packet needed smaller packets,
+  the smaller size that worked is kept for later calls.
+
+  @param[in]         SessionId       The session ID returned from a call to BlobOpen
+  @param[in]         Offset          The offset of the blob from which to start writing
+  @param[in]         Data            A pointer to the data to write
+  @param[in]         WriteLength     The length to write
+
+  @retval EFI_SUCCESS                Successfully wrote to the blob.
+  @retval EFI_INVALID_PARAMETER      Data is NULL, WriteLength is 0, or the write goes
+                                     past the largest blob offset.
+  @retval EFI_OUT_OF_RESOURCES       Memory allocation fails.
+  @retval Other                      An error occurred
+**/
+EFI_STATUS
+IpmiBlobTransferBulkWrite (
+  IN  UINT16  SessionId,
+  IN  UINT32  Offset,
+  IN  UINT8   *Data,
+  IN  UINT32  WriteLength
+  )
+{
+  EFI_STATUS                               Status;
+  IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA  *SendData;
+  UINT32                                   DataPerPacket;
+  UINT32                                   FailedDataPerPacket;
+  UINT32                                   PacketLength;
+  UINT32                                   Written;
+  UINT32                                   ResponseDataSize;
+
+  if ((Data == NULL) || (WriteLength == 0) || (WriteLength - 1 > MAX_UINT32 - Offset)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (mBulkWriteDataPerPacket == 0) {
+    mBulkWriteDataPerPacket = PcdGet32 (PcdIpmiBlobTransferMaxDataPerPacket);
+    mBulkWriteDataPerPacket = MAX (mBulkWriteDataPerPacket, BLOB_MAX_DATA_PER_PACKET);
+    mBulkWriteDataPerPacket = (UINT32)MIN (mBulkWriteDataPerPacket, BLOB_MAX_BULK_DATA_PER_PACKET);
+  }
+
+  DataPerPacket = MIN (mBulkWriteDataPerPacket, WriteLength);
+
+  //
+  // One buffer, big enough for the largest packet, is reused for every packet
+  //
+  SendData = AllocatePool (OFFSET_OF (IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA, Data) + DataPerPacket);
+  if (SendData == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  SendData->SessionId = SessionId;
+  FailedDataPerPacket = 0;
+  Written             = 0;
+  Status              = EFI_SUCCESS;
+
+  while (Written < WriteLength) {
+    PacketLength     = MIN (DataPerPacket, WriteLength - Written);
+    SendData->Offset = Offset + Written;
+    CopyMem (SendData->Data, Data + Written, PacketLength);
+
+    ResponseDataSize = 0;
+    Status           = IpmiBlobTransferSendIpmi (
+                         IpmiBlobTransferSubcommandWrite,
+                         (UINT8 *)SendData,
+                         OFFSET_OF (IPMI_BLOB_TRANSFER_BLOB_WRITE_SEND_DATA, Data) + PacketLength,
+                         NULL,
+                         &ResponseDataSize
+                         );
+    if (EFI_ERROR (Status)) {
+      //
+      // Only a rejected length or a lost packet can be helped by smaller packets
+      //
+      if ((Status != EFI_BAD_BUFFER_SIZE) && (Status != EFI_DEVICE_ERROR) && (Status != EFI_TIMEOUT)) {
+        break;
+      }
+
+      if (PacketLength <= BLOB_MAX_DATA_PER_PACKET) {
+        break;
+      }
+
+      //
+      // Writes are idempotent, so the same offset can simply be written again with smaller packets
+      //
+      if (FailedDataPerPacket == 0) {
+        FailedDataPerPacket = PacketLength;
+      }
+
+      DataPerPacket = MAX (PacketLength / 2, BLOB_MAX_DATA_PER_PACKET);
+      DEBUG ((BLOB_TRANSFER_DEBUG, "%a: %r, retrying with %u byte packets\n", __func__, Status, DataPerPacket));
+      continue;
+    }
+
+    //
+    // Keep the smaller size only once it worked, and only if the size that failed was the
+    // one later writes would start with, not a short write or a size another call changed
+    //
+    if (FailedDataPerPacket != 0) {
+      if (FailedDataPerPacket == mBulkWriteDataPerPacket) {
+        mBulkWriteDataPerPacket = DataPerPacket;
+      }
+
+      FailedDataPerPacket = 0;
+    }
+
+    Written += PacketLength;
+  }
+
+  FreePool (SendData);
+  return Status;
+}
+
 /**
   This function commits data to a blob over the IPMI.
 
@@ -31,6 +31,12 @@ UINT8  InvalidCompletion[] = {
 };
 #define INVALID_COMPLETION_SIZE  4 * sizeof(UINT8)
 
+UINT8  LengthRejectedCompletion[] = {
+  0xC7,             // CompletionCode
+  0xCF, 0xC2, 0x00, // OpenBMC OEN
+};
+#define LENGTH_REJECTED_COMPLETION_SIZE  4 * sizeof(UINT8)
+
 UINT8  NoDataResponse[] = {
   0x00,             // CompletionCode
   0xCF, 0xC2, 0x00, // OpenBMC OEN
@@ -58,6 +64,11 @@ UINT8  ValidNoDataResponse[] = {
 
 #define VALID_NODATA_RESPONSE_SIZE  4 * sizeof(UINT8)
 
+//
+// Bulk write packet size with the default PcdIpmiBlobTransferMaxDataPerPacket
+//
+#define BULK_WRITE_DEFAULT_DATA_PER_PACKET  0xE0
+
 /**
   @param[in]  Context    [Optional] An optional parameter that enables:
                          1) test-case reuse with varied parameters and
@@ -663,6 +674,278 @@ WriteValidResponse (
   return UNIT_TEST_PASSED;
 }
 
+/**
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BulkWriteValidResponse (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       SendData[4]          = { 0x00, 0x01, 0x02, 0x03 };
+  VOID        *MockResponseResults = NULL;
+
+  MockResponseResults = (UINT8 *)AllocateZeroPool (VALID_NODATA_RESPONSE_SIZE);
+  CopyMem (MockResponseResults, &ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE);
+
+  Status = MockIpmiSubmitCommand ((UINT8 *)MockResponseResults, VALID_NODATA_RESPONSE_SIZE, EFI_SUCCESS);
+  if (EFI_ERROR (Status)) {
+    return UNIT_TEST_ERROR_TEST_FAILED;
+  }
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, SendData, 4);
+
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+  FreePool (MockResponseResults);
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BulkWriteInvalidParameter (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       SendData[4] = { 0x00, 0x01, 0x02, 0x03 };
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, NULL, 4);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_INVALID_PARAMETER);
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, SendData, 0);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_INVALID_PARAMETER);
+
+  // The last byte would be written past offset MAX_UINT32
+  Status = IpmiBlobTransferBulkWrite (0, MAX_UINT32 - 2, SendData, 4);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_INVALID_PARAMETER);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Runs after BulkWriteValidResponse, so bulk writes start with packets of
+  BULK_WRITE_DEFAULT_DATA_PER_PACKET bytes.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BulkWriteRetrySmallerPackets (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       SendData[2 * BULK_WRITE_DEFAULT_DATA_PER_PACKET];
+  UINTN       Index;
+
+  SetMem (SendData, sizeof (SendData), 0x5A);
+
+  //
+  // The length of the first packet is rejected, and the whole buffer goes out in 4 packets of half the size
+  //
+  Status = MockIpmiSubmitCommand (LengthRejectedCompletion, LENGTH_REJECTED_COMPLETION_SIZE, EFI_SUCCESS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  for (Index = 0; Index < 4; Index++) {
+    Status = MockIpmiSubmitCommand (ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE, EFI_SUCCESS);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, SendData, sizeof (SendData));
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+
+  //
+  // The smaller size is kept: the next write needs 2 packets and no retry
+  //
+  for (Index = 0; Index < 2; Index++) {
+    Status = MockIpmiSubmitCommand (ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE, EFI_SUCCESS);
+    UT_ASSERT_NOT_EFI_ERROR (Status);
+  }
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, SendData, BULK_WRITE_DEFAULT_DATA_PER_PACKET);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Runs after BulkWriteRetrySmallerPackets, so bulk writes start with packets of
+  BULK_WRITE_DEFAULT_DATA_PER_PACKET / 2 bytes.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BulkWriteRetryGivesUp (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       SendData[BULK_WRITE_DEFAULT_DATA_PER_PACKET];
+
+  SetMem (SendData, sizeof (SendData), 0xA5);
+
+  //
+  // Rejected at half the default size, then at BLOB_MAX_DATA_PER_PACKET, where it stops retrying
+  //
+  Status = MockIpmiSubmitCommand (LengthRejectedCompletion, LENGTH_REJECTED_COMPLETION_SIZE, EFI_SUCCESS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  Status = MockIpmiSubmitCommand (LengthRejectedCompletion, LENGTH_REJECTED_COMPLETION_SIZE, EFI_SUCCESS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, SendData, sizeof (SendData));
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_BAD_BUFFER_SIZE);
+
+  //
+  // No smaller size worked, so later writes still start at half the default size
+  //
+  Status = MockIpmiSubmitCommand (ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE, EFI_SUCCESS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, SendData, BULK_WRITE_DEFAULT_DATA_PER_PACKET / 2);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Runs after BulkWriteRetryGivesUp, so bulk writes start with packets of
+  BULK_WRITE_DEFAULT_DATA_PER_PACKET / 2 bytes.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BulkWriteNoRetryOnOtherErrors (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       SendData[BULK_WRITE_DEFAULT_DATA_PER_PACKET / 2];
+
+  SetMem (SendData, sizeof (SendData), 0x3C);
+
+  //
+  // An error that has nothing to do with the length is returned without a retry
+  //
+  Status = MockIpmiSubmitCommand (InvalidCompletion, INVALID_COMPLETION_SIZE, EFI_SUCCESS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, SendData, sizeof (SendData));
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_PROTOCOL_ERROR);
+
+  //
+  // The packet size is unchanged: the next write needs a single packet
+  //
+  Status = MockIpmiSubmitCommand (ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE, EFI_SUCCESS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, SendData, sizeof (SendData));
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+
+  return UNIT_TEST_PASSED;
+}
+
+/**
+  Runs after BulkWriteNoRetryOnOtherErrors, so bulk writes start with packets of
+  BULK_WRITE_DEFAULT_DATA_PER_PACKET / 2 bytes.
+
+  @param[in]  Context    [Optional] An optional parameter that enables:
+                         1) test-case reuse with varied parameters and
+                         2) test-case re-entry for Target tests that need a
+                         reboot.  This parameter is a VOID* and it is the
+                         responsibility of the test author to ensure that the
+                         contents are well understood by all test cases that may
+                         consume it.
+  @retval  UNIT_TEST_PASSED             The Unit test has completed and the test
+                                        case was successful.
+  @retval  UNIT_TEST_ERROR_TEST_FAILED  A test case assertion has failed.
+**/
+UNIT_TEST_STATUS
+EFIAPI
+BulkWriteShortRetryKeepsPacketSize (
+  IN UNIT_TEST_CONTEXT  Context
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       SendData[BULK_WRITE_DEFAULT_DATA_PER_PACKET / 2];
+
+  SetMem (SendData, sizeof (SendData), 0xC3);
+
+  //
+  // A write shorter than a packet is lost by the transport, then goes through in 2 smaller packets
+  //
+  Status = MockIpmiSubmitCommand (ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE, EFI_DEVICE_ERROR);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  Status = MockIpmiSubmitCommand (ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE, EFI_SUCCESS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+  Status = MockIpmiSubmitCommand (ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE, EFI_SUCCESS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, SendData, sizeof (SendData) - 1);
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+
+  //
+  // The failed size was not the packet size, so the next full size write needs a single packet
+  //
+  Status = MockIpmiSubmitCommand (ValidNoDataResponse, VALID_NODATA_RESPONSE_SIZE, EFI_SUCCESS);
+  UT_ASSERT_NOT_EFI_ERROR (Status);
+
+  Status = IpmiBlobTransferBulkWrite (0, 0, SendData, sizeof (SendData));
+  UT_ASSERT_STATUS_EQUAL (Status, EFI_SUCCESS);
+
+  return UNIT_TEST_PASSED;
+}
+
 /**
   @param[in]  Context    [Optional] An optional parameter that enables:
                          1) test-case reuse with varied parameters and
@@ -1066,6 +1349,13 @@ SetupAndRunUnitTests (
   Status = AddTestCase (IpmiBlobTransfer, "Read call with invalid buffer", "ReadInvalidBuffer", ReadInvalidBuffer, NULL, NULL, NULL);
   // IpmiBlobTransferWrite
   Status = AddTestCase (IpmiBlobTransfer, "Write call with valid data", "WriteValidResponse", WriteValidResponse, NULL, NULL, NULL);
+  // IpmiBlobTransferBulkWrite
+  Status = AddTestCase (IpmiBlobTransfer, "Bulk write call with valid data", "BulkWriteValidResponse", BulkWriteValidResponse, NULL, NULL, NULL);
+  Status = AddTestCase (IpmiBlobTransfer, "Bulk write call with invalid parameters", "BulkWriteInvalidParameter", BulkWriteInvalidParameter, NULL, NULL, NULL);
+  Status = AddTestCase (IpmiBlobTransfer, "Bulk write retries rejected packets with smaller ones", "BulkWriteRetrySmallerPackets", BulkWriteRetrySmallerPackets, NULL, NULL, NULL);
+  Status = AddTestCase (IpmiBlobTransfer, "Bulk write gives up at the smallest packet size", "BulkWriteRetryGivesUp", BulkWriteRetryGivesUp, NULL, NULL, NULL);
+  Status = AddTestCase (IpmiBlobTransfer, "Bulk write does not retry other errors", "BulkWriteNoRetryOnOtherErrors", BulkWriteNoRetryOnOtherErrors, NULL, NULL, NULL);
+  Status = AddTestCase (IpmiBlobTransfer, "Bulk write keeps the packet size after a short retry", "BulkWriteShortRetryKeepsPacketSize", BulkWriteShortRetryKeepsPacketSize, NULL, NULL, NULL);
   // IpmiBlobTransferCommit
   Status = AddTestCase (IpmiBlobTransfer, "Commit call with valid data", "CommitValidResponse", CommitValidResponse, NULL, NULL, NULL);
   // IpmiBlobTransferClose
@@ -14,9 +14,37 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiRuntimeServicesTableLib.h>
 #include <Library/IpmiCommandLib.h>
+#include <Protocol/IpmiSelCache.h>
 
 #include <Library/ManageabilityTransportHelperLib.h>
 
+//
+// The number of entries the SEL cache grows by.
+//
+#define IPMI_SEL_CACHE_GROW_COUNT  64
+
+//
+// The record ID that terminates the SEL, as the next record ID of the last
+// entry.
+//
+#define IPMI_SEL_END_OF_RECORDS  0xFFFF
+
+typedef struct {
+  UINT16                         RecordId;
+  IPMI_GET_SEL_ENTRY_RESPONSE    SelEntry;
+} IPMI_SEL_CACHE_ENTRY;
+
+//
+// The SEL, in the order the BMC returns the entries, and the SEL information
+// it was read with.
+//
+BOOLEAN                     mSelCacheValid;
+IPMI_GET_SEL_INFO_RESPONSE  mSelCacheInfo;
+IPMI_SEL_CACHE_ENTRY        *mSelCache;
+UINTN                       mSelCacheCount;
+UINTN                       mSelCacheCapacity;
+UINTN                       mSelCacheLastIndex;
+
 EFI_STATUS
 EFIAPI
 CheckIfSelIsFull (
@@ -139,6 +167,320 @@ SetElogRedirInstall (
   return EFI_SUCCESS;
 }
 
+/**
+  Read a SEL entry from the BMC.
+
+  @param[in]  RecordId     The record ID of the entry.
+  @param[out] SelEntry     Pointer to receive the entry.
+
+  @retval EFI_SUCCESS       The entry is returned.
+  @retval EFI_DEVICE_ERROR  The BMC failed the command.
+  @retval Others            See the return values of IpmiSubmitCommand ().
+**/
+EFI_STATUS
+SelReadEntry (
+  IN  UINT16                       RecordId,
+  OUT IPMI_GET_SEL_ENTRY_RESPONSE  *SelEntry
+  )
+{
+  EFI_STATUS                  Status;
+  IPMI_GET_SEL_ENTRY_REQUEST  GetSelEntryRequest;
+  UINT32                      ResponseDataSize;
+
+  ZeroMem (&GetSelEntryRequest, sizeof (GetSelEntryRequest));
+  GetSelEntryRequest.SelRecID[0] = (UINT8)RecordId;
+  GetSelEntryRequest.SelRecID[1] = (UINT8)(RecordId >> 8);
+  GetSelEntryRequest.Offset      = 0;
+  GetSelEntryRequest.BytesToRead = IPMI_COMPLETE_SEL_RECORD;
+  ResponseDataSize               = sizeof (IPMI_GET_SEL_ENTRY_RESPONSE);
+
+  Status = IpmiGetSelEntry (&GetSelEntryRequest, SelEntry, &ResponseDataSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (SelEntry->CompletionCode != IPMI_COMP_CODE_NORMAL) {
+    DEBUG ((DEBUG_ERROR, "%a: Get SEL entry 0x%04x fails - 0x%x\n", __func__, RecordId, SelEntry->CompletionCode));
+    return EFI_DEVICE_ERROR;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Append a SEL entry to the SEL cache.
+
+  @param[in]  SelEntry     The entry.
+
+  @retval EFI_SUCCESS           The entry is appended.
+  @retval EFI_OUT_OF_RESOURCES  Not enough memory to grow the SEL cache.
+**/
+EFI_STATUS
+SelCacheAppend (
+  IN  IPMI_GET_SEL_ENTRY_RESPONSE  *SelEntry
+  )
+{
+  IPMI_SEL_CACHE_ENTRY  *NewCache;
+
+  if (mSelCacheCount == mSelCacheCapacity) {
+    NewCache = ReallocatePool (
+                 mSelCacheCapacity * sizeof (IPMI_SEL_CACHE_ENTRY),
+                 (mSelCacheCapacity + IPMI_SEL_CACHE_GROW_COUNT) * sizeof (IPMI_SEL_CACHE_ENTRY),
+                 mSelCache
+                 );
+    if (NewCache == NULL) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+
+    mSelCache          = NewCache;
+    mSelCacheCapacity += IPMI_SEL_CACHE_GROW_COUNT;
+  }
+
+  //
+  // The record ID is the first field of the SEL record.
+  //
+  mSelCache[mSelCacheCount].RecordId = ReadUnaligned16 ((UINT16 *)&SelEntry->RecordData);
+  CopyMem (&mSelCache[mSelCacheCount].SelEntry, SelEntry, sizeof (IPMI_GET_SEL_ENTRY_RESPONSE));
+  mSelCacheCount++;
+  return EFI_SUCCESS;
+}
+
+/**
+  Read the SEL entries from the BMC, from an entry up to the last one, and
+  append them to the SEL cache.
+
+  @param[in]  RecordId     The record ID of the first entry to read.
+
+  @retval EFI_SUCCESS           The entries are appended.
+  @retval EFI_OUT_OF_RESOURCES  Not enough memory to grow the SEL cache.
+  @retval Others                See the return values of SelReadEntry ().
+**/
+EFI_STATUS
+SelCacheReadEntries (
+  IN  UINT16  RecordId
+  )
+{
+  EFI_STATUS                   Status;
+  IPMI_GET_SEL_ENTRY_RESPONSE  SelEntry;
+  UINTN                        Index;
+
+  //
+  // A SEL has at most 0xFFFE entries, this stops the walk on a BMC that
+  // never returns the end of records.
+  //
+  for (Index = 0; Index < IPMI_SEL_END_OF_RECORDS; Index++) {
+    Status = SelReadEntry (RecordId, &SelEntry);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    Status = SelCacheAppend (&SelEntry);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    RecordId = SelEntry.NextSelRecordId;
+    if (RecordId == IPMI_SEL_END_OF_RECORDS) {
+      return EFI_SUCCESS;
+    }
+  }
+
+  return EFI_DEVICE_ERROR;
+}
+
+/**
+  Bring the SEL cache up to date with the BMC.
+
+  The cache is still valid when the most recent addition and erase
+  timestamps of the SEL did not change. When only entries were added, the
+  new entries are read following the last cached one. Otherwise the whole
+  SEL is read again.
+
+  @retval EFI_SUCCESS           The SEL cache is up to date.
+  @retval EFI_DEVICE_ERROR      The BMC failed a command.
+  @retval EFI_OUT_OF_RESOURCES  Not enough memory to grow the SEL cache.
+  @retval Others                See the return values of IpmiSubmitCommand ().
+**/
+EFI_STATUS
+SelCacheRefresh (
+  VOID
+  )
+{
+  EFI_STATUS                   Status;
+  IPMI_GET_SEL_INFO_RESPONSE   SelInfo;
+  IPMI_GET_SEL_ENTRY_RESPONSE  SelEntry;
+
+  Status = IpmiGetSelInfo (&SelInfo);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (SelInfo.CompletionCode != IPMI_COMP_CODE_NORMAL) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (mSelCacheValid &&
+      (SelInfo.RecentAddTimeStamp == mSelCacheInfo.RecentAddTimeStamp) &&
+      (SelInfo.RecentEraseTimeStamp == mSelCacheInfo.RecentEraseTimeStamp) &&
+      (SelInfo.NoOfEntries == mSelCacheInfo.NoOfEntries))
+  {
+    return EFI_SUCCESS;
+  }
+
+  Status = EFI_NOT_FOUND;
+  if (mSelCacheValid &&
+      (SelInfo.RecentEraseTimeStamp == mSelCacheInfo.RecentEraseTimeStamp) &&
+      (SelInfo.NoOfEntries > mSelCacheCount) &&
+      (mSelCacheCount != 0))
+  {
+    //
+    // Nothing was erased, read the last cached entry again to find the
+    // entries added after it.
+    //
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: Read 0x%x new SEL entries\n", __func__, SelInfo.NoOfEntries - mSelCacheCount));
+    Status = SelReadEntry (mSelCache[mSelCacheCount - 1].RecordId, &SelEntry);
+    if (!EFI_ERROR (Status)) {
+      CopyMem (&mSelCache[mSelCacheCount - 1].SelEntry, &SelEntry, sizeof (IPMI_GET_SEL_ENTRY_RESPONSE));
+      if (SelEntry.NextSelRecordId != IPMI_SEL_END_OF_RECORDS) {
+        Status = SelCacheReadEntries (SelEntry.NextSelRecordId);
+      }
+    }
+
+    if (!EFI_ERROR (Status) && (mSelCacheCount != SelInfo.NoOfEntries)) {
+      Status = EFI_NOT_FOUND;
+    }
+  }
+
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: Read 0x%x SEL entries\n", __func__, SelInfo.NoOfEntries));
+    mSelCacheCount = 0;
+    Status         = EFI_SUCCESS;
+    if (SelInfo.NoOfEntries != 0) {
+      Status = SelCacheReadEntries (EDKII_IPMI_SEL_CACHE_FIRST_ENTRY);
+    }
+  }
+
+  mSelCacheLastIndex = 0;
+  mSelCacheValid     = !EFI_ERROR (Status);
+  CopyMem (&mSelCacheInfo, &SelInfo, sizeof (IPMI_GET_SEL_INFO_RESPONSE));
+  return Status;
+}
+
+/**
+  This service returns the SEL information, and brings the cached SEL up to
+  date with the BMC.
+
+  @param[in]  This                 EDKII_IPMI_SEL_CACHE_PROTOCOL instance.
+  @param[out] SelInfo              Pointer to receive the response of the IPMI
+                                   Get SEL Info command.
+
+  @retval     EFI_SUCCESS          The SEL information is returned.
+  @retval     EFI_INVALID_PARAMETER  SelInfo is NULL.
+  @retval     Others               See the return values of SelCacheRefresh ().
+**/
+EFI_STATUS
+EFIAPI
+SelCacheGetInfo (
+  IN  EDKII_IPMI_SEL_CACHE_PROTOCOL  *This,
+  OUT IPMI_GET_SEL_INFO_RESPONSE     *SelInfo
+  )
+{
+  EFI_STATUS  Status;
+
+  if (SelInfo == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = SelCacheRefresh ();
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  CopyMem (SelInfo, &mSelCacheInfo, sizeof (IPMI_GET_SEL_INFO_RESPONSE));
+  return EFI_SUCCESS;
+}
+
+/**
+  This service returns a SEL entry, as the IPMI Get SEL Entry command does.
+
+  @param[in]  This                 EDKII_IPMI_SEL_CACHE_PROTOCOL instance.
+  @param[in]  RecordId             The record ID of the entry, or
+                                   EDKII_IPMI_SEL_CACHE_FIRST_ENTRY or
+                                   EDKII_IPMI_SEL_CACHE_LAST_ENTRY.
+  @param[out] SelEntry             Pointer to receive the entry.
+
+  @retval     EFI_SUCCESS          The entry is returned.
+  @retval     EFI_NOT_FOUND        The SEL has no such entry.
+  @retval     EFI_INVALID_PARAMETER  SelEntry is NULL.
+  @retval     Others               See the return values of SelCacheRefresh ().
+**/
+EFI_STATUS
+EFIAPI
+SelCacheGetEntry (
+  IN  EDKII_IPMI_SEL_CACHE_PROTOCOL  *This,
+  IN  UINT16                         RecordId,
+  OUT IPMI_GET_SEL_ENTRY_RESPONSE    *SelEntry
+  )
+{
+  EFI_STATUS  Status;
+  UINTN       Index;
+
+  if (SelEntry == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!mSelCacheValid ||
+      (RecordId == EDKII_IPMI_SEL_CACHE_FIRST_ENTRY) ||
+      (RecordId == EDKII_IPMI_SEL_CACHE_LAST_ENTRY))
+  {
+    Status = SelCacheRefresh ();
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+  }
+
+  if (mSelCacheCount == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (RecordId == EDKII_IPMI_SEL_CACHE_FIRST_ENTRY) {
+    Index = 0;
+  } else if (RecordId == EDKII_IPMI_SEL_CACHE_LAST_ENTRY) {
+    Index = mSelCacheCount - 1;
+  } else if ((mSelCacheLastIndex + 1 < mSelCacheCount) &&
+             (mSelCache[mSelCacheLastIndex + 1].RecordId == RecordId))
+  {
+    //
+    // The consumers walk the SEL with the next record IDs.
+    //
+    Index = mSelCacheLastIndex + 1;
+  } else {
+    for (Index = 0; Index < mSelCacheCount; Index++) {
+      if (mSelCache[Index].RecordId == RecordId) {
+        break;
+      }
+    }
+
+    if (Index == mSelCacheCount) {
+      return EFI_NOT_FOUND;
+    }
+  }
+
+  mSelCacheLastIndex = Index;
+  CopyMem (SelEntry, &mSelCache[Index].SelEntry, sizeof (IPMI_GET_SEL_ENTRY_RESPONSE));
+  return EFI_SUCCESS;
+}
+
+EDKII_IPMI_SEL_CACHE_PROTOCOL_V1_0  mIpmiSelCacheV1_0 = {
+  SelCacheGetInfo,
+  SelCacheGetEntry
+};
+
+EDKII_IPMI_SEL_CACHE_PROTOCOL  mIpmiSelCache = {
+  EDKII_IPMI_SEL_CACHE_PROTOCOL_VERSION,
+  { &mIpmiSelCacheV1_0 }
+};
+
 /**
   Entry point of BmcElog DXE driver
 
@@ -159,7 +501,15 @@ InitializeBmcElogLayer (
 
   CheckIfSelIsFull ();
 
-  return EFI_SUCCESS;
+  //
+  // The SEL is read on the first request to the SEL cache.
+  //
+  return gBS->InstallMultipleProtocolInterfaces (
+                &ImageHandle,
+                &gEdkiiIpmiSelCacheProtocolGuid,
+                (VOID *)&mIpmiSelCache,
+                NULL
+                );
 }
 
 /**
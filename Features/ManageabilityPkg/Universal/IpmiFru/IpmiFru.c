@@ -1,17 +1,474 @@
 /** @file
   IPMI FRU Driver.
 
+  The driver caches the FRU inventory of the FRU devices and produces
+  EDKII_IPMI_FRU_CACHE_PROTOCOL, so the FRU data is read from the BMC only
+  once per boot.
+
 Copyright (c) 2018 - 2019, Intel Corporation. All rights reserved.<BR>
 SPDX-License-Identifier: BSD-2-Clause-Patent
 
 **/
 
 #include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/DebugLib.h>
 #include <Library/IpmiCommandLib.h>
+#include <Library/PcdLib.h>
 #include <IndustryStandard/Ipmi.h>
+#include <Protocol/IpmiFruCache.h>
+
+//
+// The number of FRU devices whose FRU inventory is cached.
+//
+#define IPMI_FRU_CACHE_MAX_DEVICES  8
+
+//
+// The smallest chunk, in bytes, the FRU inventory is read in.
+//
+#define IPMI_FRU_READ_MIN_CHUNK_SIZE  8
+
+//
+// Definitions of Platform Management FRU Information Storage Definition.
+//
+#define IPMI_FRU_COMMON_HEADER_SIZE          8
+#define IPMI_FRU_AREA_OFFSET_MULTIPLIER      8
+#define IPMI_FRU_MULTIRECORD_HEADER_SIZE     5
+#define IPMI_FRU_MULTIRECORD_END_OF_LIST     BIT7
+#define IPMI_FRU_INVENTORY_ACCESS_BY_WORDS   BIT0
+
+//
+// The completion codes of Read FRU Data command when the BMC can't return
+// as many bytes as requested.
+//
+#define IPMI_FRU_COMP_CODE_INVALID_REQUEST_DATA_LENGTH     0xC7
+#define IPMI_FRU_COMP_CODE_REQUEST_EXCEED_FIELD_LENGTH     0xC8
+#define IPMI_FRU_COMP_CODE_CANNOT_RETURN_REQ_NUM_OF_BYTES  0xCA
+
+typedef struct {
+  BOOLEAN    Valid;
+  UINT8      FruDeviceId;
+  ///
+  /// TRUE when the common header checksum is correct, so the areas can be
+  /// located.
+  ///
+  BOOLEAN    HeaderValid;
+  UINT8      *Data;
+  UINT32     Size;
+  UINT32     AreaOffset[IpmiFruAreaMaximum];
+  UINT32     AreaSize[IpmiFruAreaMaximum];
+} IPMI_FRU_CACHE_ENTRY;
+
+IPMI_FRU_CACHE_ENTRY  mFruCache[IPMI_FRU_CACHE_MAX_DEVICES];
+
+//
+// The size of the chunks the FRU inventory is read in. It is lowered when
+// the BMC rejects a chunk as too large, and kept for the later reads.
+//
+UINT8  mFruReadChunkSize = FixedPcdGet8 (PcdIpmiFruReadChunkSize);
+
+/**
+  Read the whole FRU inventory of a FRU device from the BMC.
+
+  @param[in]  FruDeviceId   The FRU device ID.
+  @param[out] Data          Pointer to receive the FRU inventory allocated
+                            from pool.
+  @param[out] Size          Pointer to receive the size of the FRU inventory.
+
+  @retval EFI_SUCCESS           The FRU inventory is returned.
+  @retval EFI_NOT_FOUND         The FRU device has no FRU inventory.
+  @retval EFI_OUT_OF_RESOURCES  Not enough memory for the FRU inventory.
+  @retval EFI_DEVICE_ERROR      The BMC failed the IPMI command.
+  @retval Others                See the return values of IpmiSubmitCommand ().
+**/
+EFI_STATUS
+FruReadInventory (
+  IN  UINT8   FruDeviceId,
+  OUT UINT8   **Data,
+  OUT UINT32  *Size
+  )
+{
+  EFI_STATUS                                 Status;
+  IPMI_GET_FRU_INVENTORY_AREA_INFO_REQUEST   GetFruInventoryAreaInfoRequest;
+  IPMI_GET_FRU_INVENTORY_AREA_INFO_RESPONSE  GetFruInventoryAreaInfoResponse;
+  IPMI_READ_FRU_DATA_REQUEST                 ReadFruDataRequest;
+  IPMI_READ_FRU_DATA_RESPONSE                *ReadFruDataResponse;
+  UINT8                                      ResponseBuffer[sizeof (IPMI_READ_FRU_DATA_RESPONSE) + MAX_UINT8 + 1];
+  UINT32                                     ResponseSize;
+  UINT32                                     InventorySize;
+  UINT32                                     AccessUnit;
+  UINT32                                     Offset;
+  UINT32                                     Count;
+  UINT8                                      *Inventory;
+
+  GetFruInventoryAreaInfoRequest.DeviceId = FruDeviceId;
+  Status                                  = IpmiGetFruInventoryAreaInfo (&GetFruInventoryAreaInfoRequest, &GetFruInventoryAreaInfoResponse);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (GetFruInventoryAreaInfoResponse.CompletionCode != IPMI_COMP_CODE_NORMAL) {
+    DEBUG ((DEBUG_ERROR, "%a: Get FRU Inventory Area Info of device 0x%x fails - 0x%x\n", __func__, FruDeviceId, GetFruInventoryAreaInfoResponse.CompletionCode));
+    return EFI_DEVICE_ERROR;
+  }
+
+  InventorySize = GetFruInventoryAreaInfoResponse.InventoryAreaSize;
+  if (InventorySize == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  AccessUnit = ((GetFruInventoryAreaInfoResponse.AccessType & IPMI_FRU_INVENTORY_ACCESS_BY_WORDS) != 0) ? 2 : 1;
+  Inventory  = AllocatePool (InventorySize);
+  if (Inventory == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ReadFruDataResponse = (IPMI_READ_FRU_DATA_RESPONSE *)ResponseBuffer;
+  Offset              = 0;
+  while (Offset < InventorySize) {
+    //
+    // Read the largest chunk the BMC accepts, in the access unit of the FRU
+    // device.
+    //
+    Count                              = MIN (InventorySize - Offset, mFruReadChunkSize);
+    ReadFruDataRequest.DeviceId        = FruDeviceId;
+    ReadFruDataRequest.InventoryOffset = (UINT16)(Offset / AccessUnit);
+    ReadFruDataRequest.CountToRead     = (UINT8)((Count + AccessUnit - 1) / AccessUnit);
+    ResponseSize                       = sizeof (IPMI_READ_FRU_DATA_RESPONSE) + ReadFruDataRequest.CountToRead * AccessUnit;
+    Status                             = IpmiReadFruData (&ReadFruDataRequest, ReadFruDataResponse, &ResponseSize);
+    if (!EFI_ERROR (Status) &&
+        (ReadFruDataResponse->CompletionCode == IPMI_COMP_CODE_NORMAL) &&
+        (ReadFruDataResponse->CountReturned != 0))
+    {
+      Count = MIN (ReadFruDataResponse->CountReturned * AccessUnit, InventorySize - Offset);
+      Count = MIN (Count, ResponseSize - sizeof (IPMI_READ_FRU_DATA_RESPONSE));
+      CopyMem (Inventory + Offset, ReadFruDataResponse->Data, Count);
+      Offset += Count;
+      continue;
+    }
+
+    //
+    // Retry with a smaller chunk when the BMC or the transport can't return
+    // that many bytes.
+    //
+    if ((EFI_ERROR (Status) ||
+         (ReadFruDataResponse->CompletionCode == IPMI_FRU_COMP_CODE_INVALID_REQUEST_DATA_LENGTH) ||
+         (ReadFruDataResponse->CompletionCode == IPMI_FRU_COMP_CODE_REQUEST_EXCEED_FIELD_LENGTH) ||
+         (ReadFruDataResponse->CompletionCode == IPMI_FRU_COMP_CODE_CANNOT_RETURN_REQ_NUM_OF_BYTES)) &&
+        (mFruReadChunkSize / 2 >= IPMI_FRU_READ_MIN_CHUNK_SIZE))
+    {
+      mFruReadChunkSize /= 2;
+      DEBUG ((DEBUG_INFO, "%a: Read FRU data in chunks of 0x%x bytes\n", __func__, mFruReadChunkSize));
+      continue;
+    }
+
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: Read FRU data of device 0x%x at 0x%x fails - %r, 0x%x\n",
+      __func__,
+      FruDeviceId,
+      Offset,
+      Status,
+      ReadFruDataResponse->CompletionCode
+      ));
+    FreePool (Inventory);
+    return EFI_ERROR (Status) ? Status : EFI_DEVICE_ERROR;
+  }
+
+  *Data = Inventory;
+  *Size = InventorySize;
+  return EFI_SUCCESS;
+}
+
+/**
+  Locate the areas of a cached FRU inventory from its common header.
+
+  @param[in, out] Entry     The cache entry.
+**/
+VOID
+FruParseInventory (
+  IN OUT IPMI_FRU_CACHE_ENTRY  *Entry
+  )
+{
+  UINT8   Checksum;
+  UINT32  Index;
+  UINT32  Area;
+  UINT32  Offset;
+  UINT32  End;
+
+  ZeroMem (Entry->AreaOffset, sizeof (Entry->AreaOffset));
+  ZeroMem (Entry->AreaSize, sizeof (Entry->AreaSize));
+  Entry->AreaOffset[IpmiFruAreaAll] = 0;
+  Entry->AreaSize[IpmiFruAreaAll]   = Entry->Size;
+  Entry->HeaderValid                = FALSE;
+
+  if (Entry->Size < IPMI_FRU_COMMON_HEADER_SIZE) {
+    return;
+  }
+
+  Checksum = CalculateSum8 (Entry->Data, IPMI_FRU_COMMON_HEADER_SIZE);
+  if (Checksum != 0) {
+    DEBUG ((DEBUG_ERROR, "%a: Invalid FRU common header checksum of device 0x%x\n", __func__, Entry->FruDeviceId));
+    return;
+  }
+
+  Entry->HeaderValid = TRUE;
+
+  //
+  // The starting offsets of the areas follow the format version in the
+  // common header, in the order of EDKII_IPMI_FRU_AREA_TYPE.
+  //
+  for (Area = IpmiFruAreaInternalUse; Area < IpmiFruAreaMaximum; Area++) {
+    Offset = Entry->Data[Area] * IPMI_FRU_AREA_OFFSET_MULTIPLIER;
+    if ((Offset == 0) || (Offset >= Entry->Size)) {
+      continue;
+    }
+
+    switch (Area) {
+      case IpmiFruAreaChassisInfo:
+      case IpmiFruAreaBoardInfo:
+      case IpmiFruAreaProductInfo:
+        //
+        // The second byte of the area is its length in multiples of 8 bytes.
+        //
+        if (Offset + 2 > Entry->Size) {
+          continue;
+        }
+
+        End = Offset + Entry->Data[Offset + 1] * IPMI_FRU_AREA_OFFSET_MULTIPLIER;
+        break;
+
+      case IpmiFruAreaMultiRecord:
+        End = Offset;
+        while (End + IPMI_FRU_MULTIRECORD_HEADER_SIZE <= Entry->Size) {
+          Index = End;
+          End  += IPMI_FRU_MULTIRECORD_HEADER_SIZE + Entry->Data[Index + 2];
+          if ((Entry->Data[Index + 1] & IPMI_FRU_MULTIRECORD_END_OF_LIST) != 0) {
+            break;
+          }
+        }
+
+        break;
+
+      default:
+        //
+        // The internal use area has no length, it ends where the next area
+        // starts.
+        //
+        End = Entry->Size;
+        for (Index = IpmiFruAreaChassisInfo; Index < IpmiFruAreaMaximum; Index++) {
+          if ((Entry->Data[Index] * IPMI_FRU_AREA_OFFSET_MULTIPLIER > Offset) &&
+              (Entry->Data[Index] * IPMI_FRU_AREA_OFFSET_MULTIPLIER < End))
+          {
+            End = Entry->Data[Index] * IPMI_FRU_AREA_OFFSET_MULTIPLIER;
+          }
+        }
+
+        break;
+    }
+
+    if ((End <= Offset) || (End > Entry->Size)) {
+      DEBUG ((DEBUG_ERROR, "%a: Invalid FRU area %d of device 0x%x\n", __func__, Area, Entry->FruDeviceId));
+      continue;
+    }
+
+    Entry->AreaOffset[Area] = Offset;
+    Entry->AreaSize[Area]   = End - Offset;
+  }
+}
+
+/**
+  Get the cache entry of a FRU device, reading its FRU inventory from the BMC
+  if it is not cached.
+
+  @param[in]  FruDeviceId   The FRU device ID.
+  @param[out] Entry         Pointer to receive the cache entry.
+
+  @retval EFI_SUCCESS           The cache entry is returned.
+  @retval EFI_OUT_OF_RESOURCES  Not enough memory, or too many FRU devices
+                                are cached.
+  @retval Others                See the return values of FruReadInventory ().
+**/
+EFI_STATUS
+FruCacheGetEntry (
+  IN  UINT8                 FruDeviceId,
+  OUT IPMI_FRU_CACHE_ENTRY  **Entry
+  )
+{
+  EFI_STATUS            Status;
+  UINTN                 Index;
+  IPMI_FRU_CACHE_ENTRY  *FreeEntry;
+
+  FreeEntry = NULL;
+  for (Index = 0; Index < IPMI_FRU_CACHE_MAX_DEVICES; Index++) {
+    if (!mFruCache[Index].Valid) {
+      if (FreeEntry == NULL) {
+        FreeEntry = &mFruCache[Index];
+      }
+    } else if (mFruCache[Index].FruDeviceId == FruDeviceId) {
+      *Entry = &mFruCache[Index];
+      return EFI_SUCCESS;
+    }
+  }
+
+  if (FreeEntry == NULL) {
+    DEBUG ((DEBUG_ERROR, "%a: No cache entry left for FRU device 0x%x\n", __func__, FruDeviceId));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Status = FruReadInventory (FruDeviceId, &FreeEntry->Data, &FreeEntry->Size);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  FreeEntry->FruDeviceId = FruDeviceId;
+  FreeEntry->Valid       = TRUE;
+  FruParseInventory (FreeEntry);
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: Cached 0x%x bytes of FRU device 0x%x\n",
+    __func__,
+    FreeEntry->Size,
+    FruDeviceId
+    ));
+
+  *Entry = FreeEntry;
+  return EFI_SUCCESS;
+}
+
+/**
+  This service returns an area of the FRU inventory of a FRU device.
+
+  @param[in]  This                 EDKII_IPMI_FRU_CACHE_PROTOCOL instance.
+  @param[in]  FruDeviceId          The FRU device ID.
+  @param[in]  AreaType             The area to return.
+  @param[out] Area                 Pointer to receive the area.
+  @param[out] AreaSize             Pointer to receive the size of the area in
+                                   bytes.
+
+  @retval     EFI_SUCCESS          The area is returned.
+  @retval     EFI_NOT_FOUND        The FRU inventory has no such area.
+  @retval     EFI_INVALID_PARAMETER  A parameter is NULL or AreaType is invalid.
+  @retval     EFI_VOLUME_CORRUPTED The common header of the FRU inventory is
+                                   invalid.
+  @retval     Others               See the return values of FruCacheGetEntry ().
+**/
+EFI_STATUS
+EFIAPI
+FruCacheGetArea (
+  IN  EDKII_IPMI_FRU_CACHE_PROTOCOL  *This,
+  IN  UINT8                          FruDeviceId,
+  IN  EDKII_IPMI_FRU_AREA_TYPE       AreaType,
+  OUT CONST UINT8                    **Area,
+  OUT UINT32                         *AreaSize
+  )
+{
+  EFI_STATUS            Status;
+  IPMI_FRU_CACHE_ENTRY  *Entry;
+
+  if ((Area == NULL) || (AreaSize == NULL) || ((UINT32)AreaType >= IpmiFruAreaMaximum)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = FruCacheGetEntry (FruDeviceId, &Entry);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if ((AreaType != IpmiFruAreaAll) && !Entry->HeaderValid) {
+    return EFI_VOLUME_CORRUPTED;
+  }
+
+  if (Entry->AreaSize[AreaType] == 0) {
+    return EFI_NOT_FOUND;
+  }
+
+  *Area     = Entry->Data + Entry->AreaOffset[AreaType];
+  *AreaSize = Entry->AreaSize[AreaType];
+  return EFI_SUCCESS;
+}
+
+/**
+  This service copies data of the FRU inventory of a FRU device.
+
+  @param[in]      This             EDKII_IPMI_FRU_CACHE_PROTOCOL instance.
+  @param[in]      FruDeviceId      The FRU device ID.
+  @param[in]      Offset           The offset in the FRU inventory, in bytes.
+  @param[in, out] Size             On input, the size of Buffer in bytes. On
+                                   output, the number of bytes copied.
+  @param[out]     Buffer           The buffer to receive the FRU data.
+
+  @retval     EFI_SUCCESS          The data is copied.
+  @retval     EFI_INVALID_PARAMETER  A parameter is NULL, or Offset is beyond
+                                   the end of the FRU inventory.
+  @retval     Others               See the return values of FruCacheGetEntry ().
+**/
+EFI_STATUS
+EFIAPI
+FruCacheRead (
+  IN     EDKII_IPMI_FRU_CACHE_PROTOCOL  *This,
+  IN     UINT8                          FruDeviceId,
+  IN     UINT32                         Offset,
+  IN OUT UINT32                         *Size,
+  OUT    VOID                           *Buffer
+  )
+{
+  EFI_STATUS            Status;
+  IPMI_FRU_CACHE_ENTRY  *Entry;
+
+  if ((Size == NULL) || ((Buffer == NULL) && (*Size != 0))) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = FruCacheGetEntry (FruDeviceId, &Entry);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  if (Offset >= Entry->Size) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  *Size = MIN (*Size, Entry->Size - Offset);
+  CopyMem (Buffer, Entry->Data + Offset, *Size);
+  return EFI_SUCCESS;
+}
+
+/**
+  This service drops the cached FRU inventory of a FRU device.
+
+  @param[in]  This                 EDKII_IPMI_FRU_CACHE_PROTOCOL instance.
+  @param[in]  FruDeviceId          The FRU device ID.
+**/
+VOID
+EFIAPI
+FruCacheInvalidate (
+  IN  EDKII_IPMI_FRU_CACHE_PROTOCOL  *This,
+  IN  UINT8                          FruDeviceId
+  )
+{
+  UINTN  Index;
+
+  for (Index = 0; Index < IPMI_FRU_CACHE_MAX_DEVICES; Index++) {
+    if (mFruCache[Index].Valid && (mFruCache[Index].FruDeviceId == FruDeviceId)) {
+      FreePool (mFruCache[Index].Data);
+      ZeroMem (&mFruCache[Index], sizeof (IPMI_FRU_CACHE_ENTRY));
+    }
+  }
+}
+
+EDKII_IPMI_FRU_CACHE_PROTOCOL_V1_0  mIpmiFruCacheV1_0 = {
+  FruCacheGetArea,
+  FruCacheRead,
+  FruCacheInvalidate
+};
+
+EDKII_IPMI_FRU_CACHE_PROTOCOL  mIpmiFruCache = {
+  EDKII_IPMI_FRU_CACHE_PROTOCOL_VERSION,
+  { &mIpmiFruCacheV1_0 }
+};
 
 /*++
 
@@ -36,10 +493,9 @@ InitializeFru (
   IN EFI_SYSTEM_TABLE  *SystemTable
   )
 {
-  EFI_STATUS                                 Status;
-  IPMI_GET_DEVICE_ID_RESPONSE                ControllerInfo;
-  IPMI_GET_FRU_INVENTORY_AREA_INFO_REQUEST   GetFruInventoryAreaInfoRequest;
-  IPMI_GET_FRU_INVENTORY_AREA_INFO_RESPONSE  GetFruInventoryAreaInfoResponse;
+  EFI_STATUS                   Status;
+  IPMI_GET_DEVICE_ID_RESPONSE  ControllerInfo;
+  IPMI_FRU_CACHE_ENTRY         *Entry;
 
   //
   //  Get all the SDR Records from BMC and retrieve the Record ID from the structure for future use.
@@ -53,15 +509,22 @@ InitializeFru (
   DEBUG ((DEBUG_ERROR, "!!! IpmiFru  FruInventorySupport %x\n", ControllerInfo.DeviceSupport.Bits.FruInventorySupport));
 
   if (ControllerInfo.DeviceSupport.Bits.FruInventorySupport) {
-    GetFruInventoryAreaInfoRequest.DeviceId = 0;
-    Status                                  = IpmiGetFruInventoryAreaInfo (&GetFruInventoryAreaInfoRequest, &GetFruInventoryAreaInfoResponse);
+    //
+    // Read the FRU inventory of the BMC in advance. If that fails, the
+    // protocol is still installed and reads it again on first use.
+    //
+    Status = FruCacheGetEntry (0, &Entry);
     if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "!!! IpmiFru  IpmiGetFruInventoryAreaInfo Status=%x\n", Status));
-      return Status;
+      DEBUG ((DEBUG_ERROR, "!!! IpmiFru  Read FRU inventory Status=%x\n", Status));
+    } else {
+      DEBUG ((DEBUG_ERROR, "!!! IpmiFru  InventoryAreaSize=%x\n", Entry->Size));
     }
-
-    DEBUG ((DEBUG_ERROR, "!!! IpmiFru  InventoryAreaSize=%x\n", GetFruInventoryAreaInfoResponse.InventoryAreaSize));
   }
 
-  return EFI_SUCCESS;
+  return gBS->InstallMultipleProtocolInterfaces (
+                &ImageHandle,
+                &gEdkiiIpmiFruCacheProtocolGuid,
+                (VOID *)&mIpmiFruCache,
+                NULL
+                );
 }
@@ -97,6 +97,8 @@ SetupIpmiTransportHardwareInformation (
   @param[in]         TransportToken     The transport interface.
   @param[in]         NetFunction        IPMI function.
   @param[in]         Command            IPMI command.
+  @param[in]         IpmiHeader         Caller's storage the IPMI header is built
+                                        in, so no memory is allocated for it.
   @param[out]        PacketHeader       The pointer to receive header of request.
   @param[out]        PacketHeaderSize   Pinter to receive packet header size in byte.
   @param[in, out]    PacketBody         The request body.
@@ -118,28 +120,23 @@ SetupIpmiTransportHardwareInformation (
 **/
 EFI_STATUS
 SetupIpmiRequestTransportPacket (
-  IN   MANAGEABILITY_TRANSPORT_TOKEN    *TransportToken,
-  IN   UINT8                            NetFunction,
-  IN   UINT8                            Command,
-  OUT  MANAGEABILITY_TRANSPORT_HEADER   *PacketHeader OPTIONAL,
-  OUT  UINT16                           *PacketHeaderSize,
-  IN OUT UINT8                          **PacketBody OPTIONAL,
-  IN OUT UINT32                         *PacketBodySize OPTIONAL,
-  OUT  MANAGEABILITY_TRANSPORT_TRAILER  *PacketTrailer OPTIONAL,
-  OUT  UINT16                           *PacketTrailerSize
+  IN     MANAGEABILITY_TRANSPORT_TOKEN        *TransportToken,
+  IN     UINT8                                NetFunction,
+  IN     UINT8                                Command,
+  IN     MANAGEABILITY_IPMI_TRANSPORT_HEADER  *IpmiHeader,
+  OUT    MANAGEABILITY_TRANSPORT_HEADER       *PacketHeader OPTIONAL,
+  OUT    UINT16                               *PacketHeaderSize,
+  IN OUT UINT8                                **PacketBody OPTIONAL,
+  IN OUT UINT32                               *PacketBodySize OPTIONAL,
+  OUT    MANAGEABILITY_TRANSPORT_TRAILER      *PacketTrailer OPTIONAL,
+  OUT    UINT16                               *PacketTrailerSize
   )
 {
-  MANAGEABILITY_IPMI_TRANSPORT_HEADER  *IpmiHeader;
-
   if (  CompareGuid (&gManageabilityTransportKcsGuid, TransportToken->Transport->ManageabilityTransportSpecification)
      || CompareGuid (&gManageabilityTransportSmbusI2cGuid, TransportToken->Transport->ManageabilityTransportSpecification)
      || CompareGuid (&gManageabilityTransportSerialGuid, TransportToken->Transport->ManageabilityTransportSpecification))
   {
-    IpmiHeader = AllocateZeroPool (sizeof (MANAGEABILITY_IPMI_TRANSPORT_HEADER));
-    if (IpmiHeader == NULL) {
-      return EFI_OUT_OF_RESOURCES;
-    }
-
+    ZeroMem (IpmiHeader, sizeof (MANAGEABILITY_IPMI_TRANSPORT_HEADER));
     *PacketHeaderSize   = 0;
     *PacketTrailerSize  = 0;
     IpmiHeader->Command = Command;
@@ -203,6 +200,7 @@ CommonIpmiSubmitCommand (
   UINT8                                      *ThisRequestData;
   UINT32                                     ThisRequestDataSize;
   MANAGEABILITY_TRANSFER_TOKEN               TransferToken;
+  MANAGEABILITY_IPMI_TRANSPORT_HEADER        IpmiHeader;
   MANAGEABILITY_TRANSPORT_HEADER             IpmiTransportHeader;
   MANAGEABILITY_TRANSPORT_TRAILER            IpmiTransportTrailer;
   MANAGEABILITY_TRANSPORT_ADDITIONAL_STATUS  TransportAdditionalStatus;
@@ -231,6 +229,7 @@ CommonIpmiSubmitCommand (
                            TransportToken,
                            NetFunction,
                            Command,
+                           &IpmiHeader,
                            &IpmiTransportHeader,
                            &HeaderSize,
                            &ThisRequestData,
@@ -270,10 +269,6 @@ CommonIpmiSubmitCommand (
                                                     &TransferToken
                                                     );
 
-  if (IpmiTransportHeader != NULL) {
-    FreePool ((VOID *)IpmiTransportHeader);
-  }
-
   if (IpmiTransportTrailer != NULL) {
     FreePool ((VOID *)IpmiTransportTrailer);
   }
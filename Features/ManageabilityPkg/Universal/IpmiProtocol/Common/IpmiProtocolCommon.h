@@ -11,6 +11,7 @@
 #define MANAGEABILITY_IPMI_COMMON_H_
 
 #include <IndustryStandard/IpmiKcs.h>
+#include <Library/ManageabilityTransportIpmiLib.h>
 #include <Library/ManageabilityTransportLib.h>
 
 ///
@@ -61,6 +62,8 @@ SetupIpmiTransportHardwareInformation (
   @param[in]         TransportToken     The transport interface.
   @param[in]         NetFunction        IPMI function.
   @param[in]         Command            IPMI command.
+  @param[in]         IpmiHeader         Caller's storage the IPMI header is built
+                                        in, so no memory is allocated for it.
   @param[out]        PacketHeader       The pointer to receive header of request.
   @param[out]        PacketHeaderSize   Pinter to receive packet header size in byte.
   @param[in, out]    PacketBody         The request body.
@@ -82,15 +85,16 @@ SetupIpmiTransportHardwareInformation (
 **/
 EFI_STATUS
 SetupIpmiRequestTransportPacket (
-  IN   MANAGEABILITY_TRANSPORT_TOKEN    *TransportToken,
-  IN   UINT8                            NetFunction,
-  IN   UINT8                            Command,
-  OUT  MANAGEABILITY_TRANSPORT_HEADER   *PacketHeader OPTIONAL,
-  OUT  UINT16                           *PacketHeaderSize,
-  IN OUT UINT8                          **PacketBody OPTIONAL,
-  IN OUT UINT32                         *PacketBodySize OPTIONAL,
-  OUT  MANAGEABILITY_TRANSPORT_TRAILER  *PacketTrailer OPTIONAL,
-  OUT  UINT16                           *PacketTrailerSize
+  IN     MANAGEABILITY_TRANSPORT_TOKEN        *TransportToken,
+  IN     UINT8                                NetFunction,
+  IN     UINT8                                Command,
+  IN     MANAGEABILITY_IPMI_TRANSPORT_HEADER  *IpmiHeader,
+  OUT    MANAGEABILITY_TRANSPORT_HEADER       *PacketHeader OPTIONAL,
+  OUT    UINT16                               *PacketHeaderSize,
+  IN OUT UINT8                                **PacketBody OPTIONAL,
+  IN OUT UINT32                               *PacketBodySize OPTIONAL,
+  OUT    MANAGEABILITY_TRANSPORT_TRAILER      *PacketTrailer OPTIONAL,
+  OUT    UINT16                               *PacketTrailerSize
   );
 
 /**
@@ -11,15 +11,14 @@
 
 #include <IndustryStandard/SmBios.h>
 
-#include <Library/BaseCryptLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/ReportStatusCodeLib.h>
+#include <Library/SmbiosDigestLib.h>
 #include <Library/TimerLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
-#include <Library/UefiRuntimeServicesTableLib.h>
 
 #include <Protocol/IpmiBlobTransfer.h>
 
@@ -29,88 +28,199 @@
 #define SMBIOS_EC_DESC_SMBIOS_TRANSFER_FAILED  "Failed to send SMBIOS tables to BMC"
 #define SMBIOS_IPMI_COMMIT_RETRY               10
 
+//
+// The SMBIOS delta blob (PcdBmcSmbiosDeltaBlobTransferId) holds a
+// SMBIOS_DELTA_BLOB_HEADER, followed by NumberOfRecords records. Each record
+// is a SMBIOS_DELTA_BLOB_RECORD followed by Size bytes of SMBIOS structure,
+// strings included. The BMC applies the records by handle to the table it got
+// from the last transfer, and replaces the entry point with the one in the
+// header.
+//
+#define SMBIOS_DELTA_BLOB_SIGNATURE  SIGNATURE_32 ('S', 'M', 'D', 'L')
+#define SMBIOS_DELTA_BLOB_VERSION    1
+#define SMBIOS_DELTA_RECORD_SET      0    // Add the structure, or replace the one with the same handle.
+#define SMBIOS_DELTA_RECORD_REMOVE   1    // Remove the structure with the handle, Size is 0.
+
+#pragma pack(1)
+typedef struct {
+  UINT32                          Signature;
+  UINT16                          Version;
+  UINT16                          NumberOfRecords;
+  SMBIOS_TABLE_3_0_ENTRY_POINT    EntryPoint;
+} SMBIOS_DELTA_BLOB_HEADER;
+
+typedef struct {
+  UINT16    Handle;
+  UINT8     Operation;
+  UINT8     Reserved;
+  UINT32    Size;
+} SMBIOS_DELTA_BLOB_RECORD;
+#pragma pack()
+
 /**
-  This function will calculate smbios hash, compares it with stored
-  hash, updates UEFI variable if smbios data changed and return status.
+  This function sends data to a blob of the BMC and commits it.
 
-  @param[in]  SmbiosData      The smbios data to detect if changed.
-  @param[in]  SmbiosDataSize  The smbios data size.
+  @param[in]  IpmiBlobTransfer  The IPMI Blob Transfer protocol.
+  @param[in]  BlobId            The ID of the blob.
+  @param[in]  Data              The data to send.
+  @param[in]  DataSize          The size of the data.
 
-  @retval TRUE  If smbios data changed, otherwise FALSE.
+  @retval EFI_SUCCESS      The data is sent and committed.
+  @retval EFI_UNSUPPORTED  The BMC does not provide the blob.
+  @retval Others           Failed to send or commit the data.
 **/
-BOOLEAN
-DetectSmbiosChange (
-  UINT8   *SmbiosData,
-  UINT32  SmbiosDataSize
+STATIC
+EFI_STATUS
+IpmiSmbiosTransferSendBlob (
+  IN EDKII_IPMI_BLOB_TRANSFER_PROTOCOL  *IpmiBlobTransfer,
+  IN CHAR8                              *BlobId,
+  IN UINT8                              *Data,
+  IN UINT32                             DataSize
   )
 {
-  BOOLEAN     DeleteVar;
-  BOOLEAN     Response;
-  UINT8       ComputedHashValue[SHA256_DIGEST_SIZE];
-  UINT8       StoredHashValue[SHA256_DIGEST_SIZE];
-  UINTN       StoredHashValueSize;
   EFI_STATUS  Status;
+  UINT16      SessionId;
+  UINTN       RetryIndex;
+  UINT16      BlobState;
 
-  DeleteVar = FALSE;
-  Response  = Sha256HashAll ((VOID *)SmbiosData, SmbiosDataSize, ComputedHashValue);
-
-  if (!Response) {
-    // Delete the SmbiosHash variable and continue with smbios transfer to BMC
-    Status = gRT->SetVariable (
-                    SMBIOS_HASH_VARIABLE,
-                    &gManageabilityVariableGuid,
-                    EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
-                    0,
-                    NULL
-                    );
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: Failed to delete UEFI Variable SmbiosHash %r\n", __func__, Status));
+  Status = IpmiBlobTransfer->BlobOpen (BlobId, BLOB_TRANSFER_STAT_OPEN_W, &SessionId);
+  if (EFI_ERROR (Status)) {
+    if (Status != EFI_UNSUPPORTED) {
+      DEBUG ((DEBUG_ERROR, "%a: Unable to open Blob with Id %a: %r\n", __func__, BlobId, Status));
     }
 
-    DeleteVar = TRUE;
-  } else {
-    StoredHashValueSize = SHA256_DIGEST_SIZE;
-    // Get the stored smbios data hash
-    Status = gRT->GetVariable (
-                    SMBIOS_HASH_VARIABLE,
-                    &gManageabilityVariableGuid,
-                    NULL,
-                    &StoredHashValueSize,
-                    (VOID *)StoredHashValue
-                    );
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_INFO, "%a: Failed to get UEFI Variable SmbiosHash %r\n", __func__, Status));
-    } else {
-      // Compare StoredHash with currently ComputedHash
-      if (StoredHashValueSize != SHA256_DIGEST_SIZE) {
-        DEBUG ((DEBUG_ERROR, "%a: Invalid Hash Size %u\n", __func__, StoredHashValueSize));
-      }
+    return Status;
+  }
+
+  Status = IpmiBlobTransfer->BlobBulkWrite (SessionId, 0, Data, DataSize);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failure writing to blob: %r\n", __func__, Status));
+    IpmiBlobTransfer->BlobClose (SessionId);
+    return Status;
+  }
+
+  Status = IpmiBlobTransfer->BlobCommit (SessionId, 0, NULL);
+  if (EFI_ERROR (Status)) {
+    // Poll the stat for the blob committed
+    for (RetryIndex = 0, BlobState = 0; RetryIndex < SMBIOS_IPMI_COMMIT_RETRY; RetryIndex++, BlobState = 0) {
+      Status = IpmiBlobTransfer->BlobSessionStat (SessionId, &BlobState, NULL, NULL, NULL);
+      if (!EFI_ERROR (Status)) {
+        if ((BlobState & BLOB_TRANSFER_STAT_COMMITTED) != 0) {
+          DEBUG ((DEBUG_INFO, "%a: Blob committed %r\n", __func__, Status));
+          break;
+        }
 
-      if (CompareMem (StoredHashValue, ComputedHashValue, SHA256_DIGEST_SIZE) == 0) {
-        DEBUG ((DEBUG_INFO, "%a: Same Keys , Hash values match\n", __func__));
-        return FALSE;
+        if ((BlobState & BLOB_TRANSFER_STAT_COMMIT_ERROR) != 0) {
+          DEBUG ((DEBUG_ERROR, "%a: Failure sending commit to blob: %r\n", __func__, Status));
+          break;
+        }
       }
+
+      MicroSecondDelay (200 * 1000); // 200ms
     }
-  }
 
-  if (!DeleteVar) {
-    //
-    // ComputedHashValue is valid
-    // store the computed hash and transfer smbios tables if smbios hash variable not found or hash mismatched.
-    //
-    Status = gRT->SetVariable (
-                    SMBIOS_HASH_VARIABLE,
-                    &gManageabilityVariableGuid,
-                    EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS,
-                    SHA256_DIGEST_SIZE,
-                    (VOID *)ComputedHashValue
-                    );
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: Failed to set UEFI Variable SmbiosHash %r\n", __func__, Status));
+    if ((BlobState & BLOB_TRANSFER_STAT_COMMITTED) == 0) {
+      DEBUG ((DEBUG_ERROR, "%a: Failure sending commit to blob: %r\n", __func__, Status));
+      IpmiBlobTransfer->BlobClose (SessionId);
+      return EFI_DEVICE_ERROR;
     }
   }
 
-  return TRUE;
+  Status = IpmiBlobTransfer->BlobClose (SessionId);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failure closing blob: %r\n", __func__, Status));
+  }
+
+  return Status;
+}
+
+/**
+  This function sends the SMBIOS structures that changed since the last
+  transfer to the SMBIOS delta blob of the BMC.
+
+  @param[in]  IpmiBlobTransfer  The IPMI Blob Transfer protocol.
+  @param[in]  EntryPoint        The entry point structure to send.
+  @param[in]  Changes           The changed structures.
+  @param[in]  ChangeCount       The number of changed structures.
+  @param[in]  FullSize          The size of the whole table transfer.
+
+  @retval EFI_SUCCESS       The changes are sent.
+  @retval EFI_UNSUPPORTED   No delta blob is configured or provided by the BMC,
+                            or the changes are not smaller than the whole table.
+  @retval Others            Failed to send the changes.
+**/
+STATIC
+EFI_STATUS
+IpmiSmbiosTransferSendDelta (
+  IN EDKII_IPMI_BLOB_TRANSFER_PROTOCOL  *IpmiBlobTransfer,
+  IN SMBIOS_TABLE_3_0_ENTRY_POINT       *EntryPoint,
+  IN SMBIOS_STRUCTURE_CHANGE            *Changes,
+  IN UINTN                              ChangeCount,
+  IN UINT32                             FullSize
+  )
+{
+  EFI_STATUS                Status;
+  CHAR8                     *BlobId;
+  UINT8                     *Delta;
+  UINTN                     DeltaSize;
+  SMBIOS_DELTA_BLOB_HEADER  *Header;
+  SMBIOS_DELTA_BLOB_RECORD  *Record;
+  UINTN                     Index;
+
+  BlobId = (CHAR8 *)PcdGetPtr (PcdBmcSmbiosDeltaBlobTransferId);
+  if ((BlobId == NULL) || (*BlobId == '\0') || (ChangeCount > MAX_UINT16)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  DeltaSize = sizeof (SMBIOS_DELTA_BLOB_HEADER);
+  for (Index = 0; Index < ChangeCount; Index++) {
+    DeltaSize += sizeof (SMBIOS_DELTA_BLOB_RECORD) + Changes[Index].Size;
+  }
+
+  if (DeltaSize >= FullSize) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Delta = AllocateZeroPool (DeltaSize);
+  if (Delta == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Header                  = (SMBIOS_DELTA_BLOB_HEADER *)Delta;
+  Header->Signature       = SMBIOS_DELTA_BLOB_SIGNATURE;
+  Header->Version         = SMBIOS_DELTA_BLOB_VERSION;
+  Header->NumberOfRecords = (UINT16)ChangeCount;
+  CopyMem (&Header->EntryPoint, EntryPoint, sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT));
+
+  Record = (SMBIOS_DELTA_BLOB_RECORD *)(Header + 1);
+  for (Index = 0; Index < ChangeCount; Index++) {
+    DEBUG ((
+      SMBIOS_TRANSFER_DEBUG,
+      "%a: SMBIOS type %d handle 0x%04x %a\n",
+      __func__,
+      Changes[Index].Type,
+      Changes[Index].Handle,
+      (Changes[Index].Change == SmbiosStructureRemoved) ? "removed" : "updated"
+      ));
+    Record->Handle    = Changes[Index].Handle;
+    Record->Operation = (Changes[Index].Change == SmbiosStructureRemoved) ?
+                        SMBIOS_DELTA_RECORD_REMOVE : SMBIOS_DELTA_RECORD_SET;
+    Record->Size = Changes[Index].Size;
+    CopyMem (Record + 1, Changes[Index].Structure, Changes[Index].Size);
+    Record = (SMBIOS_DELTA_BLOB_RECORD *)((UINT8 *)(Record + 1) + Changes[Index].Size);
+  }
+
+  DEBUG ((
+    DEBUG_INFO,
+    "%a: Send %d changed SMBIOS structures, %d bytes instead of %d\n",
+    __func__,
+    ChangeCount,
+    DeltaSize,
+    FullSize
+    ));
+  Status = IpmiSmbiosTransferSendBlob (IpmiBlobTransfer, BlobId, Delta, (UINT32)DeltaSize);
+  FreePool (Delta);
+  return Status;
 }
 
 /**
@@ -131,13 +241,11 @@ IpmiSmbiosTransferSendTables (
   SMBIOS_TABLE_3_0_ENTRY_POINT       *Smbios30TableModified;
   EDKII_IPMI_BLOB_TRANSFER_PROTOCOL  *IpmiBlobTransfer;
   UINT16                             Index;
-  UINT16                             SessionId;
   UINT8                              *SendData;
   UINT32                             SendDataSize;
-  UINT32                             RemainingDataSize;
-  BOOLEAN                            SmbiosTransferRequired;
-  UINTN                              RetryIndex;
-  UINT16                             BlobState;
+  SMBIOS_DIGEST_INDEX                *DigestIndex;
+  SMBIOS_STRUCTURE_CHANGE            *Changes;
+  UINTN                              ChangeCount;
 
   gBS->CloseEvent (Event);
 
@@ -147,9 +255,8 @@ IpmiSmbiosTransferSendTables (
     goto ErrorExit;
   }
 
-  SmbiosTransferRequired = TRUE;
-  Smbios30Table          = NULL;
-  Status                 = EfiGetSystemConfigurationTable (&gEfiSmbios3TableGuid, (VOID **)&Smbios30Table);
+  Smbios30Table = NULL;
+  Status        = EfiGetSystemConfigurationTable (&gEfiSmbios3TableGuid, (VOID **)&Smbios30Table);
   if (EFI_ERROR (Status) || (Smbios30Table == NULL)) {
     DEBUG ((DEBUG_ERROR, "%a: No SMBIOS Table found: %r\n", __func__, Status));
     REPORT_STATUS_CODE_WITH_EXTENDED_DATA (
@@ -167,6 +274,21 @@ IpmiSmbiosTransferSendTables (
   // So we will save off that value and then modify the entry point to make the BMC happy
   //
   Smbios30TableModified = AllocateZeroPool (sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT));
+  SendDataSize          = sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT) + Smbios30Table->TableMaximumSize;
+  SendData              = AllocateZeroPool (SendDataSize);
+  if ((Smbios30TableModified == NULL) || (SendData == NULL)) {
+    DEBUG ((DEBUG_ERROR, "%a: Not enough memory for the SMBIOS tables\n", __func__));
+    if (Smbios30TableModified != NULL) {
+      FreePool (Smbios30TableModified);
+    }
+
+    if (SendData != NULL) {
+      FreePool (SendData);
+    }
+
+    goto ErrorExit;
+  }
+
   CopyMem (Smbios30TableModified, Smbios30Table, sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT));
   Smbios30TableModified->TableAddress = sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT);
   //
@@ -176,18 +298,44 @@ IpmiSmbiosTransferSendTables (
   Smbios30TableModified->EntryPointStructureChecksum =
     CalculateCheckSum8 ((UINT8 *)Smbios30TableModified, Smbios30TableModified->EntryPointLength);
 
-  SendData = AllocateZeroPool (sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT) + Smbios30Table->TableMaximumSize);
   CopyMem (SendData, Smbios30TableModified, sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT));
   CopyMem (SendData + sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT), (UINT8 *)Smbios30Table->TableAddress, Smbios30Table->TableMaximumSize);
-  SendDataSize      = sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT) + Smbios30Table->TableMaximumSize;
-  RemainingDataSize = SendDataSize;
 
+  //
+  // Find the SMBIOS structures that changed since the last successful transfer.
+  // Without a saved digest index, or when nothing can be compared, the whole
+  // table is sent.
+  //
+  DigestIndex = NULL;
+  Changes     = NULL;
+  ChangeCount = 0;
+  Status      = EFI_NOT_FOUND;
   if (PcdGetBool (PcdSendSmbiosOnChanged)) {
-    SmbiosTransferRequired = DetectSmbiosChange (SendData, SendDataSize);
+    Status = SmbiosDigestIndexCreate (
+               SMBIOS_HASH_VARIABLE,
+               SendData + sizeof (SMBIOS_TABLE_3_0_ENTRY_POINT),
+               Smbios30Table->TableMaximumSize,
+               &DigestIndex
+               );
+    if (!EFI_ERROR (Status)) {
+      Status = SmbiosDigestIndexCompare (DigestIndex, &Changes, &ChangeCount);
+    }
 
-    if (!SmbiosTransferRequired) {
+    if (!EFI_ERROR (Status) && (ChangeCount == 0)) {
       DEBUG ((DEBUG_INFO, "%a: Smbios tables are not changed, skipping transfer to BMC\n", __func__));
-      return;
+      goto Exit;
+    }
+  }
+
+  if (!EFI_ERROR (Status)) {
+    Status = IpmiSmbiosTransferSendDelta (IpmiBlobTransfer, Smbios30TableModified, Changes, ChangeCount, SendDataSize);
+    if (!EFI_ERROR (Status)) {
+      SmbiosDigestIndexSave (DigestIndex);
+      goto Exit;
+    }
+
+    if (Status != EFI_UNSUPPORTED) {
+      DEBUG ((DEBUG_ERROR, "%a: Failed to send SMBIOS changes, send the whole table: %r\n", __func__, Status));
     }
   }
 
@@ -206,70 +354,31 @@ IpmiSmbiosTransferSendTables (
   DEBUG ((SMBIOS_TRANSFER_DEBUG, "\n"));
   DEBUG_CODE_END ();
 
-  Status = IpmiBlobTransfer->BlobOpen ((CHAR8 *)PcdGetPtr (PcdBmcSmbiosBlobTransferId), BLOB_TRANSFER_STAT_OPEN_W, &SessionId);
-  if (EFI_ERROR (Status)) {
-    if (Status == EFI_UNSUPPORTED) {
-      return;
-    }
-
-    DEBUG ((DEBUG_ERROR, "%a: Unable to open Blob with Id %a: %r\n", __func__, PcdGetPtr (PcdBmcSmbiosBlobTransferId), Status));
-    goto ErrorExit;
-  }
-
-  for (Index = 0; Index < (SendDataSize / BLOB_MAX_DATA_PER_PACKET); Index++) {
-    Status = IpmiBlobTransfer->BlobWrite (SessionId, Index * BLOB_MAX_DATA_PER_PACKET, SendData, BLOB_MAX_DATA_PER_PACKET);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: Failure writing to blob: %r\n", __func__, Status));
-      goto ErrorExit;
-    }
-
-    SendData           = (UINT8 *)SendData + BLOB_MAX_DATA_PER_PACKET;
-    RemainingDataSize -= BLOB_MAX_DATA_PER_PACKET;
-  }
-
-  ASSERT (RemainingDataSize < BLOB_MAX_DATA_PER_PACKET);
-  if (RemainingDataSize) {
-    Status = IpmiBlobTransfer->BlobWrite (SessionId, Index * BLOB_MAX_DATA_PER_PACKET, SendData, RemainingDataSize);
+  Status = IpmiSmbiosTransferSendBlob (IpmiBlobTransfer, (CHAR8 *)PcdGetPtr (PcdBmcSmbiosBlobTransferId), SendData, SendDataSize);
+  if (DigestIndex != NULL) {
+    //
+    // The table on the BMC is unknown after a failed transfer, make sure the
+    // next boot sends the whole table again.
+    //
     if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "%a: Failure writing final block to blob: %r\n", __func__, Status));
-      goto ErrorExit;
+      SmbiosDigestIndexInvalidate (DigestIndex);
+    } else {
+      SmbiosDigestIndexSave (DigestIndex);
     }
   }
 
-  Status = IpmiBlobTransfer->BlobCommit (SessionId, 0, NULL);
-  if (EFI_ERROR (Status)) {
-    // Poll the stat for the blob committed
-    for (RetryIndex = 0, BlobState = 0; RetryIndex < SMBIOS_IPMI_COMMIT_RETRY; RetryIndex++, BlobState = 0) {
-      Status = IpmiBlobTransfer->BlobSessionStat (SessionId, &BlobState, NULL, NULL, NULL);
-      if (!EFI_ERROR (Status)) {
-        if ((BlobState & BLOB_TRANSFER_STAT_COMMITTED) != 0) {
-          DEBUG ((DEBUG_INFO, "%a: Blob committed %r\n", __func__));
-          break;
-        }
-
-        if ((BlobState & BLOB_TRANSFER_STAT_COMMIT_ERROR) != 0) {
-          DEBUG ((DEBUG_ERROR, "%a: Failure sending commit to blob: %r\n", __func__, Status));
-          break;
-        }
-      }
-
-      MicroSecondDelay (200 * 1000); // 200ms
-    }
-
-    if ((BlobState & BLOB_TRANSFER_STAT_COMMITTED) == 0) {
-      DEBUG ((DEBUG_ERROR, "%a: Failure sending commit to blob: %r\n", __func__, Status));
-      goto ErrorExit;
-    }
+Exit:
+  if (Changes != NULL) {
+    FreePool (Changes);
   }
 
-  Status = IpmiBlobTransfer->BlobClose (SessionId);
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: Sent SMBIOS Tables to BMC: %r\n", __func__, Status));
-    goto ErrorExit;
+  SmbiosDigestIndexFree (DigestIndex);
+  FreePool (SendData);
+  FreePool (Smbios30TableModified);
+  if ((Status == EFI_UNSUPPORTED) || !EFI_ERROR (Status)) {
+    return;
   }
 
-  return;
-
 ErrorExit:
   REPORT_STATUS_CODE_WITH_EXTENDED_DATA (
     EFI_ERROR_CODE | EFI_ERROR_MAJOR,
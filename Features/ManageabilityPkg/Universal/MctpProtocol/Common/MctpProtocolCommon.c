@@ -18,13 +18,101 @@
 
 #include "MctpProtocolCommon.h"
 
-extern CHAR16  *mTransportName;
-extern UINT32  mTransportMaximumPayload;
+extern CHAR16                              *mTransportName;
+extern UINT32                              mTransportMaximumPayload;
+extern MANAGEABILITY_TRANSPORT_CAPABILITY  mTransportCapability;
 
 MANAGEABILITY_TRANSPORT_HARDWARE_INFORMATION  mHardwareInformation;
 UINT8                                         mMctpPacketSequence;
 BOOLEAN                                       mStartOfMessage;
 BOOLEAN                                       mEndOfMessage;
+UINT8                                         mMctpMessageTag;
+UINT8                                         mMctpOutstandingTags;
+
+//
+// The headers and trailer of the packet being sent. Only one packet is sent
+// at a time.
+//
+MANAGEABILITY_MCTP_KCS_HEADER   mMctpKcsHeader;
+MANAGEABILITY_MCTP_KCS_TRAILER  mMctpKcsTrailer;
+MCTP_PACKET_HEADER              mMctpPacketHeader;
+MANAGEABILITY_TRANSMIT_SEGMENT  mMctpTransmitSegments[2];
+
+UINT8                      mMctpBufferPoolStorage[MCTP_BUFFER_POOL_BUFFER_COUNT][MCTP_BUFFER_POOL_BUFFER_SIZE];
+MANAGEABILITY_BUFFER_POOL  mMctpBufferPool = MANAGEABILITY_BUFFER_POOL_INIT (
+                                               mMctpBufferPoolStorage,
+                                               MCTP_BUFFER_POOL_BUFFER_SIZE,
+                                               MCTP_BUFFER_POOL_BUFFER_COUNT
+                                               );
+
+/**
+  This function allocates the MCTP message tag of a new request.
+
+  A tag stays outstanding until the response carrying it is received, so
+  that a late response to a request that failed (e.g. timed out) is never
+  taken for the response to a later request.
+
+  @retval  The message tag allocated.
+**/
+UINT8
+MctpAllocateMessageTag (
+  VOID
+  )
+{
+  UINT8  Index;
+  UINT8  Tag;
+
+  if (mMctpOutstandingTags == (UINT8)((1 << MCTP_MESSAGE_TAG_COUNT) - 1)) {
+    //
+    // The responses to all of the previous requests were lost,
+    // they will never come.
+    //
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: All MCTP message tags are outstanding, reclaim them.\n", __func__));
+    mMctpOutstandingTags = 0;
+  }
+
+  Tag = mMctpMessageTag;
+  for (Index = 1; Index <= MCTP_MESSAGE_TAG_COUNT; Index++) {
+    Tag = (mMctpMessageTag + Index) % MCTP_MESSAGE_TAG_COUNT;
+    if ((mMctpOutstandingTags & (1 << Tag)) == 0) {
+      break;
+    }
+  }
+
+  mMctpMessageTag       = Tag;
+  mMctpOutstandingTags |= (UINT8)(1 << Tag);
+  return Tag;
+}
+
+/**
+  This function checks whether a received MCTP message is the late response
+  to an earlier request, rather than the response to the current one. The tag
+  of a late response is released.
+
+  @param[in]  MctpTransportHeader  MCTP transport header of the received message.
+
+  @retval     TRUE                 The message is a late response, discard it.
+  @retval     FALSE                The message is for the current request or
+                                   unexpected.
+**/
+BOOLEAN
+MctpIsLateResponse (
+  IN  MCTP_TRANSPORT_HEADER  *MctpTransportHeader
+  )
+{
+  UINT8  Tag;
+
+  Tag = (UINT8)MctpTransportHeader->Bits.MessageTag;
+  if ((MctpTransportHeader->Bits.TagOwner != MCTP_MESSAGE_TAG_OWNER_RESPONSE) ||
+      (Tag == mMctpMessageTag) ||
+      ((mMctpOutstandingTags & (1 << Tag)) == 0))
+  {
+    return FALSE;
+  }
+
+  mMctpOutstandingTags &= (UINT8)~(1 << Tag);
+  return TRUE;
+}
 
 /**
   This functions setup the MCTP transport hardware information according
@@ -84,29 +172,27 @@ SetupMctpTransportHardwareInformation (
 }
 
 /**
-  This functions setup the final header/body/trailer packets for
+  This functions setup the transfer token of a packet of MCTP message for
   the acquired transport interface.
 
+  The transport header, the MCTP headers and the transport trailer are built
+  in module variables, and the packet body is sent from the caller's buffer
+  as a scatter-gather segment. If the transport interface doesn't support
+  scatter-gather, the MCTP headers and the packet body are gathered in a
+  buffer of the MCTP buffer pool instead.
+
   @param[in]         TransportToken             The transport interface.
   @param[in]         MctpType                   MCTP message type.
   @param[in]         MctpSourceEndpointId       MCTP source endpoint ID.
   @param[in]         MctpDestinationEndpointId  MCTP source endpoint ID.
   @param[in]         RequestDataIntegrityCheck  Indicates whether MCTP message has
                                                 integrity check byte.
-  @param[out]        PacketHeader               The pointer to receive header of request.
-  @param[out]        PacketHeaderSize           Packet header size.
-  @param[in, out]    PacketBody                 The request body.
-                                                When IN, it is the caller's request body.
-                                                When OUT and NULL, the request body is not
-                                                changed.
-                                                Whee out and non-NULL, the request body is
-                                                changed to comfort the transport interface.
-  @param[in, out]    PacketBodySize             The request body size.
-                                                When IN and non-zero, it is the new data
-                                                length of request body.
-                                                When IN and zero, the request body is unchanged.
-  @param[out]        PacketTrailer              The pointer to receive trailer of request.
-  @param[out]        PacketTrailerSize          Packet trailer size.
+  @param[in]         PacketBody                 The message data carried by the packet.
+  @param[in]         PacketBodySize             Size of PacketBody in byte.
+  @param[in, out]    TransferToken              The transfer token whose transmit
+                                                fields are set up. Call
+                                                ReleaseMctpRequestTransportPacket()
+                                                once the packet is transmitted.
 
   @retval EFI_SUCCESS            Request packet is returned.
   @retval EFI_OUT_OF_RESOURCE    Not enough resource to create the request
@@ -116,98 +202,118 @@ SetupMctpTransportHardwareInformation (
 **/
 EFI_STATUS
 SetupMctpRequestTransportPacket (
-  IN   MANAGEABILITY_TRANSPORT_TOKEN    *TransportToken,
-  IN   UINT8                            MctpType,
-  IN   UINT8                            MctpSourceEndpointId,
-  IN   UINT8                            MctpDestinationEndpointId,
-  IN   BOOLEAN                          RequestDataIntegrityCheck,
-  OUT  MANAGEABILITY_TRANSPORT_HEADER   *PacketHeader,
-  OUT  UINT16                           *PacketHeaderSize,
-  IN   OUT UINT8                        **PacketBody,
-  IN   OUT UINT32                       *PacketBodySize,
-  OUT  MANAGEABILITY_TRANSPORT_TRAILER  *PacketTrailer,
-  OUT  UINT16                           *PacketTrailerSize
+  IN     MANAGEABILITY_TRANSPORT_TOKEN  *TransportToken,
+  IN     UINT8                          MctpType,
+  IN     UINT8                          MctpSourceEndpointId,
+  IN     UINT8                          MctpDestinationEndpointId,
+  IN     BOOLEAN                        RequestDataIntegrityCheck,
+  IN     UINT8                          *PacketBody,
+  IN     UINT32                         PacketBodySize,
+  IN OUT MANAGEABILITY_TRANSFER_TOKEN   *TransferToken
   )
 {
-  MANAGEABILITY_MCTP_KCS_HEADER   *MctpKcsHeader;
-  MCTP_TRANSPORT_HEADER           *MctpTransportHeader;
-  MCTP_MESSAGE_HEADER             *MctpMessageHeader;
-  MANAGEABILITY_MCTP_KCS_TRAILER  *MctpKcsTrailer;
-  UINT8                           *ThisPackage;
-
-  if ((PacketHeader == NULL) || (PacketHeaderSize == NULL) ||
-      (PacketBody == NULL) || (PacketBodySize == NULL) ||
-      (PacketTrailer == NULL) || (PacketTrailerSize == NULL)
-      )
-  {
-    DEBUG ((DEBUG_ERROR, "%a: One or more than one of the input parameter is invalid.\n", __func__));
+  UINT8  *Packet;
+
+  if (TransferToken == NULL) {
+    DEBUG ((DEBUG_ERROR, "%a: TransferToken is NULL.\n", __func__));
     return EFI_INVALID_PARAMETER;
   }
 
-  if (CompareGuid (&gManageabilityTransportKcsGuid, TransportToken->Transport->ManageabilityTransportSpecification)) {
-    MctpKcsHeader = (MANAGEABILITY_MCTP_KCS_HEADER *)AllocateZeroPool (sizeof (MANAGEABILITY_MCTP_KCS_HEADER));
-    if (MctpKcsHeader == NULL) {
-      DEBUG ((DEBUG_ERROR, "%a: Not enough resource for MANAGEABILITY_MCTP_KCS_HEADER.\n", __func__));
-      return EFI_OUT_OF_RESOURCES;
-    }
+  if (!CompareGuid (&gManageabilityTransportKcsGuid, TransportToken->Transport->ManageabilityTransportSpecification)) {
+    DEBUG ((DEBUG_ERROR, "%a: No implementation of building up packet.", __func__));
+    ASSERT (FALSE);
+    return EFI_UNSUPPORTED;
+  }
 
-    MctpKcsTrailer = (MANAGEABILITY_MCTP_KCS_TRAILER *)AllocateZeroPool (sizeof (MANAGEABILITY_MCTP_KCS_TRAILER));
-    if (MctpKcsTrailer == NULL) {
-      DEBUG ((DEBUG_ERROR, "%a: Not enough resource for PEC.\n", __func__));
-      FreePool (MctpKcsHeader);
-      return EFI_OUT_OF_RESOURCES;
-    }
+  ASSERT (sizeof (MCTP_PACKET_HEADER) + PacketBodySize <= MIN (mTransportMaximumPayload, MAX_UINT8));
+
+  // Setup MCTP transport header
+  ZeroMem (&mMctpPacketHeader, sizeof (MCTP_PACKET_HEADER));
+  mMctpPacketHeader.TransportHeader.Bits.HeaderVersion         = MCTP_KCS_HEADER_VERSION;
+  mMctpPacketHeader.TransportHeader.Bits.DestinationEndpointId = MctpDestinationEndpointId;
+  mMctpPacketHeader.TransportHeader.Bits.SourceEndpointId      = MctpSourceEndpointId;
+  mMctpPacketHeader.TransportHeader.Bits.MessageTag            = mMctpMessageTag;
+  mMctpPacketHeader.TransportHeader.Bits.TagOwner              = MCTP_MESSAGE_TAG_OWNER_REQUEST;
+  mMctpPacketHeader.TransportHeader.Bits.PacketSequence        = mMctpPacketSequence & MCTP_PACKET_SEQUENCE_MASK;
+  mMctpPacketHeader.TransportHeader.Bits.StartOfMessage        = mStartOfMessage ? 1 : 0;
+  mMctpPacketHeader.TransportHeader.Bits.EndOfMessage          = mEndOfMessage ? 1 : 0;
+
+  // Setup MCTP message header
+  mMctpPacketHeader.MessageHeader.Bits.MessageType    = MctpType;
+  mMctpPacketHeader.MessageHeader.Bits.IntegrityCheck = RequestDataIntegrityCheck ? 1 : 0;
+
+  // Generate MCTP KCS transport header
+  mMctpKcsHeader.DefiningBody = DEFINING_BODY_DMTF_PRE_OS_WORKING_GROUP;
+  mMctpKcsHeader.NetFunc      = MCTP_KCS_NETFN_LUN;
+  mMctpKcsHeader.ByteCount    = (UINT8)(sizeof (MCTP_PACKET_HEADER) + PacketBodySize);
+
+  //
+  // Generate PEC follow SMBUS 2.0 specification, over the MCTP headers
+  // then the packet body.
+  //
+  mMctpKcsTrailer.Pec = HelperManageabilityGenerateCrc8 (
+                          MCTP_KCS_PACKET_ERROR_CODE_POLY,
+                          0,
+                          (UINT8 *)&mMctpPacketHeader,
+                          sizeof (MCTP_PACKET_HEADER)
+                          );
+  mMctpKcsTrailer.Pec = HelperManageabilityGenerateCrc8 (
+                          MCTP_KCS_PACKET_ERROR_CODE_POLY,
+                          mMctpKcsTrailer.Pec,
+                          PacketBody,
+                          PacketBodySize
+                          );
+
+  mMctpTransmitSegments[0].Data       = (UINT8 *)&mMctpPacketHeader;
+  mMctpTransmitSegments[0].SizeInByte = sizeof (MCTP_PACKET_HEADER);
+  mMctpTransmitSegments[1].Data       = PacketBody;
+  mMctpTransmitSegments[1].SizeInByte = PacketBodySize;
+
+  TransferToken->TransmitHeader      = (MANAGEABILITY_TRANSPORT_HEADER)&mMctpKcsHeader;
+  TransferToken->TransmitHeaderSize  = sizeof (MANAGEABILITY_MCTP_KCS_HEADER);
+  TransferToken->TransmitTrailer     = (MANAGEABILITY_TRANSPORT_TRAILER)&mMctpKcsTrailer;
+  TransferToken->TransmitTrailerSize = sizeof (MANAGEABILITY_MCTP_KCS_TRAILER);
+  if ((mTransportCapability & MANAGEABILITY_TRANSPORT_CAPABILITY_SCATTER_GATHER) != 0) {
+    TransferToken->TransmitPackage.TransmitPayload    = NULL;
+    TransferToken->TransmitPackage.TransmitSizeInByte = 0;
+    TransferToken->TransmitSegments                   = mMctpTransmitSegments;
+    TransferToken->TransmitSegmentCount               = ARRAY_SIZE (mMctpTransmitSegments);
+    return EFI_SUCCESS;
+  }
 
-    // Generate MCTP KCS transport header
-    MctpKcsHeader->DefiningBody = DEFINING_BODY_DMTF_PRE_OS_WORKING_GROUP;
-    MctpKcsHeader->NetFunc      = MCTP_KCS_NETFN_LUN;
-    MctpKcsHeader->ByteCount    = (UINT8)(MIN (mTransportMaximumPayload, *PacketBodySize + (UINT8)sizeof (MCTP_MESSAGE_HEADER) + (UINT8)sizeof (MCTP_TRANSPORT_HEADER)));
+  Packet = HelperManageabilityAllocateBuffer (&mMctpBufferPool, mMctpKcsHeader.ByteCount);
+  if (Packet == NULL) {
+    DEBUG ((DEBUG_ERROR, "%a: Not enough resource for package.\n", __func__));
+    return EFI_OUT_OF_RESOURCES;
+  }
 
-    ThisPackage = (UINT8 *)AllocateZeroPool (MctpKcsHeader->ByteCount);
-    if (ThisPackage == NULL) {
-      DEBUG ((DEBUG_ERROR, "%a: Not enough resource for package.\n", __func__));
-      FreePool (MctpKcsHeader);
-      FreePool (MctpKcsTrailer);
-      return EFI_OUT_OF_RESOURCES;
-    }
+  HelperManageabilityGatherSegments (mMctpTransmitSegments, ARRAY_SIZE (mMctpTransmitSegments), Packet, mMctpKcsHeader.ByteCount);
+  TransferToken->TransmitPackage.TransmitPayload    = Packet;
+  TransferToken->TransmitPackage.TransmitSizeInByte = mMctpKcsHeader.ByteCount;
+  TransferToken->TransmitSegments                   = NULL;
+  TransferToken->TransmitSegmentCount               = 0;
+  return EFI_SUCCESS;
+}
 
-    // Setup MCTP transport header
-    MctpTransportHeader                             = (MCTP_TRANSPORT_HEADER *)ThisPackage;
-    MctpTransportHeader->Bits.Reserved              = 0;
-    MctpTransportHeader->Bits.HeaderVersion         = MCTP_KCS_HEADER_VERSION;
-    MctpTransportHeader->Bits.DestinationEndpointId = MctpDestinationEndpointId;
-    MctpTransportHeader->Bits.SourceEndpointId      = MctpSourceEndpointId;
-    MctpTransportHeader->Bits.MessageTag            = MCTP_MESSAGE_TAG;
-    MctpTransportHeader->Bits.TagOwner              = MCTP_MESSAGE_TAG_OWNER_REQUEST;
-    MctpTransportHeader->Bits.PacketSequence        = mMctpPacketSequence & MCTP_PACKET_SEQUENCE_MASK;
-    MctpTransportHeader->Bits.StartOfMessage        = mStartOfMessage ? 1 : 0;
-    MctpTransportHeader->Bits.EndOfMessage          = mEndOfMessage ? 1 : 0;
-
-    // Setup MCTP message header
-    MctpMessageHeader                      = (MCTP_MESSAGE_HEADER *)(MctpTransportHeader + 1);
-    MctpMessageHeader->Bits.MessageType    = MctpType;
-    MctpMessageHeader->Bits.IntegrityCheck = RequestDataIntegrityCheck ? 1 : 0;
-
-    // Copy payload
-    CopyMem ((VOID *)(MctpMessageHeader + 1), (VOID *)*PacketBody, *PacketBodySize);
+/**
+  This functions releases the resources of the packet set up by
+  SetupMctpRequestTransportPacket().
 
-    //
-    // Generate PEC follow SMBUS 2.0 specification.
-    MctpKcsTrailer->Pec = HelperManageabilityGenerateCrc8 (MCTP_KCS_PACKET_ERROR_CODE_POLY, 0, ThisPackage, MctpKcsHeader->ByteCount);
-
-    *PacketBody        = (UINT8 *)ThisPackage;
-    *PacketBodySize    = MctpKcsHeader->ByteCount;
-    *PacketTrailer     = (MANAGEABILITY_TRANSPORT_TRAILER)MctpKcsTrailer;
-    *PacketHeader      = (MANAGEABILITY_TRANSPORT_HEADER)MctpKcsHeader;
-    *PacketHeaderSize  = sizeof (MANAGEABILITY_MCTP_KCS_HEADER);
-    *PacketTrailerSize = sizeof (MANAGEABILITY_MCTP_KCS_TRAILER);
-    return EFI_SUCCESS;
-  } else {
-    DEBUG ((DEBUG_ERROR, "%a: No implementation of building up packet.", __func__));
-    ASSERT (FALSE);
+  @param[in, out]    TransferToken              The transfer token of the packet.
+**/
+VOID
+ReleaseMctpRequestTransportPacket (
+  IN OUT MANAGEABILITY_TRANSFER_TOKEN  *TransferToken
+  )
+{
+  if (TransferToken->TransmitPackage.TransmitPayload != NULL) {
+    HelperManageabilityFreeBuffer (&mMctpBufferPool, TransferToken->TransmitPackage.TransmitPayload);
+    TransferToken->TransmitPackage.TransmitPayload    = NULL;
+    TransferToken->TransmitPackage.TransmitSizeInByte = 0;
   }
 
-  return EFI_SUCCESS;
+  TransferToken->TransmitSegments     = NULL;
+  TransferToken->TransmitSegmentCount = 0;
 }
 
 /**
@@ -257,19 +363,16 @@ CommonMctpSubmitMessage (
   )
 {
   EFI_STATUS                                 Status;
-  UINT16                                     IndexOfPackage;
+  UINT32                                     IndexOfPacket;
+  UINT32                                     NumberOfPackets;
+  UINT32                                     PacketPayloadSize;
   UINT8                                      *ThisRequestData;
   UINT32                                     ThisRequestDataSize;
-  UINT16                                     MctpTransportHeaderSize;
-  UINT16                                     MctpTransportTrailerSize;
   MANAGEABILITY_TRANSFER_TOKEN               TransferToken;
-  MANAGEABILITY_TRANSPORT_HEADER             MctpTransportHeader;
-  MANAGEABILITY_TRANSPORT_TRAILER            MctpTransportTrailer;
-  MANAGEABILITY_TRANSMISSION_MULTI_PACKAGES  *MultiPackages;
-  MANAGEABILITY_TRANSMISSION_PACKAGE_ATTR    *ThisPackage;
   UINT8                                      *ResponseBuffer;
   MCTP_TRANSPORT_HEADER                      *MctpTransportResponseHeader;
   MCTP_MESSAGE_HEADER                        *MctpMessageResponseHeader;
+  UINT8                                      DiscardedResponses;
 
   if (TransportToken == NULL) {
     DEBUG ((DEBUG_ERROR, "%a: No transport toke for MCTP\n", __func__));
@@ -285,86 +388,50 @@ CommonMctpSubmitMessage (
     return Status;
   }
 
-  MultiPackages = NULL;
-  Status        = HelperManageabilitySplitPayload (
-                    sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER),
-                    0,
-                    RequestData,
-                    RequestDataSize,
-                    mTransportMaximumPayload,
-                    &MultiPackages
-                    );
-  if (EFI_ERROR (Status) || (MultiPackages == NULL)) {
-    DEBUG ((DEBUG_ERROR, "%a: Fails to split payload into multiple packages - (%r)\n", __func__, mTransportName, Status));
-    return Status;
+  //
+  // Split the message into packets of the transport interface Maximum
+  // Transfer Unit, each is sent from the caller's buffer.
+  //
+  if (mTransportMaximumPayload <= sizeof (MCTP_PACKET_HEADER)) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: MCTP headers 0x%x is not less than MaximumTransferUnit 0x%x.\n",
+      __func__,
+      sizeof (MCTP_PACKET_HEADER),
+      mTransportMaximumPayload
+      ));
+    return EFI_INVALID_PARAMETER;
   }
 
-  // Print transmission packages info.
-  DEBUG ((DEBUG_MANAGEABILITY_INFO, "Manageability Transmission packages:\n"));
-  ThisPackage = (MANAGEABILITY_TRANSMISSION_PACKAGE_ATTR *)(MultiPackages + 1);
-  for (IndexOfPackage = 0; IndexOfPackage < MultiPackages->NumberOfPackages; IndexOfPackage++) {
-    DEBUG ((DEBUG_MANAGEABILITY_INFO, "#%d: \n", IndexOfPackage));
-    DEBUG ((DEBUG_MANAGEABILITY_INFO, "    Packet pointer: 0x%08x\n", ThisPackage->PayloadPointer));
-    DEBUG ((DEBUG_MANAGEABILITY_INFO, "    Packet size   : 0x%08x\n", ThisPackage->PayloadSize));
-  }
+  PacketPayloadSize = mTransportMaximumPayload - sizeof (MCTP_PACKET_HEADER);
+  NumberOfPackets   = (RequestDataSize + (PacketPayloadSize - 1)) / PacketPayloadSize;
 
-  ThisPackage         = (MANAGEABILITY_TRANSMISSION_PACKAGE_ATTR *)(MultiPackages + 1);
   mMctpPacketSequence = 0;
-  for (IndexOfPackage = 0; IndexOfPackage < MultiPackages->NumberOfPackages; IndexOfPackage++) {
-    MctpTransportHeader  = NULL;
-    MctpTransportTrailer = NULL;
-    ThisRequestData      = ThisPackage->PayloadPointer;
-    ThisRequestDataSize  = ThisPackage->PayloadSize;
+  MctpAllocateMessageTag ();
+  for (IndexOfPacket = 0; IndexOfPacket < NumberOfPackets; IndexOfPacket++) {
+    ThisRequestData     = RequestData + IndexOfPacket * PacketPayloadSize;
+    ThisRequestDataSize = MIN (RequestDataSize - IndexOfPacket * PacketPayloadSize, PacketPayloadSize);
 
     // Setup Start of Message bit and End of Message bit.
-    if (MultiPackages->NumberOfPackages == 1) {
-      mStartOfMessage = TRUE;
-      mEndOfMessage   = TRUE;
-    } else if (IndexOfPackage == 0) {
-      mStartOfMessage = TRUE;
-      mEndOfMessage   = FALSE;
-    } else if (IndexOfPackage == MultiPackages->NumberOfPackages - 1) {
-      mStartOfMessage = FALSE;
-      mEndOfMessage   = TRUE;
-    } else {
-      mStartOfMessage = FALSE;
-      mEndOfMessage   = FALSE;
-    }
+    mStartOfMessage = (BOOLEAN)(IndexOfPacket == 0);
+    mEndOfMessage   = (BOOLEAN)(IndexOfPacket == NumberOfPackets - 1);
 
+    ZeroMem (&TransferToken, sizeof (MANAGEABILITY_TRANSFER_TOKEN));
     Status = SetupMctpRequestTransportPacket (
                TransportToken,
                MctpType,
                MctpSourceEndpointId,
                MctpDestinationEndpointId,
                RequestDataIntegrityCheck,
-               &MctpTransportHeader,
-               &MctpTransportHeaderSize,
-               &ThisRequestData,
-               &ThisRequestDataSize,
-               &MctpTransportTrailer,
-               &MctpTransportTrailerSize
+               ThisRequestData,
+               ThisRequestDataSize,
+               &TransferToken
                );
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a: Fail to build packets - (%r)\n", __func__, Status));
       return Status;
     }
 
-    ZeroMem (&TransferToken, sizeof (MANAGEABILITY_TRANSFER_TOKEN));
-    TransferToken.TransmitHeader      = MctpTransportHeader;
-    TransferToken.TransmitHeaderSize  = MctpTransportHeaderSize;
-    TransferToken.TransmitTrailer     = MctpTransportTrailer;
-    TransferToken.TransmitTrailerSize = MctpTransportTrailerSize;
-
-    // Transmit packet.
-    if ((ThisRequestData == NULL) || (ThisRequestDataSize == 0)) {
-      // Transmit parameter were not changed by SetupMctpRequestTransportPacket().
-      TransferToken.TransmitPackage.TransmitPayload    = ThisPackage->PayloadPointer;
-      TransferToken.TransmitPackage.TransmitSizeInByte = ThisPackage->PayloadSize;
-    } else {
-      TransferToken.TransmitPackage.TransmitPayload    = ThisRequestData;
-      TransferToken.TransmitPackage.TransmitSizeInByte = ThisRequestDataSize;
-    }
-
     TransferToken.TransmitPackage.TransmitTimeoutInMillisecond = MANAGEABILITY_TRANSPORT_NO_TIMEOUT;
 
     // Receive packet.
@@ -375,53 +442,45 @@ CommonMctpSubmitMessage (
     // Print out MCTP packet.
     DEBUG ((
       DEBUG_MANAGEABILITY_INFO,
-      "%a: Send MCTP message type: 0x%x, from source endpoint ID: 0x%x to destination ID 0x%x: Request size: 0x%x, Response size: 0x%x\n",
+      "%a: Send MCTP message type: 0x%x, from source endpoint ID: 0x%x to destination ID 0x%x: Packet #%d, request size: 0x%x, Response size: 0x%x\n",
       __func__,
       MctpType,
       MctpSourceEndpointId,
       MctpDestinationEndpointId,
-      TransferToken.TransmitPackage.TransmitSizeInByte,
+      IndexOfPacket,
+      ThisRequestDataSize,
       TransferToken.ReceivePackage.ReceiveSizeInByte
       ));
 
-    if ((MctpTransportHeader != NULL) && (MctpTransportHeaderSize != 0)) {
-      HelperManageabilityDebugPrint (
-        (VOID *)TransferToken.TransmitHeader,
-        (UINT32)TransferToken.TransmitHeaderSize,
-        "MCTP transport header.\n"
-        );
-    }
+    HelperManageabilityDebugPrint (
+      (VOID *)TransferToken.TransmitHeader,
+      (UINT32)TransferToken.TransmitHeaderSize,
+      "MCTP transport header.\n"
+      );
 
     HelperManageabilityDebugPrint (
-      (VOID *)TransferToken.TransmitPackage.TransmitPayload,
-      TransferToken.TransmitPackage.TransmitSizeInByte,
-      "MCTP full request payload.\n"
+      (VOID *)&mMctpPacketHeader,
+      sizeof (MCTP_PACKET_HEADER),
+      "MCTP packet header.\n"
       );
 
-    if ((MctpTransportTrailer != NULL) && (MctpTransportTrailerSize != 0)) {
-      HelperManageabilityDebugPrint (
-        (VOID *)TransferToken.TransmitTrailer,
-        (UINT32)TransferToken.TransmitTrailerSize,
-        "MCTP transport trailer.\n"
-        );
-    }
+    HelperManageabilityDebugPrint (
+      (VOID *)ThisRequestData,
+      ThisRequestDataSize,
+      "MCTP packet payload.\n"
+      );
+
+    HelperManageabilityDebugPrint (
+      (VOID *)TransferToken.TransmitTrailer,
+      (UINT32)TransferToken.TransmitTrailerSize,
+      "MCTP transport trailer.\n"
+      );
 
     TransportToken->Transport->Function.Version1_0->TransportTransmitReceive (
                                                       TransportToken,
                                                       &TransferToken
                                                       );
-    if (MctpTransportHeader != NULL) {
-      FreePool ((VOID *)MctpTransportHeader);
-    }
-
-    if (MctpTransportTrailer != NULL) {
-      FreePool ((VOID *)MctpTransportTrailer);
-    }
-
-    if (ThisRequestData != NULL) {
-      FreePool ((VOID *)ThisRequestData);
-      ThisRequestData = NULL;
-    }
+    ReleaseMctpRequestTransportPacket (&TransferToken);
 
     //
     // Return transfer status.
@@ -430,45 +489,73 @@ CommonMctpSubmitMessage (
     *AdditionalTransferError = TransferToken.TransportAdditionalStatus;
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "%a: Failed to send MCTP command over %s\n", __func__, mTransportName));
-      FreePool (MultiPackages);
       return Status;
     }
 
     mMctpPacketSequence++;
-    ThisPackage++;
   }
 
-  ResponseBuffer = (UINT8 *)AllocatePool (*ResponseDataSize + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER));
-  // Receive packet.
-  TransferToken.TransmitPackage.TransmitPayload             = NULL;
-  TransferToken.TransmitPackage.TransmitSizeInByte          = 0;
-  TransferToken.ReceivePackage.ReceiveBuffer                = ResponseBuffer;
-  TransferToken.ReceivePackage.ReceiveSizeInByte            = *ResponseDataSize + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER);
-  TransferToken.TransmitHeader                              = NULL;
-  TransferToken.TransmitHeaderSize                          = 0;
-  TransferToken.TransmitTrailer                             = NULL;
-  TransferToken.TransmitTrailerSize                         = 0;
-  TransferToken.ReceivePackage.TransmitTimeoutInMillisecond = MANAGEABILITY_TRANSPORT_NO_TIMEOUT;
-
-  DEBUG ((
-    DEBUG_MANAGEABILITY_INFO,
-    "%a: Retrieve MCTP message Response size: 0x%x\n",
-    __func__,
-    TransferToken.ReceivePackage.ReceiveSizeInByte
-    ));
-  TransportToken->Transport->Function.Version1_0->TransportTransmitReceive (
-                                                    TransportToken,
-                                                    &TransferToken
-                                                    );
-
-  *AdditionalTransferError = TransferToken.TransportAdditionalStatus;
-  Status                   = TransferToken.TransferStatus;
-  if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "%a: Failed to send MCTP command over %s: %r\n", __func__, mTransportName, Status));
-    return Status;
+  ResponseBuffer = (UINT8 *)HelperManageabilityAllocateBuffer (
+                              &mMctpBufferPool,
+                              *ResponseDataSize + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER)
+                              );
+  if (ResponseBuffer == NULL) {
+    DEBUG ((DEBUG_ERROR, "%a: Not enough resource for response buffer.\n", __func__));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // Receive the response, and discard the late responses to earlier
+  // requests that may be in front of it.
+  //
+  for (DiscardedResponses = 0; ; DiscardedResponses++) {
+    TransferToken.TransmitPackage.TransmitPayload             = NULL;
+    TransferToken.TransmitPackage.TransmitSizeInByte          = 0;
+    TransferToken.ReceivePackage.ReceiveBuffer                = ResponseBuffer;
+    TransferToken.ReceivePackage.ReceiveSizeInByte            = *ResponseDataSize + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER);
+    TransferToken.TransmitHeader                              = NULL;
+    TransferToken.TransmitHeaderSize                          = 0;
+    TransferToken.TransmitTrailer                             = NULL;
+    TransferToken.TransmitTrailerSize                         = 0;
+    TransferToken.TransmitSegments                            = NULL;
+    TransferToken.TransmitSegmentCount                        = 0;
+    TransferToken.ReceivePackage.TransmitTimeoutInMillisecond = MANAGEABILITY_TRANSPORT_NO_TIMEOUT;
+
+    DEBUG ((
+      DEBUG_MANAGEABILITY_INFO,
+      "%a: Retrieve MCTP message Response size: 0x%x\n",
+      __func__,
+      TransferToken.ReceivePackage.ReceiveSizeInByte
+      ));
+    TransportToken->Transport->Function.Version1_0->TransportTransmitReceive (
+                                                      TransportToken,
+                                                      &TransferToken
+                                                      );
+
+    *AdditionalTransferError = TransferToken.TransportAdditionalStatus;
+    Status                   = TransferToken.TransferStatus;
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "%a: Failed to send MCTP command over %s: %r\n", __func__, mTransportName, Status));
+      HelperManageabilityFreeBuffer (&mMctpBufferPool, ResponseBuffer);
+      return Status;
+    }
+
+    MctpTransportResponseHeader = (MCTP_TRANSPORT_HEADER *)ResponseBuffer;
+    if ((DiscardedResponses >= MCTP_MAX_DISCARDED_RESPONSES) ||
+        !MctpIsLateResponse (MctpTransportResponseHeader))
+    {
+      break;
+    }
+
+    DEBUG ((
+      DEBUG_MANAGEABILITY_INFO,
+      "%a: Discard the late response with MessageTag 0x%02x, waiting for 0x%02x.\n",
+      __func__,
+      MctpTransportResponseHeader->Bits.MessageTag,
+      mMctpMessageTag
+      ));
   }
 
-  MctpTransportResponseHeader = (MCTP_TRANSPORT_HEADER *)ResponseBuffer;
   if (MctpTransportResponseHeader->Bits.HeaderVersion != MCTP_KCS_HEADER_VERSION) {
     DEBUG ((
       DEBUG_ERROR,
@@ -477,19 +564,19 @@ CommonMctpSubmitMessage (
       MctpTransportResponseHeader->Bits.HeaderVersion,
       MCTP_KCS_HEADER_VERSION
       ));
-    FreePool (ResponseBuffer);
+    HelperManageabilityFreeBuffer (&mMctpBufferPool, ResponseBuffer);
     return EFI_DEVICE_ERROR;
   }
 
-  if (MctpTransportResponseHeader->Bits.MessageTag != MCTP_MESSAGE_TAG) {
+  if (MctpTransportResponseHeader->Bits.MessageTag != mMctpMessageTag) {
     DEBUG ((
       DEBUG_ERROR,
-      "%a: Error! Response MessageTag (0x%02x) doesn't match MCTP_MESSAGE_TAG (0x%02x)\n",
+      "%a: Error! Response MessageTag (0x%02x) doesn't match request MessageTag (0x%02x)\n",
       __func__,
       MctpTransportResponseHeader->Bits.MessageTag,
-      MCTP_MESSAGE_TAG
+      mMctpMessageTag
       ));
-    FreePool (ResponseBuffer);
+    HelperManageabilityFreeBuffer (&mMctpBufferPool, ResponseBuffer);
     return EFI_DEVICE_ERROR;
   }
 
@@ -501,7 +588,7 @@ CommonMctpSubmitMessage (
       MctpTransportResponseHeader->Bits.TagOwner,
       MCTP_MESSAGE_TAG_OWNER_RESPONSE
       ));
-    FreePool (ResponseBuffer);
+    HelperManageabilityFreeBuffer (&mMctpBufferPool, ResponseBuffer);
     return EFI_DEVICE_ERROR;
   }
 
@@ -513,7 +600,7 @@ CommonMctpSubmitMessage (
       MctpTransportResponseHeader->Bits.SourceEndpointId,
       MctpDestinationEndpointId
       ));
-    FreePool (ResponseBuffer);
+    HelperManageabilityFreeBuffer (&mMctpBufferPool, ResponseBuffer);
     return EFI_DEVICE_ERROR;
   }
 
@@ -525,7 +612,7 @@ CommonMctpSubmitMessage (
       MctpTransportResponseHeader->Bits.DestinationEndpointId,
       MctpSourceEndpointId
       ));
-    FreePool (ResponseBuffer);
+    HelperManageabilityFreeBuffer (&mMctpBufferPool, ResponseBuffer);
     return EFI_DEVICE_ERROR;
   }
 
@@ -538,7 +625,7 @@ CommonMctpSubmitMessage (
       "%a: Error! Multiple-packet MCTP responses are not supported by the current driver\n",
       __func__
       ));
-    FreePool (ResponseBuffer);
+    HelperManageabilityFreeBuffer (&mMctpBufferPool, ResponseBuffer);
     return EFI_UNSUPPORTED;
   }
 
@@ -551,7 +638,7 @@ CommonMctpSubmitMessage (
       MctpMessageResponseHeader->Bits.MessageType,
       MctpType
       ));
-    FreePool (ResponseBuffer);
+    HelperManageabilityFreeBuffer (&mMctpBufferPool, ResponseBuffer);
     return EFI_DEVICE_ERROR;
   }
 
@@ -563,13 +650,16 @@ CommonMctpSubmitMessage (
       MctpMessageResponseHeader->Bits.IntegrityCheck,
       (UINT8)RequestDataIntegrityCheck
       ));
-    FreePool (ResponseBuffer);
+    HelperManageabilityFreeBuffer (&mMctpBufferPool, ResponseBuffer);
     return EFI_DEVICE_ERROR;
   }
 
+  // The response to this request is received, its tag can be reused.
+  mMctpOutstandingTags &= (UINT8)~(1 << mMctpMessageTag);
+
   *ResponseDataSize = TransferToken.ReceivePackage.ReceiveSizeInByte - sizeof (MCTP_TRANSPORT_HEADER) - sizeof (MCTP_MESSAGE_HEADER);
   CopyMem (ResponseData, ResponseBuffer + sizeof (MCTP_TRANSPORT_HEADER) + sizeof (MCTP_MESSAGE_HEADER), *ResponseDataSize);
-  FreePool (ResponseBuffer);
+  HelperManageabilityFreeBuffer (&mMctpBufferPool, ResponseBuffer);
 
   return Status;
 }
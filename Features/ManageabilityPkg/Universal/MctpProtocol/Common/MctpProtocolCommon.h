@@ -9,6 +9,7 @@
 #define MANAGEABILITY_MCTP_COMMON_H_
 
 #include <IndustryStandard/IpmiKcs.h>
+#include <IndustryStandard/Mctp.h>
 #include <Library/ManageabilityTransportLib.h>
 
 #define MCTP_KCS_BASE_ADDRESS  PcdGet32(PcdMctpKcsBaseAddress)
@@ -25,6 +26,60 @@
 #define MCTP_KCS_REG_COMMAND_MEMMAP   MCTP_KCS_BASE_ADDRESS + (IPMI_KCS_COMMAND_REGISTER_OFFSET * 4)
 #define MCTP_KCS_REG_STATUS_MEMMAP    MCTP_KCS_BASE_ADDRESS + (IPMI_KCS_STATUS_REGISTER_OFFSET * 4)
 
+// MCTP message tags are 3-bit wide.
+#define MCTP_MESSAGE_TAG_COUNT  8
+
+// Number of late responses to earlier requests discarded while waiting for
+// the response to the current request.
+#define MCTP_MAX_DISCARDED_RESPONSES  (MCTP_MESSAGE_TAG_COUNT - 1)
+
+// The buffers of the MCTP buffer pool hold a packet of the maximum
+// transport unit of MCTP over KCS.
+#define MCTP_BUFFER_POOL_BUFFER_SIZE   256
+#define MCTP_BUFFER_POOL_BUFFER_COUNT  2
+
+#pragma pack(1)
+
+///
+/// The MCTP headers that precede the message data in each packet.
+///
+typedef struct {
+  MCTP_TRANSPORT_HEADER    TransportHeader;
+  MCTP_MESSAGE_HEADER      MessageHeader;
+} MCTP_PACKET_HEADER;
+
+#pragma pack()
+
+/**
+  This function allocates the MCTP message tag of a new request.
+
+  A tag stays outstanding until the response carrying it is received, so
+  that a late response to a request that failed (e.g. timed out) is never
+  taken for the response to a later request.
+
+  @retval  The message tag allocated.
+**/
+UINT8
+MctpAllocateMessageTag (
+  VOID
+  );
+
+/**
+  This function checks whether a received MCTP message is the late response
+  to an earlier request, rather than the response to the current one. The tag
+  of a late response is released.
+
+  @param[in]  MctpTransportHeader  MCTP transport header of the received message.
+
+  @retval     TRUE                 The message is a late response, discard it.
+  @retval     FALSE                The message is for the current request or
+                                   unexpected.
+**/
+BOOLEAN
+MctpIsLateResponse (
+  IN  MCTP_TRANSPORT_HEADER  *MctpTransportHeader
+  );
+
 /**
   This functions setup the PLDM transport hardware information according
   to the specification of transport token acquired from transport library.
@@ -45,29 +100,27 @@ SetupMctpTransportHardwareInformation (
   );
 
 /**
-  This functions setup the final header/body/trailer packets for
+  This functions setup the transfer token of a packet of MCTP message for
   the acquired transport interface.
 
+  The transport header, the MCTP headers and the transport trailer are built
+  in module variables, and the packet body is sent from the caller's buffer
+  as a scatter-gather segment. If the transport interface doesn't support
+  scatter-gather, the MCTP headers and the packet body are gathered in a
+  buffer of the MCTP buffer pool instead.
+
   @param[in]         TransportToken             The transport interface.
   @param[in]         MctpType                   MCTP message type.
   @param[in]         MctpSourceEndpointId       MCTP source endpoint ID.
   @param[in]         MctpDestinationEndpointId  MCTP source endpoint ID.
   @param[in]         RequestDataIntegrityCheck  Indicates whether MCTP message has
                                                 integrity check byte.
-  @param[out]        PacketHeader               The pointer to receive header of request.
-  @param[out]        PacketHeaderSize           Packet header size.
-  @param[in, out]    PacketBody                 The request body.
-                                                When IN, it is the caller's request body.
-                                                When OUT and NULL, the request body is not
-                                                changed.
-                                                Whee out and non-NULL, the request body is
-                                                changed to comfort the transport interface.
-  @param[in, out]    PacketBodySize             The request body size.
-                                                When IN and non-zero, it is the new data
-                                                length of request body.
-                                                When IN and zero, the request body is unchanged.
-  @param[out]        PacketTrailer              The pointer to receive trailer of request.
-  @param[out]        PacketTrailerSize          Packet trailer size.
+  @param[in]         PacketBody                 The message data carried by the packet.
+  @param[in]         PacketBodySize             Size of PacketBody in byte.
+  @param[in, out]    TransferToken              The transfer token whose transmit
+                                                fields are set up. Call
+                                                ReleaseMctpRequestTransportPacket()
+                                                once the packet is transmitted.
 
   @retval EFI_SUCCESS            Request packet is returned.
   @retval EFI_OUT_OF_RESOURCE    Not enough resource to create the request
@@ -77,17 +130,25 @@ SetupMctpTransportHardwareInformation (
 **/
 EFI_STATUS
 SetupMctpRequestTransportPacket (
-  IN   MANAGEABILITY_TRANSPORT_TOKEN    *TransportToken,
-  IN   UINT8                            MctpType,
-  IN   UINT8                            MctpSourceEndpointId,
-  IN   UINT8                            MctpDestinationEndpointId,
-  IN   BOOLEAN                          RequestDataIntegrityCheck,
-  OUT  MANAGEABILITY_TRANSPORT_HEADER   *PacketHeader,
-  OUT  UINT16                           *PacketHeaderSize,
-  IN OUT UINT8                          **PacketBody,
-  IN OUT UINT32                         *PacketBodySize,
-  OUT  MANAGEABILITY_TRANSPORT_TRAILER  *PacketTrailer,
-  OUT  UINT16                           *PacketTrailerSize
+  IN     MANAGEABILITY_TRANSPORT_TOKEN  *TransportToken,
+  IN     UINT8                          MctpType,
+  IN     UINT8                          MctpSourceEndpointId,
+  IN     UINT8                          MctpDestinationEndpointId,
+  IN     BOOLEAN                        RequestDataIntegrityCheck,
+  IN     UINT8                          *PacketBody,
+  IN     UINT32                         PacketBodySize,
+  IN OUT MANAGEABILITY_TRANSFER_TOKEN   *TransferToken
+  );
+
+/**
+  This functions releases the resources of the packet set up by
+  SetupMctpRequestTransportPacket().
+
+  @param[in, out]    TransferToken              The transfer token of the packet.
+**/
+VOID
+ReleaseMctpRequestTransportPacket (
+  IN OUT MANAGEABILITY_TRANSFER_TOKEN  *TransferToken
   );
 
 /**
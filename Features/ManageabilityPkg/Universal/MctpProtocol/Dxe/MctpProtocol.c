@@ -20,9 +20,10 @@
 
 extern MANAGEABILITY_TRANSPORT_HARDWARE_INFORMATION  mHardwareInformation;
 
-MANAGEABILITY_TRANSPORT_TOKEN  *mTransportToken = NULL;
-CHAR16                         *mTransportName;
-UINT32                         mTransportMaximumPayload;
+MANAGEABILITY_TRANSPORT_TOKEN       *mTransportToken = NULL;
+CHAR16                              *mTransportName;
+UINT32                              mTransportMaximumPayload;
+MANAGEABILITY_TRANSPORT_CAPABILITY  mTransportCapability;
 
 /**
   This service enables submitting message via EDKII MCTP protocol.
@@ -178,6 +179,7 @@ DxeMctpEntry (
     return Status;
   }
 
+  mTransportCapability     = TransportCapability;
   mTransportMaximumPayload = MANAGEABILITY_TRANSPORT_PAYLOAD_SIZE_FROM_CAPABILITY (TransportCapability);
   if (mTransportMaximumPayload == (1 << MANAGEABILITY_TRANSPORT_CAPABILITY_MAXIMUM_PAYLOAD_NOT_AVAILABLE)) {
     DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: Transport interface maximum payload is undefined.\n", __func__));
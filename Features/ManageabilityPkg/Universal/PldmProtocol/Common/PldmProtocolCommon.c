@@ -20,6 +20,54 @@
 
 extern CHAR16  *mTransportName;
 extern UINT8   mPldmRequestInstanceId;
+extern UINT32  mPldmInstanceIdInUse;
+
+/**
+  Allocate a PLDM instance ID that no outstanding request uses.
+
+  Instance IDs are handed out round-robin, so the ID of a request that has
+  just completed is not reused right away. A late response to it can then
+  not be mistaken for the response to the next request.
+
+  @param[out]  InstanceId        Pointer to receive the instance ID.
+
+  @retval EFI_SUCCESS            The instance ID is returned in InstanceId.
+  @retval EFI_NOT_READY          All instance IDs are in use.
+**/
+EFI_STATUS
+PldmAllocateInstanceId (
+  OUT UINT8  *InstanceId
+  )
+{
+  UINT8  Index;
+  UINT8  Id;
+
+  for (Index = 0; Index < PLDM_INSTANCE_ID_COUNT; Index++) {
+    Id = (mPldmRequestInstanceId + Index) & PLDM_MESSAGE_HEADER_INSTANCE_ID_MASK;
+    if ((mPldmInstanceIdInUse & (1u << Id)) == 0) {
+      mPldmInstanceIdInUse  |= (1u << Id);
+      mPldmRequestInstanceId = (Id + 1) & PLDM_MESSAGE_HEADER_INSTANCE_ID_MASK;
+      *InstanceId            = Id;
+      return EFI_SUCCESS;
+    }
+  }
+
+  DEBUG ((DEBUG_ERROR, "%a: All %d PLDM instance IDs are in use.\n", __func__, PLDM_INSTANCE_ID_COUNT));
+  return EFI_NOT_READY;
+}
+
+/**
+  Free a PLDM instance ID allocated by PldmAllocateInstanceId().
+
+  @param[in]  InstanceId         The instance ID to free.
+**/
+VOID
+PldmFreeInstanceId (
+  IN UINT8  InstanceId
+  )
+{
+  mPldmInstanceIdInUse &= ~(1u << (InstanceId & PLDM_MESSAGE_HEADER_INSTANCE_ID_MASK));
+}
 
 /**
   This functions setup the final header/body/trailer packets for
@@ -30,6 +78,7 @@ extern UINT8   mPldmRequestInstanceId;
   @param[in]         PldmCommand        PLDM command of this PLDM type.
   @param[in]         SourceId           PLDM source teminus ID.
   @param[in]         DestinationId      PLDM destination teminus ID.
+  @param[in]         InstanceId         PLDM instance ID of the request.
   @param[out]        PacketHeader       The pointer to receive header of request.
   @param[out]        PacketHeaderSize   Packet header size in bytes.
   @param[in, out]    PacketBody         The request body.
@@ -56,6 +105,7 @@ SetupPldmRequestTransportPacket (
   IN   UINT8                            PldmCommand,
   IN   UINT8                            SourceId,
   IN   UINT8                            DestinationId,
+  IN   UINT8                            InstanceId,
   OUT  MANAGEABILITY_TRANSPORT_HEADER   *PacketHeader,
   OUT  UINT16                           *PacketHeaderSize,
   IN OUT UINT8                          **PacketBody,
@@ -112,7 +162,7 @@ SetupPldmRequestTransportPacket (
   PldmRequestHeader->HeaderVersion       = PLDM_MESSAGE_HEADER_VERSION;
   PldmRequestHeader->PldmType            = PldmType;
   PldmRequestHeader->PldmTypeCommandCode = PldmCommand;
-  PldmRequestHeader->InstanceId          = mPldmRequestInstanceId;
+  PldmRequestHeader->InstanceId          = InstanceId;
   if ((*PacketBody != NULL) && (*PacketBodySize != 0)) {
     CopyMem (
       (VOID *)((UINT8 *)PldmRequestHeader + sizeof (PLDM_REQUEST_HEADER)),
@@ -134,6 +184,7 @@ SetupPldmRequestTransportPacket (
   @param[in]         PldmCommand                PLDM command of this PLDM type.
   @param[in]         PldmTerminusSourceId       PLDM source teminus ID.
   @param[in]         PldmTerminusDestinationId  PLDM destination teminus ID.
+  @param[in]         InstanceId                 PLDM instance ID allocated by PldmAllocateInstanceId().
   @param[in]         RequestData                Command Request Data.
   @param[in]         RequestDataSize            Size of Command Request Data.
   @param[out]        ResponseData               Command Response Data. The completion code is the first byte of response data.
@@ -154,6 +205,7 @@ CommonPldmSubmitCommand (
   IN     UINT8                          PldmCommand,
   IN     UINT8                          PldmTerminusSourceId,
   IN     UINT8                          PldmTerminusDestinationId,
+  IN     UINT8                          InstanceId,
   IN     UINT8                          *RequestData OPTIONAL,
   IN     UINT32                         RequestDataSize,
   OUT    UINT8                          *ResponseData OPTIONAL,
@@ -199,6 +251,7 @@ CommonPldmSubmitCommand (
                            PldmCommand,
                            PldmTerminusSourceId,
                            PldmTerminusDestinationId,
+                           InstanceId,
                            &PldmTransportHeader,
                            &HeaderSize,
                            &ThisRequestData,
@@ -291,7 +344,7 @@ CommonPldmSubmitCommand (
   ResponseHeader = (PLDM_RESPONSE_HEADER *)FullPacketResponseData;
   if ((ResponseHeader->PldmHeader.DatagramBit != (!PLDM_MESSAGE_HEADER_IS_DATAGRAM)) ||
       (ResponseHeader->PldmHeader.RequestBit != PLDM_MESSAGE_HEADER_IS_RESPONSE) ||
-      (ResponseHeader->PldmHeader.InstanceId != mPldmRequestInstanceId) ||
+      (ResponseHeader->PldmHeader.InstanceId != InstanceId) ||
       (ResponseHeader->PldmHeader.PldmType != PldmType) ||
       (ResponseHeader->PldmHeader.PldmTypeCommandCode != PldmCommand) ||
       (ResponseHeader->PldmCompletionCode != PLDM_COMPLETION_CODE_SUCCESS))
@@ -299,7 +352,7 @@ CommonPldmSubmitCommand (
     DEBUG ((DEBUG_ERROR, "PLDM integrity check of response data is failed.\n"));
     DEBUG ((DEBUG_ERROR, "    Datagram     = %d (Expected value: %d)\n", ResponseHeader->PldmHeader.DatagramBit, (!PLDM_MESSAGE_HEADER_IS_DATAGRAM)));
     DEBUG ((DEBUG_ERROR, "    Request bit  = %d (Expected value: %d)\n", ResponseHeader->PldmHeader.RequestBit, PLDM_MESSAGE_HEADER_IS_RESPONSE));
-    DEBUG ((DEBUG_ERROR, "    Instance ID  = %d (Expected value: %d)\n", ResponseHeader->PldmHeader.InstanceId, mPldmRequestInstanceId));
+    DEBUG ((DEBUG_ERROR, "    Instance ID  = %d (Expected value: %d)\n", ResponseHeader->PldmHeader.InstanceId, InstanceId));
     DEBUG ((DEBUG_ERROR, "    Pldm Type    = %d (Expected value: %d)\n", ResponseHeader->PldmHeader.PldmType, PldmType));
     DEBUG ((DEBUG_ERROR, "    Pldm Command = %d (Expected value: %d)\n", ResponseHeader->PldmHeader.PldmTypeCommandCode, PldmCommand));
     DEBUG ((DEBUG_ERROR, "    Pldm Completion Code = 0x%x\n", ResponseHeader->PldmCompletionCode));
@@ -377,9 +430,5 @@ ErrorExit:
     FreePool ((VOID *)FullPacketResponseData);
   }
 
-  //
-  // Update PLDM message instance ID.
-  mPldmRequestInstanceId++;
-  mPldmRequestInstanceId &= PLDM_MESSAGE_HEADER_INSTANCE_ID_MASK;
   return Status;
 }
@@ -21,6 +21,8 @@ typedef struct {
   UINT32    ResponseSize;
 } PLDM_MESSAGE_PACKET_MAPPING;
 
+#define PLDM_INSTANCE_ID_COUNT  (PLDM_MESSAGE_HEADER_INSTANCE_ID_MASK + 1)
+
 /**
   This functions setup the PLDM transport hardware information according
   to the specification of transport token acquired from transport library.
@@ -49,6 +51,7 @@ SetupPldmTransportHardwareInformation (
   @param[in]         PldmCommand        PLDM command of this PLDM type.
   @param[in]         SourceId           PLDM source teminus ID.
   @param[in]         DestinationId      PLDM destination teminus ID.
+  @param[in]         InstanceId         PLDM instance ID of the request.
   @param[out]        PacketHeader       The pointer to receive header of request.
   @param[out]        PacketHeaderSize   Packet header size in bytes.
   @param[in, out]    PacketBody         The request body.
@@ -75,6 +78,7 @@ SetupPldmRequestTransportPacket (
   IN   UINT8                            PldmCommand,
   IN   UINT8                            SourceId,
   IN   UINT8                            DestinationId,
+  IN   UINT8                            InstanceId,
   OUT  MANAGEABILITY_TRANSPORT_HEADER   *PacketHeader,
   OUT  UINT16                           *PacketHeaderSize,
   IN OUT UINT8                          **PacketBody,
@@ -91,6 +95,7 @@ SetupPldmRequestTransportPacket (
   @param[in]         PldmCommand                PLDM command of this PLDM type.
   @param[in]         PldmTerminusSourceId       PLDM source teminus ID.
   @param[in]         PldmTerminusDestinationId  PLDM destination teminus ID.
+  @param[in]         InstanceId                 PLDM instance ID allocated by PldmAllocateInstanceId().
   @param[in]         RequestData                Command Request Data.
   @param[in]         RequestDataSize            Size of Command Request Data.
   @param[out]        ResponseData               Command Response Data. The completion code is the first byte of response data.
@@ -111,10 +116,38 @@ CommonPldmSubmitCommand (
   IN     UINT8                          PldmCommand,
   IN     UINT8                          PldmTerminusSourceId,
   IN     UINT8                          PldmTerminusDestinationId,
+  IN     UINT8                          InstanceId,
   IN     UINT8                          *RequestData OPTIONAL,
   IN     UINT32                         RequestDataSize,
   OUT    UINT8                          *ResponseData OPTIONAL,
   IN OUT UINT32                         *ResponseDataSize
   );
 
+/**
+  Allocate a PLDM instance ID that no outstanding request uses.
+
+  Instance IDs are handed out round-robin, so the ID of a request that has
+  just completed is not reused right away. A late response to it can then
+  not be mistaken for the response to the next request.
+
+  @param[out]  InstanceId        Pointer to receive the instance ID.
+
+  @retval EFI_SUCCESS            The instance ID is returned in InstanceId.
+  @retval EFI_NOT_READY          All instance IDs are in use.
+**/
+EFI_STATUS
+PldmAllocateInstanceId (
+  OUT UINT8  *InstanceId
+  );
+
+/**
+  Free a PLDM instance ID allocated by PldmAllocateInstanceId().
+
+  @param[in]  InstanceId         The instance ID to free.
+**/
+VOID
+PldmFreeInstanceId (
+  IN UINT8  InstanceId
+  );
+
 #endif // MANAGEABILITY_EDKII_PLDM_COMMON_H_
@@ -6,6 +6,7 @@
 **/
 
 #include <PiDxe.h>
+#include <Library/BaseLib.h>
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
@@ -17,52 +18,75 @@
 
 #include "PldmProtocolCommon.h"
 
+//
+// Period of the timer event that sends the asynchronous commands, in 100ns units.
+//
+#define PLDM_ASYNC_TIMER_PERIOD  10000
+
+#define PLDM_ASYNC_REQUEST_SIGNATURE  SIGNATURE_32 ('P', 'L', 'D', 'A')
+
+typedef struct {
+  UINT32                         Signature;
+  LIST_ENTRY                     Link;
+  UINT8                          PldmType;
+  UINT8                          Command;
+  UINT8                          PldmTerminusSourceId;
+  UINT8                          PldmTerminusDestinationId;
+  UINT8                          InstanceId;
+  UINT8                          *RequestData;
+  UINT32                         RequestDataSize;
+  UINT8                          *ResponseData;
+  UINT32                         *ResponseDataSize;
+  EDKII_PLDM_COMPLETION_TOKEN    *Token;
+} PLDM_ASYNC_REQUEST;
+
+#define PLDM_ASYNC_REQUEST_FROM_LINK(a)  CR (a, PLDM_ASYNC_REQUEST, Link, PLDM_ASYNC_REQUEST_SIGNATURE)
+
 MANAGEABILITY_TRANSPORT_TOKEN  *mTransportToken = NULL;
 CHAR16                         *mTransportName;
 UINT8                          mPldmRequestInstanceId;
+UINT32                         mPldmInstanceIdInUse;
 UINT32                         TransportMaximumPayload;
 
+LIST_ENTRY  mPldmAsyncRequestQueue = INITIALIZE_LIST_HEAD_VARIABLE (mPldmAsyncRequestQueue);
+EFI_EVENT   mPldmAsyncEvent        = NULL;
+BOOLEAN     mPldmTransportBusy     = FALSE;
+
 /**
-  This service enables submitting commands via EDKII PLDM protocol.
+  Check the parameters of a PLDM command submitted by the caller.
 
-  @param[in]         This                       EDKII_PLDM_PROTOCOL instance.
   @param[in]         PldmType                   PLDM message type.
   @param[in]         Command                    PLDM Command of PLDM message type.
-  @param[in]         PldmTerminusSourceId       PLDM source teminus ID.
-  @param[in]         PldmTerminusDestinationId  PLDM destination teminus ID.
   @param[in]         RequestData                Command Request Data.
   @param[in]         RequestDataSize            Size of Command Request Data.
-  @param[out]        ResponseData               Command Response Data. The completion code is the first byte of response data.
-  @param[in, out]    ResponseDataSize           Size of Command Response Data.
+  @param[in]         ResponseData               Command Response Data.
+  @param[in]         ResponseDataSize           Size of Command Response Data.
 
-  @retval EFI_SUCCESS            The command byte stream was successfully submit to the device and a response was successfully received.
-  @retval EFI_NOT_FOUND          The command was not successfully sent to the device or a response was not successfully received from the device.
-  @retval EFI_NOT_READY          PLDM transport interface is not ready for PLDM command access.
-  @retval EFI_DEVICE_ERROR       PLDM transport interface Device hardware error.
-  @retval EFI_TIMEOUT            The command time out.
-  @retval EFI_UNSUPPORTED        The command was not successfully sent to the device.
-  @retval EFI_OUT_OF_RESOURCES   The resource allcation is out of resource or data size error.
-  @retval EFI_INVALID_PARAMETER  Both RequestData and ResponseData are NULL
+  @retval EFI_SUCCESS            The parameters are valid.
+  @retval EFI_INVALID_PARAMETER  One of the parameters is invalid.
 **/
+STATIC
 EFI_STATUS
-EFIAPI
-PldmSubmitCommand (
-  IN     EDKII_PLDM_PROTOCOL  *This,
-  IN     UINT8                PldmType,
-  IN     UINT8                Command,
-  IN     UINT8                PldmTerminusSourceId,
-  IN     UINT8                PldmTerminusDestinationId,
-  IN     UINT8                *RequestData,
-  IN     UINT32               RequestDataSize,
-  OUT    UINT8                *ResponseData,
-  IN OUT UINT32               *ResponseDataSize
+PldmCheckCommandParameters (
+  IN UINT8   PldmType,
+  IN UINT8   Command,
+  IN UINT8   *RequestData,
+  IN UINT32  RequestDataSize,
+  IN UINT8   *ResponseData,
+  IN UINT32  *ResponseDataSize
   )
 {
-  EFI_STATUS  Status;
+  if (ResponseDataSize == NULL) {
+    DEBUG ((
+      DEBUG_ERROR,
+      "%a: ResponseDataSize is NULL for PLDM type: 0x%x, Command: 0x%x.\n",
+      __func__,
+      PldmType,
+      Command
+      ));
+    return EFI_INVALID_PARAMETER;
+  }
 
-  //
-  // Check the given input parameters.
-  //
   if ((RequestData == NULL) && (RequestDataSize != 0)) {
     DEBUG ((
       DEBUG_ERROR,
@@ -107,23 +131,310 @@ PldmSubmitCommand (
     return EFI_INVALID_PARAMETER;
   }
 
-  DEBUG ((DEBUG_MANAGEABILITY, "%a: Source terminus ID: 0x%x, Destination terminus ID: 0x%x.\n"));
+  return EFI_SUCCESS;
+}
+
+/**
+  Send the queued asynchronous PLDM commands and complete their tokens.
+
+  The transport is half duplex, so the commands are sent one after the
+  other, but without going back to the caller in between. The timer of the
+  asynchronous commands is cancelled once the queue is empty.
+**/
+STATIC
+VOID
+PldmSendQueuedRequests (
+  VOID
+  )
+{
+  EFI_TPL             OldTpl;
+  EFI_STATUS          Status;
+  BOOLEAN             TransportBusy;
+  PLDM_ASYNC_REQUEST  *Request;
+
+  OldTpl             = gBS->RaiseTPL (TPL_NOTIFY);
+  TransportBusy      = mPldmTransportBusy;
+  mPldmTransportBusy = TRUE;
+  while (!IsListEmpty (&mPldmAsyncRequestQueue)) {
+    Request = PLDM_ASYNC_REQUEST_FROM_LINK (GetFirstNode (&mPldmAsyncRequestQueue));
+    RemoveEntryList (&Request->Link);
+    gBS->RestoreTPL (OldTpl);
+
+    Status = CommonPldmSubmitCommand (
+               mTransportToken,
+               Request->PldmType,
+               Request->Command,
+               Request->PldmTerminusSourceId,
+               Request->PldmTerminusDestinationId,
+               Request->InstanceId,
+               Request->RequestData,
+               Request->RequestDataSize,
+               Request->ResponseData,
+               Request->ResponseDataSize
+               );
+
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    PldmFreeInstanceId (Request->InstanceId);
+    gBS->RestoreTPL (OldTpl);
+
+    Request->Token->Status = Status;
+    gBS->SignalEvent (Request->Token->Event);
+    if (Request->RequestData != NULL) {
+      FreePool (Request->RequestData);
+    }
+
+    FreePool (Request);
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  }
+
+  gBS->SetTimer (mPldmAsyncEvent, TimerCancel, 0);
+  mPldmTransportBusy = TransportBusy;
+  gBS->RestoreTPL (OldTpl);
+}
+
+/**
+  This is the notification function of the periodic timer event armed by
+  PldmSubmitCommandAsync(). It sends the queued commands, unless a
+  synchronous command is in flight.
+
+  @param[in]  Event              The timer event.
+  @param[in]  Context            Not used.
+**/
+STATIC
+VOID
+EFIAPI
+PldmAsyncRequestWorker (
+  IN EFI_EVENT  Event,
+  IN VOID       *Context
+  )
+{
+  EFI_TPL  OldTpl;
+  BOOLEAN  TransportBusy;
+
+  OldTpl        = gBS->RaiseTPL (TPL_NOTIFY);
+  TransportBusy = mPldmTransportBusy;
+  gBS->RestoreTPL (OldTpl);
+  if (TransportBusy) {
+    //
+    // A synchronous command is in flight, try again on the next tick.
+    //
+    return;
+  }
+
+  PldmSendQueuedRequests ();
+}
+
+/**
+  This service enables submitting commands via EDKII PLDM protocol.
+
+  @param[in]         This                       EDKII_PLDM_PROTOCOL instance.
+  @param[in]         PldmType                   PLDM message type.
+  @param[in]         Command                    PLDM Command of PLDM message type.
+  @param[in]         PldmTerminusSourceId       PLDM source teminus ID.
+  @param[in]         PldmTerminusDestinationId  PLDM destination teminus ID.
+  @param[in]         RequestData                Command Request Data.
+  @param[in]         RequestDataSize            Size of Command Request Data.
+  @param[out]        ResponseData               Command Response Data. The completion code is the first byte of response data.
+  @param[in, out]    ResponseDataSize           Size of Command Response Data.
+
+  @retval EFI_SUCCESS            The command byte stream was successfully submit to the device and a response was successfully received.
+  @retval EFI_NOT_FOUND          The command was not successfully sent to the device or a response was not successfully received from the device.
+  @retval EFI_NOT_READY          PLDM transport interface is not ready for PLDM command access.
+  @retval EFI_DEVICE_ERROR       PLDM transport interface Device hardware error.
+  @retval EFI_TIMEOUT            The command time out.
+  @retval EFI_UNSUPPORTED        The command was not successfully sent to the device.
+  @retval EFI_OUT_OF_RESOURCES   The resource allcation is out of resource or data size error.
+  @retval EFI_INVALID_PARAMETER  Both RequestData and ResponseData are NULL
+**/
+EFI_STATUS
+EFIAPI
+PldmSubmitCommand (
+  IN     EDKII_PLDM_PROTOCOL  *This,
+  IN     UINT8                PldmType,
+  IN     UINT8                Command,
+  IN     UINT8                PldmTerminusSourceId,
+  IN     UINT8                PldmTerminusDestinationId,
+  IN     UINT8                *RequestData,
+  IN     UINT32               RequestDataSize,
+  OUT    UINT8                *ResponseData,
+  IN OUT UINT32               *ResponseDataSize
+  )
+{
+  EFI_STATUS  Status;
+  EFI_TPL     OldTpl;
+  BOOLEAN     TransportBusy;
+  UINT8       InstanceId;
+
+  //
+  // Check the given input parameters.
+  //
+  Status = PldmCheckCommandParameters (PldmType, Command, RequestData, RequestDataSize, ResponseData, ResponseDataSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Status = PldmAllocateInstanceId (&InstanceId);
+  if (EFI_ERROR (Status)) {
+    //
+    // Every instance ID is held by a queued asynchronous command. Send those
+    // first rather than failing a caller that waits for the response anyway.
+    //
+    gBS->RestoreTPL (OldTpl);
+    PldmSendQueuedRequests ();
+    OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+    Status = PldmAllocateInstanceId (&InstanceId);
+    if (EFI_ERROR (Status)) {
+      gBS->RestoreTPL (OldTpl);
+      return Status;
+    }
+  }
+
+  //
+  // The transport is only found busy when this is called from a notification
+  // function that interrupted the asynchronous worker. The worker can't
+  // resume before this returns, so waiting for it would hang; the command is
+  // sent right away instead, as before asynchronous commands existed. A
+  // response to an interrupted command carries another MCTP message tag and
+  // is discarded.
+  //
+  TransportBusy      = mPldmTransportBusy;
+  mPldmTransportBusy = TRUE;
+  gBS->RestoreTPL (OldTpl);
+
+  DEBUG ((DEBUG_MANAGEABILITY, "%a: Source terminus ID: 0x%x, Destination terminus ID: 0x%x.\n", __func__, PldmTerminusSourceId, PldmTerminusDestinationId));
   Status = CommonPldmSubmitCommand (
              mTransportToken,
              PldmType,
              Command,
              PldmTerminusSourceId,
              PldmTerminusDestinationId,
+             InstanceId,
              RequestData,
              RequestDataSize,
              ResponseData,
              ResponseDataSize
              );
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  PldmFreeInstanceId (InstanceId);
+  mPldmTransportBusy = TransportBusy;
+  gBS->RestoreTPL (OldTpl);
   return Status;
 }
 
-EDKII_PLDM_PROTOCOL_V1_0  mPldmProtocolV10 = {
-  PldmSubmitCommand
+/**
+  This service queues a command to be submitted via EDKII PLDM protocol, and
+  returns without waiting for the response.
+
+  @param[in]         This                       EDKII_PLDM_PROTOCOL instance.
+  @param[in]         PldmType                   PLDM message type.
+  @param[in]         Command                    PLDM Command of PLDM message type.
+  @param[in]         PldmTerminusSourceId       PLDM source teminus ID.
+  @param[in]         PldmTerminusDestinationId  PLDM destination teminus ID.
+  @param[in]         RequestData                Command Request Data. It is copied.
+  @param[in]         RequestDataSize            Size of Command Request Data.
+  @param[out]        ResponseData               Command Response Data. The completion code is the first byte of response data.
+  @param[in, out]    ResponseDataSize           Size of Command Response Data.
+  @param[in]         Token                      Completion token of the command.
+
+  @retval EFI_SUCCESS            The command is queued.
+  @retval EFI_NOT_READY          32 commands are already outstanding.
+  @retval EFI_OUT_OF_RESOURCES   The resource allcation is out of resource.
+  @retval EFI_INVALID_PARAMETER  One of the parameters is invalid.
+**/
+EFI_STATUS
+EFIAPI
+PldmSubmitCommandAsync (
+  IN     EDKII_PLDM_PROTOCOL          *This,
+  IN     UINT8                        PldmType,
+  IN     UINT8                        Command,
+  IN     UINT8                        PldmTerminusSourceId,
+  IN     UINT8                        PldmTerminusDestinationId,
+  IN     UINT8                        *RequestData,
+  IN     UINT32                       RequestDataSize,
+  OUT    UINT8                        *ResponseData,
+  IN OUT UINT32                       *ResponseDataSize,
+  IN     EDKII_PLDM_COMPLETION_TOKEN  *Token
+  )
+{
+  EFI_STATUS          Status;
+  EFI_TPL             OldTpl;
+  PLDM_ASYNC_REQUEST  *Request;
+
+  if ((Token == NULL) || (Token->Event == NULL)) {
+    DEBUG ((DEBUG_ERROR, "%a: No completion token for PLDM type: 0x%x, Command: 0x%x.\n", __func__, PldmType, Command));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Status = PldmCheckCommandParameters (PldmType, Command, RequestData, RequestDataSize, ResponseData, ResponseDataSize);
+  if (EFI_ERROR (Status)) {
+    return Status;
+  }
+
+  Request = AllocateZeroPool (sizeof (PLDM_ASYNC_REQUEST));
+  if (Request == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (RequestData != NULL) {
+    Request->RequestData = AllocateCopyPool (RequestDataSize, RequestData);
+    if (Request->RequestData == NULL) {
+      FreePool (Request);
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
+
+  Request->Signature                 = PLDM_ASYNC_REQUEST_SIGNATURE;
+  Request->PldmType                  = PldmType;
+  Request->Command                   = Command;
+  Request->PldmTerminusSourceId      = PldmTerminusSourceId;
+  Request->PldmTerminusDestinationId = PldmTerminusDestinationId;
+  Request->RequestDataSize           = RequestDataSize;
+  Request->ResponseData              = ResponseData;
+  Request->ResponseDataSize          = ResponseDataSize;
+  Request->Token                     = Token;
+  Token->Status                      = EFI_NOT_READY;
+
+  OldTpl = gBS->RaiseTPL (TPL_NOTIFY);
+  Status = PldmAllocateInstanceId (&Request->InstanceId);
+  if (!EFI_ERROR (Status)) {
+    if (IsListEmpty (&mPldmAsyncRequestQueue)) {
+      Status = gBS->SetTimer (mPldmAsyncEvent, TimerPeriodic, PLDM_ASYNC_TIMER_PERIOD);
+    }
+
+    if (EFI_ERROR (Status)) {
+      PldmFreeInstanceId (Request->InstanceId);
+    } else {
+      InsertTailList (&mPldmAsyncRequestQueue, &Request->Link);
+    }
+  }
+
+  gBS->RestoreTPL (OldTpl);
+
+  if (EFI_ERROR (Status)) {
+    if (Request->RequestData != NULL) {
+      FreePool (Request->RequestData);
+    }
+
+    FreePool (Request);
+    return Status;
+  }
+
+  DEBUG ((
+    DEBUG_MANAGEABILITY,
+    "%a: PLDM type: 0x%x, Command: 0x%x queued with instance ID %d.\n",
+    __func__,
+    PldmType,
+    Command,
+    Request->InstanceId
+    ));
+  return EFI_SUCCESS;
+}
+
+EDKII_PLDM_PROTOCOL_V1_1  mPldmProtocolV11 = {
+  PldmSubmitCommand,
+  PldmSubmitCommandAsync
 };
 
 EDKII_PLDM_PROTOCOL  mPldmProtocol;
@@ -187,9 +498,27 @@ DxePldmProtocolEntry (
     return Status;
   }
 
-  mPldmRequestInstanceId             = 0;
+  Status = gBS->CreateEvent (
+                  EVT_TIMER | EVT_NOTIFY_SIGNAL,
+                  TPL_CALLBACK,
+                  PldmAsyncRequestWorker,
+                  NULL,
+                  &mPldmAsyncEvent
+                  );
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "%a: Failed to create the event for asynchronous PLDM commands - %r\n", __func__, Status));
+    return Status;
+  }
+
+  mPldmRequestInstanceId = 0;
+  mPldmInstanceIdInUse   = 0;
+
+  //
+  // EDKII_PLDM_PROTOCOL_V1_1 starts with the functions of EDKII_PLDM_PROTOCOL_V1_0,
+  // so the callers of version 1.0 keep working.
+  //
   mPldmProtocol.ProtocolVersion      = EDKII_PLDM_PROTOCOL_VERSION;
-  mPldmProtocol.Functions.Version1_0 = &mPldmProtocolV10;
+  mPldmProtocol.Functions.Version1_1 = &mPldmProtocolV11;
   Handle                             = NULL;
   Status                             = gBS->InstallProtocolInterface (
                                               &Handle,
@@ -199,6 +528,8 @@ DxePldmProtocolEntry (
                                               );
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "%a: Failed to install EDKII PLDM protocol - %r\n", __func__, Status));
+    gBS->CloseEvent (mPldmAsyncEvent);
+    mPldmAsyncEvent = NULL;
   }
 
   return Status;
@@ -219,7 +550,29 @@ PldmProtocolUnloadImage (
   IN EFI_HANDLE  ImageHandle
   )
 {
-  EFI_STATUS  Status;
+  EFI_STATUS          Status;
+  PLDM_ASYNC_REQUEST  *Request;
+
+  if (mPldmAsyncEvent != NULL) {
+    gBS->CloseEvent (mPldmAsyncEvent);
+    mPldmAsyncEvent = NULL;
+  }
+
+  //
+  // Complete the commands that are still queued.
+  //
+  while (!IsListEmpty (&mPldmAsyncRequestQueue)) {
+    Request = PLDM_ASYNC_REQUEST_FROM_LINK (GetFirstNode (&mPldmAsyncRequestQueue));
+    RemoveEntryList (&Request->Link);
+    PldmFreeInstanceId (Request->InstanceId);
+    Request->Token->Status = EFI_ABORTED;
+    gBS->SignalEvent (Request->Token->Event);
+    if (Request->RequestData != NULL) {
+      FreePool (Request->RequestData);
+    }
+
+    FreePool (Request);
+  }
 
   Status = EFI_SUCCESS;
   if (mTransportToken != NULL) {
@@ -15,6 +15,8 @@
 #include <Library/DebugLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/SmbiosDigestLib.h>
 #include <Library/UefiBootServicesTableLib.h>
 #include <Library/UefiLib.h>
 #include <Library/BasePldmProtocolLib.h>
@@ -24,6 +26,8 @@
 #include <Protocol/PldmSmbiosTransferProtocol.h>
 #include <Protocol/Smbios.h>
 
+#define PLDM_SMBIOS_DIGEST_VARIABLE  L"PldmSmbiosDigest"
+
 UINT32  SetSmbiosStructureTableHandle;
 
 /**
@@ -270,6 +274,81 @@ GetSmbiosStructureTable (
   return EFI_UNSUPPORTED;
 }
 
+/**
+  This function checks whether the BMC already has the SMBIOS structure table
+  that is about to be sent, that is whether no structure changed since the
+  last successful transfer.
+
+  @param [in]   This          EDKII_PLDM_SMBIOS_TRANSFER_PROTOCOL instance.
+  @param [in]   DigestIndex   Digest index of the table to send.
+  @param [in]   TableLength   Length of the table to send.
+  @param [in]   Crc32         Integrity checksum of the table to send.
+
+  @retval       TRUE          The BMC has the table, it does not need to be sent.
+  @retval       FALSE         The table must be sent, including when the BMC
+                              can't report which table it has.
+**/
+STATIC
+BOOLEAN
+PldmSmbiosTableUnchanged (
+  IN  EDKII_PLDM_SMBIOS_TRANSFER_PROTOCOL  *This,
+  IN  SMBIOS_DIGEST_INDEX                  *DigestIndex,
+  IN  UINT16                               TableLength,
+  IN  UINT32                               Crc32
+  )
+{
+  EFI_STATUS                            Status;
+  SMBIOS_STRUCTURE_CHANGE               *Changes;
+  UINTN                                 ChangeCount;
+  UINTN                                 Index;
+  PLDM_SMBIOS_STRUCTURE_TABLE_METADATA  MetaData;
+
+  Status = SmbiosDigestIndexCompare (DigestIndex, &Changes, &ChangeCount);
+  if (EFI_ERROR (Status)) {
+    return FALSE;
+  }
+
+  if (ChangeCount != 0) {
+    //
+    // PLDM for SMBIOS Data Transfer has no command to set single structures,
+    // the whole table is sent.
+    //
+    for (Index = 0; Index < ChangeCount; Index++) {
+      DEBUG ((
+        DEBUG_MANAGEABILITY_INFO,
+        "%a: SMBIOS type %d handle 0x%04x %a.\n",
+        __func__,
+        Changes[Index].Type,
+        Changes[Index].Handle,
+        (Changes[Index].Change == SmbiosStructureAdded) ? "added" :
+        ((Changes[Index].Change == SmbiosStructureRemoved) ? "removed" : "changed")
+        ));
+    }
+
+    FreePool (Changes);
+    return FALSE;
+  }
+
+  //
+  // The BMC may have lost the table since the last transfer. Send it again
+  // unless the BMC confirms it still has the same table.
+  //
+  Status = GetSmbiosStructureTableMetaData (This, &MetaData);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: Can't get SMBIOS structure table metadata from BMC - %r.\n", __func__, Status));
+    return FALSE;
+  }
+
+  if ((MetaData.SmbiosStructureTableLength != TableLength) ||
+      (MetaData.SmbiosStructureTableIntegrityChecksum != Crc32))
+  {
+    DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: SMBIOS structure table on BMC differs.\n", __func__));
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
 /**
   This function sets SMBIOS structure table.
 
@@ -300,6 +379,7 @@ SetSmbiosStructureTable (
   UINT16                                   TableLength;
   EFI_SMBIOS_TABLE_HEADER                  *Record;
   PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST  *PldmSetSmbiosStructureTable;
+  SMBIOS_DIGEST_INDEX                      *DigestIndex;
 
   DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: Set SMBIOS structure table.\n", __func__));
 
@@ -393,6 +473,24 @@ SetSmbiosStructureTable (
   DataPointer += PaddingSize;
   CopyMem ((VOID *)DataPointer, (VOID *)&Crc32, 4);
 
+  DigestIndex = NULL;
+  if (PcdGetBool (PcdSendSmbiosOnChanged)) {
+    Status = SmbiosDigestIndexCreate (
+               PLDM_SMBIOS_DIGEST_VARIABLE,
+               (UINT8 *)(UINTN)SmbiosEntry->TableAddress,
+               TableLength,
+               &DigestIndex
+               );
+    if (EFI_ERROR (Status)) {
+      DigestIndex = NULL;
+    } else if (PldmSmbiosTableUnchanged (This, DigestIndex, TableLength, Crc32)) {
+      DEBUG ((DEBUG_MANAGEABILITY_INFO, "%a: SMBIOS structure table is not changed, skip the transfer.\n", __func__));
+      SmbiosDigestIndexFree (DigestIndex);
+      FreePool (RequestBuffer);
+      return EFI_SUCCESS;
+    }
+  }
+
   PldmSetSmbiosStructureTable                     = (PLDM_SET_SMBIOS_STRUCTURE_TABLE_REQUEST *)RequestBuffer;
   PldmSetSmbiosStructureTable->DataTransferHandle = SetSmbiosStructureTableHandle;
   PldmSetSmbiosStructureTable->TransferFlag       = PLDM_TRANSFER_FLAG_START_AND_END;
@@ -414,6 +512,16 @@ SetSmbiosStructureTable (
     DEBUG ((DEBUG_ERROR, "%a: Set SMBIOS structure table.\n", __func__));
   }
 
+  if (DigestIndex != NULL) {
+    if (EFI_ERROR (Status)) {
+      SmbiosDigestIndexInvalidate (DigestIndex);
+    } else {
+      SmbiosDigestIndexSave (DigestIndex);
+    }
+
+    SmbiosDigestIndexFree (DigestIndex);
+  }
+
   if ((ResponseSize != 0) && (ResponseSize <= sizeof (SetSmbiosStructureTableHandle))) {
     HelperManageabilityDebugPrint (
       (VOID *)&SetSmbiosStructureTableHandle,
@@ -23,12 +23,162 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/LargeVariableWriteLib.h>
 #include <Library/PcdLib.h>
 #include <Library/VariableWriteLib.h>
+#include <Library/TestPointCheckLib.h>
 #include <Guid/FspNonVolatileStorageHob2.h>
 
+#define FSP_NVS_BUFFER_DIGEST_SIGNATURE   SIGNATURE_32 ('F', 'N', 'V', 'D')
+#define FSP_NVS_BUFFER_DIGEST_BLOCK_SIZE  SIZE_4KB
+
+///
+/// Digest map of the FSP NVS data saved in the FspNvsBuffer variable, kept in
+/// the FspNvsBufferDigest variable. It tells whether the FSP NVS data of this
+/// boot is the same as the saved one without compressing it nor reading the
+/// FspNvsBuffer variable back.
+///
+typedef struct {
+  UINT32    Signature;
+  UINT32    BlockSize;
+  UINT32    DataSize;       ///< Size of the FSP NVS data, before compression.
+  UINT32    StoredSize;     ///< Size of the FspNvsBuffer variable.
+  UINT32    Compressed;     ///< The FspNvsBuffer variable holds compressed data.
+  UINT32    BlockCount;
+  // UINT32 BlockDigest[BlockCount];  ///< CRC32 of each block of the FSP NVS data.
+} FSP_NVS_BUFFER_DIGEST;
+
+#define FSP_NVS_BUFFER_DIGEST_SIZE(BlockCount)  (sizeof (FSP_NVS_BUFFER_DIGEST) + (BlockCount) * sizeof (UINT32))
+
+/**
+  Builds the digest map of FSP NVS data.
+
+  @param[in] Data           The FSP NVS data.
+  @param[in] DataSize       Size of the FSP NVS data in bytes.
+  @param[in] Compressed     TRUE if the data is saved compressed.
+
+  @return The digest map, or NULL if out of resources. StoredSize is 0.
+**/
+FSP_NVS_BUFFER_DIGEST *
+CreateFspNvsBufferDigest (
+  IN VOID     *Data,
+  IN UINTN    DataSize,
+  IN BOOLEAN  Compressed
+  )
+{
+  FSP_NVS_BUFFER_DIGEST  *Digest;
+  UINT32                 *BlockDigest;
+  UINTN                  BlockCount;
+  UINTN                  Index;
+  UINTN                  Offset;
+
+  BlockCount = (DataSize + FSP_NVS_BUFFER_DIGEST_BLOCK_SIZE - 1) / FSP_NVS_BUFFER_DIGEST_BLOCK_SIZE;
+  Digest     = AllocateZeroPool (FSP_NVS_BUFFER_DIGEST_SIZE (BlockCount));
+  if (Digest == NULL) {
+    return NULL;
+  }
+
+  Digest->Signature  = FSP_NVS_BUFFER_DIGEST_SIGNATURE;
+  Digest->BlockSize  = FSP_NVS_BUFFER_DIGEST_BLOCK_SIZE;
+  Digest->DataSize   = (UINT32)DataSize;
+  Digest->Compressed = Compressed;
+  Digest->BlockCount = (UINT32)BlockCount;
+
+  BlockDigest = (UINT32 *)(Digest + 1);
+  for (Index = 0, Offset = 0; Index < BlockCount; Index++, Offset += FSP_NVS_BUFFER_DIGEST_BLOCK_SIZE) {
+    BlockDigest[Index] = CalculateCrc32 (
+                           (UINT8 *)Data + Offset,
+                           MIN (DataSize - Offset, FSP_NVS_BUFFER_DIGEST_BLOCK_SIZE)
+                           );
+  }
+
+  return Digest;
+}
+
+/**
+  Reads the digest map of the FSP NVS data saved in a previous boot.
+
+  @return The digest map, or NULL if there is no valid one.
+**/
+FSP_NVS_BUFFER_DIGEST *
+GetSavedFspNvsBufferDigest (
+  VOID
+  )
+{
+  EFI_STATUS             Status;
+  FSP_NVS_BUFFER_DIGEST  *Digest;
+  UINTN                  DigestSize;
+
+  DigestSize = 0;
+  Status     = GetLargeVariable (L"FspNvsBufferDigest", &gFspNvsBufferVariableGuid, &DigestSize, NULL);
+  if ((Status != EFI_BUFFER_TOO_SMALL) || (DigestSize < sizeof (FSP_NVS_BUFFER_DIGEST))) {
+    return NULL;
+  }
+
+  Digest = AllocatePool (DigestSize);
+  if (Digest == NULL) {
+    return NULL;
+  }
+
+  Status = GetLargeVariable (L"FspNvsBufferDigest", &gFspNvsBufferVariableGuid, &DigestSize, Digest);
+  if (EFI_ERROR (Status) ||
+      (Digest->Signature != FSP_NVS_BUFFER_DIGEST_SIGNATURE) ||
+      (DigestSize != FSP_NVS_BUFFER_DIGEST_SIZE (Digest->BlockCount)))
+  {
+    FreePool (Digest);
+    return NULL;
+  }
+
+  return Digest;
+}
+
+/**
+  Counts the blocks of the FSP NVS data that changed since it was saved.
+
+  @param[in] Digest         The digest map of the FSP NVS data of this boot.
+  @param[in] SavedDigest    The digest map of the saved FSP NVS data, or NULL.
+
+  @return The number of blocks that changed. All of them when the digest maps
+          cannot be compared.
+**/
+UINTN
+CountChangedBlocks (
+  IN FSP_NVS_BUFFER_DIGEST  *Digest,
+  IN FSP_NVS_BUFFER_DIGEST  *SavedDigest  OPTIONAL
+  )
+{
+  UINT32  *BlockDigest;
+  UINT32  *SavedBlockDigest;
+  UINTN   ChangedBlocks;
+  UINTN   Index;
+
+  if ((SavedDigest == NULL) ||
+      (SavedDigest->BlockSize != Digest->BlockSize) ||
+      (SavedDigest->DataSize != Digest->DataSize) ||
+      (SavedDigest->Compressed != Digest->Compressed) ||
+      (SavedDigest->BlockCount != Digest->BlockCount))
+  {
+    return Digest->BlockCount;
+  }
+
+  BlockDigest      = (UINT32 *)(Digest + 1);
+  SavedBlockDigest = (UINT32 *)(SavedDigest + 1);
+  ChangedBlocks    = 0;
+  for (Index = 0; Index < Digest->BlockCount; Index++) {
+    if (BlockDigest[Index] != SavedBlockDigest[Index]) {
+      ChangedBlocks++;
+    }
+  }
+
+  return ChangedBlocks;
+}
+
 /**
   This is the standard EFI driver point that detects whether there is a
   MemoryConfigurationData HOB and, if so, saves its data to nvRAM.
 
+  The FSP NVS data is compared with the digest map of the data saved in a
+  previous boot first. When it did not change, it is neither compressed nor
+  written. Otherwise only the variables of FspNvsBuffer whose data changed are
+  written.
+
   @param[in] ImageHandle    Handle for the image of this driver
   @param[in] SystemTable    Pointer to the EFI System Table
 
@@ -41,26 +191,29 @@ SaveMemoryConfigEntryPoint (
   IN EFI_SYSTEM_TABLE   *SystemTable
   )
 {
-  EFI_STATUS         Status;
-  EFI_HOB_GUID_TYPE  *GuidHob;
-  VOID               *HobData;
-  VOID               *VariableData;
-  UINTN              DataSize;
-  UINTN              BufferSize;
-  BOOLEAN            DataIsIdentical;
-  VOID               *CompressedData;
-  UINT64             CompressedSize;
-  UINTN              CompressedAllocationPages;
+  EFI_STATUS                       Status;
+  EFI_HOB_GUID_TYPE                *GuidHob;
+  VOID                             *HobData;
+  UINTN                            DataSize;
+  UINTN                            BufferSize;
+  VOID                             *CompressedData;
+  UINT64                           CompressedSize;
+  UINTN                            CompressedAllocationPages;
+  FSP_NVS_BUFFER_DIGEST            *Digest;
+  FSP_NVS_BUFFER_DIGEST            *SavedDigest;
+  UINTN                            ChangedBlocks;
+  LARGE_VARIABLE_WRITE_STATISTICS  Statistics;
 
   DataSize                  = 0;
   BufferSize                = 0;
-  VariableData              = NULL;
   GuidHob                   = NULL;
   HobData                   = NULL;
-  DataIsIdentical           = FALSE;
   CompressedData            = NULL;
   CompressedSize            = 0;
   CompressedAllocationPages = 0;
+  Digest                    = NULL;
+  SavedDigest               = NULL;
+  ZeroMem (&Statistics, sizeof (Statistics));
 
   //
   // Search for the Memory Configuration GUID HOB.  If it is not present, then
@@ -82,14 +235,71 @@ SaveMemoryConfigEntryPoint (
     }
   }
 
-  if (PcdGetBool (PcdEnableCompressedFspNvsBuffer)) {
-    if (DataSize > 0) {
+  if (HobData == NULL) {
+    DEBUG((DEBUG_ERROR, "Memory S3 Data HOB was not found\n"));
+    return EFI_REQUEST_UNLOAD_IMAGE;
+  }
+
+  DEBUG ((DEBUG_INFO, "FspNvsHob.NvsDataLength:%d\n", DataSize));
+  DEBUG ((DEBUG_INFO, "FspNvsHob.NvsDataPtr   : 0x%x\n", HobData));
+  if (DataSize == 0) {
+    return EFI_REQUEST_UNLOAD_IMAGE;
+  }
+
+  //
+  // Check if the presently saved data is identical to the data given by MRC/FSP
+  //
+  Digest = CreateFspNvsBufferDigest (HobData, DataSize, PcdGetBool (PcdEnableCompressedFspNvsBuffer));
+  if (Digest == NULL) {
+    DEBUG ((DEBUG_ERROR, "[%a] - Failed to allocate digest map.\n", __func__));
+    ASSERT_EFI_ERROR (EFI_OUT_OF_RESOURCES);
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  SavedDigest   = GetSavedFspNvsBufferDigest ();
+  ChangedBlocks = CountChangedBlocks (Digest, SavedDigest);
+  Status        = GetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, &BufferSize, NULL);
+  if ((ChangedBlocks == 0) && (Status == EFI_BUFFER_TOO_SMALL) && (BufferSize == SavedDigest->StoredSize)) {
+    DataSize = BufferSize;
+    //
+    // No need to update Variable, only lock it.
+    //
+    Status = LockLargeVariable (L"FspNvsBuffer",  &gFspNvsBufferVariableGuid);
+    if (!EFI_ERROR (Status)) {
+      Status = LockLargeVariable (L"FspNvsBufferDigest", &gFspNvsBufferVariableGuid);
+    }
+    if (EFI_ERROR (Status)) {
+      //
+      // Fail to lock variable is security vulnerability and should not happen.
+      //
+      ASSERT_EFI_ERROR (Status);
+      //
+      // When building without ASSERT_EFI_ERROR hang, delete the variable so it will not be consumed.
+      //
+      DEBUG ((DEBUG_ERROR, "Delete variable!\n"));
+      DataSize = 0;
+      SetLargeVariable (L"FspNvsBufferDigest", &gFspNvsBufferVariableGuid, FALSE, 0, NULL);
+      Status = SetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, FALSE, DataSize, NULL);
+      ASSERT_EFI_ERROR (Status);
+    }
+    DEBUG ((DEBUG_INFO, "FSP / MRC Training Data is identical to data from last boot, no need to save.\n"));
+  } else {
+    DEBUG ((DEBUG_INFO, "FSP / MRC Training Data changed in %d of %d blocks\n", ChangedBlocks, Digest->BlockCount));
+
+    //
+    // Delete the digest map first, so that data only partially saved is never
+    // taken for up to date.
+    //
+    SetLargeVariable (L"FspNvsBufferDigest", &gFspNvsBufferVariableGuid, FALSE, 0, NULL);
+
+    if (PcdGetBool (PcdEnableCompressedFspNvsBuffer)) {
       CompressedAllocationPages = EFI_SIZE_TO_PAGES (DataSize);
       CompressedData            = AllocatePages (CompressedAllocationPages);
       if (CompressedData == NULL) {
         DEBUG ((DEBUG_ERROR, "[%a] - Failed to allocate compressed data buffer.\n", __func__));
         ASSERT_EFI_ERROR (EFI_OUT_OF_RESOURCES);
-        return EFI_OUT_OF_RESOURCES;
+        Status = EFI_OUT_OF_RESOURCES;
+        goto Done;
       }
 
       CompressedSize = EFI_PAGES_TO_SIZE (CompressedAllocationPages);
@@ -97,81 +307,61 @@ SaveMemoryConfigEntryPoint (
       if (EFI_ERROR (Status)) {
         DEBUG ((DEBUG_ERROR, "[%a] - failed to compress data. Status = %r\n", __func__, Status));
         ASSERT_EFI_ERROR (Status);
-        return Status;
+        goto Done;
       }
-    }
 
-    HobData  = CompressedData;
-    DataSize = (UINTN)CompressedSize;
-  }
+      HobData  = CompressedData;
+      DataSize = (UINTN)CompressedSize;
+    }
 
-  if (HobData != NULL) {
-    DEBUG ((DEBUG_INFO, "FspNvsHob.NvsDataLength:%d\n", DataSize));
-    DEBUG ((DEBUG_INFO, "FspNvsHob.NvsDataPtr   : 0x%x\n", HobData));
-    if (DataSize > 0) {
+    //
+    // Only the variables of FspNvsBuffer whose data changed are written.
+    //
+    Status = UpdateLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, TRUE, DataSize, HobData, &Statistics);
+    if (Status == EFI_ABORTED) {
       //
-      // Check if the presently saved data is identical to the data given by MRC/FSP
+      // Fail to lock variable! This should not happen.
       //
-      Status = GetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, &BufferSize, NULL);
-      if (Status == EFI_BUFFER_TOO_SMALL) {
-        if (BufferSize == DataSize) {
-          VariableData = AllocatePool (BufferSize);
-          if (VariableData != NULL) {
-            Status = GetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, &BufferSize, VariableData);
-            if (!EFI_ERROR (Status) && (BufferSize == DataSize) && (0 == CompareMem (HobData, VariableData, DataSize))) {
-              DataIsIdentical = TRUE;
-              //
-              // No need to update Variable, only lock it.
-              //
-              Status = LockLargeVariable (L"FspNvsBuffer",  &gFspNvsBufferVariableGuid);
-              if (EFI_ERROR (Status)) {
-                //
-                // Fail to lock variable is security vulnerability and should not happen.
-                //
-                ASSERT_EFI_ERROR (Status);
-                //
-                // When building without ASSERT_EFI_ERROR hang, delete the variable so it will not be consumed.
-                //
-                DEBUG ((DEBUG_ERROR, "Delete variable!\n"));
-                DataSize = 0;
-                Status = SetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, FALSE, DataSize, HobData);
-                ASSERT_EFI_ERROR (Status);
-              }
-            }
-            FreePool (VariableData);
-          }
-        }
-      }
-      Status = EFI_SUCCESS;
-
-      if (!DataIsIdentical) {
-        Status = SetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, TRUE, DataSize, HobData);
-        if (Status == EFI_ABORTED) {
-          //
-          // Fail to lock variable! This should not happen.
-          //
-          ASSERT_EFI_ERROR (Status);
-          //
-          // When building without ASSERT_EFI_ERROR hang, delete the variable so it will not be consumed.
-          //
-          DEBUG ((DEBUG_ERROR, "Delete variable!\n"));
-          DataSize = 0;
-          Status = SetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, FALSE, DataSize, HobData);
-        }
-        ASSERT_EFI_ERROR (Status);
-        DEBUG ((DEBUG_INFO, "Saved size of FSP / MRC Training Data: 0x%x\n", DataSize));
-      } else {
-        DEBUG ((DEBUG_INFO, "FSP / MRC Training Data is identical to data from last boot, no need to save.\n"));
+      ASSERT_EFI_ERROR (Status);
+      //
+      // When building without ASSERT_EFI_ERROR hang, delete the variable so it will not be consumed.
+      //
+      DEBUG ((DEBUG_ERROR, "Delete variable!\n"));
+      DataSize = 0;
+      Status = SetLargeVariable (L"FspNvsBuffer", &gFspNvsBufferVariableGuid, FALSE, DataSize, HobData);
+    } else if (!EFI_ERROR (Status)) {
+      Digest->StoredSize = (UINT32)DataSize;
+      if (EFI_ERROR (SetLargeVariable (L"FspNvsBufferDigest", &gFspNvsBufferVariableGuid, TRUE, FSP_NVS_BUFFER_DIGEST_SIZE (Digest->BlockCount), Digest))) {
+        //
+        // Without the digest map, the data is compared again in the next boot.
+        //
+        SetLargeVariable (L"FspNvsBufferDigest", &gFspNvsBufferVariableGuid, FALSE, 0, NULL);
       }
     }
-  } else {
-    DEBUG((DEBUG_ERROR, "Memory S3 Data HOB was not found\n"));
+    ASSERT_EFI_ERROR (Status);
+    DEBUG ((DEBUG_INFO, "Saved size of FSP / MRC Training Data: 0x%x\n", DataSize));
+    DEBUG ((
+      DEBUG_INFO,
+      "FSP / MRC Training Data: %d of %d variables written, 0x%x bytes written\n",
+      Statistics.VariablesWritten,
+      Statistics.VariableCount,
+      Statistics.BytesWritten
+      ));
   }
 
+Done:
+  TestPointFspNvsBufferSaved (Status, DataSize, Statistics.VariableCount, Statistics.VariablesWritten, Statistics.BytesWritten);
+
   if (CompressedData != NULL) {
     FreePages (CompressedData, CompressedAllocationPages);
   }
 
+  if (SavedDigest != NULL) {
+    FreePool (SavedDigest);
+  }
+
+  FreePool (Digest);
+
   //
   // This driver does not produce any protocol services, so always unload it.
   //
@@ -26,6 +26,16 @@
 
 #include <Uefi/UefiBaseType.h>
 
+///
+/// What UpdateLargeVariable() did to the variables a large variable is split in.
+///
+typedef struct {
+  UINTN    VariableCount;       ///< Number of variables the data is stored in.
+  UINTN    VariablesWritten;    ///< Number of variables written, the others were unchanged.
+  UINTN    VariablesDeleted;    ///< Number of variables deleted that the data no longer needs.
+  UINTN    BytesWritten;        ///< Number of data bytes written.
+} LARGE_VARIABLE_WRITE_STATISTICS;
+
 /**
   Sets the value of a large variable.
 
@@ -66,6 +76,53 @@ SetLargeVariable (
   IN  VOID                         *Data
   );
 
+/**
+  Sets the value of a large variable, writing only the variables whose data changed.
+
+  The data is split in the same variables as SetLargeVariable() does. Each of
+  them that already holds its part of the data is kept as is, so only the parts
+  of the data that changed cost a write to the variable storage. The variables
+  the data no longer needs are deleted.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+                                 Each VariableName is unique for each VendorGuid. VariableName must
+                                 contain 1 or more characters. If VariableName is an empty string,
+                                 then EFI_INVALID_PARAMETER is returned.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+  @param[in]  LockVariable       If TRUE, any further writes to the variable will be prevented until the next reset.
+                                 Note: LockVariable must be FALSE when running in SMM or after ExitBootServices.
+  @param[in]  DataSize           The size in bytes of the Data buffer. A size of zero causes the variable to be deleted.
+                                 If DataSize is zero, then LockVariable must be FALSE since a variable that does not
+                                 exist cannot be locked.
+  @param[in]  Data               The contents for the variable.
+  @param[out] Statistics         Optional pointer to receive what was written.
+
+  @retval EFI_SUCCESS            The firmware has successfully stored the variable and its data as
+                                 defined by the Attributes.
+  @retval EFI_INVALID_PARAMETER  An invalid combination of LockVariable, name, and GUID was supplied, or the
+                                 DataSize exceeds the maximum allowed.
+  @retval EFI_INVALID_PARAMETER  VariableName is an empty string.
+  @retval EFI_INVALID_PARAMETER  DataSize is zero and LockVariable is TRUE
+  @retval EFI_OUT_OF_RESOURCES   Not enough storage is available to hold the variable and its data.
+  @retval EFI_OUT_OF_RESOURCES   The VariableName is longer than 1018 characters
+  @retval EFI_DEVICE_ERROR       The variable could not be retrieved due to a hardware error.
+  @retval EFI_WRITE_PROTECTED    The variable in question is read-only.
+  @retval EFI_WRITE_PROTECTED    The variable in question cannot be deleted.
+  @retval EFI_ABORTED            LockVariable was requested but failed.
+  @retval EFI_NOT_FOUND          The variable trying to be updated or deleted was not found.
+
+**/
+EFI_STATUS
+EFIAPI
+UpdateLargeVariable (
+  IN  CHAR16                           *VariableName,
+  IN  EFI_GUID                         *VendorGuid,
+  IN  BOOLEAN                          LockVariable,
+  IN  UINTN                            DataSize,
+  IN  VOID                             *Data,
+  OUT LARGE_VARIABLE_WRITE_STATISTICS  *Statistics    OPTIONAL
+  );
+
 /**
   Locks the existing large variable.
 
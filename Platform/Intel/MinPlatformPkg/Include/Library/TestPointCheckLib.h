@@ -607,6 +607,95 @@ TestPointSmmReadyToBootSmmPageProtection (
   VOID
   );
 
+/**
+  This service verifies the FSP NVS buffer is saved, and reports what saving it
+  wrote to the variable storage.
+
+  Test subject: FSP NVS buffer.
+  Test overview: Verify the FSP NVS buffer is saved, and dump the number of
+                 variables and bytes written.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @param[in]  SaveStatus        The status of saving the FSP NVS buffer.
+  @param[in]  DataSize          The size of the FSP NVS buffer as stored, in bytes.
+  @param[in]  VariableCount     The number of variables the FSP NVS buffer is stored in.
+  @param[in]  VariablesWritten  The number of those variables written in this boot.
+  @param[in]  BytesWritten      The number of bytes written in this boot.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointFspNvsBufferSaved (
+  IN EFI_STATUS  SaveStatus,
+  IN UINTN       DataSize,
+  IN UINTN       VariableCount,
+  IN UINTN       VariablesWritten,
+  IN UINTN       BytesWritten
+  );
+
+/**
+  This service verifies the boot time at the end of PEI is within the budget
+  of the platform.
+
+  Test subject: Boot performance at the end of PEI.
+  Test overview: Compare the time elapsed since reset, taken from the
+                 performance counter as the FPDT records are, with
+                 PcdTestPointEndOfPeiBootTimeBudget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfPeiBootPerformance (
+  VOID
+  );
+
+/**
+  This service verifies the boot time at the end of DXE is within the budget
+  of the platform.
+
+  Test subject: Boot performance at the end of DXE.
+  Test overview: Compare the time elapsed since reset, taken from the
+                 performance counter as the FPDT records are, with
+                 PcdTestPointEndOfDxeBootTimeBudget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfDxeBootPerformance (
+  VOID
+  );
+
+/**
+  This service verifies the boot time at ready to boot is within the budget
+  of the platform.
+
+  Test subject: Boot performance at ready to boot.
+  Test overview: Compare the time elapsed since reset, taken from the
+                 performance counter as the FPDT records are, with
+                 PcdTestPointReadyToBootBootTimeBudget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointReadyToBootBootPerformance (
+  VOID
+  );
+
 /**
   This service verifies the system state after Exit Boot Services is invoked.
 
@@ -770,6 +859,22 @@ TestPointSmmExitBootServices (
 #define   TEST_POINT_BYTE8_READY_TO_BOOT_HSTI_TABLE_FUNCTIONAL_ERROR_CODE                        L"0x08010000"
 #define   TEST_POINT_BYTE8_READY_TO_BOOT_HSTI_TABLE_FUNCTIONAL_ERROR_STRING                      L"No HSTI\r\n"
 
+// Byte 9 - Boot Performance
+#define TEST_POINT_FSP_NVS_BUFFER_SAVED                                                     L" - FSP NVS Buffer Saved - "
+
+#define TEST_POINT_BYTE9_FSP_NVS_BUFFER_SAVED_FUNCTIONAL                                    BIT0
+#define TEST_POINT_BYTE9_END_OF_PEI_BOOT_TIME_WITHIN_BUDGET                                 BIT1
+#define TEST_POINT_BYTE9_END_OF_DXE_BOOT_TIME_WITHIN_BUDGET                                 BIT2
+#define TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_TIME_WITHIN_BUDGET                              BIT3
+#define   TEST_POINT_BYTE9_FSP_NVS_BUFFER_SAVED_FUNCTIONAL_ERROR_CODE                            L"0x09000000"
+#define   TEST_POINT_BYTE9_FSP_NVS_BUFFER_SAVED_FUNCTIONAL_ERROR_STRING                          L"FSP NVS buffer not saved\r\n"
+#define   TEST_POINT_BYTE9_END_OF_PEI_BOOT_TIME_WITHIN_BUDGET_ERROR_CODE                         L"0x09010000"
+#define   TEST_POINT_BYTE9_END_OF_PEI_BOOT_TIME_WITHIN_BUDGET_ERROR_STRING                       L"Boot time over budget\r\n"
+#define   TEST_POINT_BYTE9_END_OF_DXE_BOOT_TIME_WITHIN_BUDGET_ERROR_CODE                         L"0x09020000"
+#define   TEST_POINT_BYTE9_END_OF_DXE_BOOT_TIME_WITHIN_BUDGET_ERROR_STRING                       L"Boot time over budget\r\n"
+#define   TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_TIME_WITHIN_BUDGET_ERROR_CODE                      L"0x09030000"
+#define   TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_TIME_WITHIN_BUDGET_ERROR_STRING                    L"Boot time over budget\r\n"
+
 #pragma pack (1)
 
 typedef struct {
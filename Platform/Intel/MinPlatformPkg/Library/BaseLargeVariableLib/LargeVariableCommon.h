@@ -11,6 +11,9 @@
   will be incremented for each variable as needed to retrieve the entire data
   set.
 
+  The variables of such a multi-variable set may be described by an index
+  variable, see LARGE_VARIABLE_INDEX.
+
   Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
   SPDX-License-Identifier: BSD-2-Clause-Patent
 
@@ -51,4 +54,39 @@
 //
 #define MAX_VARIABLE_NAME_PAD_SIZE  3
 
+//
+// A multi-variable set may have an index variable, whose name is the name of
+// the set followed by LARGE_VARIABLE_INDEX_SUFFIX. The index records the size
+// and the CRC32 of each variable of the set, so the set is read without
+// probing for its variables, and a write can tell which variables already hold
+// their part of the data. The index is only a hint: it is checked against the
+// variables, and the variables are probed when it is missing or does not match
+// them, as for a set written without an index.
+//
+#define LARGE_VARIABLE_INDEX_SUFFIX     L"#"
+#define LARGE_VARIABLE_INDEX_SIGNATURE  SIGNATURE_32 ('L', 'V', 'I', 'X')
+#define LARGE_VARIABLE_INDEX_VERSION    1
+
+typedef struct {
+  UINT32    Size;
+  UINT32    Crc32;
+} LARGE_VARIABLE_INDEX_ENTRY;
+
+typedef struct {
+  UINT32    Signature;
+  UINT32    Version;
+  UINT32    VariableCount;
+  UINT32    Reserved;
+  UINT64    TotalSize;
+  //
+  // LARGE_VARIABLE_INDEX_ENTRY  Entry[VariableCount];
+  //
+} LARGE_VARIABLE_INDEX;
+
+#define LARGE_VARIABLE_INDEX_SIZE(VariableCount) \
+  (sizeof (LARGE_VARIABLE_INDEX) + (VariableCount) * sizeof (LARGE_VARIABLE_INDEX_ENTRY))
+
+#define LARGE_VARIABLE_INDEX_ENTRIES(VariableIndex) \
+  ((LARGE_VARIABLE_INDEX_ENTRY *) ((LARGE_VARIABLE_INDEX *) (VariableIndex) + 1))
+
 #endif  // _LARGE_VARIABLE_COMMON_H_
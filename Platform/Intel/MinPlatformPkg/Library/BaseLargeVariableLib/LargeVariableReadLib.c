@@ -19,11 +19,146 @@
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
 #include <Library/PrintLib.h>
 #include <Library/VariableReadLib.h>
 
 #include "LargeVariableCommon.h"
 
+/**
+  Returns the value of a multi-variable set, using the index of the set.
+
+  The index gives the number and the sizes of the variables of the set, so
+  each variable is read once, straight to its place in Data. The data read is
+  checked against the index, so an index that no longer matches the variables
+  is ignored.
+
+  @param[in]       VariableName  A Null-terminated string that is the name of the vendor's
+                                 variable.
+  @param[in]       VendorGuid    A unique identifier for the vendor.
+  @param[in, out]  DataSize      On input, the size in bytes of the return Data buffer.
+                                 On output the size of data returned in Data.
+  @param[out]      Data          The buffer to return the contents of the variable. May be NULL
+                                 with a zero DataSize in order to determine the size buffer needed.
+
+  @retval EFI_SUCCESS            The function completed successfully.
+  @retval EFI_BUFFER_TOO_SMALL   The DataSize is too small for the result.
+  @retval EFI_INVALID_PARAMETER  The DataSize is not too small and Data is NULL.
+  @retval EFI_NOT_FOUND          The set has no index, or the index does not match the variables.
+
+**/
+EFI_STATUS
+GetLargeVariableFromIndex (
+  IN     CHAR16                      *VariableName,
+  IN     EFI_GUID                    *VendorGuid,
+  IN OUT UINTN                       *DataSize,
+  OUT    VOID                        *Data           OPTIONAL
+  )
+{
+  CHAR16                      TempVariableName[MAX_VARIABLE_NAME_SIZE];
+  EFI_STATUS                  Status;
+  LARGE_VARIABLE_INDEX        *VariableIndex;
+  LARGE_VARIABLE_INDEX_ENTRY  *Entry;
+  UINTN                       IndexSize;
+  UINTN                       VarDataSize;
+  UINTN                       Index;
+  UINT64                      TotalSize;
+  UINT8                       *OffsetPtr;
+
+  ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%s", VariableName, LARGE_VARIABLE_INDEX_SUFFIX);
+  IndexSize = 0;
+  Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &IndexSize, NULL);
+  if ((Status != EFI_BUFFER_TOO_SMALL) || (IndexSize < sizeof (LARGE_VARIABLE_INDEX))) {
+    return EFI_NOT_FOUND;
+  }
+
+  VariableIndex = AllocatePool (IndexSize);
+  if (VariableIndex == NULL) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = EFI_NOT_FOUND;
+  if (EFI_ERROR (VarLibGetVariable (TempVariableName, VendorGuid, NULL, &IndexSize, VariableIndex)) ||
+      (VariableIndex->Signature != LARGE_VARIABLE_INDEX_SIGNATURE) ||
+      (VariableIndex->Version != LARGE_VARIABLE_INDEX_VERSION) ||
+      (VariableIndex->VariableCount == 0) ||
+      (VariableIndex->VariableCount > MAX_VARIABLE_SPLIT) ||
+      (IndexSize != LARGE_VARIABLE_INDEX_SIZE (VariableIndex->VariableCount)) ||
+      (VariableIndex->TotalSize > MAX_UINTN)) {
+    DEBUG ((DEBUG_WARN, "GetLargeVariable: Invalid index %s, Guid = %g\n", TempVariableName, VendorGuid));
+    goto Done;
+  }
+
+  Entry     = LARGE_VARIABLE_INDEX_ENTRIES (VariableIndex);
+  TotalSize = 0;
+  for (Index = 0; Index < VariableIndex->VariableCount; Index++) {
+    TotalSize += Entry[Index].Size;
+  }
+  if (TotalSize != VariableIndex->TotalSize) {
+    DEBUG ((DEBUG_WARN, "GetLargeVariable: Invalid index %s, Guid = %g\n", TempVariableName, VendorGuid));
+    goto Done;
+  }
+
+  //
+  // The set may have been written since the index was, by an implementation
+  // that does not know about the index. A variable after the last one, or a
+  // last one of another size, means the index is stale.
+  //
+  ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, VariableIndex->VariableCount);
+  VarDataSize = 0;
+  if (VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VarDataSize, NULL) != EFI_NOT_FOUND) {
+    goto Done;
+  }
+
+  if (*DataSize < TotalSize) {
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, VariableIndex->VariableCount - 1);
+    VarDataSize = 0;
+    if ((VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VarDataSize, NULL) == EFI_BUFFER_TOO_SMALL) &&
+        (VarDataSize == Entry[VariableIndex->VariableCount - 1].Size)) {
+      *DataSize = (UINTN) TotalSize;
+      Status    = EFI_BUFFER_TOO_SMALL;
+    }
+    goto Done;
+  }
+
+  if (Data == NULL) {
+    Status = EFI_INVALID_PARAMETER;
+    goto Done;
+  }
+
+  //
+  // Read the data from all variables, each one checked against the index.
+  //
+  DEBUG ((DEBUG_VERBOSE, "GetLargeVariable: Index Found, NumVariables = %d\n", VariableIndex->VariableCount));
+  OffsetPtr = (UINT8 *) Data;
+  for (Index = 0; Index < VariableIndex->VariableCount; Index++) {
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+    VarDataSize = Entry[Index].Size;
+    DEBUG ((DEBUG_INFO, "Reading %s, Guid = %g,", TempVariableName, VendorGuid));
+    Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VarDataSize, (VOID *) OffsetPtr);
+    DEBUG ((DEBUG_INFO, " Size %d\n", VarDataSize));
+    if (EFI_ERROR (Status) ||
+        (VarDataSize != Entry[Index].Size) ||
+        (CalculateCrc32 (OffsetPtr, VarDataSize) != Entry[Index].Crc32)) {
+      DEBUG ((DEBUG_WARN, "GetLargeVariable: %s does not match the index\n", TempVariableName));
+      Status = EFI_NOT_FOUND;
+      goto Done;
+    }
+    OffsetPtr += VarDataSize;
+  }
+
+  *DataSize = (UINTN) TotalSize;
+  Status    = EFI_SUCCESS;
+
+Done:
+  FreePool (VariableIndex);
+  return Status;
+}
+
 /**
   Returns the value of a large variable.
 
@@ -95,6 +230,14 @@ GetLargeVariable (
       goto Done;
     }
 
+    //
+    // Read the variables as the index of the set lists them, if it has one.
+    //
+    Status = GetLargeVariableFromIndex (VariableName, VendorGuid, DataSize, Data);
+    if (Status != EFI_NOT_FOUND) {
+      goto Done;
+    }
+
     VarDataSize = 0;
     Index       = 0;
     ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
@@ -19,10 +19,13 @@
 #include <Library/BaseLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
 #include <Library/PrintLib.h>
 #include <Library/VariableReadLib.h>
 #include <Library/VariableWriteLib.h>
 #include <Library/LargeVariableReadLib.h>
+#include <Library/LargeVariableWriteLib.h>
 #include "LargeVariableCommon.h"
 
 /**
@@ -118,6 +121,73 @@ GetVariableSplitSize (
   return VariableSplitSize;
 }
 
+/**
+  Deletes the index of a multi-variable set.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+
+  @retval EFI_SUCCESS            The index was deleted, or there was none.
+  @retval Others                 The index could not be deleted.
+
+**/
+EFI_STATUS
+DeleteVariableIndex (
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid
+  )
+{
+  CHAR16        IndexName[MAX_VARIABLE_NAME_SIZE];
+  EFI_STATUS    Status;
+
+  ZeroMem (IndexName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (IndexName, MAX_VARIABLE_NAME_SIZE, L"%s%s", VariableName, LARGE_VARIABLE_INDEX_SUFFIX);
+  Status = VarLibSetVariable (
+             IndexName,
+             VendorGuid,
+             EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+             0,
+             NULL
+             );
+  if (Status == EFI_NOT_FOUND) {
+    return EFI_SUCCESS;
+  }
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "DeleteVariableIndex: Error deleting %s: Status = %r\n", IndexName, Status));
+  }
+  return Status;
+}
+
+/**
+  Locks the index of a multi-variable set, if the set has one.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+
+  @retval EFI_SUCCESS            The index was locked, or there is none.
+  @retval Others                 The index could not be locked.
+
+**/
+EFI_STATUS
+LockVariableIndex (
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid
+  )
+{
+  CHAR16        IndexName[MAX_VARIABLE_NAME_SIZE];
+  UINTN         VariableSize;
+
+  ZeroMem (IndexName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (IndexName, MAX_VARIABLE_NAME_SIZE, L"%s%s", VariableName, LARGE_VARIABLE_INDEX_SUFFIX);
+  VariableSize = 0;
+  if (VarLibGetVariable (IndexName, VendorGuid, NULL, &VariableSize, NULL) != EFI_BUFFER_TOO_SMALL) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "Locking %s, Guid = %g\n", IndexName, VendorGuid));
+  return VarLibVariableRequestToLock (IndexName, VendorGuid);
+}
+
 /**
   Deletes a large variable.
 
@@ -189,7 +259,7 @@ DeleteLargeVariableInternal (
       // The first variable exists. Delete all the variables.
       //
       DEBUG ((DEBUG_VERBOSE, "DeleteLargeVariableInternal: Multiple Variables Found\n"));
-      Status = EFI_SUCCESS;
+      Status = DeleteVariableIndex (VariableName, VendorGuid);
       for (Index = 0; Index < MAX_VARIABLE_SPLIT; Index++) {
         VarDataSize = 0;
         ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
@@ -219,6 +289,355 @@ Done:
   return Status;
 }
 
+/**
+  Checks whether a variable already holds the given data.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+  @param[in]  DataSize           The size in bytes of the Data buffer.
+  @param[in]  Data               The contents for the variable.
+
+  @retval TRUE                   The variable holds Data, with the attributes of a large variable.
+  @retval FALSE                  The variable does not exist, or it must be written.
+
+**/
+BOOLEAN
+IsVariableDataUnchanged (
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid,
+  IN  UINTN                        DataSize,
+  IN  VOID                         *Data
+  )
+{
+  EFI_STATUS    Status;
+  UINT32        Attributes;
+  UINTN         VarDataSize;
+  VOID          *VarData;
+  BOOLEAN       Unchanged;
+
+  //
+  // A variable of another size does not fit in the buffer, so one read tells.
+  //
+  VarData = AllocatePool (DataSize);
+  if (VarData == NULL) {
+    return FALSE;
+  }
+
+  VarDataSize = DataSize;
+  Status = VarLibGetVariable (VariableName, VendorGuid, &Attributes, &VarDataSize, VarData);
+  Unchanged = (BOOLEAN) (!EFI_ERROR (Status) &&
+                         (Attributes == (EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS)) &&
+                         (VarDataSize == DataSize) &&
+                         (CompareMem (VarData, Data, DataSize) == 0));
+  FreePool (VarData);
+  return Unchanged;
+}
+
+/**
+  Deletes the variables of a multi-variable set from a given index on.
+
+  @param[in]      VariableName   A Null-terminated string that is the name of the vendor's variable.
+  @param[in]      VendorGuid     A unique identifier for the vendor.
+  @param[in]      FirstIndex     Index of the first variable to delete.
+  @param[in, out] Statistics     The number of deleted variables is added to it.
+
+  @retval EFI_SUCCESS            The variables were deleted, or there were none.
+  @retval Others                 A variable could not be deleted.
+
+**/
+EFI_STATUS
+DeleteVariablesFrom (
+  IN     CHAR16                           *VariableName,
+  IN     EFI_GUID                         *VendorGuid,
+  IN     UINTN                            FirstIndex,
+  IN OUT LARGE_VARIABLE_WRITE_STATISTICS  *Statistics
+  )
+{
+  CHAR16        TempVariableName[MAX_VARIABLE_NAME_SIZE];
+  EFI_STATUS    Status;
+  UINTN         Index;
+
+  for (Index = FirstIndex; Index < MAX_VARIABLE_SPLIT; Index++) {
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+    Status = VarLibSetVariable (
+               TempVariableName,
+               VendorGuid,
+               EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+               0,
+               NULL
+               );
+    if (Status == EFI_NOT_FOUND) {
+      break;
+    } else if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "DeleteVariablesFrom: Error deleting %s: Status = %r\n", TempVariableName, Status));
+      return Status;
+    }
+    DEBUG ((DEBUG_INFO, "Deleted %s, Guid = %g\n", TempVariableName, VendorGuid));
+    Statistics->VariablesDeleted++;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Reads the index of a multi-variable set.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+
+  @return     The index, to be freed with FreePool(), or NULL if the set has no valid index.
+
+**/
+LARGE_VARIABLE_INDEX *
+GetVariableIndex (
+  IN  CHAR16                       *VariableName,
+  IN  EFI_GUID                     *VendorGuid
+  )
+{
+  CHAR16                IndexName[MAX_VARIABLE_NAME_SIZE];
+  LARGE_VARIABLE_INDEX  *VariableIndex;
+  UINTN                 IndexSize;
+
+  ZeroMem (IndexName, MAX_VARIABLE_NAME_SIZE);
+  UnicodeSPrint (IndexName, MAX_VARIABLE_NAME_SIZE, L"%s%s", VariableName, LARGE_VARIABLE_INDEX_SUFFIX);
+  IndexSize = 0;
+  if ((VarLibGetVariable (IndexName, VendorGuid, NULL, &IndexSize, NULL) != EFI_BUFFER_TOO_SMALL) ||
+      (IndexSize < sizeof (LARGE_VARIABLE_INDEX))) {
+    return NULL;
+  }
+
+  VariableIndex = AllocatePool (IndexSize);
+  if (VariableIndex == NULL) {
+    return NULL;
+  }
+
+  if (EFI_ERROR (VarLibGetVariable (IndexName, VendorGuid, NULL, &IndexSize, VariableIndex)) ||
+      (VariableIndex->Signature != LARGE_VARIABLE_INDEX_SIGNATURE) ||
+      (VariableIndex->Version != LARGE_VARIABLE_INDEX_VERSION) ||
+      (VariableIndex->VariableCount > MAX_VARIABLE_SPLIT) ||
+      (IndexSize != LARGE_VARIABLE_INDEX_SIZE (VariableIndex->VariableCount))) {
+    FreePool (VariableIndex);
+    return NULL;
+  }
+
+  return VariableIndex;
+}
+
+/**
+  Stores data in the variables of a multi-variable set, writing only the
+  variables whose data changed.
+
+  The variables the data no longer needs are deleted. When
+  PcdLargeVariableIndexEnable is TRUE, the index of the set is updated, and
+  the index of the data stored before tells which variables changed without
+  reading them. Otherwise the index is deleted, and each variable is read to
+  tell whether it changed.
+
+  @param[in]      VariableName   A Null-terminated string that is the name of the vendor's variable.
+  @param[in]      VendorGuid     A unique identifier for the vendor.
+  @param[in]      DataSize       The size in bytes of the Data buffer, which needs more than one variable.
+  @param[in]      Data           The contents for the variable.
+  @param[in, out] Statistics     What was written is added to it.
+
+  @retval EFI_SUCCESS            The data was stored.
+  @retval EFI_OUT_OF_RESOURCES   Not enough storage is available to hold the data.
+  @retval Others                 A variable could not be written or deleted. The set may hold a
+                                 mix of the old and the new data.
+
+**/
+EFI_STATUS
+WriteVariableSet (
+  IN     CHAR16                           *VariableName,
+  IN     EFI_GUID                         *VendorGuid,
+  IN     UINTN                            DataSize,
+  IN     VOID                             *Data,
+  IN OUT LARGE_VARIABLE_WRITE_STATISTICS  *Statistics
+  )
+{
+  CHAR16                      TempVariableName[MAX_VARIABLE_NAME_SIZE];
+  LARGE_VARIABLE_INDEX        *OldIndex;
+  LARGE_VARIABLE_INDEX        *NewIndex;
+  LARGE_VARIABLE_INDEX_ENTRY  *OldEntry;
+  LARGE_VARIABLE_INDEX_ENTRY  *NewEntry;
+  EFI_STATUS                  Status;
+  UINT64                      VariableSplitSize;
+  UINTN                       MaxVariableCount;
+  UINTN                       VariablesDeleted;
+  UINTN                       Index;
+  UINT8                       *OffsetPtr;
+  UINTN                       BytesRemaining;
+  UINTN                       SizeToSave;
+  UINT32                      Crc32;
+  BOOLEAN                     Unchanged;
+  BOOLEAN                     IndexDeleted;
+
+  OldIndex = NULL;
+  NewIndex = NULL;
+  OldEntry = NULL;
+  NewEntry = NULL;
+  if (FeaturePcdGet (PcdLargeVariableIndexEnable)) {
+    //
+    // All the variables but the last one hold at least this much data.
+    //
+    VariableSplitSize = GetVariableSplitSize (StrLen (VariableName) + MAX_VARIABLE_SPLIT_DIGITS);
+    if (VariableSplitSize != 0) {
+      MaxVariableCount = DataSize / (UINTN) VariableSplitSize + 1;
+      if (MaxVariableCount <= MAX_VARIABLE_SPLIT) {
+        NewIndex = AllocateZeroPool (LARGE_VARIABLE_INDEX_SIZE (MaxVariableCount));
+      }
+    }
+    if (NewIndex != NULL) {
+      NewEntry = LARGE_VARIABLE_INDEX_ENTRIES (NewIndex);
+      OldIndex = GetVariableIndex (VariableName, VendorGuid);
+      if (OldIndex != NULL) {
+        OldEntry = LARGE_VARIABLE_INDEX_ENTRIES (OldIndex);
+      }
+    }
+  }
+
+  //
+  // The index must not describe variables that are being written. Without a
+  // valid index to compare with, delete it now, else only when a variable
+  // changes.
+  //
+  IndexDeleted = FALSE;
+  if (OldIndex == NULL) {
+    Status = DeleteVariableIndex (VariableName, VendorGuid);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+    IndexDeleted = TRUE;
+  }
+
+  OffsetPtr      = (UINT8 *) Data;
+  BytesRemaining = DataSize;
+  for (Index = 0; (Index < MAX_VARIABLE_SPLIT) && (BytesRemaining > 0); Index++) {
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
+
+    VariableSplitSize = GetVariableSplitSize (StrLen (TempVariableName));
+    if (VariableSplitSize == 0) {
+      DEBUG ((DEBUG_ERROR, "Unable to save variable, out of NV storage space\n"));
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Done;
+    }
+
+    if (BytesRemaining > VariableSplitSize) {
+      SizeToSave = (UINTN) VariableSplitSize;
+    } else {
+      SizeToSave = BytesRemaining;
+    }
+
+    Crc32 = 0;
+    if (NewIndex != NULL) {
+      Crc32 = CalculateCrc32 (OffsetPtr, SizeToSave);
+      NewEntry[Index].Size  = (UINT32) SizeToSave;
+      NewEntry[Index].Crc32 = Crc32;
+    }
+
+    if (OldIndex == NULL) {
+      Unchanged = IsVariableDataUnchanged (TempVariableName, VendorGuid, SizeToSave, OffsetPtr);
+    } else if ((Index < OldIndex->VariableCount) &&
+               (OldEntry[Index].Size == SizeToSave) &&
+               (OldEntry[Index].Crc32 == Crc32)) {
+      //
+      // The index may be stale, make sure before skipping the write.
+      //
+      Unchanged = IsVariableDataUnchanged (TempVariableName, VendorGuid, SizeToSave, OffsetPtr);
+    } else {
+      Unchanged = FALSE;
+    }
+
+    if (!Unchanged) {
+      if (!IndexDeleted) {
+        Status = DeleteVariableIndex (VariableName, VendorGuid);
+        if (EFI_ERROR (Status)) {
+          goto Done;
+        }
+        IndexDeleted = TRUE;
+      }
+
+      DEBUG ((DEBUG_INFO, "Saving %s, Guid = %g, Size %d\n", TempVariableName, VendorGuid, SizeToSave));
+      Status = VarLibSetVariable (
+                 TempVariableName,
+                 VendorGuid,
+                 EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+                 SizeToSave,
+                 (VOID *) OffsetPtr
+                 );
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "WriteVariableSet: Error writting variable: Status = %r\n", Status));
+        goto Done;
+      }
+      Statistics->VariablesWritten++;
+      Statistics->BytesWritten += SizeToSave;
+    }
+    Statistics->VariableCount++;
+    BytesRemaining -= SizeToSave;
+    OffsetPtr      += SizeToSave;
+  }   // End of for loop
+
+  //
+  // The data may need fewer variables than what was stored before.
+  //
+  if (!IndexDeleted && (OldIndex->VariableCount > Index)) {
+    Status = DeleteVariableIndex (VariableName, VendorGuid);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+    IndexDeleted = TRUE;
+  }
+  VariablesDeleted = Statistics->VariablesDeleted;
+  Status = DeleteVariablesFrom (VariableName, VendorGuid, Index, Statistics);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+  if (!IndexDeleted && (Statistics->VariablesDeleted != VariablesDeleted)) {
+    //
+    // The set had more variables than the index told, the index is stale.
+    //
+    Status = DeleteVariableIndex (VariableName, VendorGuid);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+    IndexDeleted = TRUE;
+  }
+
+  Status = EFI_SUCCESS;
+  if ((NewIndex != NULL) && IndexDeleted) {
+    NewIndex->Signature     = LARGE_VARIABLE_INDEX_SIGNATURE;
+    NewIndex->Version       = LARGE_VARIABLE_INDEX_VERSION;
+    NewIndex->VariableCount = (UINT32) Index;
+    NewIndex->TotalSize     = DataSize;
+
+    ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
+    UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%s", VariableName, LARGE_VARIABLE_INDEX_SUFFIX);
+    DEBUG ((DEBUG_INFO, "Saving %s, Guid = %g, Size %d\n", TempVariableName, VendorGuid, LARGE_VARIABLE_INDEX_SIZE (Index)));
+    if (EFI_ERROR (VarLibSetVariable (
+                     TempVariableName,
+                     VendorGuid,
+                     EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+                     LARGE_VARIABLE_INDEX_SIZE (Index),
+                     NewIndex
+                     ))) {
+      //
+      // The index is optional, the set is read without it.
+      //
+      DEBUG ((DEBUG_WARN, "WriteVariableSet: Unable to save the index of %s\n", VariableName));
+    }
+  }
+
+Done:
+  if (OldIndex != NULL) {
+    FreePool (OldIndex);
+  }
+  if (NewIndex != NULL) {
+    FreePool (NewIndex);
+  }
+  return Status;
+}
+
 /**
   Sets the value of a large variable.
 
@@ -259,18 +678,15 @@ SetLargeVariable (
   IN  VOID                         *Data
   )
 {
-  CHAR16        TempVariableName[MAX_VARIABLE_NAME_SIZE];
-  UINT64        VariableSplitSize;
-  UINT64        RemainingVariableStorage;
-  EFI_STATUS    Status;
-  EFI_STATUS    Status2;
-  UINTN         VariableNameLength;
-  UINTN         Index;
-  UINTN         VariablesSaved;
-  UINT8         *OffsetPtr;
-  UINTN         BytesRemaining;
-  UINTN         SizeToSave;
-  UINTN         BufferSize = 0;
+  CHAR16                           TempVariableName[MAX_VARIABLE_NAME_SIZE];
+  LARGE_VARIABLE_WRITE_STATISTICS  Statistics;
+  UINT64                           VariableSplitSize;
+  UINT64                           RemainingVariableStorage;
+  EFI_STATUS                       Status;
+  UINTN                            VariableNameLength;
+  UINTN                            Index;
+  UINTN                            VariablesSaved;
+  UINTN                            BufferSize = 0;
 
   //
   // Check input parameters.
@@ -380,47 +796,15 @@ SetLargeVariable (
     }
 
     DEBUG ((DEBUG_VERBOSE, "SetLargeVariable: Saving using multiple variables.\n"));
-    OffsetPtr         = (UINT8 *) Data;
-    BytesRemaining    = DataSize;
-    VariablesSaved    = 0;
-
-    //
-    // Store chunks of data in UEFI variables until all data is stored
-    //
-    for (Index = 0; (Index < MAX_VARIABLE_SPLIT) && (BytesRemaining > 0); Index++) {
-      ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
-      UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
-
-      SizeToSave          = 0;
-      VariableNameLength  = StrLen (TempVariableName);
-      VariableSplitSize   = GetVariableSplitSize (VariableNameLength);
-      if (VariableSplitSize == 0) {
-        DEBUG ((DEBUG_ERROR, "Unable to save variable, out of NV storage space\n"));
-        Status = EFI_OUT_OF_RESOURCES;
-        goto Done;
-      }
-
-      if (BytesRemaining > VariableSplitSize) {
-        SizeToSave = (UINTN) VariableSplitSize;
-      } else {
-        SizeToSave = BytesRemaining;
-      }
-      DEBUG ((DEBUG_INFO, "Saving %s, Guid = %g, Size %d\n", TempVariableName, VendorGuid, SizeToSave));
-      Status = VarLibSetVariable (
-                TempVariableName,
-                VendorGuid,
-                EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
-                SizeToSave,
-                (VOID *) OffsetPtr
-                );
-      if (EFI_ERROR (Status)) {
-        DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error writting variable: Status = %r\n", Status));
-        goto Done;
-      }
-      VariablesSaved++;
-      BytesRemaining -= SizeToSave;
-      OffsetPtr += SizeToSave;
-    }   // End of for loop
+    ZeroMem (&Statistics, sizeof (Statistics));
+    Status = WriteVariableSet (VariableName, VendorGuid, DataSize, Data, &Statistics);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error writting variable: Status = %r\n", Status));
+      DEBUG ((DEBUG_ERROR, "SetLargeVariable: An error was encountered, deleting variables with partially stored data\n"));
+      DeleteLargeVariableInternal (VariableName, VendorGuid);
+      goto Done;
+    }
+    VariablesSaved = Statistics.VariableCount;
 
     //
     // If the user requested that the variables be locked, lock them now that
@@ -439,34 +823,194 @@ SetLargeVariable (
           // Do not delete Variable when failed to lock. Caller is responsible to do this.
           //
           Status = EFI_ABORTED;
-          VariablesSaved = 0;
           goto Done;
         }
       }
+
+      Status = LockVariableIndex (VariableName, VendorGuid);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error locking variable: Status = %r\n", Status));
+        Status = EFI_ABORTED;
+        goto Done;
+      }
     }
   }
 
 Done:
-  if (EFI_ERROR (Status) && VariablesSaved > 0) {
-    DEBUG ((DEBUG_ERROR, "SetLargeVariable: An error was encountered, deleting variables with partially stored data\n"));
-    for (Index = 0; Index < VariablesSaved; Index++) {
-      ZeroMem (TempVariableName, MAX_VARIABLE_NAME_SIZE);
-      UnicodeSPrint (TempVariableName, MAX_VARIABLE_NAME_SIZE, L"%s%d", VariableName, Index);
-
-      DEBUG ((DEBUG_INFO, "Deleting %s, Guid = %g\n", TempVariableName, VendorGuid));
-      Status2 = VarLibSetVariable (
-                  TempVariableName,
-                  VendorGuid,
-                  EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
-                  0,
-                  NULL
-                  );
-      if (EFI_ERROR (Status2)) {
-        DEBUG ((DEBUG_ERROR, "SetLargeVariable: Error deleting variable: Status = %r\n", Status2));
+  DEBUG ((DEBUG_ERROR, "SetLargeVariable: Status = %r\n", Status));
+  return Status;
+}
+
+/**
+  Sets the value of a large variable, writing only the variables whose data changed.
+
+  The data is split in the same variables as SetLargeVariable() does. Each of
+  them that already holds its part of the data is kept as is, so only the parts
+  of the data that changed cost a write to the variable storage. The variables
+  the data no longer needs are deleted.
+
+  @param[in]  VariableName       A Null-terminated string that is the name of the vendor's variable.
+                                 Each VariableName is unique for each VendorGuid. VariableName must
+                                 contain 1 or more characters. If VariableName is an empty string,
+                                 then EFI_INVALID_PARAMETER is returned.
+  @param[in]  VendorGuid         A unique identifier for the vendor.
+  @param[in]  LockVariable       If TRUE, any further writes to the variable will be prevented until the next reset.
+                                 Note: LockVariable must be FALSE when running in SMM or after ExitBootServices.
+  @param[in]  DataSize           The size in bytes of the Data buffer. A size of zero causes the variable to be deleted.
+                                 If DataSize is zero, then LockVariable must be FALSE since a variable that does not
+                                 exist cannot be locked.
+  @param[in]  Data               The contents for the variable.
+  @param[out] Statistics         Optional pointer to receive what was written.
+
+  @retval EFI_SUCCESS            The firmware has successfully stored the variable and its data as
+                                 defined by the Attributes.
+  @retval EFI_INVALID_PARAMETER  An invalid combination of LockVariable, name, and GUID was supplied, or the
+                                 DataSize exceeds the maximum allowed.
+  @retval EFI_INVALID_PARAMETER  VariableName is an empty string.
+  @retval EFI_INVALID_PARAMETER  DataSize is zero and LockVariable is TRUE
+  @retval EFI_OUT_OF_RESOURCES   Not enough storage is available to hold the variable and its data.
+  @retval EFI_OUT_OF_RESOURCES   The VariableName is longer than 1018 characters
+  @retval EFI_DEVICE_ERROR       The variable could not be retrieved due to a hardware error.
+  @retval EFI_WRITE_PROTECTED    The variable in question is read-only.
+  @retval EFI_WRITE_PROTECTED    The variable in question cannot be deleted.
+  @retval EFI_ABORTED            LockVariable was requested but failed.
+  @retval EFI_NOT_FOUND          The variable trying to be updated or deleted was not found.
+
+**/
+EFI_STATUS
+EFIAPI
+UpdateLargeVariable (
+  IN  CHAR16                           *VariableName,
+  IN  EFI_GUID                         *VendorGuid,
+  IN  BOOLEAN                          LockVariable,
+  IN  UINTN                            DataSize,
+  IN  VOID                             *Data,
+  OUT LARGE_VARIABLE_WRITE_STATISTICS  *Statistics    OPTIONAL
+  )
+{
+  LARGE_VARIABLE_WRITE_STATISTICS  LocalStatistics;
+  UINT64                           VariableSplitSize;
+  EFI_STATUS                       Status;
+  UINTN                            VariableNameLength;
+  UINTN                            VarDataSize;
+  BOOLEAN                          SingleVariable;
+  BOOLEAN                          SingleVariableFound;
+
+  if (Statistics == NULL) {
+    Statistics = &LocalStatistics;
+  }
+  ZeroMem (Statistics, sizeof (*Statistics));
+
+  //
+  // Check input parameters. Deleting the variable leaves nothing to keep.
+  //
+  if (VariableName == NULL || VariableName[0] == 0 || VendorGuid == NULL ||
+      DataSize == 0 || Data == NULL) {
+    return SetLargeVariable (VariableName, VendorGuid, LockVariable, DataSize, Data);
+  }
+
+  VariableNameLength = StrLen (VariableName);
+  if (VariableNameLength >= (MAX_VARIABLE_NAME_SIZE - MAX_VARIABLE_SPLIT_DIGITS)) {
+    DEBUG ((DEBUG_ERROR, "UpdateLargeVariable: Variable name too long\n"));
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (LockVariable && !VarLibIsVariableRequestToLockSupported ()) {
+    DEBUG ((DEBUG_ERROR, "UpdateLargeVariable: Variable locking is not currently supported\n"));
+    return EFI_INVALID_PARAMETER;
+  }
+
+  VariableSplitSize = GetVariableSplitSize (VariableNameLength);
+  SingleVariable    = (BOOLEAN) (DataSize <= VariableSplitSize);
+
+  VarDataSize         = 0;
+  Status              = VarLibGetVariable (VariableName, VendorGuid, NULL, &VarDataSize, NULL);
+  SingleVariableFound = (BOOLEAN) (Status == EFI_BUFFER_TOO_SMALL);
+
+  if (SingleVariable) {
+    //
+    // A single variable is sufficient to store the data, the variables of a
+    // multi-variable set must go.
+    //
+    Statistics->VariableCount = 1;
+    Status = DeleteVariableIndex (VariableName, VendorGuid);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+    Status = DeleteVariablesFrom (VariableName, VendorGuid, 0, Statistics);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+
+    if (!SingleVariableFound || !IsVariableDataUnchanged (VariableName, VendorGuid, DataSize, Data)) {
+      DEBUG ((DEBUG_INFO, "Saving %s, Guid = %g, Size %d\n", VariableName, VendorGuid, DataSize));
+      Status = VarLibSetVariable (
+                 VariableName,
+                 VendorGuid,
+                 EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+                 DataSize,
+                 Data
+                 );
+      if (EFI_ERROR (Status)) {
+        goto Done;
+      }
+      Statistics->VariablesWritten++;
+      Statistics->BytesWritten += DataSize;
+    }
+  } else {
+    //
+    // Multiple variables are needed, a single variable of the same name must go.
+    //
+    if (SingleVariableFound) {
+      Status = VarLibSetVariable (
+                 VariableName,
+                 VendorGuid,
+                 EFI_VARIABLE_NON_VOLATILE | EFI_VARIABLE_BOOTSERVICE_ACCESS | EFI_VARIABLE_RUNTIME_ACCESS,
+                 0,
+                 NULL
+                 );
+      if (EFI_ERROR (Status)) {
+        goto Done;
       }
+      Statistics->VariablesDeleted++;
+    }
+
+    if ((DataSize / ((UINTN) VariableSplitSize - MAX_VARIABLE_SPLIT_DIGITS)) > MAX_VARIABLE_SPLIT) {
+      DEBUG ((DEBUG_ERROR, "UpdateLargeVariable: Too many variables are needed to store the data\n"));
+      Status = EFI_OUT_OF_RESOURCES;
+      goto Done;
+    }
+
+    Status = WriteVariableSet (VariableName, VendorGuid, DataSize, Data, Statistics);
+    if (EFI_ERROR (Status)) {
+      goto Done;
     }
   }
-  DEBUG ((DEBUG_ERROR, "SetLargeVariable: Status = %r\n", Status));
+
+  if (LockVariable) {
+    //
+    // Do not delete Variable when failed to lock. Caller is responsible to do this.
+    //
+    Status = LockLargeVariable (VariableName, VendorGuid);
+  }
+
+Done:
+  if (EFI_ERROR (Status) && (Status != EFI_ABORTED)) {
+    //
+    // The stored data may be a mix of the old and the new data, delete it.
+    //
+    DEBUG ((DEBUG_ERROR, "UpdateLargeVariable: An error was encountered, deleting variables with partially stored data\n"));
+    DeleteLargeVariableInternal (VariableName, VendorGuid);
+  }
+  DEBUG ((
+    DEBUG_INFO,
+    "UpdateLargeVariable: %d of %d variables written, %d deleted, %d bytes written, Status = %r\n",
+    Statistics->VariablesWritten,
+    Statistics->VariableCount,
+    Statistics->VariablesDeleted,
+    Statistics->BytesWritten,
+    Status
+    ));
   return Status;
 }
 
@@ -546,6 +1090,12 @@ LockLargeVariable (
     VariableSize = 0;
     Status = VarLibGetVariable (TempVariableName, VendorGuid, NULL, &VariableSize, NULL);
     if (Status == EFI_BUFFER_TOO_SMALL) {
+      Status = LockVariableIndex (VariableName, VendorGuid);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "LockLargeVariable: Failed! Satus = %r\n", Status));
+        return EFI_ABORTED;
+      }
+
       //
       // Lock first variable and continue to rest of the variables.
       //
@@ -15,6 +15,7 @@
 #include <Library/MemoryAllocationLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
+#include <Library/PcdLib.h>
 #include <Uefi/UefiBaseType.h>
 
 #define SHELL_FREE_NON_NULL(Pointer)  \
@@ -46,6 +47,16 @@ typedef INT16             NODE;
 #define CRCPOLY           0xA001
 #define UPDATE_CRC(LoopVar5)     mCrc = mCrcTable[(mCrc ^ (LoopVar5)) & 0xFF] ^ (mCrc >> UINT8_BIT)
 
+//
+// Hash chain match finder. The heads are indexed by a hash of the next three
+// bytes, the chain links are indexed by the position modulo WNDSIZ. Positions
+// are kept absolute (mHashTextBase + mPos) so a chain survives a slide of mText.
+//
+#define HASH_CHAIN_BIT    15
+#define HASH_CHAIN_SIZE   (1U << HASH_CHAIN_BIT)
+#define HASH_CHAIN_NIL    0
+#define HASH_CHAIN(Text)  ((((UINT32) (Text)[0] << 10) ^ ((UINT32) (Text)[1] << 5) ^ (Text)[2]) & (HASH_CHAIN_SIZE - 1))
+
 //
 // C: the Char&Len Set; P: the Position Set; T: the exTra Set
 //
@@ -125,6 +136,12 @@ STATIC NODE   *mPrev;
 STATIC NODE   *mNext = NULL;
 INT32         mHuffmanDepth = 0;
 
+STATIC UINT32   *mHashHead;
+STATIC UINT32   *mHashChain;
+STATIC UINT32   mHashChainDepth;
+STATIC UINT32   mHashTextBase;
+STATIC BOOLEAN  mHashSkipMatch;
+
 /**
   Make a CRC table.
 
@@ -196,12 +213,31 @@ AllocateMemory (
   )
 {
   mText       = AllocateZeroPool (WNDSIZ * 2 + MAXMATCH);
-  mLevel      = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mLevel));
-  mChildCount = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mChildCount));
-  mPosition   = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mPosition));
-  mParent     = AllocateZeroPool (WNDSIZ * 2 * sizeof (*mParent));
-  mPrev       = AllocateZeroPool (WNDSIZ * 2 * sizeof (*mPrev));
-  mNext       = AllocateZeroPool ((MAX_HASH_VAL + 1) * sizeof (*mNext));
+  if (mText == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  if (mHashChainDepth != 0) {
+    //
+    // The hash chain match finder does not use the String Info Log.
+    //
+    mHashHead   = AllocateZeroPool (HASH_CHAIN_SIZE * sizeof (*mHashHead));
+    mHashChain  = AllocateZeroPool (WNDSIZ * sizeof (*mHashChain));
+    if ((mHashHead == NULL) || (mHashChain == NULL)) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  } else {
+    mLevel      = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mLevel));
+    mChildCount = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mChildCount));
+    mPosition   = AllocateZeroPool ((WNDSIZ + MAX_UINT8 + 1) * sizeof (*mPosition));
+    mParent     = AllocateZeroPool (WNDSIZ * 2 * sizeof (*mParent));
+    mPrev       = AllocateZeroPool (WNDSIZ * 2 * sizeof (*mPrev));
+    mNext       = AllocateZeroPool ((MAX_HASH_VAL + 1) * sizeof (*mNext));
+    if ((mLevel == NULL) || (mChildCount == NULL) || (mPosition == NULL) ||
+        (mParent == NULL) || (mPrev == NULL) || (mNext == NULL)) {
+      return EFI_OUT_OF_RESOURCES;
+    }
+  }
 
   mBufSiz     = BLKSIZ;
   mBuf        = AllocateZeroPool (mBufSiz);
@@ -236,6 +272,8 @@ FreeMemory (
   SHELL_FREE_NON_NULL (mParent);
   SHELL_FREE_NON_NULL (mPrev);
   SHELL_FREE_NON_NULL (mNext);
+  SHELL_FREE_NON_NULL (mHashHead);
+  SHELL_FREE_NON_NULL (mHashChain);
   SHELL_FREE_NON_NULL (mBuf);
 }
 
@@ -574,6 +612,68 @@ DeleteNode (
   mAvail              = LoopVar4;
 }
 
+/**
+  Find the longest match for the current position with the hash chain match
+  finder, then insert the current position into its hash chain.
+
+  At most mHashChainDepth earlier positions with the same hash are compared,
+  so the match found may be shorter than the one of the String Info Log.
+  No match is searched for when mHashSkipMatch is set, the position is only
+  inserted.
+
+**/
+VOID
+EFIAPI
+HashChainInsertNode (
+  VOID
+  )
+{
+  UINT32  Hash;
+  UINT32  Current;
+  UINT32  Candidate;
+  UINT32  Depth;
+  NODE    CandidatePos;
+  INT32   Length;
+
+  Hash    = HASH_CHAIN (&mText[mPos]);
+  Current = mHashTextBase + (UINT32) mPos;
+
+  if (!mHashSkipMatch) {
+    mMatchLen = 0;
+    Candidate = mHashHead[Hash];
+    for (Depth = mHashChainDepth; Depth > 0; Depth--) {
+      if ((Candidate == HASH_CHAIN_NIL) || (Current - Candidate >= WNDSIZ)) {
+        break;
+      }
+
+      CandidatePos = (NODE) (Candidate - mHashTextBase);
+      //
+      // A longer match must also match at the length of the best one so far.
+      //
+      if (mText[CandidatePos + mMatchLen] == mText[mPos + mMatchLen]) {
+        for (Length = 0; Length < MAXMATCH; Length++) {
+          if (mText[CandidatePos + Length] != mText[mPos + Length]) {
+            break;
+          }
+        }
+
+        if (Length > mMatchLen) {
+          mMatchLen = Length;
+          mMatchPos = CandidatePos;
+          if (Length == MAXMATCH) {
+            break;
+          }
+        }
+      }
+
+      Candidate = mHashChain[Candidate & (WNDSIZ - 1)];
+    }
+  }
+
+  mHashChain[Current & (WNDSIZ - 1)] = mHashHead[Hash];
+  mHashHead[Hash]                    = Current;
+}
+
 /**
   Read in source data
 
@@ -639,10 +739,15 @@ GetNextMatch (
     LoopVar8 = FreadCrc (&mText[WNDSIZ + MAXMATCH], WNDSIZ);
     mRemainder += LoopVar8;
     mPos = WNDSIZ;
+    mHashTextBase += WNDSIZ;
   }
 
-  DeleteNode ();
-  InsertNode ();
+  if (mHashChainDepth != 0) {
+    HashChainInsertNode ();
+  } else {
+    DeleteNode ();
+    InsertNode ();
+  }
 
   return (TRUE);
 }
@@ -1296,7 +1401,9 @@ Encode (
     return Status;
   }
 
-  InitSlide ();
+  if (mHashChainDepth == 0) {
+    InitSlide ();
+  }
 
   HufEncodeStart ();
 
@@ -1304,7 +1411,11 @@ Encode (
 
   mMatchLen   = 0;
   mPos        = WNDSIZ;
-  InsertNode ();
+  if (mHashChainDepth != 0) {
+    HashChainInsertNode ();
+  } else {
+    InsertNode ();
+  }
   if (mMatchLen > mRemainder) {
     mMatchLen = mRemainder;
   }
@@ -1334,11 +1445,17 @@ Encode (
         (mPos - LastMatchPos - 2) & (WNDSIZ - 1));
       LastMatchLen--;
       while (LastMatchLen > 0) {
+        //
+        // The hash chain match finder only searches the position following
+        // the pointer, the positions it covers are just inserted.
+        //
+        mHashSkipMatch = (BOOLEAN) (LastMatchLen > 1);
         if (!GetNextMatch ()) {
           Status = EFI_OUT_OF_RESOURCES;
         }
         LastMatchLen--;
       }
+      mHashSkipMatch = FALSE;
 
       if (mMatchLen > mRemainder) {
         mMatchLen = mRemainder;
@@ -1386,6 +1503,16 @@ Compress (
   mParent         = NULL;
   mPrev           = NULL;
   mNext           = NULL;
+  mHashHead       = NULL;
+  mHashChain      = NULL;
+  mHashTextBase   = 0;
+  mHashSkipMatch  = FALSE;
+
+  //
+  // A non-zero depth selects the hash chain match finder, which trades some
+  // compression ratio for speed. The output is the same UEFI compressed format.
+  //
+  mHashChainDepth = PcdGet32 (PcdCompressLibHashChainDepth);
 
   mSrc            = SrcBuffer;
   mSrcUpperLimit  = mSrc + SrcSize;
@@ -0,0 +1,312 @@
+/** @file
+  Ratio and throughput benchmark of CompressLib, run from a host environment.
+
+  Every sample is compressed with the String Info Log tree match finder and
+  with the hash chain match finder at a few search depths, and every output
+  is decompressed with UefiDecompressLib and compared with the sample. The
+  samples are files given on the command line, typically FSP NVS buffers
+  dumped from the FspNvsBuffer variables of a platform. Without them, a
+  synthetic buffer laid out like FSP NVS data is measured.
+
+  Copyright (c) 2023, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <Uefi.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/CompressLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/PcdLib.h>
+#include <Library/UefiDecompressLib.h>
+
+//
+// Each measurement compresses the sample until this much time has elapsed.
+//
+#define BENCHMARK_MIN_SECONDS  0.5
+
+#define SYNTHETIC_SAMPLE_SIZE  SIZE_64KB
+
+/**
+  Builds a synthetic sample: blocks of per-channel and per-DIMM training
+  results, which repeat with small differences, separated by zero padding.
+
+  @param[out] Size   Pointer to receive the size of the sample.
+
+  @return     The sample, or NULL if out of memory.
+**/
+UINT8 *
+BuildSyntheticSample (
+  OUT UINTN  *Size
+  )
+{
+  UINT8   *Sample;
+  UINT32  Seed;
+  UINTN   Index;
+  UINTN   Block;
+
+  Sample = AllocateZeroPool (SYNTHETIC_SAMPLE_SIZE);
+  if (Sample == NULL) {
+    return NULL;
+  }
+
+  Seed = 0x12345678;
+  for (Block = 0; Block + SIZE_1KB <= SYNTHETIC_SAMPLE_SIZE; Block += SIZE_1KB) {
+    //
+    // 768 bytes of training data, the last 256 bytes of each block are left 0.
+    //
+    for (Index = 0; Index < 768; Index++) {
+      Seed = Seed * 1103515245 + 12345;
+      if ((Seed >> 28) < 3) {
+        Sample[Block + Index] = (UINT8)(Seed >> 16);
+      } else {
+        Sample[Block + Index] = (UINT8)(0x40 + (Index % 48) + (Block >> 13));
+      }
+    }
+  }
+
+  *Size = SYNTHETIC_SAMPLE_SIZE;
+  return Sample;
+}
+
+/**
+  Reads a sample file.
+
+  @param[in]  FileName   Name of the file.
+  @param[out] Size       Pointer to receive the size of the sample.
+
+  @return     The sample, or NULL if the file cannot be read.
+**/
+UINT8 *
+ReadSample (
+  IN  CONST CHAR8  *FileName,
+  OUT UINTN        *Size
+  )
+{
+  FILE   *File;
+  UINT8  *Sample;
+  long   FileSize;
+
+  File = fopen (FileName, "rb");
+  if (File == NULL) {
+    return NULL;
+  }
+
+  Sample = NULL;
+  if ((fseek (File, 0, SEEK_END) == 0) && ((FileSize = ftell (File)) > 0)) {
+    rewind (File);
+    Sample = AllocatePool ((UINTN)FileSize);
+    if ((Sample != NULL) && (fread (Sample, 1, (size_t)FileSize, File) != (size_t)FileSize)) {
+      FreePool (Sample);
+      Sample = NULL;
+    }
+
+    *Size = (UINTN)FileSize;
+  }
+
+  fclose (File);
+  return Sample;
+}
+
+/**
+  Checks that a compressed sample decompresses to the sample.
+
+  @param[in]  Sample           The sample.
+  @param[in]  SampleSize       Size of the sample.
+  @param[in]  Compressed       The compressed sample.
+  @param[in]  CompressedSize   Size of the compressed sample.
+
+  @retval     TRUE     The compressed sample is valid.
+  @retval     FALSE    The compressed sample is invalid.
+**/
+BOOLEAN
+VerifyRoundTrip (
+  IN  CONST UINT8  *Sample,
+  IN  UINTN        SampleSize,
+  IN  CONST UINT8  *Compressed,
+  IN  UINTN        CompressedSize
+  )
+{
+  UINT32   DestinationSize;
+  UINT32   ScratchSize;
+  VOID     *Destination;
+  VOID     *Scratch;
+  BOOLEAN  Valid;
+
+  if (RETURN_ERROR (UefiDecompressGetInfo (Compressed, (UINT32)CompressedSize, &DestinationSize, &ScratchSize))) {
+    return FALSE;
+  }
+
+  if (DestinationSize != SampleSize) {
+    return FALSE;
+  }
+
+  Destination = AllocatePool (DestinationSize);
+  Scratch     = AllocatePool (ScratchSize);
+  Valid       = FALSE;
+  if ((Destination != NULL) && (Scratch != NULL)) {
+    Valid = !RETURN_ERROR (UefiDecompress (Compressed, Destination, Scratch)) &&
+            (CompareMem (Destination, Sample, SampleSize) == 0);
+  }
+
+  if (Destination != NULL) {
+    FreePool (Destination);
+  }
+
+  if (Scratch != NULL) {
+    FreePool (Scratch);
+  }
+
+  return Valid;
+}
+
+/**
+  Compresses a sample with a match finder and prints the ratio and the
+  throughput.
+
+  @param[in]  Sample       The sample.
+  @param[in]  SampleSize   Size of the sample.
+  @param[in]  Depth        Value of PcdCompressLibHashChainDepth.
+  @param[in]  TreeSpeed    Throughput of the tree match finder in MB/s, or 0
+                           when Depth is 0.
+  @param[out] Speed        Pointer to receive the throughput in MB/s.
+
+  @retval     EFI_SUCCESS  The sample was compressed and verified.
+  @retval     Others       The compression or the verification failed.
+**/
+EFI_STATUS
+RunTest (
+  IN  CONST UINT8  *Sample,
+  IN  UINTN        SampleSize,
+  IN  UINT32       Depth,
+  IN  double       TreeSpeed,
+  OUT double       *Speed
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *Compressed;
+  UINT64      BufferSize;
+  UINT64      CompressedSize;
+  UINTN       Iterations;
+  clock_t     Start;
+  double      Seconds;
+  CHAR8       Name[16];
+
+  *Speed = 0;
+  PatchPcdSet32 (PcdCompressLibHashChainDepth, Depth);
+
+  //
+  // EFI compression can expand data that does not compress, by a little.
+  //
+  BufferSize = SampleSize + SampleSize / 8 + SIZE_1KB;
+  Compressed = AllocatePool ((UINTN)BufferSize);
+  if (Compressed == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  Iterations = 0;
+  Start      = clock ();
+  do {
+    CompressedSize = BufferSize;
+    Status         = Compress ((VOID *)Sample, SampleSize, Compressed, &CompressedSize);
+    if (EFI_ERROR (Status)) {
+      printf ("Compress() failed: %d\n", (int)Status);
+      FreePool (Compressed);
+      return Status;
+    }
+
+    Iterations++;
+    Seconds = (double)(clock () - Start) / CLOCKS_PER_SEC;
+  } while (Seconds < BENCHMARK_MIN_SECONDS);
+
+  *Speed = (double)SampleSize * Iterations / Seconds / 1000000;
+  if (Depth == 0) {
+    snprintf (Name, sizeof (Name), "tree");
+  } else {
+    snprintf (Name, sizeof (Name), "hash %u", (unsigned)Depth);
+  }
+
+  printf (
+    "  %-10s %10llu %10llu %8.2f%% %10.2f %8.2fx\n",
+    Name,
+    (unsigned long long)SampleSize,
+    (unsigned long long)CompressedSize,
+    (double)CompressedSize * 100 / SampleSize,
+    *Speed,
+    (TreeSpeed != 0) ? *Speed / TreeSpeed : 1.0
+    );
+
+  if (!VerifyRoundTrip (Sample, SampleSize, Compressed, (UINTN)CompressedSize)) {
+    printf ("  Round trip failed\n");
+    Status = EFI_VOLUME_CORRUPTED;
+  }
+
+  FreePool (Compressed);
+  return Status;
+}
+
+/**
+  Runs the benchmark.
+
+  Usage: CompressLibBenchmarkHost [Sample ...]
+  Every Sample file is measured, typically an FSP NVS buffer. Without them,
+  a synthetic sample is measured.
+
+  @param[in]  Argc  Number of arguments.
+  @param[in]  Argv  Arguments.
+
+  @retval     0     All the samples were compressed and verified.
+  @retval     1     A sample could not be read, compressed or verified.
+**/
+int
+main (
+  int   Argc,
+  char  *Argv[]
+  )
+{
+  STATIC CONST UINT32  Depths[] = { 0, 4, 16, 64, 256 };
+  UINT8                *Sample;
+  UINTN                SampleSize;
+  int                  ArgIndex;
+  UINTN                DepthIndex;
+  double               TreeSpeed;
+  double               Speed;
+  int                  Result;
+
+  Result   = 0;
+  ArgIndex = 1;
+  do {
+    if (Argc > 1) {
+      Sample = ReadSample (Argv[ArgIndex], &SampleSize);
+    } else {
+      Sample = BuildSyntheticSample (&SampleSize);
+    }
+
+    if (Sample == NULL) {
+      printf ("Cannot read %s\n", (Argc > 1) ? Argv[ArgIndex] : "the synthetic sample");
+      return 1;
+    }
+
+    printf ("%s\n", (Argc > 1) ? Argv[ArgIndex] : "Synthetic FSP NVS sample");
+    printf ("  %-10s %10s %10s %9s %10s %9s\n", "Finder", "Size", "Output", "Ratio", "MB/s", "Speedup");
+    TreeSpeed = 0;
+    for (DepthIndex = 0; DepthIndex < ARRAY_SIZE (Depths); DepthIndex++) {
+      if (EFI_ERROR (RunTest (Sample, SampleSize, Depths[DepthIndex], TreeSpeed, &Speed))) {
+        Result = 1;
+      }
+
+      if (Depths[DepthIndex] == 0) {
+        TreeSpeed = Speed;
+      }
+    }
+
+    FreePool (Sample);
+    ArgIndex++;
+  } while (ArgIndex < Argc);
+
+  return Result;
+}
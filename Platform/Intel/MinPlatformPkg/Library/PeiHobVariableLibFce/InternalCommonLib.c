@@ -291,6 +291,63 @@ GetNextVariablePtr (
   return (AUTHENTICATED_VARIABLE_HEADER *) HEADER_ALIGN (Value);
 }
 
+/**
+  Get the next added variable of a variable store.
+
+  @param  VariableStoreHeader  Pointer to the Variable Store Header.
+  @param  Variable             Pointer to the current variable header, NULL for the first.
+  @param  AuthFlag             Authenticated variable flag.
+
+  @return Pointer to the next added variable header, NULL if there is none.
+
+**/
+AUTHENTICATED_VARIABLE_HEADER *
+GetNextAddedVariable (
+  IN  VARIABLE_STORE_HEADER             *VariableStoreHeader,
+  IN  AUTHENTICATED_VARIABLE_HEADER     *Variable, OPTIONAL
+  IN  BOOLEAN                           AuthFlag
+  )
+{
+  AUTHENTICATED_VARIABLE_HEADER *EndPtr;
+
+  EndPtr = GetEndPointer (VariableStoreHeader);
+  if (Variable == NULL) {
+    Variable = GetStartPointer (VariableStoreHeader);
+  } else {
+    Variable = GetNextVariablePtr (Variable, AuthFlag);
+  }
+
+  while ((Variable < EndPtr) && IsValidVariableHeader (Variable)) {
+    if (Variable->State == VAR_ADDED) {
+      return Variable;
+    }
+    Variable = GetNextVariablePtr (Variable, AuthFlag);
+  }
+
+  return NULL;
+}
+
+/**
+  This code gets the name of a variable.
+
+  @param  Variable  Pointer to the Variable Header.
+  @param  AuthFlag  Authenticated variable flag.
+  @param  NameSize  Pointer to output the size of the name in bytes.
+
+  @return A CHAR16* pointer to Variable Name.
+
+**/
+CHAR16 *
+GetVariableName (
+  IN  AUTHENTICATED_VARIABLE_HEADER     *Variable,
+  IN  BOOLEAN                           AuthFlag,
+  OUT UINTN                             *NameSize
+  )
+{
+  *NameSize = NameSizeOfVariable (Variable, AuthFlag);
+  return GetVariableNamePtr (Variable, AuthFlag);
+}
+
 EFI_STATUS
 EFIAPI
 BuildDefaultDataHobForRecoveryVariable (
@@ -449,6 +506,13 @@ FindVariableFromHob (
     return NULL;
   }
 
+  //
+  // Use the hash index of the variable HOB, when the library instance has one.
+  //
+  if (FindVariableFromHobIndex (VariableStoreHeader, *AuthFlag, VariableName, VendorGuid, &CurrPtr)) {
+    return CurrPtr;
+  }
+
   StartPtr = GetStartPointer (VariableStoreHeader);
   EndPtr   = GetEndPointer (VariableStoreHeader);
   for ( CurrPtr = StartPtr
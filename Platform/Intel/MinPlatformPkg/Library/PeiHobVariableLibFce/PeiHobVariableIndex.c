@@ -0,0 +1,257 @@
+/**@file
+  Hash index of the default variable HOB.
+
+  Every lookup of a default variable used to walk the whole variable store,
+  and a platform looks up many of them in every PEIM. The first lookup now
+  builds a small hash index of the store in a GUID HOB, which the lookups of
+  the later PEIMs find and reuse.
+
+Copyright (c) 2023, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <PiPei.h>
+#include <Library/BaseLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/DebugLib.h>
+#include <Library/HobLib.h>
+#include "Variable.h"
+
+GLOBAL_REMOVE_IF_UNREFERENCED EFI_GUID mHobVariableIndexGuid = HOB_VARIABLE_INDEX_GUID;
+
+#define FNV1A_OFFSET_BASIS  0x811C9DC5
+#define FNV1A_PRIME         0x01000193
+
+/**
+  Compute the FNV-1a hash of a variable name and GUID.
+
+  @param  Name      Pointer to the variable name.
+  @param  NameSize  Size of the variable name in bytes, including the Null terminator.
+  @param  Guid      Pointer to the variable GUID.
+
+  @return The hash.
+
+**/
+STATIC
+UINT32
+HashVariable (
+  IN  CONST CHAR16                      *Name,
+  IN  UINTN                             NameSize,
+  IN  CONST EFI_GUID                    *Guid
+  )
+{
+  CONST UINT8   *Byte;
+  UINT32        Hash;
+  UINTN         Index;
+
+  Hash = FNV1A_OFFSET_BASIS;
+  Byte = (CONST UINT8 *) Name;
+  for (Index = 0; Index < NameSize; Index++) {
+    Hash = (Hash ^ Byte[Index]) * FNV1A_PRIME;
+  }
+  Byte = (CONST UINT8 *) Guid;
+  for (Index = 0; Index < sizeof (EFI_GUID); Index++) {
+    Hash = (Hash ^ Byte[Index]) * FNV1A_PRIME;
+  }
+
+  return Hash;
+}
+
+/**
+  Build the hash index of a variable store in a new GUID HOB.
+
+  @param  VariableStoreHeader  Pointer to the default variable store HOB data.
+  @param  AuthFlag             Authenticated variable flag.
+
+  @return Pointer to the index, NULL if it cannot be built.
+
+**/
+STATIC
+HOB_VARIABLE_INDEX *
+BuildVariableIndex (
+  IN  VARIABLE_STORE_HEADER             *VariableStoreHeader,
+  IN  BOOLEAN                           AuthFlag
+  )
+{
+  AUTHENTICATED_VARIABLE_HEADER *Variable;
+  HOB_VARIABLE_INDEX            *VariableIndex;
+  HOB_VARIABLE_INDEX_ENTRY      *Entry;
+  UINT16                        *Bucket;
+  UINT16                        *Link;
+  CHAR16                        *Name;
+  UINTN                         NameSize;
+  UINTN                         Count;
+  UINTN                         BucketCount;
+  UINTN                         IndexSize;
+  UINT32                        Hash;
+
+  Count = 0;
+  for ( Variable = GetNextAddedVariable (VariableStoreHeader, NULL, AuthFlag)
+      ; Variable != NULL
+      ; Variable = GetNextAddedVariable (VariableStoreHeader, Variable, AuthFlag)
+      ) {
+    Count++;
+  }
+  if (Count >= MAX_UINT16) {
+    return NULL;
+  }
+
+  //
+  // About two variables per bucket keeps the chains short and the HOB small.
+  //
+  BucketCount = 2;
+  while (BucketCount < Count / 2) {
+    BucketCount <<= 1;
+  }
+
+  IndexSize = sizeof (HOB_VARIABLE_INDEX) +
+              BucketCount * sizeof (UINT16) +
+              Count * sizeof (HOB_VARIABLE_INDEX_ENTRY);
+  IndexSize = ALIGN_VALUE (IndexSize, sizeof (UINT64));
+  if (IndexSize > 0xFFF8 - sizeof (EFI_HOB_GUID_TYPE)) {
+    return NULL;
+  }
+
+  VariableIndex = BuildGuidHob (&mHobVariableIndexGuid, IndexSize);
+  if (VariableIndex == NULL) {
+    return NULL;
+  }
+  ZeroMem (VariableIndex, IndexSize);
+  VariableIndex->Signature   = HOB_VARIABLE_INDEX_SIGNATURE;
+  VariableIndex->StoreSize   = VariableStoreHeader->Size;
+  VariableIndex->AuthFlag    = AuthFlag;
+  VariableIndex->BucketCount = (UINT16) BucketCount;
+  VariableIndex->EntryCount  = (UINT16) Count;
+
+  Bucket = (UINT16 *) (VariableIndex + 1);
+  Entry  = (HOB_VARIABLE_INDEX_ENTRY *) (Bucket + BucketCount);
+  Count  = 0;
+  for ( Variable = GetNextAddedVariable (VariableStoreHeader, NULL, AuthFlag)
+      ; Variable != NULL
+      ; Variable = GetNextAddedVariable (VariableStoreHeader, Variable, AuthFlag)
+      ) {
+    Name = GetVariableName (Variable, AuthFlag, &NameSize);
+    Hash = HashVariable (Name, NameSize, GetVendorGuidPtr (Variable, AuthFlag));
+
+    Entry[Count].Offset = (UINT32) ((UINTN) Variable - (UINTN) VariableStoreHeader);
+    Entry[Count].Hash   = (UINT16) (Hash >> 16);
+    Entry[Count].Next   = 0;
+
+    //
+    // Append to the tail of the bucket, so the first one of duplicate
+    // variables is found first, as by the walk of the variable store.
+    //
+    Link = &Bucket[Hash & (BucketCount - 1)];
+    while (*Link != 0) {
+      Link = &Entry[*Link - 1].Next;
+    }
+    *Link = (UINT16) (Count + 1);
+    Count++;
+  }
+
+  DEBUG ((DEBUG_INFO, "HobVariableIndex: %d variables in %d buckets\n", (UINT32) Count, (UINT32) BucketCount));
+  return VariableIndex;
+}
+
+/**
+  Get the hash index of a variable store, build it if there is none.
+
+  @param  VariableStoreHeader  Pointer to the default variable store HOB data.
+  @param  AuthFlag             Authenticated variable flag.
+
+  @return Pointer to the index, NULL if it cannot be built.
+
+**/
+STATIC
+HOB_VARIABLE_INDEX *
+GetVariableIndex (
+  IN  VARIABLE_STORE_HEADER             *VariableStoreHeader,
+  IN  BOOLEAN                           AuthFlag
+  )
+{
+  EFI_HOB_GUID_TYPE             *GuidHob;
+  HOB_VARIABLE_INDEX            *VariableIndex;
+
+  GuidHob = GetFirstGuidHob (&mHobVariableIndexGuid);
+  while (GuidHob != NULL) {
+    VariableIndex = (HOB_VARIABLE_INDEX *) GET_GUID_HOB_DATA (GuidHob);
+    if ((VariableIndex->Signature == HOB_VARIABLE_INDEX_SIGNATURE) &&
+        (VariableIndex->StoreSize == VariableStoreHeader->Size) &&
+        (VariableIndex->AuthFlag == AuthFlag)) {
+      return VariableIndex;
+    }
+    GuidHob = GetNextGuidHob (&mHobVariableIndexGuid, GET_NEXT_HOB (GuidHob));
+  }
+
+  return BuildVariableIndex (VariableStoreHeader, AuthFlag);
+}
+
+/**
+  Find variable from the hash index of the default variable HOB.
+
+  @param[in]  VariableStoreHeader  Pointer to the default variable store HOB data.
+  @param[in]  AuthFlag             Authenticated variable flag.
+  @param[in]  VariableName         A Null-terminated string that is the name of the vendor's
+                                   variable.
+  @param[in]  VendorGuid           A unique identifier for the vendor.
+  @param[out] Variable             Pointer to output the variable header, NULL if not found.
+
+  @retval TRUE                     The index is used, Variable is the result.
+  @retval FALSE                    There is no index, the variable store must be walked.
+
+**/
+BOOLEAN
+FindVariableFromHobIndex (
+  IN  VARIABLE_STORE_HEADER             *VariableStoreHeader,
+  IN  BOOLEAN                           AuthFlag,
+  IN  CHAR16                            *VariableName,
+  IN  EFI_GUID                          *VendorGuid,
+  OUT AUTHENTICATED_VARIABLE_HEADER     **Variable
+  )
+{
+  HOB_VARIABLE_INDEX            *VariableIndex;
+  HOB_VARIABLE_INDEX_ENTRY      *Entry;
+  UINT16                        *Bucket;
+  AUTHENTICATED_VARIABLE_HEADER *CurrPtr;
+  CHAR16                        *Name;
+  UINTN                         NameSize;
+  UINTN                         VariableNameSize;
+  UINT32                        Hash;
+  UINT16                        Link;
+
+  *Variable = NULL;
+
+  VariableIndex = GetVariableIndex (VariableStoreHeader, AuthFlag);
+  if (VariableIndex == NULL) {
+    return FALSE;
+  }
+
+  VariableNameSize = StrSize (VariableName);
+  Hash   = HashVariable (VariableName, VariableNameSize, VendorGuid);
+  Bucket = (UINT16 *) (VariableIndex + 1);
+  Entry  = (HOB_VARIABLE_INDEX_ENTRY *) (Bucket + VariableIndex->BucketCount);
+  for ( Link = Bucket[Hash & (VariableIndex->BucketCount - 1)]
+      ; Link != 0
+      ; Link = Entry[Link - 1].Next
+      ) {
+    if (Entry[Link - 1].Hash != (UINT16) (Hash >> 16)) {
+      continue;
+    }
+
+    CurrPtr = (AUTHENTICATED_VARIABLE_HEADER *) ((UINTN) VariableStoreHeader + Entry[Link - 1].Offset);
+    if (CurrPtr->State != VAR_ADDED) {
+      continue;
+    }
+    Name = GetVariableName (CurrPtr, AuthFlag, &NameSize);
+    if ((NameSize == VariableNameSize) &&
+        CompareGuid (VendorGuid, GetVendorGuidPtr (CurrPtr, AuthFlag)) &&
+        (CompareMem (VariableName, Name, NameSize) == 0)) {
+      *Variable = CurrPtr;
+      break;
+    }
+  }
+
+  return TRUE;
+}
@@ -198,3 +198,31 @@ CreateDefaultVariableHob (
 
   return EFI_SUCCESS;
 }
+
+/**
+  Find variable from the hash index of the default variable HOB.
+
+  This instance is optimized for size and has no index, the variable store
+  is walked for every lookup.
+
+  @param[in]  VariableStoreHeader  Pointer to the default variable store HOB data.
+  @param[in]  AuthFlag             Authenticated variable flag.
+  @param[in]  VariableName         A Null-terminated string that is the name of the vendor's
+                                   variable.
+  @param[in]  VendorGuid           A unique identifier for the vendor.
+  @param[out] Variable             Pointer to output the variable header, NULL if not found.
+
+  @retval FALSE                    There is no index, the variable store must be walked.
+
+**/
+BOOLEAN
+FindVariableFromHobIndex (
+  IN  VARIABLE_STORE_HEADER             *VariableStoreHeader,
+  IN  BOOLEAN                           AuthFlag,
+  IN  CHAR16                            *VariableName,
+  IN  EFI_GUID                          *VendorGuid,
+  OUT AUTHENTICATED_VARIABLE_HEADER     **Variable
+  )
+{
+  return FALSE;
+}
@@ -169,4 +169,122 @@ typedef struct {
 
 #pragma pack()
 
+///
+/// Hash index of the default variable HOB. It is built on the first lookup
+/// and kept in a GUID HOB of its own, so the later lookups of every PEIM use
+/// it. The offsets are relative to the variable store, so the index is still
+/// valid after the HOB list moves to permanent memory.
+///
+#define HOB_VARIABLE_INDEX_GUID \
+  { \
+    0x4e1d0928, 0xc024, 0x4aa0, { 0xa8, 0x0c, 0x7a, 0x5f, 0xe6, 0x3f, 0xbe, 0x59 } \
+  }
+
+#define HOB_VARIABLE_INDEX_SIGNATURE  SIGNATURE_32 ('H', 'V', 'I', 'X')
+
+typedef struct {
+  ///
+  /// Offset of the variable header from the variable store header.
+  ///
+  UINT32      Offset;
+  ///
+  /// Upper 16 bits of the hash of the variable name and GUID.
+  ///
+  UINT16      Hash;
+  ///
+  /// Index + 1 of the next entry in the bucket, 0 for the last one.
+  ///
+  UINT16      Next;
+} HOB_VARIABLE_INDEX_ENTRY;
+
+typedef struct {
+  UINT32      Signature;
+  ///
+  /// Size and format of the indexed variable store.
+  ///
+  UINT32      StoreSize;
+  BOOLEAN     AuthFlag;
+  UINT8       Reserved;
+  ///
+  /// Number of buckets, a power of 2.
+  ///
+  UINT16      BucketCount;
+  UINT16      EntryCount;
+  UINT16      Reserved1;
+//UINT16                    Bucket[BucketCount];  // Index + 1 of the first entry, 0 for none
+//HOB_VARIABLE_INDEX_ENTRY  Entry[EntryCount];
+} HOB_VARIABLE_INDEX;
+
+/**
+  Get the next added variable of a variable store.
+
+  @param  VariableStoreHeader  Pointer to the Variable Store Header.
+  @param  Variable             Pointer to the current variable header, NULL for the first.
+  @param  AuthFlag             Authenticated variable flag.
+
+  @return Pointer to the next added variable header, NULL if there is none.
+
+**/
+AUTHENTICATED_VARIABLE_HEADER *
+GetNextAddedVariable (
+  IN  VARIABLE_STORE_HEADER             *VariableStoreHeader,
+  IN  AUTHENTICATED_VARIABLE_HEADER     *Variable, OPTIONAL
+  IN  BOOLEAN                           AuthFlag
+  );
+
+/**
+  This code gets the name of a variable.
+
+  @param  Variable  Pointer to the Variable Header.
+  @param  AuthFlag  Authenticated variable flag.
+  @param  NameSize  Pointer to output the size of the name in bytes.
+
+  @return A CHAR16* pointer to Variable Name.
+
+**/
+CHAR16 *
+GetVariableName (
+  IN  AUTHENTICATED_VARIABLE_HEADER     *Variable,
+  IN  BOOLEAN                           AuthFlag,
+  OUT UINTN                             *NameSize
+  );
+
+/**
+  This code gets the pointer to the variable guid.
+
+  @param Variable   Pointer to the Variable Header.
+  @param AuthFlag   Authenticated variable flag.
+
+  @return A EFI_GUID* pointer to Vendor Guid.
+
+**/
+EFI_GUID *
+GetVendorGuidPtr (
+  IN  AUTHENTICATED_VARIABLE_HEADER     *AuthVariable,
+  IN  BOOLEAN                           AuthFlag
+  );
+
+/**
+  Find variable from the hash index of the default variable HOB.
+
+  @param[in]  VariableStoreHeader  Pointer to the default variable store HOB data.
+  @param[in]  AuthFlag             Authenticated variable flag.
+  @param[in]  VariableName         A Null-terminated string that is the name of the vendor's
+                                   variable.
+  @param[in]  VendorGuid           A unique identifier for the vendor.
+  @param[out] Variable             Pointer to output the variable header, NULL if not found.
+
+  @retval TRUE                     The index is used, Variable is the result.
+  @retval FALSE                    There is no index, the variable store must be walked.
+
+**/
+BOOLEAN
+FindVariableFromHobIndex (
+  IN  VARIABLE_STORE_HEADER             *VariableStoreHeader,
+  IN  BOOLEAN                           AuthFlag,
+  IN  CHAR16                            *VariableName,
+  IN  EFI_GUID                          *VendorGuid,
+  OUT AUTHENTICATED_VARIABLE_HEADER     **Variable
+  );
+
 #endif
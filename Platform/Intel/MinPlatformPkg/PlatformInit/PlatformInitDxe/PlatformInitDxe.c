@@ -74,6 +74,8 @@ OnEndOfDxe (
 {
   gBS->CloseEvent (Event);
 
+  TestPointEndOfDxeBootPerformance ();
+
   TestPointEndOfDxeNoThirdPartyPciOptionRom ();
 
   TestPointEndOfDxeDmaAcpiTableFunctional ();
@@ -138,6 +140,8 @@ OnReadyToBootLater (
 
   gBS->CloseEvent (Event);
 
+  TestPointReadyToBootBootPerformance ();
+
   TestPointReadyToBootMemoryTypeInformationFunctional ();
   TestPointReadyToBootUefiMemoryAttributeTableFunctional ();
   TestPointReadyToBootUefiBootVariableFunctional ();
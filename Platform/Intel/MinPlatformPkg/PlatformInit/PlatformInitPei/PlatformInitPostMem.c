@@ -57,6 +57,8 @@ PlatformInitEndOfPei (
 {
   EFI_STATUS                    Status;
 
+  TestPointEndOfPeiBootPerformance ();
+
   Status = BoardInitAfterSiliconInit ();
   ASSERT_EFI_ERROR (Status);
 
@@ -0,0 +1,77 @@
+/** @file
+
+Copyright (c) 2023, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <Library/TestPointCheckLib.h>
+#include <Library/TestPointLib.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseLib.h>
+#include <Library/TimerLib.h>
+
+/**
+  Get the time elapsed since reset, the way the performance libraries take
+  the timestamps of the FPDT records.
+
+  @return The time elapsed since reset, in milliseconds.
+**/
+UINT64
+GetBootTimeInMilliseconds (
+  VOID
+  )
+{
+  UINT64  Counter;
+  UINT64  StartValue;
+  UINT64  EndValue;
+
+  Counter = GetPerformanceCounter ();
+  GetPerformanceCounterProperties (&StartValue, &EndValue);
+  if (EndValue < StartValue) {
+    Counter = StartValue - Counter;
+  } else {
+    Counter = Counter - StartValue;
+  }
+
+  return DivU64x32 (GetTimeInNanoSecond (Counter), 1000000);
+}
+
+/**
+  Check the boot time against a budget.
+
+  @param[in]  Budget          The budget in milliseconds since reset, 0 for none.
+  @param[in]  ErrorString     The error string to report if the budget is exceeded.
+
+  @retval EFI_SUCCESS         The boot time is within the budget.
+  @retval EFI_UNSUPPORTED     There is no budget, the boot time is only logged.
+  @retval EFI_TIMEOUT         The boot time is over the budget.
+**/
+EFI_STATUS
+TestPointCheckBootPerformance (
+  IN UINT32  Budget,
+  IN CHAR16  *ErrorString
+  )
+{
+  UINT64  BootTime;
+
+  BootTime = GetBootTimeInMilliseconds ();
+  if (Budget == 0) {
+    DEBUG ((DEBUG_INFO, "Boot time - %ld ms, no budget\n", BootTime));
+    return EFI_UNSUPPORTED;
+  }
+
+  DEBUG ((DEBUG_INFO, "Boot time - %ld ms, budget %d ms\n", BootTime, Budget));
+  if (BootTime > Budget) {
+    DEBUG ((DEBUG_ERROR, "Boot time over budget by %ld ms\n", BootTime - Budget));
+    TestPointLibAppendErrorString (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      ErrorString
+      );
+    return EFI_TIMEOUT;
+  }
+
+  return EFI_SUCCESS;
+}
@@ -0,0 +1,38 @@
+/** @file
+
+Copyright (c) 2023, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Uefi.h>
+#include <PiDxe.h>
+#include <Library/TestPointCheckLib.h>
+#include <Library/DebugLib.h>
+#include <Library/TimerLib.h>
+#include <Library/UefiLib.h>
+#include <Guid/Performance.h>
+
+/**
+  Check the timer used for the boot time is the timer of the FPDT records.
+
+  The DXE core publishes the timer of the FPDT records. The boot time is
+  only comparable with them if this module uses the same timer.
+**/
+VOID
+TestPointCheckPerformanceTimer (
+  VOID
+  )
+{
+  EFI_STATUS            Status;
+  PERFORMANCE_PROPERTY  *PerformanceProperty;
+  UINT64                Frequency;
+
+  Status = EfiGetSystemConfigurationTable (&gPerformanceProtocolGuid, (VOID **)&PerformanceProperty);
+  if (!EFI_ERROR (Status) && (PerformanceProperty != NULL)) {
+    Frequency = GetPerformanceCounterProperties (NULL, NULL);
+    if (PerformanceProperty->Frequency != Frequency) {
+      DEBUG ((DEBUG_WARN, "Timer frequency %ld, FPDT timer frequency %ld\n", Frequency, PerformanceProperty->Frequency));
+    }
+  }
+}
@@ -148,6 +148,17 @@ TestPointVtdEngine (
   VOID
   );
 
+EFI_STATUS
+TestPointCheckBootPerformance (
+  IN UINT32  Budget,
+  IN CHAR16  *ErrorString
+  );
+
+VOID
+TestPointCheckPerformanceTimer (
+  VOID
+  );
+
 VOID *
 TestPointGetAcpi (
   IN UINT32  Signature
@@ -1259,6 +1270,162 @@ TestPointExitBootServices (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the FSP NVS buffer is saved, and reports what saving it
+  wrote to the variable storage.
+
+  Test subject: FSP NVS buffer.
+  Test overview: Verify the FSP NVS buffer is saved, and dump the number of
+                 variables and bytes written.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @param[in]  SaveStatus        The status of saving the FSP NVS buffer.
+  @param[in]  DataSize          The size of the FSP NVS buffer as stored, in bytes.
+  @param[in]  VariableCount     The number of variables the FSP NVS buffer is stored in.
+  @param[in]  VariablesWritten  The number of those variables written in this boot.
+  @param[in]  BytesWritten      The number of bytes written in this boot.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointFspNvsBufferSaved (
+  IN EFI_STATUS  SaveStatus,
+  IN UINTN       DataSize,
+  IN UINTN       VariableCount,
+  IN UINTN       VariablesWritten,
+  IN UINTN       BytesWritten
+  )
+{
+  if ((mFeatureImplemented[9] & TEST_POINT_BYTE9_FSP_NVS_BUFFER_SAVED_FUNCTIONAL) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointFspNvsBufferSaved - Enter\n"));
+
+  DEBUG ((DEBUG_INFO, "FSP NVS buffer - Size 0x%x, Status %r\n", DataSize, SaveStatus));
+  DEBUG ((DEBUG_INFO, "  Variables written %d of %d, bytes written 0x%x\n", VariablesWritten, VariableCount, BytesWritten));
+
+  if (EFI_ERROR (SaveStatus)) {
+    DEBUG ((DEBUG_ERROR, "FSP NVS buffer not saved\n"));
+    TestPointLibAppendErrorString (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      TEST_POINT_BYTE9_FSP_NVS_BUFFER_SAVED_FUNCTIONAL_ERROR_CODE \
+        TEST_POINT_FSP_NVS_BUFFER_SAVED \
+        TEST_POINT_BYTE9_FSP_NVS_BUFFER_SAVED_FUNCTIONAL_ERROR_STRING
+      );
+  } else {
+    TestPointLibSetFeaturesVerified (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      9,
+      TEST_POINT_BYTE9_FSP_NVS_BUFFER_SAVED_FUNCTIONAL
+      );
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointFspNvsBufferSaved - Exit\n"));
+  return EFI_SUCCESS;
+}
+
+/**
+  This service verifies the boot time at the end of DXE is within the budget
+  of the platform.
+
+  Test subject: Boot performance at the end of DXE.
+  Test overview: Compare the time elapsed since reset, taken from the
+                 performance counter as the FPDT records are, with
+                 PcdTestPointEndOfDxeBootTimeBudget. It is not verified
+                 when the budget is 0.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfDxeBootPerformance (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((mFeatureImplemented[9] & TEST_POINT_BYTE9_END_OF_DXE_BOOT_TIME_WITHIN_BUDGET) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointEndOfDxeBootPerformance - Enter\n"));
+  TestPointCheckPerformanceTimer ();
+  Status = TestPointCheckBootPerformance (
+             PcdGet32 (PcdTestPointEndOfDxeBootTimeBudget),
+             TEST_POINT_BYTE9_END_OF_DXE_BOOT_TIME_WITHIN_BUDGET_ERROR_CODE \
+               TEST_POINT_END_OF_DXE \
+               TEST_POINT_BYTE9_END_OF_DXE_BOOT_TIME_WITHIN_BUDGET_ERROR_STRING
+             );
+  if (!EFI_ERROR (Status)) {
+    TestPointLibSetFeaturesVerified (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      9,
+      TEST_POINT_BYTE9_END_OF_DXE_BOOT_TIME_WITHIN_BUDGET
+      );
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointEndOfDxeBootPerformance - Exit\n"));
+  return EFI_SUCCESS;
+}
+
+/**
+  This service verifies the boot time at ready to boot is within the budget
+  of the platform.
+
+  Test subject: Boot performance at ready to boot.
+  Test overview: Compare the time elapsed since reset, taken from the
+                 performance counter as the FPDT records are, with
+                 PcdTestPointReadyToBootBootTimeBudget. It is not verified
+                 when the budget is 0.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointReadyToBootBootPerformance (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+
+  if ((mFeatureImplemented[9] & TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_TIME_WITHIN_BUDGET) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointReadyToBootBootPerformance - Enter\n"));
+  TestPointCheckPerformanceTimer ();
+  Status = TestPointCheckBootPerformance (
+             PcdGet32 (PcdTestPointReadyToBootBootTimeBudget),
+             TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_TIME_WITHIN_BUDGET_ERROR_CODE \
+               TEST_POINT_READY_TO_BOOT \
+               TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_TIME_WITHIN_BUDGET_ERROR_STRING
+             );
+  if (!EFI_ERROR (Status)) {
+    TestPointLibSetFeaturesVerified (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      9,
+      TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_TIME_WITHIN_BUDGET
+      );
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointReadyToBootBootPerformance - Exit\n"));
+  return EFI_SUCCESS;
+}
+
 /**
   Initialize feature data.
 
@@ -52,6 +52,12 @@ TestPointVtdEngine (
   VOID
   );
 
+EFI_STATUS
+TestPointCheckBootPerformance (
+  IN UINT32  Budget,
+  IN CHAR16  *ErrorString
+  );
+
 GLOBAL_REMOVE_IF_UNREFERENCED ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT  mTestPointStruct = {
   PLATFORM_TEST_POINT_VERSION,
   PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
@@ -469,6 +475,56 @@ TestPointEndOfPeiPciBusMasterDisabled (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the boot time at the end of PEI is within the budget
+  of the platform.
+
+  Test subject: Boot performance at the end of PEI.
+  Test overview: Compare the time elapsed since reset, taken from the
+                 performance counter as the FPDT records are, with
+                 PcdTestPointEndOfPeiBootTimeBudget. It is not verified
+                 when the budget is 0.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfPeiBootPerformance (
+  VOID
+  )
+{
+  EFI_STATUS  Status;
+  UINT8       *FeatureImplemented;
+
+  FeatureImplemented = GetFeatureImplemented ();
+
+  if ((FeatureImplemented[9] & TEST_POINT_BYTE9_END_OF_PEI_BOOT_TIME_WITHIN_BUDGET) == 0) {
+    return EFI_SUCCESS;
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointEndOfPeiBootPerformance - Enter\n"));
+  Status = TestPointCheckBootPerformance (
+             PcdGet32 (PcdTestPointEndOfPeiBootTimeBudget),
+             TEST_POINT_BYTE9_END_OF_PEI_BOOT_TIME_WITHIN_BUDGET_ERROR_CODE \
+               TEST_POINT_END_OF_PEI \
+               TEST_POINT_BYTE9_END_OF_PEI_BOOT_TIME_WITHIN_BUDGET_ERROR_STRING
+             );
+  if (!EFI_ERROR (Status)) {
+    TestPointLibSetFeaturesVerified (
+      PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV,
+      NULL,
+      9,
+      TEST_POINT_BYTE9_END_OF_PEI_BOOT_TIME_WITHIN_BUDGET
+      );
+  }
+
+  DEBUG ((DEBUG_INFO, "======== TestPointEndOfPeiBootPerformance - Exit\n"));
+  return EFI_SUCCESS;
+}
+
 /**
   Initialize feature data.
 
@@ -696,6 +696,107 @@ TestPointSmmReadyToBootSmmPageProtection (
   return EFI_SUCCESS;
 }
 
+/**
+  This service verifies the FSP NVS buffer is saved, and reports what saving it
+  wrote to the variable storage.
+
+  Test subject: FSP NVS buffer.
+  Test overview: Verify the FSP NVS buffer is saved, and dump the number of
+                 variables and bytes written.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @param[in]  SaveStatus        The status of saving the FSP NVS buffer.
+  @param[in]  DataSize          The size of the FSP NVS buffer as stored, in bytes.
+  @param[in]  VariableCount     The number of variables the FSP NVS buffer is stored in.
+  @param[in]  VariablesWritten  The number of those variables written in this boot.
+  @param[in]  BytesWritten      The number of bytes written in this boot.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointFspNvsBufferSaved (
+  IN EFI_STATUS  SaveStatus,
+  IN UINTN       DataSize,
+  IN UINTN       VariableCount,
+  IN UINTN       VariablesWritten,
+  IN UINTN       BytesWritten
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  This service verifies the boot time at the end of PEI is within the budget
+  of the platform.
+
+  Test subject: Boot performance at the end of PEI.
+  Test overview: Compare the time elapsed since reset, taken from the
+                 performance counter as the FPDT records are, with
+                 PcdTestPointEndOfPeiBootTimeBudget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfPeiBootPerformance (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  This service verifies the boot time at the end of DXE is within the budget
+  of the platform.
+
+  Test subject: Boot performance at the end of DXE.
+  Test overview: Compare the time elapsed since reset, taken from the
+                 performance counter as the FPDT records are, with
+                 PcdTestPointEndOfDxeBootTimeBudget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointEndOfDxeBootPerformance (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
+/**
+  This service verifies the boot time at ready to boot is within the budget
+  of the platform.
+
+  Test subject: Boot performance at ready to boot.
+  Test overview: Compare the time elapsed since reset, taken from the
+                 performance counter as the FPDT records are, with
+                 PcdTestPointReadyToBootBootTimeBudget.
+  Reporting mechanism: Set ADAPTER_INFO_PLATFORM_TEST_POINT_STRUCT.
+                       Dumps results to the debug log.
+
+  @retval EFI_SUCCESS         The test point check was performed successfully.
+  @retval EFI_UNSUPPORTED     The test point check is not supported on this platform.
+**/
+EFI_STATUS
+EFIAPI
+TestPointReadyToBootBootPerformance (
+  VOID
+  )
+{
+  return EFI_SUCCESS;
+}
+
 /**
   This service verifies the system state after Exit Boot Services is invoked.
 
@@ -13,8 +13,63 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/DebugLib.h>
 #include <Library/UefiLib.h>
 #include <Library/TestPointLib.h>
+#include <Library/TestPointCheckLib.h>
 #include <Protocol/AdapterInformation.h>
 
+typedef struct {
+  UINT8   Mask;
+  CHAR16  *Name;
+  CHAR16  *ImplementationID;
+} TEST_POINT_BOOT_PERFORMANCE_NAME;
+
+GLOBAL_REMOVE_IF_UNREFERENCED TEST_POINT_BOOT_PERFORMANCE_NAME  mBootPerformanceName[] = {
+  {TEST_POINT_BYTE9_END_OF_PEI_BOOT_TIME_WITHIN_BUDGET,    TEST_POINT_END_OF_PEI,    TEST_POINT_IMPLEMENTATION_ID_PLATFORM_PEI},
+  {TEST_POINT_BYTE9_END_OF_DXE_BOOT_TIME_WITHIN_BUDGET,    TEST_POINT_END_OF_DXE,    TEST_POINT_IMPLEMENTATION_ID_PLATFORM_DXE},
+  {TEST_POINT_BYTE9_READY_TO_BOOT_BOOT_TIME_WITHIN_BUDGET, TEST_POINT_READY_TO_BOOT, TEST_POINT_IMPLEMENTATION_ID_PLATFORM_DXE},
+};
+
+/**
+  Dump the boot performance test points of a platform test point structure.
+  The ones over budget also have an entry in the error string.
+
+  @param[in]  ImplementationID     The implementation ID of the structure.
+  @param[in]  FeaturesImplemented  The features implemented.
+  @param[in]  FeaturesVerified     The features verified.
+  @param[in]  FeaturesSize         The size of the features.
+**/
+VOID
+DumpTestPointBootPerformance (
+  IN CHAR16                   *ImplementationID,
+  IN UINT8                    *FeaturesImplemented,
+  IN UINT8                    *FeaturesVerified,
+  IN UINT32                   FeaturesSize
+  )
+{
+  UINTN                            Index;
+  BOOLEAN                          Found;
+
+  if (FeaturesSize <= 9) {
+    return;
+  }
+
+  Found = FALSE;
+  for (Index = 0; Index < ARRAY_SIZE (mBootPerformanceName); Index++) {
+    if (((FeaturesImplemented[9] & mBootPerformanceName[Index].Mask) == 0) ||
+        (StrCmp (ImplementationID, mBootPerformanceName[Index].ImplementationID) != 0)) {
+      continue;
+    }
+    if (!Found) {
+      Print (L"  BootPerformance\n");
+      Found = TRUE;
+    }
+    Print (
+      L"    %s%s\n",
+      mBootPerformanceName[Index].Name,
+      ((FeaturesVerified[9] & mBootPerformanceName[Index].Mask) != 0) ? L"Within budget" : L"Not verified"
+      );
+  }
+}
+
 VOID
 DumpTestPoint (
   IN VOID                     *TestPointData
@@ -47,6 +102,15 @@ DumpTestPoint (
   }
   Print (L"\n");
 
+  if (TestPoint->Role == PLATFORM_TEST_POINT_ROLE_PLATFORM_IBV) {
+    DumpTestPointBootPerformance (
+      TestPoint->ImplementationID,
+      (UINT8 *)(TestPoint + 1),
+      Features,
+      TestPoint->FeaturesSize
+      );
+  }
+
   ErrorString = (CHAR16 *)(Features + TestPoint->FeaturesSize);
   Print (L"  ErrorString                 - \"");
   CopyMem (&ErrorChar, ErrorString, sizeof(ErrorChar));
@@ -522,10 +522,11 @@ PrintUsage (
   printf ("\tBit                    - The Bit Number of the port.\n");
   printf ("\tIndex                  - The Index Number of the port.\n");
   printf ("\tFixedFitLocation       - Fixed FIT location in flash address. FIT table will be generated at this location and Option Modules will be directly put right before it.\n");
-  printf ("\nUsage (view): %s [-view] InputFile -F <FitTablePointerOffset>\n", UTILITY_NAME);
+  printf ("\nUsage (view): %s [-view] InputFile [-F <FitTablePointerOffset>] [-TIME]\n", UTILITY_NAME);
   printf ("  Where:\n");
   printf ("\tInputFile              - Name of the input file.\n");
   printf ("\tFitTablePointerOffset  - FIT table pointer offset from end of file. 0x%x as default.\n", DEFAULT_FIT_TABLE_POINTER_OFFSET);
+  printf ("\t-TIME                  - Print the time taken by each step, in microseconds.\n");
   printf ("\nTool return values:\n");
   printf ("\tSTATUS_SUCCESS=%d, STATUS_WARNING=%d, STATUS_ERROR=%d\n", STATUS_SUCCESS, STATUS_WARNING, STATUS_ERROR);
 }
@@ -628,13 +629,160 @@ GetFixedFitLocation (
   return FitLocation;
 }
 
+#if defined (__linux__)
+//
+// Input files that ReadInputFile() maps rather than reads.
+//
+typedef struct {
+  UINT8     *Raw;
+  UINTN     RawSize;
+  dev_t     Device;
+  ino_t     Inode;
+} MAPPED_INPUT_FILE;
+
+#define MAX_MAPPED_INPUT_FILES  4
+
+MAPPED_INPUT_FILE  gMappedInputFile[MAX_MAPPED_INPUT_FILES];
+
+/**
+  Map an input file, at a 64 KB aligned address as ReadInputFile() reads it.
+
+  The mapping is private, so the changes made to the data are copy-on-write:
+  they never reach the input file, and only the pages changed are copied.
+  Only the parts of the file that are used are read from the disk.
+
+  @param FileName                    The input file name.
+  @param FileSize                    The input file size.
+  @param FileData                    The input file data, the memory is aligned.
+  @param FileBufferRaw               The memory holding the input file data.
+
+  @return STATUS_SUCCESS             The file is mapped.
+  @return STATUS_WARNING             The file cannot be mapped, read it instead.
+**/
+STATUS
+MapInputFile (
+  IN CHAR8    *FileName,
+  IN UINT32   FileSize,
+  OUT UINT8   **FileData,
+  OUT UINT8   **FileBufferRaw
+  )
+{
+  int                         Fd;
+  struct stat                 FileStat;
+  UINT8                       *Raw;
+  UINT8                       *Data;
+  UINTN                       RawSize;
+  UINTN                       Slot;
+
+  for (Slot = 0; Slot < MAX_MAPPED_INPUT_FILES; Slot++) {
+    if (gMappedInputFile[Slot].Raw == NULL) {
+      break;
+    }
+  }
+  if ((Slot == MAX_MAPPED_INPUT_FILES) || (FileSize == 0)) {
+    return STATUS_WARNING;
+  }
+
+  Fd = open (FileName, O_RDONLY);
+  if (Fd < 0) {
+    return STATUS_WARNING;
+  }
+  if ((fstat (Fd, &FileStat) != 0) || (FileStat.st_size != (off_t)FileSize)) {
+    close (Fd);
+    return STATUS_WARNING;
+  }
+
+  //
+  // Reserve the room the copy would take, plus a page of zeros after the data
+  // since the FV header scan reads a little past the end of the file. Then map
+  // the file over the aligned part.
+  //
+  RawSize = (UINTN)FileSize + 0x10000 + 0x1000;
+  Raw = mmap (NULL, RawSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (Raw == MAP_FAILED) {
+    close (Fd);
+    return STATUS_WARNING;
+  }
+  Data = Raw + (0x10000 - ((UINTN)Raw & 0x0FFFF));
+  if (mmap (Data, FileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, Fd, 0) == MAP_FAILED) {
+    munmap (Raw, RawSize);
+    close (Fd);
+    return STATUS_WARNING;
+  }
+  close (Fd);
+
+  gMappedInputFile[Slot].Raw     = Raw;
+  gMappedInputFile[Slot].RawSize = RawSize;
+  gMappedInputFile[Slot].Device  = FileStat.st_dev;
+  gMappedInputFile[Slot].Inode   = FileStat.st_ino;
+  *FileBufferRaw = Raw;
+  *FileData      = Data;
+  return STATUS_SUCCESS;
+}
+
+/**
+  Check whether a file is mapped by ReadInputFile().
+
+  @param FileName         The file name.
+
+  @return TRUE            The file is mapped.
+  @return FALSE           The file is not mapped.
+**/
+BOOLEAN
+IsMappedInputFile (
+  IN CHAR8    *FileName
+  )
+{
+  struct stat                 FileStat;
+  UINTN                       Slot;
+
+  if (stat (FileName, &FileStat) != 0) {
+    return FALSE;
+  }
+  for (Slot = 0; Slot < MAX_MAPPED_INPUT_FILES; Slot++) {
+    if ((gMappedInputFile[Slot].Raw != NULL) &&
+        (gMappedInputFile[Slot].Device == FileStat.st_dev) &&
+        (gMappedInputFile[Slot].Inode == FileStat.st_ino)) {
+      return TRUE;
+    }
+  }
+  return FALSE;
+}
+#endif
+
+/**
+  Free the memory of an input file read by ReadInputFile().
+
+  @param FileBufferRaw               The memory holding the input file data.
+**/
+VOID
+FreeInputFile (
+  IN UINT8    *FileBufferRaw
+  )
+{
+#if defined (__linux__)
+  UINTN                       Slot;
+
+  for (Slot = 0; Slot < MAX_MAPPED_INPUT_FILES; Slot++) {
+    if ((FileBufferRaw != NULL) && (gMappedInputFile[Slot].Raw == FileBufferRaw)) {
+      munmap (gMappedInputFile[Slot].Raw, gMappedInputFile[Slot].RawSize);
+      gMappedInputFile[Slot].Raw = NULL;
+      return;
+    }
+  }
+#endif
+  free ((VOID *)FileBufferRaw);
+}
+
 /**
   Read input file.
 
   @param FileName                    The input file name.
   @param FileData                    The input file data, the memory is aligned.
   @param FileSize                    The input file size.
-  @param FileBufferRaw               The memory to hold input file data. The caller must free the memory.
+  @param FileBufferRaw               The memory to hold input file data. The caller must free the memory
+                                     with FreeInputFile(). If it is not NULL, the file may be mapped rather
+                                     than read.
 
   @return STATUS_SUCCESS             The file found and data read.
   @return STATUS_ERROR               The file data is not read.
@@ -679,6 +827,12 @@ ReadInputFile (
   // Read the contents of input file to memory buffer
   //
   if (FileBufferRaw != NULL) {
+#if defined (__linux__)
+    if (MapInputFile (FileName, *FileSize, FileData, FileBufferRaw) == STATUS_SUCCESS) {
+      fclose (FpIn);
+      return STATUS_SUCCESS;
+    }
+#endif
     *FileBufferRaw = (UINT8 *) malloc (*FileSize + 0x10000);
     if (NULL == *FileBufferRaw) {
       Error (NULL, 0, 0, "No sufficient memory to allocate!", NULL);
@@ -779,6 +933,288 @@ FindNextFvHeader (
   return NULL;
 }
 
+//
+// Index of the FFS files of the input image. It is built in one pass over the
+// image, so looking up a GUID does not scan the image again.
+//
+typedef struct {
+  EFI_GUID                    *Name;
+  EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
+  UINT8                       *Data;
+  UINT32                      DataSize;
+} FFS_INDEX_ENTRY;
+
+typedef struct {
+  UINT8                       *Buffer;
+  UINT32                      BufferSize;
+  EFI_FIRMWARE_VOLUME_HEADER  **Fv;
+  UINT32                      FvCount;
+  FFS_INDEX_ENTRY             *File;
+  UINT32                      FileCount;
+  UINT32                      *Hash;      // Index in File + 1, 0 for a free slot
+  UINT32                      HashMask;
+} FFS_INDEX;
+
+FFS_INDEX  gFfsIndex;
+
+/**
+  Hash a GUID for the FFS index.
+
+  @param Guid             The GUID.
+
+  @return The hash.
+**/
+UINT32
+FfsIndexHash (
+  IN EFI_GUID  *Guid
+  )
+{
+  UINT32  Hash;
+
+  Hash = Guid->Data1 ^ ((UINT32)Guid->Data2 << 16) ^ Guid->Data3;
+  Hash ^= ((UINT32)Guid->Data4[4] << 24) | ((UINT32)Guid->Data4[5] << 16) | ((UINT32)Guid->Data4[6] << 8) | Guid->Data4[7];
+  Hash ^= Hash >> 15;
+  Hash *= 0x2C1B3C6D;
+  Hash ^= Hash >> 12;
+  return Hash;
+}
+
+/**
+  Free the FFS index.
+**/
+VOID
+FreeFfsIndex (
+  VOID
+  )
+{
+  free (gFfsIndex.Fv);
+  free (gFfsIndex.File);
+  free (gFfsIndex.Hash);
+  memset (&gFfsIndex, 0, sizeof (gFfsIndex));
+}
+
+/**
+  Build the FFS index of an FD or FV image.
+
+  The FVs are found and their files are walked as FindFileFromFvByGuid() does,
+  so a lookup in the index finds the file FindFileFromFvByGuid() would find.
+
+  @param FdBuffer         FD or FV binary buffer.
+  @param FdSize           FD or FV size.
+
+  @retval STATUS_SUCCESS  The index is built.
+  @retval STATUS_ERROR    No sufficient memory, there is no index.
+**/
+STATUS
+BuildFfsIndex (
+  IN UINT8     *FdBuffer,
+  IN UINT32    FdSize
+  )
+{
+  EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
+  EFI_FFS_FILE_HEADER         *FileHeader;
+  FFS_INDEX_ENTRY             *Entry;
+  UINT64                      FvLength;
+  UINTN                       Offset;
+  UINTN                       FileLength;
+  UINTN                       FileOccupiedSize;
+  UINT32                      FvMax;
+  UINT32                      FileMax;
+  UINT32                      Index;
+  UINT32                      Slot;
+  VOID                        *NewBuffer;
+
+  FreeFfsIndex ();
+  FvMax   = 0;
+  FileMax = 0;
+
+  FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *)FindNextFvHeader (FdBuffer, FdSize);
+  while (FvHeader != NULL) {
+    FvLength = FvHeader->FvLength;
+
+    if (gFfsIndex.FvCount == FvMax) {
+      FvMax     = (FvMax == 0) ? 16 : FvMax * 2;
+      NewBuffer = realloc (gFfsIndex.Fv, FvMax * sizeof (*gFfsIndex.Fv));
+      if (NewBuffer == NULL) {
+        goto Error;
+      }
+      gFfsIndex.Fv = NewBuffer;
+    }
+    gFfsIndex.Fv[gFfsIndex.FvCount++] = FvHeader;
+
+    FileHeader = (EFI_FFS_FILE_HEADER *)((UINTN)FvHeader + FvHeader->HeaderLength);
+    Offset     = (UINTN) FileHeader - (UINTN) FvHeader;
+    while (Offset < FvLength) {
+      FileLength = (*(UINT32 *)(FileHeader->Size)) & 0x00FFFFFF;
+      FileOccupiedSize = GETOCCUPIEDSIZE(FileLength, 8);
+      if (FileOccupiedSize == 0) {
+        break;
+      }
+
+      if (gFfsIndex.FileCount == FileMax) {
+        FileMax   = (FileMax == 0) ? 256 : FileMax * 2;
+        NewBuffer = realloc (gFfsIndex.File, FileMax * sizeof (*gFfsIndex.File));
+        if (NewBuffer == NULL) {
+          goto Error;
+        }
+        gFfsIndex.File = NewBuffer;
+      }
+      Entry           = &gFfsIndex.File[gFfsIndex.FileCount++];
+      Entry->Name     = &FileHeader->Name;
+      Entry->FvHeader = FvHeader;
+      Entry->Data     = (UINT8 *)FileHeader + sizeof(EFI_FFS_FILE_HEADER);
+      Entry->DataSize = (UINT32)(FileLength - sizeof(EFI_FFS_FILE_HEADER));
+#if (PI_SPECIFICATION_VERSION < 0x00010000)
+      if (FileHeader->Attributes & FFS_ATTRIB_TAIL_PRESENT) {
+        Entry->DataSize -= sizeof(EFI_FFS_FILE_TAIL);
+      }
+#endif
+
+      FileHeader = (EFI_FFS_FILE_HEADER *)((UINTN)FileHeader + FileOccupiedSize);
+      Offset = (UINTN) FileHeader - (UINTN) FvHeader;
+    }
+
+    //
+    // Next FV
+    //
+    if ((UINTN)FdBuffer + FdSize > (UINTN)FvHeader + FvLength) {
+      FvHeader = (EFI_FIRMWARE_VOLUME_HEADER *)FindNextFvHeader ((UINT8 *)FvHeader + (UINTN)FvLength, (UINTN)FdBuffer + FdSize - ((UINTN)FvHeader + (UINTN)FvLength));
+    } else {
+      break;
+    }
+  }
+
+  //
+  // Open addressing, at most half full. The files are added in the order they
+  // were found, so a probe meets the first file with a GUID first.
+  //
+  gFfsIndex.HashMask = 15;
+  while (gFfsIndex.HashMask < gFfsIndex.FileCount * 2) {
+    gFfsIndex.HashMask = gFfsIndex.HashMask * 2 + 1;
+  }
+  gFfsIndex.Hash = calloc ((UINTN)gFfsIndex.HashMask + 1, sizeof (*gFfsIndex.Hash));
+  if (gFfsIndex.Hash == NULL) {
+    goto Error;
+  }
+  for (Index = 0; Index < gFfsIndex.FileCount; Index++) {
+    Slot = FfsIndexHash (gFfsIndex.File[Index].Name) & gFfsIndex.HashMask;
+    while (gFfsIndex.Hash[Slot] != 0) {
+      Slot = (Slot + 1) & gFfsIndex.HashMask;
+    }
+    gFfsIndex.Hash[Slot] = Index + 1;
+  }
+
+  gFfsIndex.Buffer     = FdBuffer;
+  gFfsIndex.BufferSize = FdSize;
+  return STATUS_SUCCESS;
+
+Error:
+  FreeFfsIndex ();
+  return STATUS_ERROR;
+}
+
+/**
+  Find File with GUID using the FFS index.
+
+  @param FvBuffer         FV binary buffer.
+  @param FvSize           FV size.
+  @param Guid             File GUID value to be searched.
+  @param FileSize         Guid File size.
+  @param Indexed          TRUE if the index covers the FV buffer, FALSE if it
+                          must be searched without the index.
+
+  @return FileLocation    Guid File location.
+  @return NULL            Guid File is not found.
+**/
+UINT8  *
+FindFileFromFfsIndex (
+  IN UINT8     *FvBuffer,
+  IN UINT32    FvSize,
+  IN EFI_GUID  *Guid,
+  OUT UINT32   *FileSize,
+  OUT BOOLEAN  *Indexed
+  )
+{
+  EFI_FIRMWARE_VOLUME_HEADER  *FvHeader;
+  FFS_INDEX_ENTRY             *Entry;
+  UINT32                      Index;
+  UINT32                      Slot;
+
+  *Indexed = FALSE;
+  if (gFfsIndex.Buffer == NULL) {
+    return NULL;
+  }
+
+  //
+  // The index covers the whole image, and each of its FVs.
+  //
+  FvHeader = NULL;
+  if ((FvBuffer != gFfsIndex.Buffer) || (FvSize != gFfsIndex.BufferSize)) {
+    for (Index = 0; Index < gFfsIndex.FvCount; Index++) {
+      if (((UINT8 *)gFfsIndex.Fv[Index] == FvBuffer) && (gFfsIndex.Fv[Index]->FvLength == FvSize)) {
+        FvHeader = gFfsIndex.Fv[Index];
+        break;
+      }
+    }
+    if (FvHeader == NULL) {
+      return NULL;
+    }
+  }
+
+  *Indexed = TRUE;
+  for (Slot = FfsIndexHash (Guid) & gFfsIndex.HashMask; gFfsIndex.Hash[Slot] != 0; Slot = (Slot + 1) & gFfsIndex.HashMask) {
+    Entry = &gFfsIndex.File[gFfsIndex.Hash[Slot] - 1];
+    if ((CompareGuid (Entry->Name, Guid) == 0) &&
+        ((FvHeader == NULL) || (Entry->FvHeader == FvHeader))) {
+      *FileSize = Entry->DataSize;
+      return Entry->Data;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Find the FV following an FV of an FD, or the first one.
+
+  @param FdBuffer         Fd file buffer.
+  @param FdFileSize       Fd file size.
+  @param FvBuffer         The FV, or NULL to find the first FV.
+
+  @return FvHeader        The next FV.
+  @return NULL            There is no other FV.
+**/
+UINT8 *
+GetNextFvFromFd (
+  IN UINT8     *FdBuffer,
+  IN UINT32    FdFileSize,
+  IN UINT8     *FvBuffer OPTIONAL
+  )
+{
+  UINT32                      Index;
+
+  if ((gFfsIndex.Buffer == FdBuffer) && (gFfsIndex.BufferSize == FdFileSize) && (FdBuffer != NULL)) {
+    if (FvBuffer == NULL) {
+      return (gFfsIndex.FvCount != 0) ? (UINT8 *)gFfsIndex.Fv[0] : NULL;
+    }
+    for (Index = 0; Index + 1 < gFfsIndex.FvCount; Index++) {
+      if ((UINT8 *)gFfsIndex.Fv[Index] == FvBuffer) {
+        return (UINT8 *)gFfsIndex.Fv[Index + 1];
+      }
+    }
+    return NULL;
+  }
+
+  if (FvBuffer == NULL) {
+    return FindNextFvHeader (FdBuffer, FdFileSize);
+  }
+  FvBuffer = FvBuffer + (UINT32)((EFI_FIRMWARE_VOLUME_HEADER *)FvBuffer)->FvLength;
+  if ((UINTN)FvBuffer >= (UINTN)FdBuffer + FdFileSize) {
+    return NULL;
+  }
+  return FindNextFvHeader (FvBuffer, (UINTN)FdBuffer + FdFileSize - (UINTN)FvBuffer);
+}
+
 /**
   Find File with GUID in an FV.
 
@@ -806,6 +1242,12 @@ FindFileFromFvByGuid (
   UINTN                       Offset;
   UINTN                       FileLength;
   UINTN                       FileOccupiedSize;
+  BOOLEAN                     Indexed;
+
+  FixPoint = FindFileFromFfsIndex (FvBuffer, FvSize, Guid, FileSize, &Indexed);
+  if (Indexed) {
+    return FixPoint;
+  }
 
   //
   // Find the FFS file
@@ -1853,7 +2295,7 @@ GetFitEntryNumber (
     }
 
     if (MicrocodeFileBufferRaw != NULL) {
-      free ((VOID *)MicrocodeFileBufferRaw);
+      FreeInputFile (MicrocodeFileBufferRaw);
       MicrocodeFileBufferRaw = NULL;
     }
   }
@@ -3342,6 +3784,8 @@ WriteOutputFile (
   )
 {
   FILE                        *FpOut;
+  UINT8                       *FileCopy;
+  STATUS                      Status;
 
   //
   //Check the File Path
@@ -3352,28 +3796,47 @@ WriteOutputFile (
     return STATUS_ERROR;
   }
 
+  FileCopy = NULL;
+#if defined (__linux__)
+  if (IsMappedInputFile (FileName)) {
+    //
+    // The output file is a mapped input file, and opening it for writing
+    // truncates it under the mapping. Write from a copy of the data.
+    //
+    FileCopy = (UINT8 *) malloc (FileSize);
+    if (FileCopy == NULL) {
+      Error (NULL, 0, 0, "No sufficient memory to allocate!", NULL);
+      return STATUS_ERROR;
+    }
+    memcpy (FileCopy, FileData, FileSize);
+    FileData = FileCopy;
+  }
+#endif
+
   //
   // Open the output FvRecovery.fv file
   //
   if ((FpOut = fopen (FileName, "w+b")) == NULL) {
     Error (NULL, 0, 0, "Unable to open file", "%s", FileName);
+    free (FileCopy);
     return STATUS_ERROR;
   }
   //
   // Write the output FvRecovery.fv file
   //
+  Status = STATUS_SUCCESS;
   if ((fwrite (FileData, 1, FileSize, FpOut)) != FileSize) {
     Error (NULL, 0, 0, "Write output file error!", NULL);
-    fclose (FpOut);
-    return STATUS_ERROR;
+    Status = STATUS_ERROR;
   }
 
   //
   // Close the output FvRecovery.fv file
   //
   fclose (FpOut);
+  free (FileCopy);
 
-  return STATUS_SUCCESS;
+  return Status;
 }
 
 
@@ -3399,12 +3862,8 @@ GetFvAcmSizeFromFd(
   UINT32                        FileLength;
 
   //*FvRecovery = NULL;
-  FileBuffer = FindNextFvHeader(FdBuffer, FdFileSize);
-  if (FileBuffer == NULL) {
-    return 0;
-  }
-
-  while ((UINTN)FileBuffer < (UINTN)FdBuffer + FdFileSize) {
+  FileBuffer = GetNextFvFromFd (FdBuffer, FdFileSize, NULL);
+  while (FileBuffer != NULL) {
     FvLength = (UINT32)((EFI_FIRMWARE_VOLUME_HEADER *)FileBuffer)->FvLength;
 
     if (FindFileFromFvByGuid(FileBuffer, FvLength, &ACMGuid, &FileLength) != NULL) {
@@ -3417,15 +3876,7 @@ GetFvAcmSizeFromFd(
     //
     // Next fv
     //
-    FileBuffer = (UINT8 *)FileBuffer + FvLength;
-    if ((UINTN)FileBuffer >= (UINTN)FdBuffer + FdFileSize) {
-      break;
-    }
-    FileBuffer = FindNextFvHeader(FileBuffer, (UINTN)FdBuffer + FdFileSize - (UINTN)FileBuffer);
-    if (FileBuffer == NULL) {
-      break;
-    }
-
+    FileBuffer = GetNextFvFromFd (FdBuffer, FdFileSize, FileBuffer);
   }
 
   return FvAcmSize;
@@ -3456,12 +3907,8 @@ GetFvRecoveryInfoFromFd (
   UINT32                        FileLength;
 
   *FvRecovery = NULL;
-  FileBuffer = FindNextFvHeader (FdBuffer, FdFileSize);
-  if (FileBuffer == NULL) {
-    return 0;
-  }
-
-  while ((UINTN)FileBuffer < (UINTN)FdBuffer + FdFileSize) {
+  FileBuffer = GetNextFvFromFd (FdBuffer, FdFileSize, NULL);
+  while (FileBuffer != NULL) {
     FvLength         = (UINT32)((EFI_FIRMWARE_VOLUME_HEADER *)FileBuffer)->FvLength;
 
     if (FindFileFromFvByGuid (FileBuffer, FvLength, &VTFGuid, &FileLength) != NULL) {
@@ -3475,15 +3922,7 @@ GetFvRecoveryInfoFromFd (
     //
     // Next fv
     //
-    FileBuffer = (UINT8 *)FileBuffer + FvLength;
-    if ((UINTN)FileBuffer >= (UINTN)FdBuffer + FdFileSize) {
-      break;
-    }
-    FileBuffer = FindNextFvHeader (FileBuffer, (UINTN)FdBuffer + FdFileSize - (UINTN)FileBuffer);
-    if (FileBuffer == NULL) {
-      break;
-    }
-
+    FileBuffer = GetNextFvFromFd (FdBuffer, FdFileSize, FileBuffer);
   }
 
   //
@@ -3721,7 +4160,15 @@ FitGen (
       Error (NULL, 0, 0, "Unable to open file", "%s", argv[2]);
       goto exitFunc;
     }
+  }
+
+  //
+  // Index the FFS files once for the GUID lookups. Without the index, each
+  // lookup scans the image.
+  //
+  BuildFfsIndex (FdFileBuffer, FdFileSize);
 
+  if (!IsFv) {
     //
     // Get Fvrecovery information
     //
@@ -3861,12 +4308,31 @@ FitGen (
   }
 
 exitFunc:
+  FreeFfsIndex ();
   if (FileBufferRaw != NULL) {
-    free ((VOID *)FileBufferRaw);
+    FreeInputFile (FileBufferRaw);
   }
   return Status;
 }
 
+/**
+  Get the wall clock time.
+
+  @return The time in microseconds, or 0 if it is not available.
+**/
+UINT64
+GetTimeInMicroseconds (
+  VOID
+  )
+{
+  struct timespec  Time;
+
+  if (timespec_get (&Time, TIME_UTC) == 0) {
+    return 0;
+  }
+  return (UINT64)Time.tv_sec * 1000000 + (UINT64)Time.tv_nsec / 1000;
+}
+
 /**
   View function for FitGen.
 
@@ -3892,6 +4358,14 @@ FitView (
   UINT32                        BiosRegionBaseOffset;
   FLASH_MAP_0_REGISTER          FlashMap0;
   FLASH_REGION_1_BIOS_REGISTER  FlashRegion1;
+  INTN                          Index;
+  BOOLEAN                       Timing;
+  UINT64                        StartTime;
+  UINT64                        ReadTime;
+  UINT64                        ParseTime;
+  UINT64                        PrintTime;
+
+  StartTime = GetTimeInMicroseconds ();
 
   //
   // Step 1: Read input file
@@ -3901,28 +4375,32 @@ FitView (
     Error (NULL, 0, 0, "Unable to open file", "%s", argv[2]);
     goto exitFunc;
   }
+  ReadTime = GetTimeInMicroseconds ();
 
+  //
   // no -f option, use default FIT pointer offset
-  if (argc == 3) {
-    //
-    // Use default address
-    //
-    gFitTableContext.FitTablePointerOffset = DEFAULT_FIT_TABLE_POINTER_OFFSET;
-  } else if (stricmp (argv[3], "-f") == 0) {
-    if (argc == 5) {
-      //
-      // Get offset from parameter
-      //
-      gFitTableContext.FitTablePointerOffset = xtoi (argv[3 + 1]);
+  //
+  gFitTableContext.FitTablePointerOffset = DEFAULT_FIT_TABLE_POINTER_OFFSET;
+  Timing = FALSE;
+  for (Index = 3; Index < argc; Index++) {
+    if (stricmp (argv[Index], "-f") == 0) {
+      if (Index + 1 < argc) {
+        //
+        // Get offset from parameter
+        //
+        gFitTableContext.FitTablePointerOffset = xtoi (argv[++Index]);
+      } else {
+        Error (NULL, 0, 0, "FIT offset not specified!", NULL);
+        Status = STATUS_ERROR;
+        goto exitFunc;
+      }
+    } else if (stricmp (argv[Index], "-time") == 0) {
+      Timing = TRUE;
     } else {
-      Error (NULL, 0, 0, "FIT offset not specified!", NULL);
+      Error (NULL, 0, 0, "Invalid view option: ", "%s", argv[Index]);
       Status = STATUS_ERROR;
       goto exitFunc;
     }
-  } else {
-    Error (NULL, 0, 0, "Invalid view option: ", "%s", argv[3]);
-    Status = STATUS_ERROR;
-    goto exitFunc;
   }
 
   //
@@ -3966,15 +4444,27 @@ FitView (
   // Close the Input file
   //
   fclose (FpIn);
+  ParseTime = GetTimeInMicroseconds ();
 
   //
   // For debug
   //
   PrintFitTable (FileBuffer, FvRecoveryFileSize);
+  PrintTime = GetTimeInMicroseconds ();
+
+  if (Timing) {
+    printf (
+      "\nFitView time (us): ReadInput %llu, ParseDescriptor %llu, PrintFitTable %llu, Total %llu\n",
+      (unsigned long long)(ReadTime - StartTime),
+      (unsigned long long)(ParseTime - ReadTime),
+      (unsigned long long)(PrintTime - ParseTime),
+      (unsigned long long)(PrintTime - StartTime)
+      );
+  }
 
 exitFunc:
   if (FileBufferRaw != NULL) {
-    free ((VOID *)FileBufferRaw);
+    FreeInputFile (FileBufferRaw);
   }
   return Status;
 }
@@ -11,6 +11,13 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
+#if defined (__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #define PI_SPECIFICATION_VERSION  0x00010000
 #define EFI_FVH_PI_REVISION       EFI_FVH_REVISION
 #include <Common/UefiBaseTypes.h>
@@ -31,7 +38,7 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 // Utility version information
 //
 #define UTILITY_MAJOR_VERSION 0
-#define UTILITY_MINOR_VERSION 67
+#define UTILITY_MINOR_VERSION 68
 #define UTILITY_DATE          __DATE__
 
 #define FIT_SPEC_VERSION_MAJOR 1